@@ -0,0 +1,166 @@
+#include "bytecode/serializer.hpp"
+#include "compilation_unit.hpp"
+#include "compiler.hpp"
+#include "interpreter/interpreter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+/* Interpreter time per loop iteration (or call, or allocated object) with switch and
+ * computed goto (threaded) dispatch, and with hot functions compiled by the JIT.
+ *
+ * Usage: dispatch_bench [iterations in millions] [--no-fuse]
+ *
+ * --no-fuse compiles without superinstructions, for comparing the two.
+ */
+namespace {
+using namespace cool;
+using vm::interpreter::Dispatch;
+
+struct Program
+{
+    const char *name;
+    std::string source;
+    double      iterations;
+    const char *unit;
+};
+
+// the module as the VM sees it, after a round trip through the file format
+std::optional<vm::bytecode::Image> compile(const std::string &source, const bool fuse)
+{
+    compiler::CompilationUnit unit{"<bench>", compiler::lexer::SourceBuffer{source}};
+    compiler::CompilerOptions options;
+    options.fuse = fuse;
+    compiler::Diagnostics diagnostics;
+    vm::bytecode::Module  module;
+    if (compiler::Compiler::build(unit, options, diagnostics, module) != compiler::SUCCESS)
+    {
+        for (const std::string &message : diagnostics.messages)
+            std::cerr << message << '\n';
+        return std::nullopt;
+    }
+    std::ostringstream bytes;
+    vm::bytecode::write_module(module, bytes);
+    std::string error;
+    return vm::bytecode::Image::load(bytes.str(), error);
+}
+
+struct Mode
+{
+    const char *name;
+    Dispatch    dispatch;
+    bool        jit;
+};
+
+double run_seconds(const vm::bytecode::Image &image, const Mode &mode)
+{
+    std::ostringstream              out;
+    vm::interpreter::Interpreter    interpreter{image, out};
+    interpreter.jit.enabled = interpreter.jit.enabled && mode.jit;
+    const auto                      start = std::chrono::steady_clock::now();
+    const vm::interpreter::InterpretResult result = interpreter.run(mode.dispatch);
+    const auto                      stop  = std::chrono::steady_clock::now();
+    if (result != vm::interpreter::InterpretResult::OK)
+        std::exit(1);
+    return std::chrono::duration<double>(stop - start).count();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    long millions = 20;
+    bool fuse     = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--no-fuse") == 0)
+            fuse = false;
+        else
+            millions = std::strtol(argv[i], nullptr, 10);
+    }
+    const std::string n = std::to_string(millions * 1000000);
+
+    const Program programs[] = {
+            {"while loop over globals",
+             "var i: int = 0;\nwhile (i < " + n + ") { i = i + 1; }\nprint(i);\n",
+             static_cast<double>(millions) * 1e6, "iteration"},
+            // `i - sum` stays small, a running sum would leave the inline int range
+            {"for loop over locals",
+             "fn run(): int {\n    var sum: int = 0;\n"
+             "    for (var i: int = 0; i < " + n + "; i = i + 1) { sum = i - sum; }\n"
+             "    return sum;\n}\nprint(run());\n",
+             static_cast<double>(millions) * 1e6, "iteration"},
+            // the optimizer turns the globals into constants and drops the identities
+            {"loop over constant globals",
+             "val LIMIT: int = " + n + ";\nval STEP: int = 2 - 1;\n"
+             "fn run(): int {\n    var sum: int = 0;\n"
+             "    for (var i: int = 0; i < LIMIT; i = i + STEP) { sum = i * 1 - sum + 0; }\n"
+             "    return sum;\n}\nprint(run());\n",
+             static_cast<double>(millions) * 1e6, "iteration"},
+            {"recursive calls (fib 27)",
+             "fn fib(n: int): int {\n    if (n < 2) { return n; }\n"
+             "    return fib(n - 1) + fib(n - 2);\n}\nprint(fib(27));\n",
+             635621, "call"},
+            {"instance allocation",
+             "class Point {\n    var x: int = 0;\n    var y: int = 0;\n}\nfn run(): void {\n"
+             "    for (var i: int = 0; i < " + n + "; i = i + 1) { val p: Point = Point(); }\n"
+             "}\nrun();\n",
+             static_cast<double>(millions) * 1e6, "object"},
+            {"field access and method calls",
+             "class Point {\n    var x: int = 0;\n    var y: int = 0;\n"
+             "    fn move(dx: int, dy: int): void { x = x + dx; y = y + dy; }\n}\n"
+             "fn run(): int {\n    val p: Point = Point();\n"
+             "    for (var i: int = 0; i < " + n + "; i = i + 1) { p.move(1, -1); p.x = p.y; }\n"
+             "    return p.x;\n}\nprint(run());\n",
+             static_cast<double>(millions) * 1e6, "iteration"},
+            // one call site alternating between two classes
+            {"polymorphic method calls",
+             "class Shape {\n    var side: int = 2;\n"
+             "    fn area(): int { return side * side; }\n}\n"
+             "class Rect : Shape {\n    var width: int = 3;\n"
+             "    fn area(): int { return side * width; }\n}\n"
+             "fn run(): int {\n    val shape: Shape = Shape();\n    val rect: Rect = Rect();\n"
+             "    var sum: int = 0;\n    for (var i: int = 0; i < " + n + "; i = i + 1) {\n"
+             "        var s: Shape = shape;\n        if (i % 2 == 0) { s = rect; }\n"
+             "        sum = s.area() - sum;\n    }\n    return sum;\n}\nprint(run());\n",
+             static_cast<double>(millions) * 1e6, "call"},
+            // appends to a string of up to 1000 pieces, then starts over
+            {"string building",
+             "fn run(): void {\n    var s: string = \"\";\n"
+             "    for (var i: int = 0; i < " + n + "; i = i + 1) {\n"
+             "        s = s + \"entry; \";\n        if (i % 1000 == 0) { s = \"\"; }\n    }\n"
+             "}\nrun();\n",
+             static_cast<double>(millions) * 1e6, "concatenation"},
+    };
+
+    const Mode modes[] = {
+            {"switch:   ", Dispatch::SWITCH, false},
+            {"threaded: ", Dispatch::THREADED, false},
+            {"jit:      ", vm::interpreter::DEFAULT_DISPATCH, true},
+    };
+    if (!COOL_HAS_COMPUTED_GOTO)
+        std::cout << "computed goto is not available, both modes run the switch loop\n";
+    if (!COOL_HAS_JIT)
+        std::cout << "the JIT is not available, the jit mode only interprets\n";
+    for (const Program &program : programs)
+    {
+        const std::optional<vm::bytecode::Image> image = compile(program.source, fuse);
+        if (!image)
+            return 1;
+        std::cout << program.name << ":\n";
+        for (const Mode &mode : modes)
+        {
+            double best = 1e300;
+            for (int run = 0; run < 3; ++run)
+                best = std::min(best, run_seconds(*image, mode));
+            std::cout << "  " << mode.name << best << " s, " << best / program.iterations * 1e9
+                      << " ns/" << program.unit << " (best of 3)\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "lexer/keywords.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/* Keyword lookup cost per identifier: the compile-time perfect hash used by the lexer
+ * against the std::unordered_map<std::string, TokenType> it replaced, which also had to
+ * build a std::string from every lexeme.
+ *
+ * Usage: keyword_bench [lookups in millions]
+ */
+namespace {
+using namespace cool::compiler::lexer;
+
+volatile std::size_t sink = 0;
+
+std::optional<TokenType> map_lookup(const std::string &word)
+{
+    static const std::unordered_map<std::string, TokenType> keyword_map = {
+            {"class", CLASS},    {"var", VAR},
+            {"val", VAL},        {"print", PRINT},
+            {"fn", FN},          {"true", TRUE},
+            {"false", FALSE},    {"if", IF},
+            {"else", ELSE},      {"while", WHILE},
+            {"for", FOR},        {"return", RETURN},
+            {"int", INT},        {"string", STRING_TYPE},
+            {"bool", BOOL},      {"void", VOID},
+            {"float", FLOAT},    {"extends", EXTENDS}};
+
+    if (const auto it = keyword_map.find(word); it != keyword_map.end())
+        return it->second;
+    return std::nullopt;
+}
+
+// about half keywords and half identifiers, the mix seen in real sources
+std::vector<std::string_view> corpus(const std::string &text)
+{
+    std::vector<std::string_view> words;
+    std::size_t                   start = 0;
+    while (start < text.size())
+    {
+        const std::size_t end = text.find(' ', start);
+        words.push_back(std::string_view(text).substr(start, end - start));
+        start = end == std::string::npos ? text.size() : end + 1;
+    }
+    return words;
+}
+
+template <typename Lookup>
+double nanoseconds_per_lookup(const std::vector<std::string_view> &words, const std::size_t total,
+                              Lookup &&lookup)
+{
+    std::size_t hits  = 0;
+    const auto  start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < total; ++i)
+        hits += lookup(words[i % words.size()]).has_value();
+    const auto stop = std::chrono::steady_clock::now();
+    sink = hits;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / total;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t total = (argc > 1 ? std::stoul(argv[1]) : 50) * 1000000;
+    const std::string text  = "var counter val total_count fn compute return result while index "
+                              "if value_of else x for i int print message string name bool flag "
+                              "class Point extends Animal true speak false y void move";
+    const std::vector<std::string_view> words = corpus(text);
+
+    const double map     = nanoseconds_per_lookup(words, total, [](const std::string_view word) {
+        return map_lookup(std::string(word));
+    });
+    const double perfect = nanoseconds_per_lookup(words, total, keywords::lookup);
+
+    std::cout << "unordered_map<std::string>: " << map << " ns/lookup\n";
+    std::cout << "perfect hash:               " << perfect << " ns/lookup\n";
+    return 0;
+}
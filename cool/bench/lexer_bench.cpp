@@ -0,0 +1,88 @@
+#include "lexer/lexer.hpp"
+#include "lexer/scan.hpp"
+#include "lexer/source_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+
+/* Lexing throughput in MB/s for every scanning kernel the CPU supports.
+ *
+ * Usage: lexer_bench [file.cl] [size in MB]
+ * Without a file a synthetic program of the given size (default 32 MB) is generated.
+ */
+namespace {
+using namespace cool::compiler::lexer;
+
+std::string synthetic_source(const std::size_t bytes)
+{
+    std::string source;
+    source.reserve(bytes + 512);
+    for (int i = 0; source.size() < bytes; ++i)
+    {
+        const std::string n = std::to_string(i);
+        source += "var counter_" + n + ": int = 1234567;\n";
+        source += "val message_" + n + ": string = \"a string literal that spans a few words\";\n";
+        source += "fn compute_" + n + "(first_value: int, second_value: int) -> int {\n";
+        source += "    while (first_value < 100000000) {\n";
+        source += "        first_value = first_value * 31 + second_value % 17;\n";
+        source += "    }\n";
+        source += "    return first_value;\n";
+        source += "}\n\n";
+    }
+    return source;
+}
+
+double lex_seconds(const std::string_view source, std::size_t &token_count)
+{
+    const auto start = std::chrono::steady_clock::now();
+    Lexer      lexer{source};
+    lexer.scan_tokens();
+    const auto stop = std::chrono::steady_clock::now();
+    token_count     = lexer.tokens.size();
+    return std::chrono::duration<double>(stop - start).count();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::optional<SourceBuffer> file;
+    std::string                 generated;
+    std::string_view            source;
+    if (argc > 1 && std::string(argv[1]).find(".cl") != std::string::npos)
+    {
+        file = SourceBuffer::map(argv[1]);
+        if (!file)
+        {
+            std::cerr << "Could not map " << argv[1] << '\n';
+            return 1;
+        }
+        source = file->view();
+    }
+    else
+    {
+        const std::size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+        generated                   = synthetic_source(megabytes << 20);
+        source                      = generated;
+    }
+
+    const double megabytes = static_cast<double>(source.size()) / (1 << 20);
+    std::cout << "input: " << megabytes << " MB\n";
+    for (const scan::Level level : {scan::Level::SCALAR, scan::Level::SSE2, scan::Level::AVX2})
+    {
+        if (!scan::supported(level))
+            continue;
+        scan::select(level);
+        double      best   = 1e300;
+        std::size_t tokens = 0;
+        for (int run = 0; run < 5; ++run)
+            best = std::min(best, lex_seconds(source, tokens));
+        std::cout << scan::level_name(level) << ": " << megabytes / best << " MB/s (" << tokens
+                  << " tokens, best of 5)\n";
+    }
+    scan::select(scan::best_level());
+    return 0;
+}
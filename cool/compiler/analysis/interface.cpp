@@ -0,0 +1,86 @@
+#include "interface.hpp"
+
+#include "../ast/visitor.hpp"
+
+#include <string_view>
+
+namespace cool::compiler::analysis {
+namespace {
+// an undeclared type is left to inference, written as `?`
+std::string_view type_name(const lexer::TokenStream &tokens, const lexer::TokenIndex type)
+{
+    return type == lexer::NO_TOKEN ? std::string_view{"?"} : tokens.lexeme(type);
+}
+
+void describe(const lexer::TokenStream &tokens, const ast::Function &function, std::string &out)
+{
+    out += "fun ";
+    out += tokens.lexeme(function.name);
+    out += '(';
+    for (std::size_t i = 0; i < function.params.size(); ++i)
+    {
+        if (i > 0)
+            out += ", ";
+        out += tokens.lexeme(function.params[i].first);
+        out += ": ";
+        out += type_name(tokens, function.params[i].second);
+    }
+    out += "): ";
+    out += type_name(tokens, function.return_type);
+    out += '\n';
+}
+
+void describe(const lexer::TokenStream &tokens, const ast::VarDecl &var, std::string &out)
+{
+    out += var.immutable ? "val " : "var ";
+    out += tokens.lexeme(var.name);
+    out += ": ";
+    out += type_name(tokens, var.type);
+    out += '\n';
+}
+} // namespace
+
+std::string describe_interface(const lexer::TokenStream &tokens, const ast::StmtList &statements)
+{
+    std::string out;
+    for (const ast::Stmt *stmt : statements)
+    {
+        if (const auto *function = ast::as<ast::Function>(stmt))
+        {
+            describe(tokens, *function, out);
+        }
+        else if (const auto *var = ast::as<ast::VarDecl>(stmt))
+        {
+            describe(tokens, *var, out);
+        }
+        else if (const auto *klass = ast::as<ast::Class>(stmt))
+        {
+            out += "class ";
+            out += tokens.lexeme(klass->name);
+            if (klass->parent != lexer::NO_TOKEN)
+            {
+                out += " < ";
+                out += tokens.lexeme(klass->parent);
+            }
+            out += '\n';
+            for (const ast::Stmt *attribute : klass->attributes)
+            {
+                if (const auto *field = ast::as<ast::VarDecl>(attribute))
+                {
+                    out += "  ";
+                    describe(tokens, *field, out);
+                }
+            }
+            for (const ast::Stmt *method : klass->methods)
+            {
+                if (const auto *body = ast::as<ast::Function>(method))
+                {
+                    out += "  ";
+                    describe(tokens, *body, out);
+                }
+            }
+        }
+    }
+    return out;
+}
+} // namespace cool::compiler::analysis
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../ast/stmt.hpp"
+#include "../lexer/token_stream.hpp"
+
+#include <string>
+
+namespace cool::compiler::analysis {
+/* The exported interface of a compilation unit: its top-level functions, classes and globals
+ * with their declared signatures, one declaration per line in source order. Two units with
+ * the same interface can be used interchangeably by anything that only names their
+ * declarations, which is what the compile cache records next to the bytecode.
+ */
+std::string describe_interface(const lexer::TokenStream &tokens, const ast::StmtList &statements);
+} // namespace cool::compiler::analysis
@@ -0,0 +1,434 @@
+#include "resolver.hpp"
+
+#include "../ast/visitor.hpp"
+#include "../compiler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace cool::compiler::analysis {
+lexer::TokenIndex Resolver::Local::declaration() const
+{
+    if (const auto *var = ast::as<ast::VarDecl>(node))
+        return var->name;
+    if (const auto *fn = ast::as<ast::Function>(node))
+        return param < 0 ? fn->name : fn->params[param].first;
+    return lexer::NO_TOKEN;
+}
+
+Resolver::Resolver(const lexer::TokenStream &tokens)
+    : tokens{tokens}, this_symbol{tokens.find_symbol("this")}
+{
+}
+
+void Resolver::resolve(ast::StmtList &program)
+{
+    declare_globals(program);
+    begin_function(nullptr, nullptr);
+
+    // functions and classes first, in the order CodeGenerator::generate compiles them
+    for (ast::Stmt *stmt : program)
+    {
+        if (auto *fn = ast::as<ast::Function>(stmt))
+            function(*fn, nullptr);
+        else if (auto *klass = ast::as<ast::Class>(stmt))
+            class_declaration(*klass);
+    }
+    for (ast::Stmt *stmt : program)
+    {
+        if (stmt != nullptr && stmt->kind != ast::StmtKind::FUNCTION &&
+            stmt->kind != ast::StmtKind::CLASS)
+            statement(stmt);
+    }
+    end_function();
+}
+
+// numbered like CodeGenerator::declare_globals, which reports the names it rejects
+void Resolver::declare_globals(const ast::StmtList &program)
+{
+    for (const ast::Stmt *stmt : program)
+    {
+        lexer::TokenIndex name = lexer::NO_TOKEN;
+        if (const auto *var = ast::as<ast::VarDecl>(stmt))
+            name = var->name;
+        else if (const auto *fn = ast::as<ast::Function>(stmt))
+            name = fn->name;
+        else if (const auto *klass = ast::as<ast::Class>(stmt))
+            name = klass->name;
+        if (name == lexer::NO_TOKEN)
+            continue;
+
+        if (globals.size() > UINT16_MAX)
+            return;
+        const auto global = static_cast<std::uint16_t>(globals.size());
+        if (!globals.try_emplace(tokens.symbol(name), Global{global, name}).second)
+            continue;
+        if (const auto *klass = ast::as<ast::Class>(stmt))
+            classes.emplace(tokens.symbol(name), klass);
+    }
+}
+
+// parent fields first, a field redeclared by a subclass keeps the slot it inherited
+const Resolver::Members &Resolver::members_of(const ast::Class &node)
+{
+    if (const auto it = members.find(&node); it != members.end())
+        return it->second;
+    members[&node]; // empty while the parents are laid out, which ends a cyclic chain
+
+    Members layout;
+    if (node.parent != lexer::NO_TOKEN)
+    {
+        if (const auto parent = classes.find(tokens.symbol(node.parent)); parent != classes.end())
+            layout = members_of(*parent->second);
+    }
+    for (const ast::Stmt *attribute : node.attributes)
+    {
+        const auto *field = ast::as<ast::VarDecl>(attribute);
+        if (field == nullptr)
+            continue;
+        const lexer::Symbol name = tokens.symbol(field->name);
+        if (std::find(layout.fields.begin(), layout.fields.end(), name) == layout.fields.end())
+            layout.fields.push_back(name);
+    }
+    for (const ast::Stmt *method : node.methods)
+        if (const auto *fn = ast::as<ast::Function>(method))
+            layout.methods.push_back(tokens.symbol(fn->name));
+    return members[&node] = std::move(layout);
+}
+
+void Resolver::function(ast::Function &node, const Members *klass)
+{
+    begin_function(&node, klass);
+    if (klass != nullptr)
+        declare(this_symbol, nullptr);
+    for (std::size_t i = 0; i < node.params.size(); ++i)
+        declare(tokens.symbol(node.params[i].first), &node, static_cast<int>(i));
+
+    if (auto *body = ast::as<ast::Block>(node.body))
+    {
+        for (ast::Stmt *stmt : body->statements)
+            statement(stmt);
+    }
+    else
+    {
+        statement(node.body);
+    }
+    end_function();
+}
+
+// the field initializers run in a method of the class, so they see its members
+void Resolver::class_declaration(ast::Class &node)
+{
+    const Members &layout = members_of(node);
+    node.fields.assign(layout.fields.begin(), layout.fields.end());
+    begin_function(nullptr, &layout);
+    declare(this_symbol, nullptr);
+    for (ast::Stmt *attribute : node.attributes)
+        if (auto *field = ast::as<ast::VarDecl>(attribute))
+            expr(field->initializer);
+    end_function();
+
+    for (ast::Stmt *method : node.methods)
+        if (auto *fn = ast::as<ast::Function>(method))
+            function(*fn, &layout);
+}
+
+void Resolver::statement(ast::Stmt *stmt)
+{
+    if (stmt != nullptr)
+        visit(*stmt, *this);
+}
+
+// the branches and bodies of control flow get a scope of their own, as in CodeGenerator
+void Resolver::scoped(ast::Stmt *stmt)
+{
+    begin_scope();
+    statement(stmt);
+    end_scope();
+}
+
+// the initializer is resolved before the name is in scope, it may refer to a shadowed one
+void Resolver::operator()(ast::VarDecl &stmt)
+{
+    expr(stmt.initializer);
+    if (!is_top_level())
+        declare(tokens.symbol(stmt.name), &stmt);
+}
+
+void Resolver::operator()(ast::ExprStatement &stmt)
+{
+    expr(stmt.expression);
+}
+
+void Resolver::operator()(ast::If &stmt)
+{
+    expr(stmt.condition);
+    scoped(stmt.then_branch);
+    scoped(stmt.else_branch);
+}
+
+void Resolver::operator()(ast::While &stmt)
+{
+    expr(stmt.condition);
+    scoped(stmt.body);
+}
+
+void Resolver::operator()(ast::Return &stmt)
+{
+    expr(stmt.expression);
+}
+
+void Resolver::operator()(ast::Print &stmt)
+{
+    expr(stmt.expression);
+}
+
+// a nested function is a local, in scope in its own body so that it can call itself
+void Resolver::operator()(ast::Function &stmt)
+{
+    declare(tokens.symbol(stmt.name), &stmt);
+    function(stmt, nullptr);
+}
+
+void Resolver::operator()(ast::Class &stmt)
+{
+    error(stmt.name, "Classes can only be declared at the top level.");
+}
+
+void Resolver::operator()(ast::Block &stmt)
+{
+    begin_scope();
+    for (ast::Stmt *s : stmt.statements)
+        statement(s);
+    end_scope();
+}
+
+void Resolver::expr(ast::Expr *expr)
+{
+    if (expr != nullptr)
+        visit(*expr, *this);
+}
+
+void Resolver::operator()(ast::Binary &expr)
+{
+    this->expr(expr.lhs);
+    this->expr(expr.rhs);
+}
+
+void Resolver::operator()(ast::Unary &expr)
+{
+    this->expr(expr.operand);
+}
+
+void Resolver::operator()(ast::Logical &expr)
+{
+    this->expr(expr.lhs);
+    this->expr(expr.rhs);
+}
+
+void Resolver::operator()(ast::Literal &) {}
+
+void Resolver::operator()(ast::Grouping &expr)
+{
+    this->expr(expr.expr);
+}
+
+void Resolver::operator()(ast::Variable &expr)
+{
+    bind(expr.name, expr.binding);
+    if (expr.binding.kind == ast::Binding::Kind::METHOD)
+        error(expr.name, "Methods can only be called, not used as values.");
+}
+
+// only `this` is captured by value, any other local something assigns is boxed
+void Resolver::operator()(ast::Assignment &expr)
+{
+    this->expr(expr.value);
+    Local *local = bind(expr.name, expr.binding);
+    if (local != nullptr)
+        local->assigned = true;
+    if (expr.binding.kind == ast::Binding::Kind::METHOD)
+        error(expr.name, "Cannot assign to a method.");
+    else if (expr.binding.kind == ast::Binding::Kind::UPVALUE && local->node == nullptr)
+        error(expr.name, "Cannot assign to a captured variable.");
+}
+
+// `method(...)` inside a class invokes on `this`
+void Resolver::operator()(ast::Call &expr)
+{
+    if (auto *callee = ast::as<ast::Variable>(expr.callee))
+        bind(callee->name, callee->binding);
+    else
+        this->expr(expr.callee);
+    for (ast::Expr *argument : expr.arguments)
+        this->expr(argument);
+}
+
+void Resolver::operator()(ast::Get &expr)
+{
+    this->expr(expr.object);
+}
+
+void Resolver::operator()(ast::Set &expr)
+{
+    this->expr(expr.object);
+    this->expr(expr.value);
+}
+
+void Resolver::begin_function(ast::Function *node, const Members *klass)
+{
+    scopes.push_back({node, klass});
+}
+
+void Resolver::end_function()
+{
+    std::vector<Local> &locals = scopes.back().locals;
+    for (auto it = locals.rbegin(); it != locals.rend(); ++it)
+        close(*it);
+    scopes.pop_back();
+}
+
+void Resolver::begin_scope()
+{
+    scopes.back().depth++;
+}
+
+void Resolver::end_scope()
+{
+    Scope &scope = scopes.back();
+    scope.depth--;
+    while (!scope.locals.empty() && scope.locals.back().depth > scope.depth)
+    {
+        close(scope.locals.back());
+        scope.locals.pop_back();
+    }
+}
+
+void Resolver::declare(const lexer::Symbol name, ast::Stmt *node, const int param)
+{
+    scopes.back().locals.push_back({name, scopes.back().depth, node, param});
+}
+
+// the local `name` refers to, if any
+Resolver::Local *Resolver::bind(const lexer::TokenIndex name, ast::Binding &binding)
+{
+    using Kind                 = ast::Binding::Kind;
+    const lexer::Symbol symbol = tokens.symbol(name);
+    for (std::size_t scope = scopes.size(); scope-- > 0;)
+    {
+        std::vector<Local> &locals = scopes[scope].locals;
+        for (std::size_t i = locals.size(); i-- > 0;)
+        {
+            Local &local = locals[i];
+            if (local.name != symbol)
+                continue;
+            const auto depth = static_cast<std::uint16_t>(scopes.size() - 1 - scope);
+            if (depth == 0)
+            {
+                binding = {Kind::LOCAL, false, 0, static_cast<std::uint32_t>(i),
+                           local.declaration()};
+            }
+            else
+            {
+                binding = {Kind::UPVALUE, false, depth,
+                           capture(scope, static_cast<std::uint32_t>(i)), local.declaration()};
+                local.captured = true;
+                // a closure that captures its own name reads it before it is stored
+                for (std::size_t inner = scope + 1; inner < scopes.size(); ++inner)
+                    local.recursive = local.recursive || scopes[inner].node == local.node;
+            }
+            local.uses.push_back(&binding);
+            return &local;
+        }
+    }
+
+    // a member of the class of the method around the use, nested functions capture its `this`
+    std::size_t scope = scopes.size();
+    while (scope > 0 && scopes[scope - 1].members == nullptr)
+        --scope;
+    if (scope-- > 0)
+    {
+        const Members *klass  = scopes[scope].members;
+        const auto     depth  = static_cast<std::uint16_t>(scopes.size() - 1 - scope);
+        const auto     field  = std::find(klass->fields.begin(), klass->fields.end(), symbol);
+        const bool     method = std::find(klass->methods.begin(), klass->methods.end(), symbol) !=
+                            klass->methods.end();
+        if (field != klass->fields.end())
+            binding = {Kind::FIELD, false, depth,
+                       static_cast<std::uint32_t>(field - klass->fields.begin())};
+        else if (method)
+            binding = {Kind::METHOD, false, depth};
+        if (field != klass->fields.end() || method)
+        {
+            if (depth > 0)
+                binding.receiver = capture(scope, 0);
+            return nullptr;
+        }
+    }
+
+    if (const auto it = globals.find(symbol); it != globals.end())
+    {
+        binding = {Kind::GLOBAL, false, 0, it->second.index, it->second.declaration};
+    }
+    else
+    {
+        binding = {Kind::UNDEFINED};
+        error(name, "Undefined variable.");
+    }
+    return nullptr;
+}
+
+/* Makes register `slot` of the function of `scopes[scope]` an upvalue of every function
+ * nested between it and the innermost one, each capturing it from the one around it, and
+ * returns its index among the upvalues of the innermost.
+ */
+std::uint32_t Resolver::capture(const std::size_t scope, std::uint32_t slot)
+{
+    const lexer::TokenIndex declaration  = scopes[scope].locals[slot].declaration();
+    bool                    from_upvalue = false;
+    for (std::size_t inner = scope + 1; inner < scopes.size(); ++inner)
+    {
+        std::pmr::vector<ast::Upvalue> &upvalues = scopes[inner].node->upvalues;
+        const auto                      it       = std::find_if(
+                upvalues.begin(), upvalues.end(), [&](const ast::Upvalue &upvalue) {
+                    return upvalue.from_upvalue == from_upvalue && upvalue.slot == slot;
+                });
+        if (it == upvalues.end())
+        {
+            upvalues.push_back({from_upvalue, slot, declaration});
+            slot = static_cast<std::uint32_t>(upvalues.size() - 1);
+        }
+        else
+        {
+            slot = static_cast<std::uint32_t>(it - upvalues.begin());
+        }
+        from_upvalue = true;
+    }
+    return slot;
+}
+
+// once nothing more can use `local`, decides whether it lives in a cell; `this` never does
+void Resolver::close(Local &local)
+{
+    const bool boxed = local.node != nullptr && local.captured &&
+                       (local.assigned || local.recursive);
+    if (auto *var = ast::as<ast::VarDecl>(local.node))
+        var->boxed = boxed;
+    else if (auto *fn = ast::as<ast::Function>(local.node); fn != nullptr && local.param >= 0)
+        fn->boxed_params[local.param] = boxed;
+    else if (fn != nullptr)
+        fn->boxed = boxed;
+    for (ast::Binding *use : local.uses)
+        use->boxed = boxed;
+}
+
+void Resolver::error(const lexer::TokenIndex token, const std::string &message) const
+{
+    Compiler::error(tokens.token(token), message);
+}
+
+bool Resolver::is_top_level() const
+{
+    return scopes.size() == 1 && scopes.back().depth == 0;
+}
+} // namespace cool::compiler::analysis
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../ast/stmt.hpp"
+#include "../lexer/token_stream.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cool::compiler::analysis {
+/* Binds every name a compilation unit reads or assigns to what it refers to (ast::Binding),
+ * so the passes after it never look a name up again. Names are compared by symbol and
+ * resolve, innermost first, to a local of the function they are used in, a local of an
+ * enclosing function, a member of the class of the method they are used in, then a global.
+ * Everything is numbered as CodeGenerator lays it out: a local by its register, `this`
+ * first, then the parameters and the block locals live at that point in declaration order,
+ * a field by its instance slot and a global by its index.
+ *
+ * A local of an enclosing function becomes an upvalue of every function between it and the
+ * use, which copy it when they are created. A captured local that anything assigns (or a
+ * nested function that captures its own name) is boxed: its register holds a cell that the
+ * closures share. It reports the names that refer to nothing and the uses of a method as
+ * a value, before any pass may drop the code they are in.
+ */
+struct Resolver
+{
+    struct Local
+    {
+        lexer::Symbol               name;
+        int                         depth;
+        ast::Stmt                  *node      = nullptr; // the declaration, nullptr for `this`
+        int                         param     = -1;      // its position among those of `node`
+        bool                        captured  = false;
+        bool                        assigned  = false;
+        bool                        recursive = false;   // a function its own body captures
+        std::vector<ast::Binding *> uses{};              // to be told whether it is boxed
+
+        [[nodiscard]] lexer::TokenIndex declaration() const;
+    };
+
+    // the members of a class, its fields in slot order (see ast::Class::fields)
+    struct Members
+    {
+        std::vector<lexer::Symbol> fields; // of every slot
+        std::vector<lexer::Symbol> methods;
+    };
+
+    // a function being resolved, the script and the field initializers of a class included
+    struct Scope
+    {
+        ast::Function     *node    = nullptr; // a function that may capture
+        const Members     *members = nullptr; // of a method's class
+        std::vector<Local> locals{};
+        int                depth = 0;
+    };
+
+    struct Global
+    {
+        std::uint16_t     index;
+        lexer::TokenIndex declaration;
+    };
+
+    const lexer::TokenStream                             &tokens;
+    lexer::Symbol                                         this_symbol;
+    std::unordered_map<lexer::Symbol, Global>             globals;
+    std::unordered_map<lexer::Symbol, const ast::Class *> classes;
+    std::unordered_map<const ast::Class *, Members>       members;
+    std::vector<Scope>                                    scopes; // the innermost last
+
+    explicit Resolver(const lexer::TokenStream &tokens);
+    void resolve(ast::StmtList &program);
+
+    // declarations
+    void           declare_globals(const ast::StmtList &program);
+    const Members &members_of(const ast::Class &node);
+    void           function(ast::Function &node, const Members *klass);
+    void           class_declaration(ast::Class &node);
+
+    // statements
+    void statement(ast::Stmt *stmt);
+    void scoped(ast::Stmt *stmt);
+    void operator()(ast::VarDecl &stmt);
+    void operator()(ast::ExprStatement &stmt);
+    void operator()(ast::If &stmt);
+    void operator()(ast::While &stmt);
+    void operator()(ast::Return &stmt);
+    void operator()(ast::Print &stmt);
+    void operator()(ast::Function &stmt);
+    void operator()(ast::Class &stmt);
+    void operator()(ast::Block &stmt);
+
+    // expressions
+    void expr(ast::Expr *expr);
+    void operator()(ast::Binary &expr);
+    void operator()(ast::Unary &expr);
+    void operator()(ast::Logical &expr);
+    void operator()(ast::Literal &expr);
+    void operator()(ast::Grouping &expr);
+    void operator()(ast::Variable &expr);
+    void operator()(ast::Assignment &expr);
+    void operator()(ast::Call &expr);
+    void operator()(ast::Get &expr);
+    void operator()(ast::Set &expr);
+
+    // scopes
+    void               begin_function(ast::Function *node, const Members *klass);
+    void               end_function();
+    void               begin_scope();
+    void               end_scope();
+    void               declare(lexer::Symbol name, ast::Stmt *node, int param = -1);
+    Local             *bind(lexer::TokenIndex name, ast::Binding &binding);
+    std::uint32_t      capture(std::size_t scope, std::uint32_t slot);
+    static void        close(Local &local);
+    void               error(lexer::TokenIndex token, const std::string &message) const;
+    [[nodiscard]] bool is_top_level() const;
+};
+} // namespace cool::compiler::analysis
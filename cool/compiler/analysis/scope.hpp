@@ -1 +0,0 @@
-#pragma once
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "type.hpp"
+
+namespace cool::compiler::analysis {
+const char *name_of(const Type type)
+{
+    switch (type)
+    {
+    case Type::INT:
+        return "int";
+    case Type::FLOAT:
+        return "float";
+    case Type::STRING:
+        return "string";
+    case Type::BOOL:
+        return "bool";
+    case Type::VOID:
+        return "void";
+    case Type::OBJECT:
+        return "object";
+    case Type::SELF_TYPE:
+        return "SELF_TYPE";
+    }
+    return "?";
+}
+
+bool is_primitive(const Type type)
+{
+    return type == Type::INT || type == Type::FLOAT || type == Type::STRING || type == Type::BOOL;
+}
+
+bool is_number(const Type type)
+{
+    return type == Type::INT || type == Type::FLOAT;
+}
+
+bool assignable(const Type from, const Type to)
+{
+    return from == to || (from == Type::INT && to == Type::FLOAT);
+}
+} // namespace cool::compiler::analysis
@@ -4,6 +4,15 @@ namespace cool::compiler::analysis {
 /* TODO, we will probably need to refactor this once we will have more types,
  * and also if we want to support user-defined types later.
  */
-enum class Type { INT, STRING, BOOL, VOID, OBJECT, SELF_TYPE };
+enum class Type { INT, FLOAT, STRING, BOOL, VOID, OBJECT, SELF_TYPE };
 
-}; // namespace cool::compiler::analysis
\ No newline at end of file
+// the name of a type as it is written in a declaration
+const char *name_of(Type type);
+
+// the types whose values the VM tells apart by their tag
+bool is_primitive(Type type);
+bool is_number(Type type);
+
+// a value of type `from` may be stored where `to` is declared, an int widens to a float
+bool assignable(Type from, Type to);
+} // namespace cool::compiler::analysis
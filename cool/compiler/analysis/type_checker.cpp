@@ -0,0 +1,730 @@
+#include "type_checker.hpp"
+
+#include "../ast/visitor.hpp"
+#include "../compiler.hpp"
+
+#include <utility>
+
+namespace cool::compiler::analysis {
+namespace {
+using StaticType = TypeChecker::StaticType;
+
+bool primitive(const StaticType type)
+{
+    return type && is_primitive(*type);
+}
+
+bool number(const StaticType type)
+{
+    return type && is_number(*type);
+}
+
+// both types known to the VM and a value of the one never stored as the other
+bool mismatched(const StaticType from, const StaticType to)
+{
+    return primitive(from) && primitive(to) && !assignable(*from, *to);
+}
+
+// whether evaluating `expr` may call a function, which may read any global
+bool calls(const ast::Expr *expr)
+{
+    if (expr == nullptr)
+        return false;
+    switch (expr->kind)
+    {
+    case ast::ExprKind::CALL:
+        return true;
+    case ast::ExprKind::BINARY: {
+        const auto *binary = ast::as<ast::Binary>(expr);
+        return calls(binary->lhs) || calls(binary->rhs);
+    }
+    case ast::ExprKind::LOGICAL: {
+        const auto *logical = ast::as<ast::Logical>(expr);
+        return calls(logical->lhs) || calls(logical->rhs);
+    }
+    case ast::ExprKind::UNARY:
+        return calls(ast::as<ast::Unary>(expr)->operand);
+    case ast::ExprKind::GROUPING:
+        return calls(ast::as<ast::Grouping>(expr)->expr);
+    case ast::ExprKind::ASSIGNMENT:
+        return calls(ast::as<ast::Assignment>(expr)->value);
+    case ast::ExprKind::GET:
+        return calls(ast::as<ast::Get>(expr)->object);
+    case ast::ExprKind::SET: {
+        const auto *set = ast::as<ast::Set>(expr);
+        return calls(set->object) || calls(set->value);
+    }
+    default:
+        return false;
+    }
+}
+
+// whether every path through `stmt` ends in a return, a function falling off its end
+// returns nil
+bool returns(const ast::Stmt *stmt)
+{
+    if (stmt == nullptr)
+        return false;
+    switch (stmt->kind)
+    {
+    case ast::StmtKind::RETURN:
+        return true;
+    case ast::StmtKind::WHILE: {
+        // nothing but a return leaves a `while (true)`
+        const auto *condition = ast::as<ast::Literal>(ast::as<ast::While>(stmt)->condition);
+        return condition != nullptr && condition->value == lexer::Literal{true};
+    }
+    case ast::StmtKind::IF: {
+        const auto *branch = ast::as<ast::If>(stmt);
+        return returns(branch->then_branch) && returns(branch->else_branch);
+    }
+    case ast::StmtKind::BLOCK:
+        for (const ast::Stmt *s : ast::as<ast::Block>(stmt)->statements)
+            if (returns(s))
+                return true;
+        return false;
+    default:
+        return false;
+    }
+}
+
+StaticType literal_type(const lexer::Literal &value)
+{
+    if (std::holds_alternative<std::int64_t>(value))
+        return Type::INT;
+    if (std::holds_alternative<double>(value))
+        return Type::FLOAT;
+    if (std::holds_alternative<std::string_view>(value))
+        return Type::STRING;
+    if (std::holds_alternative<bool>(value))
+        return Type::BOOL;
+    return std::nullopt;
+}
+
+std::string described(const StaticType type)
+{
+    return type ? name_of(*type) : "unknown";
+}
+} // namespace
+
+TypeChecker::TypeChecker(const lexer::TokenStream &tokens) : tokens{tokens} {}
+
+// the first pass reports errors, later ones only run until the proofs settle
+void TypeChecker::check(const ast::StmtList &program)
+{
+    declare_globals(program);
+    do
+    {
+        pass(program);
+        report = false;
+    } while (settle());
+}
+
+/* The globals declared before any top-level statement that is not a declaration, and whose
+ * initializers call nothing, are set before any function runs.
+ */
+void TypeChecker::declare_globals(const ast::StmtList &program)
+{
+    for (const ast::Stmt *stmt : program)
+        if (const auto *klass = ast::as<ast::Class>(stmt))
+            classes.try_emplace(tokens.symbol(klass->name), klass);
+
+    std::unordered_set<lexer::Symbol> globals;
+    bool                              prefix = true;
+    for (const ast::Stmt *stmt : program)
+    {
+        if (const auto *klass = ast::as<ast::Class>(stmt))
+        {
+            globals.insert(tokens.symbol(klass->name));
+            continue;
+        }
+        if (const auto *fn = ast::as<ast::Function>(stmt))
+        {
+            if (!globals.insert(tokens.symbol(fn->name)).second)
+                continue;
+            callables.try_emplace(fn->name, Callable{fn, declared_type(fn->return_type)});
+            for (const auto &[name, type] : fn->params)
+            {
+                const StaticType declared = declared_type(type);
+                declarations.try_emplace(name, Declaration{declared, primitive(declared)})
+                        .first->second.klass = class_named(type);
+            }
+            continue;
+        }
+
+        const auto *var = ast::as<ast::VarDecl>(stmt);
+        if (var == nullptr)
+        {
+            prefix = false;
+            continue;
+        }
+        if (!globals.insert(tokens.symbol(var->name)).second)
+            continue;
+        prefix              = prefix && !calls(var->initializer);
+        Declaration &global = declarations[var->name];
+        global.type         = declared_type(var->type);
+        global.proven       = primitive(global.type) && var->initializer != nullptr;
+        global.everywhere   = prefix;
+        global.immutable    = var->immutable;
+        global.klass        = class_named(var->type);
+    }
+}
+
+// functions and classes first, in the order CodeGenerator::generate compiles them
+void TypeChecker::pass(const ast::StmtList &program)
+{
+    initialized.clear();
+    for (const ast::Stmt *stmt : program)
+    {
+        if (const auto *fn = ast::as<ast::Function>(stmt))
+            function(*fn, nullptr);
+        else if (const auto *klass = ast::as<ast::Class>(stmt))
+            class_declaration(*klass);
+    }
+    for (const ast::Stmt *stmt : program)
+    {
+        if (stmt == nullptr || stmt->kind == ast::StmtKind::FUNCTION ||
+            stmt->kind == ast::StmtKind::CLASS)
+            continue;
+        statement(stmt);
+        if (const auto *var = ast::as<ast::VarDecl>(stmt))
+            initialized.insert(var->name);
+    }
+}
+
+// drops what the pass disproved, true when that may change what other reads prove
+bool TypeChecker::settle()
+{
+    bool       changed = false;
+    const auto drop    = [&](bool &fact) {
+        changed = changed || fact;
+        fact    = false;
+    };
+    for (auto &[token, callable] : callables)
+    {
+        if (!callable.closed)
+            for (const auto &[name, type] : callable.node->params)
+                drop(declarations.at(name).proven);
+        if (!callable.closed || !callable.returned)
+            drop(callable.proven);
+        callable.returned = true;
+    }
+    for (auto &[token, declaration] : declarations)
+    {
+        if (!declaration.stored)
+            drop(declaration.proven);
+        declaration.stored = true;
+    }
+    return changed;
+}
+
+void TypeChecker::function(const ast::Function &node, const ast::Class *klass)
+{
+    const auto it   = klass == nullptr ? callables.find(node.name) : callables.end();
+    Callable  *self = it != callables.end() && it->second.node == &node ? &it->second : nullptr;
+
+    const Context outer = context;
+    context             = {node.name, self, declared_type(node.return_type),
+                           klass != nullptr ? klass : outer.klass,
+                           klass != nullptr && lexeme(node.name) == "init"};
+    function_depth++;
+
+    // only the parameters of a top-level function see every argument passed to them
+    for (const auto &[name, type] : node.params)
+    {
+        const StaticType declared = declared_type(type);
+        declarations
+                .try_emplace(name, Declaration{declared, self != nullptr && primitive(declared)})
+                .first->second.klass = class_named(type);
+    }
+
+    if (const auto *body = ast::as<ast::Block>(node.body))
+    {
+        for (const ast::Stmt *stmt : body->statements)
+            statement(stmt);
+    }
+    else
+    {
+        statement(node.body);
+    }
+    if (self != nullptr && !returns(node.body))
+        self->returned = false;
+    const bool value = node.return_type != lexer::NO_TOKEN &&
+                       tokens.type(node.return_type) != lexer::VOID;
+    if (value && !returns(node.body))
+        error(node.name, "Missing return in a function returning " +
+                                 std::string(lexeme(node.return_type)) + ".");
+
+    function_depth--;
+    context = outer;
+}
+
+// the field initializers run in a method of the class
+void TypeChecker::class_declaration(const ast::Class &node)
+{
+    const Context outer = context;
+    context             = {};
+    function_depth++;
+    for (const ast::Stmt *attribute : node.attributes)
+    {
+        const auto *field = ast::as<ast::VarDecl>(attribute);
+        if (field == nullptr)
+            continue;
+        expr(field->initializer);
+        const StaticType declared = declared_type(field->type);
+        if (field->initializer != nullptr && mismatched(field->initializer->type, declared))
+            error(field->name, "Cannot assign a value of type " +
+                                       described(field->initializer->type) + " to '" +
+                                       std::string(lexeme(field->name)) + "' of type " +
+                                       described(declared) + ".");
+    }
+    context = outer;
+    function_depth--;
+
+    for (const ast::Stmt *method : node.methods)
+        if (const auto *fn = ast::as<ast::Function>(method))
+            function(*fn, &node);
+}
+
+void TypeChecker::statement(const ast::Stmt *stmt)
+{
+    if (stmt != nullptr)
+        visit(*stmt, *this);
+}
+
+// the initializer is checked before the declaration, as CodeGenerator compiles it; an int
+// literal initializing a float is stored as a float constant
+void TypeChecker::operator()(const ast::VarDecl &stmt)
+{
+    expr(stmt.initializer);
+    const StaticType type    = declared_type(stmt.type);
+    const auto      *literal = ast::as<ast::Literal>(stmt.initializer);
+    const bool       widened = literal != nullptr && type == Type::FLOAT &&
+                         std::holds_alternative<std::int64_t>(literal->value);
+    if (stmt.initializer != nullptr && !widened && mismatched(stmt.initializer->type, type))
+        error(stmt.name, "Cannot assign a value of type " + described(stmt.initializer->type) +
+                                 " to '" + std::string(lexeme(stmt.name)) + "' of type " +
+                                 described(type) + ".");
+
+    const auto [it, inserted] = declarations.try_emplace(stmt.name);
+    if (inserted)
+    {
+        it->second.type      = type;
+        it->second.proven    = primitive(type) && stmt.initializer != nullptr;
+        it->second.immutable = stmt.immutable;
+        it->second.klass     = class_named(stmt.type);
+    }
+    store(&it->second, stmt.initializer, widened ? StaticType(Type::FLOAT) : std::nullopt);
+}
+
+void TypeChecker::operator()(const ast::ExprStatement &stmt)
+{
+    expr(stmt.expression);
+}
+
+void TypeChecker::operator()(const ast::If &stmt)
+{
+    expr(stmt.condition);
+    statement(stmt.then_branch);
+    statement(stmt.else_branch);
+}
+
+void TypeChecker::operator()(const ast::While &stmt)
+{
+    expr(stmt.condition);
+    statement(stmt.body);
+}
+
+void TypeChecker::operator()(const ast::Return &stmt)
+{
+    expr(stmt.expression);
+    const ast::Expr *value = stmt.expression;
+    if (value != nullptr && mismatched(value->type, context.returns))
+        error(context.name, "Cannot return a value of type " + described(value->type) +
+                                    " from a function returning " + described(context.returns) +
+                                    ".");
+    if (context.callable != nullptr &&
+        (value == nullptr || !value->proven || value->type != context.returns))
+        context.callable->returned = false;
+}
+
+void TypeChecker::operator()(const ast::Print &stmt)
+{
+    expr(stmt.expression);
+}
+
+void TypeChecker::operator()(const ast::Function &stmt)
+{
+    function(stmt, nullptr);
+}
+
+void TypeChecker::operator()(const ast::Class &) {} // only valid at the top level
+
+void TypeChecker::operator()(const ast::Block &stmt)
+{
+    for (const ast::Stmt *s : stmt.statements)
+        statement(s);
+}
+
+void TypeChecker::expr(ast::Expr *expr)
+{
+    if (expr != nullptr)
+        visit(*expr, *this);
+}
+
+void TypeChecker::operator()(ast::Binary &expr)
+{
+    this->expr(expr.lhs);
+    this->expr(expr.rhs);
+    const lexer::TokenType op      = tokens.type(expr.op);
+    const StaticType       lhs     = expr.lhs->type;
+    const StaticType       rhs     = expr.rhs->type;
+    const bool             numbers = number(lhs) && number(rhs);
+    const bool             strings = lhs == Type::STRING && rhs == Type::STRING;
+    const bool             known   = primitive(lhs) && primitive(rhs);
+    const bool             proven  = expr.lhs->proven && expr.rhs->proven;
+
+    switch (op)
+    {
+    case lexer::PLUS:
+    case lexer::MINUS:
+    case lexer::STAR:
+    case lexer::SLASH:
+    case lexer::PERCENT:
+    case lexer::ASTRIX:
+        if (op == lexer::PLUS && strings)
+        {
+            expr.type   = Type::STRING;
+            expr.proven = proven;
+            return;
+        }
+        if (known && !numbers)
+            error(expr.op, op == lexer::PLUS ? "Operands must be two numbers or two strings."
+                                             : "Operands must be numbers.");
+        expr.type = std::nullopt;
+        if (numbers)
+            expr.type = lhs == Type::INT && rhs == Type::INT && op != lexer::ASTRIX ? Type::INT
+                                                                                    : Type::FLOAT;
+        expr.proven = numbers && proven;
+        return;
+    case lexer::LESS:
+    case lexer::LESS_EQUAL:
+    case lexer::GREATER:
+    case lexer::GREATER_EQUAL:
+        if (known && !numbers)
+            error(expr.op, "Operands must be numbers.");
+        break;
+    default:
+        break;
+    }
+    // a comparison produces a bool or fails
+    expr.type   = Type::BOOL;
+    expr.proven = true;
+}
+
+void TypeChecker::operator()(ast::Unary &expr)
+{
+    this->expr(expr.operand);
+    if (tokens.type(expr.op) != lexer::MINUS)
+    {
+        expr.type   = Type::BOOL;
+        expr.proven = true;
+        return;
+    }
+    const StaticType operand = expr.operand->type;
+    if (primitive(operand) && !number(operand))
+        error(expr.op, "Operand must be a number.");
+    expr.type   = number(operand) ? operand : std::nullopt;
+    expr.proven = number(operand) && expr.operand->proven;
+}
+
+// the result is one of the operands
+void TypeChecker::operator()(ast::Logical &expr)
+{
+    this->expr(expr.lhs);
+    this->expr(expr.rhs);
+    const bool same = expr.lhs->type == expr.rhs->type;
+    expr.type       = same ? expr.lhs->type : std::nullopt;
+    expr.proven     = same && expr.type && expr.lhs->proven && expr.rhs->proven;
+}
+
+void TypeChecker::operator()(ast::Literal &expr)
+{
+    expr.type   = literal_type(expr.value);
+    expr.proven = expr.type.has_value();
+}
+
+void TypeChecker::operator()(ast::Grouping &expr)
+{
+    this->expr(expr.expr);
+    expr.type   = expr.expr->type;
+    expr.proven = expr.expr->proven;
+}
+
+// a function read as a value may be called with anything; a local is stored before any read
+// of it runs, a closure is only created after the locals it captures
+void TypeChecker::operator()(ast::Variable &expr)
+{
+    const ast::Binding &binding = expr.binding;
+    if (Callable *target = callable(binding))
+        target->closed = false;
+
+    const bool         local    = binding.kind == ast::Binding::Kind::LOCAL ||
+                                  binding.kind == ast::Binding::Kind::UPVALUE;
+    const Declaration *declared = declaration(binding);
+    expr.type                   = declared != nullptr ? declared->type : std::nullopt;
+    expr.proven                 = declared != nullptr && declared->proven &&
+                  (local || declared->everywhere ||
+                   (function_depth == 0 && initialized.count(binding.declaration) != 0));
+}
+
+void TypeChecker::operator()(ast::Assignment &expr)
+{
+    this->expr(expr.value);
+    if (Callable *target = callable(expr.binding))
+        target->closed = false;
+
+    Declaration *declared = declaration(expr.binding);
+    if (declared != nullptr && declared->immutable)
+        error(expr.name, "Cannot assign to a val.");
+    else if (declared != nullptr && mismatched(expr.value->type, declared->type))
+        error(expr.name, "Cannot assign a value of type " + described(expr.value->type) +
+                                 " to '" + std::string(lexeme(expr.name)) + "' of type " +
+                                 described(declared->type) + ".");
+    store(declared, expr.value);
+    if (expr.binding.kind == ast::Binding::Kind::FIELD)
+        store_field(context.klass, expr.name, expr.value);
+    expr.type   = expr.value->type;
+    expr.proven = expr.value->proven;
+}
+
+// a top-level function called by name passes its arguments to its parameters
+void TypeChecker::operator()(ast::Call &expr)
+{
+    Callable *target = nullptr;
+    if (auto *callee = ast::as<ast::Variable>(expr.callee))
+        target = callable(callee->binding);
+    if (target == nullptr)
+        this->expr(expr.callee);
+    for (ast::Expr *argument : expr.arguments)
+        this->expr(argument);
+
+    expr.type   = std::nullopt;
+    expr.proven = false;
+    if (const auto *member = ast::as<ast::Get>(expr.callee))
+    {
+        const ast::Class *klass = class_of(member->object);
+        if (klass != nullptr && !responds(klass, member->name))
+            error(member->name, "Undefined method '" + std::string(lexeme(member->name)) +
+                                        "' for an instance of " +
+                                        std::string(lexeme(klass->name)) + ".");
+    }
+    if (target == nullptr)
+        return;
+    expr.type                        = target->returns;
+    const ast::ParamList &parameters = target->node->params;
+    if (parameters.size() != expr.arguments.size())
+    {
+        error(expr.paren, "Expected " + std::to_string(parameters.size()) +
+                                  " arguments but got " + std::to_string(expr.arguments.size()) +
+                                  ".");
+        return;
+    }
+    for (std::size_t i = 0; i < parameters.size(); ++i)
+    {
+        const ast::Expr *argument  = expr.arguments[i];
+        Declaration     &parameter = declarations.at(parameters[i].first);
+        if (mismatched(argument->type, parameter.type))
+            error(expr.paren, "Cannot pass a value of type " + described(argument->type) +
+                                      " as parameter '" +
+                                      std::string(lexeme(parameters[i].first)) + "' of type " +
+                                      described(parameter.type) + ".");
+        store(&parameter, argument);
+    }
+    expr.proven = target->closed && target->proven && primitive(target->returns);
+}
+
+// typed as the field is declared on the object's class, never proven: the VM does not check
+// what a field is set to
+void TypeChecker::operator()(ast::Get &expr)
+{
+    this->expr(expr.object);
+    const ast::VarDecl *declared = field(class_of(expr.object), expr.name);
+    expr.type   = declared != nullptr ? declared_type(declared->type) : std::nullopt;
+    expr.proven = false;
+}
+
+void TypeChecker::operator()(ast::Set &expr)
+{
+    this->expr(expr.object);
+    this->expr(expr.value);
+    store_field(class_of(expr.object), expr.name, expr.value);
+    expr.type   = expr.value->type;
+    expr.proven = expr.value->proven;
+}
+
+TypeChecker::Declaration *TypeChecker::declaration(const ast::Binding &binding)
+{
+    if (binding.kind != ast::Binding::Kind::LOCAL && binding.kind != ast::Binding::Kind::UPVALUE &&
+        binding.kind != ast::Binding::Kind::GLOBAL)
+        return nullptr;
+    const auto it = declarations.find(binding.declaration);
+    return it != declarations.end() ? &it->second : nullptr;
+}
+
+TypeChecker::Callable *TypeChecker::callable(const ast::Binding &binding)
+{
+    if (binding.kind != ast::Binding::Kind::GLOBAL)
+        return nullptr;
+    const auto it = callables.find(binding.declaration);
+    return it != callables.end() ? &it->second : nullptr;
+}
+
+// a store of anything but a proven value of the declared type disproves the declaration
+void TypeChecker::store(Declaration *to, const ast::Expr *value, const StaticType coerced)
+{
+    if (to == nullptr)
+        return;
+    const StaticType type = coerced ? coerced
+                                    : value != nullptr && value->proven ? value->type
+                                                                        : std::nullopt;
+    if (!type || type != to->type)
+        to->stored = false;
+}
+
+// a store into field `name` of an object declared as `klass`, an init method sets the `val`s
+void TypeChecker::store_field(const ast::Class *klass, const lexer::TokenIndex name,
+                              const ast::Expr *value)
+{
+    const ast::VarDecl *declared = field(klass, name);
+    if (declared == nullptr)
+        return;
+    const StaticType type = declared_type(declared->type);
+    if (declared->immutable && !context.init)
+        error(name, "Cannot assign to a val.");
+    else if (mismatched(value->type, type))
+        error(name, "Cannot assign a value of type " + described(value->type) + " to '" +
+                            std::string(lexeme(name)) + "' of type " + described(type) + ".");
+}
+
+void TypeChecker::error(const lexer::TokenIndex token, const std::string &message) const
+{
+    if (!report)
+        return;
+    if (token == lexer::NO_TOKEN)
+        Compiler::error(message);
+    else
+        Compiler::error(tokens.token(token), message);
+}
+
+// the class an identifier names
+const ast::Class *TypeChecker::class_named(const lexer::TokenIndex name) const
+{
+    if (name == lexer::NO_TOKEN || tokens.type(name) != lexer::IDENTIFIER)
+        return nullptr;
+    const auto it = classes.find(tokens.symbol(name));
+    return it != classes.end() ? it->second : nullptr;
+}
+
+// the class the value of `expr` is declared as or constructed from, nullptr when unknown
+const ast::Class *TypeChecker::class_of(const ast::Expr *expr)
+{
+    if (const auto *grouping = ast::as<ast::Grouping>(expr))
+        return class_of(grouping->expr);
+    if (const auto *call = ast::as<ast::Call>(expr))
+    {
+        const auto *callee = ast::as<ast::Variable>(call->callee);
+        if (callee == nullptr || callee->binding.kind != ast::Binding::Kind::GLOBAL)
+            return nullptr;
+        const ast::Class *klass = class_named(callee->binding.declaration);
+        return klass != nullptr && klass->name == callee->binding.declaration ? klass : nullptr;
+    }
+    const auto *variable = ast::as<ast::Variable>(expr);
+    if (variable == nullptr)
+        return nullptr;
+    const ast::Binding &binding = variable->binding;
+    if (binding.declaration == lexer::NO_TOKEN && (binding.kind == ast::Binding::Kind::LOCAL ||
+                                                   binding.kind == ast::Binding::Kind::UPVALUE))
+        return context.klass; // `this`
+    const Declaration *declared = declaration(binding);
+    return declared != nullptr ? declared->klass : nullptr;
+}
+
+// a chain that runs into itself ends there, the code generator reports it
+const ast::Class *TypeChecker::parent_of(const ast::Class *klass) const
+{
+    return klass->parent != lexer::NO_TOKEN ? class_named(klass->parent) : nullptr;
+}
+
+// the declaration of field `name` nearest to `klass` in its chain
+const ast::VarDecl *TypeChecker::field(const ast::Class *klass, const lexer::TokenIndex name) const
+{
+    const lexer::Symbol symbol = tokens.symbol(name);
+    for (std::size_t hops = 0; klass != nullptr && hops <= classes.size(); ++hops)
+    {
+        for (const ast::Stmt *attribute : klass->attributes)
+        {
+            const auto *var = ast::as<ast::VarDecl>(attribute);
+            if (var != nullptr && tokens.symbol(var->name) == symbol)
+                return var;
+        }
+        klass = parent_of(klass);
+    }
+    return nullptr;
+}
+
+// whether an object declared as `klass` may have method `name`, which a subclass may add
+bool TypeChecker::responds(const ast::Class *klass, const lexer::TokenIndex name) const
+{
+    const lexer::Symbol symbol = tokens.symbol(name);
+    for (const auto &[other_name, other] : classes)
+    {
+        if (!inherits(klass, other) && !inherits(other, klass))
+            continue;
+        for (const ast::Stmt *method : other->methods)
+        {
+            const auto *fn = ast::as<ast::Function>(method);
+            if (fn != nullptr && tokens.symbol(fn->name) == symbol)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool TypeChecker::inherits(const ast::Class *klass, const ast::Class *from) const
+{
+    for (std::size_t hops = 0; klass != nullptr && hops <= classes.size(); ++hops)
+    {
+        if (klass == from)
+            return true;
+        klass = parent_of(klass);
+    }
+    return false;
+}
+
+StaticType TypeChecker::declared_type(const lexer::TokenIndex token) const
+{
+    if (token == lexer::NO_TOKEN)
+        return std::nullopt;
+    switch (tokens.type(token))
+    {
+    case lexer::INT:
+        return Type::INT;
+    case lexer::FLOAT:
+        return Type::FLOAT;
+    case lexer::STRING_TYPE:
+        return Type::STRING;
+    case lexer::BOOL:
+        return Type::BOOL;
+    case lexer::VOID:
+        return Type::VOID;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::string_view TypeChecker::lexeme(const lexer::TokenIndex token) const
+{
+    return tokens.lexeme(token);
+}
+} // namespace cool::compiler::analysis
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../ast/stmt.hpp"
+#include "../lexer/token_stream.hpp"
+#include "type.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cool::compiler::analysis {
+/* Annotates every expression of a compilation unit with its static type (ast::Expr::type)
+ * and marks it `proven` where the VM is certain to produce a value of that type, which is
+ * what lets the code generator emit the typed opcodes without a tag check. It runs after
+ * analysis::Resolver and follows the bindings it left on every name.
+ *
+ * The VM does not enforce declared types, so a read of a name is only proven when every
+ * value ever stored in it is: a `var`/`val` of a primitive type with an initializer, or a
+ * parameter of a top-level function that is only ever called by name, with a proven
+ * argument at every call. A global is read before its declaration runs in top-level code
+ * above it and in functions called from there, so inside functions only the globals
+ * declared before any top-level code that could call one count. The result of a call to
+ * such a function is proven when every path returns a proven value. These facts depend on
+ * each other, so they are assumed and dropped again until nothing changes. Fields, methods
+ * and anything read through an object are never proven.
+ *
+ * Mismatches that are certain are reported: storing a value whose static type is not
+ * assignable to the declared one, operands of a type the operator rejects, and calling a
+ * top-level function with the wrong number of arguments. So are assignments to a `val`, a
+ * function declared to return a value that can end without one, and invoking a method that
+ * neither the class an object is declared as nor any of its subclasses has. A field of an
+ * object is checked against its declaration in that class.
+ */
+struct TypeChecker
+{
+    using StaticType = std::optional<Type>;
+
+    // a local, parameter or global, keyed by the token that declares it
+    struct Declaration
+    {
+        StaticType        type;                 // declared
+        bool              proven     = false;   // reads have `type`, until a store shows otherwise
+        bool              stored     = true;    // every store of the current pass was proven `type`
+        bool              everywhere = false;   // a global set before any function can run
+        bool              immutable  = false;   // declared with `val`
+        const ast::Class *klass      = nullptr; // the class it is declared as
+    };
+
+    struct Callable
+    {
+        const ast::Function *node;
+        StaticType           returns;        // declared
+        bool                 closed   = true; // only ever called by name, never assigned
+        bool                 proven   = true; // every call returns a proven `returns`
+        bool                 returned = true; // every return of the current pass was proven
+    };
+
+    // the function whose body is being checked
+    struct Context
+    {
+        lexer::TokenIndex name     = lexer::NO_TOKEN;
+        Callable         *callable = nullptr; // a top-level function
+        StaticType        returns;
+        const ast::Class *klass = nullptr; // of the method, or of the one it is nested in
+        bool              init  = false;   // an init method, which sets the `val` fields
+    };
+
+    const lexer::TokenStream                              &tokens;
+    std::unordered_map<lexer::TokenIndex, Declaration>     declarations;
+    std::unordered_map<lexer::TokenIndex, Callable>        callables;   // by name token
+    std::unordered_map<lexer::Symbol, const ast::Class *>  classes;
+    std::unordered_set<lexer::TokenIndex>                  initialized; // globals set so far
+    Context                                                context;
+    int                                                    function_depth = 0;
+    bool                                                   report         = true; // first pass only
+
+    explicit TypeChecker(const lexer::TokenStream &tokens);
+    void check(const ast::StmtList &program);
+
+    // declarations
+    void declare_globals(const ast::StmtList &program);
+    void pass(const ast::StmtList &program);
+    bool settle();
+    void function(const ast::Function &node, const ast::Class *klass);
+    void class_declaration(const ast::Class &node);
+
+    // statements
+    void statement(const ast::Stmt *stmt);
+    void operator()(const ast::VarDecl &stmt);
+    void operator()(const ast::ExprStatement &stmt);
+    void operator()(const ast::If &stmt);
+    void operator()(const ast::While &stmt);
+    void operator()(const ast::Return &stmt);
+    void operator()(const ast::Print &stmt);
+    void operator()(const ast::Function &stmt);
+    void operator()(const ast::Class &stmt);
+    void operator()(const ast::Block &stmt);
+
+    // expressions, each sets the `type` and `proven` of the node
+    void expr(ast::Expr *expr);
+    void operator()(ast::Binary &expr);
+    void operator()(ast::Unary &expr);
+    void operator()(ast::Logical &expr);
+    void operator()(ast::Literal &expr);
+    void operator()(ast::Grouping &expr);
+    void operator()(ast::Variable &expr);
+    void operator()(ast::Assignment &expr);
+    void operator()(ast::Call &expr);
+    void operator()(ast::Get &expr);
+    void operator()(ast::Set &expr);
+
+    // helpers
+    Declaration *declaration(const ast::Binding &binding);
+    Callable    *callable(const ast::Binding &binding);
+    void         store(Declaration *to, const ast::Expr *value, StaticType coerced = std::nullopt);
+    void         store_field(const ast::Class *klass, lexer::TokenIndex name,
+                             const ast::Expr *value);
+    void         error(lexer::TokenIndex token, const std::string &message) const;
+    [[nodiscard]] StaticType       declared_type(lexer::TokenIndex token) const;
+    [[nodiscard]] std::string_view lexeme(lexer::TokenIndex token) const;
+
+    // the classes objects are declared as
+    [[nodiscard]] const ast::Class   *class_named(lexer::TokenIndex name) const;
+    [[nodiscard]] const ast::Class   *class_of(const ast::Expr *expr);
+    [[nodiscard]] const ast::Class   *parent_of(const ast::Class *klass) const;
+    [[nodiscard]] const ast::VarDecl *field(const ast::Class *klass, lexer::TokenIndex name) const;
+    [[nodiscard]] bool                responds(const ast::Class *klass,
+                                               lexer::TokenIndex name) const;
+    [[nodiscard]] bool                inherits(const ast::Class *klass,
+                                               const ast::Class *from) const;
+};
+} // namespace cool::compiler::analysis
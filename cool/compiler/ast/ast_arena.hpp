@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cool::compiler::ast {
+/* Bump allocator that owns every AST node of one compilation unit. Nodes and the lists
+ * inside them are carved out of the same monotonic buffer and are never destroyed one by
+ * one, the whole tree is released at once when the arena goes away. Anything stored in a
+ * node therefore has to take its memory from the arena (or need no memory at all).
+ */
+struct AstArena
+{
+    std::pmr::monotonic_buffer_resource resource{64 * 1024};
+
+    AstArena()                            = default;
+    AstArena(const AstArena &)            = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    template <typename T, typename... Args>
+    T *make(Args &&...args)
+    {
+        void *memory = resource.allocate(sizeof(T), alignof(T));
+        return ::new (memory) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    std::pmr::vector<T> list()
+    {
+        return std::pmr::vector<T>{&resource};
+    }
+};
+} // namespace cool::compiler::ast
@@ -1,17 +1,40 @@
 #pragma once
 
+#include "../lexer/token_stream.hpp"
 #include "stmt.hpp"
 
-#include <memory>
-#include <vector>
-
 namespace cool::compiler::ast {
 struct AstPrinter
 {
-    static void print(const std::vector<std::unique_ptr<Stmt>> &statements);
-    static void print_indent(int indent);
-    static void print_stmt(const Stmt *stmt, int indent);
-    static void print_expr(const Expr *expr, int indent);
+    const lexer::TokenStream &tokens;
+    int                       indent = 0;
+
+    explicit AstPrinter(const lexer::TokenStream &tokens);
+    void                           print(const StmtList &statements);
+    [[nodiscard]] std::string_view lexeme(lexer::TokenIndex token) const;
+    static void                    print_indent(int indent);
+    void                           print_stmt(const Stmt *stmt, int indent);
+    void                           print_expr(const Expr *expr, int indent);
+
+    void operator()(const VarDecl &stmt);
+    void operator()(const ExprStatement &stmt);
+    void operator()(const If &stmt);
+    void operator()(const While &stmt);
+    void operator()(const Return &stmt);
+    void operator()(const Print &stmt);
+    void operator()(const Function &stmt);
+    void operator()(const Class &stmt);
+    void operator()(const Block &stmt);
+    void operator()(const Binary &expr);
+    void operator()(const Unary &expr);
+    void operator()(const Logical &expr);
+    void operator()(const Literal &expr);
+    void operator()(const Grouping &expr);
+    void operator()(const Variable &expr);
+    void operator()(const Assignment &expr);
+    void operator()(const Call &expr);
+    void operator()(const Get &expr);
+    void operator()(const Set &expr);
 };
 
 } // namespace cool::compiler::ast
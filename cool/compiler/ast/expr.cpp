@@ -2,30 +2,33 @@
 #include <utility>
 
 namespace cool::compiler::ast {
-Binary::Binary(std::unique_ptr<Expr> lhs, lexer::Token op, std::unique_ptr<Expr> rhs)
-    : lhs{std::move(lhs)}, rhs{std::move(rhs)}, op{std::move(op)}
+Binary::Binary(Expr *lhs, const lexer::TokenIndex op, Expr *rhs)
+    : Expr{KIND}, lhs{lhs}, rhs{rhs}, op{op}
 {}
 
-Unary::Unary(lexer::Token op, std::unique_ptr<Expr> operand)
-    : operand{std::move(operand)}, op{std::move(op)}
-{}
+Unary::Unary(const lexer::TokenIndex op, Expr *operand) : Expr{KIND}, operand{operand}, op{op} {}
 
-Logical::Logical(std::unique_ptr<Expr> lhs, lexer::Token op, std::unique_ptr<Expr> rhs)
-    : lhs{std::move(lhs)}, rhs{std::move(rhs)}, op{std::move(op)}
+Logical::Logical(Expr *lhs, const lexer::TokenIndex op, Expr *rhs)
+    : Expr{KIND}, lhs{lhs}, rhs{rhs}, op{op}
 {}
 
-Literal::Literal(lexer::Literal value) : value{std::move(value)} {}
+Literal::Literal(lexer::Literal value) : Expr{KIND}, value{std::move(value)} {}
+
+Grouping::Grouping(Expr *expr) : Expr{KIND}, expr{expr} {}
 
-Grouping::Grouping(std::unique_ptr<Expr> expr) : expr{std::move(expr)} {}
+Variable::Variable(const lexer::TokenIndex name) : Expr{KIND}, name{name} {}
 
-Variable::Variable(lexer::Token name) : name{std::move(name)} {}
+Assignment::Assignment(const lexer::TokenIndex name, Expr *value)
+    : Expr{KIND}, name{name}, value{value}
+{}
 
-Assignment::Assignment(lexer::Token name, std::unique_ptr<Expr> value)
-    : name{std::move(name)}, value{std::move(value)}
+Call::Call(Expr *callee, const lexer::TokenIndex paren, ExprList arguments)
+    : Expr{KIND}, callee{callee}, paren{paren}, arguments{std::move(arguments)}
 {}
 
-Call::Call(std::unique_ptr<Expr> callee, lexer::Token paren,
-           std::vector<std::unique_ptr<Expr>> arguments)
-    : callee{std::move(callee)}, paren{std::move(paren)}, arguments{std::move(arguments)}
+Get::Get(Expr *object, const lexer::TokenIndex name) : Expr{KIND}, object{object}, name{name} {}
+
+Set::Set(Expr *object, const lexer::TokenIndex name, Expr *value)
+    : Expr{KIND}, object{object}, name{name}, value{value}
 {}
 } // namespace cool::compiler::ast
@@ -1,69 +1,155 @@
 #pragma once
+#include "../analysis/type.hpp"
 #include "../lexer/token.hpp"
+#include "../lexer/token_stream.hpp"
 
-#include <memory>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
 #include <vector>
 
 namespace cool::compiler::ast {
+/* Nodes live in an AstArena and point at each other with plain pointers, tokens are
+ * referenced by their index in the unit's TokenStream. Every node carries its Kind, so
+ * passes dispatch with ast::visit (see visitor.hpp) instead of RTTI.
+ */
+enum class ExprKind : std::uint8_t {
+    BINARY,
+    UNARY,
+    LOGICAL,
+    LITERAL,
+    GROUPING,
+    VARIABLE,
+    ASSIGNMENT,
+    CALL,
+    GET,
+    SET
+};
+
+// `type` and `proven` are filled in by analysis::TypeChecker
 struct Expr
 {
-    virtual ~Expr() = default;
+    const ExprKind                kind;
+    std::optional<analysis::Type> type;           // the static type, if known
+    bool                          proven = false; // the VM always produces a value of `type`
+    explicit Expr(const ExprKind kind) : kind{kind} {}
 };
 
+using ExprList = std::pmr::vector<Expr *>;
+
 struct Binary final : Expr
 {
-    std::unique_ptr<Expr> lhs;
-    std::unique_ptr<Expr> rhs;
-    lexer::Token          op;
-    Binary(std::unique_ptr<Expr> lhs, lexer::Token op, std::unique_ptr<Expr> rhs);
+    static constexpr ExprKind KIND = ExprKind::BINARY;
+
+    Expr             *lhs;
+    Expr             *rhs;
+    lexer::TokenIndex op;
+    Binary(Expr *lhs, lexer::TokenIndex op, Expr *rhs);
 };
 
 struct Unary final : Expr
 {
-    std::unique_ptr<Expr> operand;
-    lexer::Token          op;
-    Unary(lexer::Token op, std::unique_ptr<Expr> operand);
+    static constexpr ExprKind KIND = ExprKind::UNARY;
+
+    Expr             *operand;
+    lexer::TokenIndex op;
+    Unary(lexer::TokenIndex op, Expr *operand);
 };
 
 struct Logical final : Expr
 {
-    std::unique_ptr<Expr> lhs;
-    std::unique_ptr<Expr> rhs;
-    lexer::Token          op;
-    Logical(std::unique_ptr<Expr> lhs, lexer::Token op, std::unique_ptr<Expr> rhs);
+    static constexpr ExprKind KIND = ExprKind::LOGICAL;
+
+    Expr             *lhs;
+    Expr             *rhs;
+    lexer::TokenIndex op;
+    Logical(Expr *lhs, lexer::TokenIndex op, Expr *rhs);
 };
 
 struct Literal final : Expr
 {
+    static constexpr ExprKind KIND = ExprKind::LITERAL;
+
     lexer::Literal value;
     explicit Literal(lexer::Literal value);
 };
 
 struct Grouping final : Expr
 {
-    std::unique_ptr<Expr> expr;
-    explicit Grouping(std::unique_ptr<Expr> expr);
+    static constexpr ExprKind KIND = ExprKind::GROUPING;
+
+    Expr *expr;
+    explicit Grouping(Expr *expr);
+};
+
+/* What a name refers to, filled in by analysis::Resolver. A LOCAL is register `slot` of the
+ * function it is used in, an UPVALUE entry `slot` of the upvalues of its closure (see
+ * Function::upvalues), a FIELD slot `slot` of `this` and a GLOBAL module global `slot`.
+ * A FIELD or METHOD used in a function nested in the method goes through the method's
+ * `this`, upvalue `receiver` of the closure. A `boxed` local or upvalue holds a cell with
+ * the value rather than the value, because a closure captures it and something assigns
+ * it. `declaration` is the token declaring a local, upvalue or global, which identifies it
+ * across passes (NO_TOKEN for `this`).
+ */
+struct Binding
+{
+    enum class Kind : std::uint8_t { UNRESOLVED, LOCAL, UPVALUE, FIELD, METHOD, GLOBAL, UNDEFINED };
+
+    Kind              kind        = Kind::UNRESOLVED;
+    bool              boxed       = false;
+    std::uint16_t     depth       = 0; // functions between the use and the declaration
+    std::uint32_t     slot        = 0;
+    lexer::TokenIndex declaration = lexer::NO_TOKEN;
+    std::uint32_t     receiver    = 0;
 };
 
 struct Variable final : Expr
 {
-    lexer::Token name;
-    explicit Variable(lexer::Token name);
+    static constexpr ExprKind KIND = ExprKind::VARIABLE;
+
+    lexer::TokenIndex name;
+    Binding           binding;
+    explicit Variable(lexer::TokenIndex name);
 };
 
 struct Assignment final : Expr
 {
-    lexer::Token          name;
-    std::unique_ptr<Expr> value;
-    Assignment(lexer::Token name, std::unique_ptr<Expr> value);
+    static constexpr ExprKind KIND = ExprKind::ASSIGNMENT;
+
+    lexer::TokenIndex name;
+    Expr             *value;
+    Binding           binding;
+    Assignment(lexer::TokenIndex name, Expr *value);
 };
 
 struct Call final : Expr
 {
-    std::unique_ptr<Expr>              callee;
-    lexer::Token                       paren;
-    std::vector<std::unique_ptr<Expr>> arguments;
-    Call(std::unique_ptr<Expr> callee, lexer::Token paren,
-         std::vector<std::unique_ptr<Expr>> arguments);
+    static constexpr ExprKind KIND = ExprKind::CALL;
+
+    Expr             *callee;
+    lexer::TokenIndex paren;
+    ExprList          arguments;
+    Call(Expr *callee, lexer::TokenIndex paren, ExprList arguments);
+};
+
+// `object.name`, a method call is a Call whose callee is a Get
+struct Get final : Expr
+{
+    static constexpr ExprKind KIND = ExprKind::GET;
+
+    Expr             *object;
+    lexer::TokenIndex name;
+    Get(Expr *object, lexer::TokenIndex name);
+};
+
+// `object.name = value`
+struct Set final : Expr
+{
+    static constexpr ExprKind KIND = ExprKind::SET;
+
+    Expr             *object;
+    lexer::TokenIndex name;
+    Expr             *value;
+    Set(Expr *object, lexer::TokenIndex name, Expr *value);
 };
-} // namespace cool::compiler::ast
\ No newline at end of file
+} // namespace cool::compiler::ast
@@ -2,38 +2,35 @@
 #include <utility>
 
 namespace cool::compiler::ast {
-VarDecl::VarDecl(lexer::Token name, lexer::Token type, std::unique_ptr<Expr> initializer)
-    : name(std::move(name)), type(std::move(type)), initializer(std::move(initializer))
+VarDecl::VarDecl(const lexer::TokenIndex name, const lexer::TokenIndex type, Expr *initializer,
+                 const bool immutable)
+    : Stmt{KIND}, name(name), type(type), initializer(initializer), immutable(immutable)
 {}
 
-ExprStatement::ExprStatement(std::unique_ptr<Expr> expression) : expression{std::move(expression)}
-{}
+ExprStatement::ExprStatement(Expr *expression) : Stmt{KIND}, expression{expression} {}
 
-If::If(std::unique_ptr<Expr> condition, std::unique_ptr<Stmt> then_branch,
-       std::unique_ptr<Stmt> else_branch)
-    : condition{std::move(condition)}, then_branch{std::move(then_branch)},
-      else_branch{std::move(else_branch)}
+If::If(Expr *condition, Stmt *then_branch, Stmt *else_branch)
+    : Stmt{KIND}, condition{condition}, then_branch{then_branch}, else_branch{else_branch}
 {}
 
-While::While(std::unique_ptr<Expr> condition, std::unique_ptr<Stmt> body)
-    : condition{std::move(condition)}, body{std::move(body)}
-{}
+While::While(Expr *condition, Stmt *body) : Stmt{KIND}, condition{condition}, body{body} {}
 
-Return::Return(std::unique_ptr<Expr> expression) : expression{std::move(expression)} {}
+Return::Return(Expr *expression) : Stmt{KIND}, expression{expression} {}
 
-Print::Print(std::unique_ptr<Expr> expression) : expression{std::move(expression)} {}
+Print::Print(Expr *expression) : Stmt{KIND}, expression{expression} {}
 
-Function::Function(lexer::Token name, std::vector<std::pair<lexer::Token, lexer::Token>> params,
-                   lexer::Token return_type, std::unique_ptr<Stmt> body)
-    : name{std::move(name)}, params{std::move(params)}, return_type{std::move(return_type)},
-      body{std::move(body)}
+Function::Function(const lexer::TokenIndex name, ParamList params,
+                   const lexer::TokenIndex return_type, Stmt *body)
+    : Stmt{KIND}, name{name}, params{std::move(params)}, return_type{return_type}, body{body},
+      upvalues{this->params.get_allocator()},
+      boxed_params(this->params.size(), false, this->params.get_allocator())
 {}
 
-Class::Class(lexer::Token name, std::vector<std::unique_ptr<Stmt>> methods,
-             std::vector<std::unique_ptr<Stmt>> attributes, lexer::Token parent)
-    : name{std::move(name)}, methods{std::move(methods)}, attributes{std::move(attributes)},
-      parent{std::move(parent)}
+Class::Class(const lexer::TokenIndex name, StmtList methods, StmtList attributes,
+             const lexer::TokenIndex parent)
+    : Stmt{KIND}, name{name}, methods{std::move(methods)}, attributes{std::move(attributes)},
+      parent{parent}, fields{this->methods.get_allocator()}
 {}
 
-Block::Block(std::vector<std::unique_ptr<Stmt>> statements) : statements{std::move(statements)} {}
+Block::Block(StmtList statements) : Stmt{KIND}, statements{std::move(statements)} {}
 } // namespace cool::compiler::ast
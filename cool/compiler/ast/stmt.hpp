@@ -5,76 +5,128 @@
 #include "expr.hpp"
 
 namespace cool::compiler::ast {
+enum class StmtKind : std::uint8_t {
+    VAR_DECL,
+    EXPR_STATEMENT,
+    IF,
+    WHILE,
+    RETURN,
+    PRINT,
+    FUNCTION,
+    CLASS,
+    BLOCK
+};
+
 struct Stmt
 {
-    virtual ~Stmt() = default;
+    const StmtKind kind;
+    explicit Stmt(const StmtKind kind) : kind{kind} {}
 };
 
+using StmtList = std::pmr::vector<Stmt *>;
+
 struct VarDecl final : Stmt
 {
-    lexer::Token          name;
-    lexer::Token          type;
-    std::unique_ptr<Expr> initializer;
-    VarDecl(lexer::Token name, lexer::Token type, std::unique_ptr<Expr> initializer);
+    static constexpr StmtKind KIND = StmtKind::VAR_DECL;
+
+    lexer::TokenIndex name;
+    lexer::TokenIndex type;
+    Expr             *initializer;
+    bool              immutable;     // declared with `val`
+    bool              boxed = false; // see Binding, set by analysis::Resolver
+    VarDecl(lexer::TokenIndex name, lexer::TokenIndex type, Expr *initializer, bool immutable);
 };
 
 struct ExprStatement final : Stmt
 {
-    std::unique_ptr<Expr> expression;
-    explicit ExprStatement(std::unique_ptr<Expr> expression);
+    static constexpr StmtKind KIND = StmtKind::EXPR_STATEMENT;
+
+    Expr *expression;
+    explicit ExprStatement(Expr *expression);
 };
 
 struct If final : Stmt
 {
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> then_branch;
-    std::unique_ptr<Stmt> else_branch;
-    If(std::unique_ptr<Expr> condition, std::unique_ptr<Stmt> then_branch,
-       std::unique_ptr<Stmt> else_branch);
+    static constexpr StmtKind KIND = StmtKind::IF;
+
+    Expr *condition;
+    Stmt *then_branch;
+    Stmt *else_branch;
+    If(Expr *condition, Stmt *then_branch, Stmt *else_branch);
 };
 
 struct While final : Stmt
 {
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> body;
-    While(std::unique_ptr<Expr> condition, std::unique_ptr<Stmt> body);
+    static constexpr StmtKind KIND = StmtKind::WHILE;
+
+    Expr *condition;
+    Stmt *body;
+    While(Expr *condition, Stmt *body);
 };
 
 struct Return final : Stmt
 {
-    std::unique_ptr<Expr> expression;
-    explicit Return(std::unique_ptr<Expr> expression);
+    static constexpr StmtKind KIND = StmtKind::RETURN;
+
+    Expr *expression;
+    explicit Return(Expr *expression);
 };
 
 struct Print final : Stmt
 {
-    std::unique_ptr<Expr> expression;
-    explicit Print(std::unique_ptr<Expr> expression);
+    static constexpr StmtKind KIND = StmtKind::PRINT;
+
+    Expr *expression;
+    explicit Print(Expr *expression);
+};
+
+using ParamList = std::pmr::vector<std::pair<lexer::TokenIndex, lexer::TokenIndex>>;
+
+// a variable of the enclosing function a closure captures when it is created
+struct Upvalue
+{
+    bool              from_upvalue; // `slot` is an upvalue of the enclosing function's closure
+    std::uint32_t     slot;         // or else one of its registers
+    lexer::TokenIndex declaration;
 };
 
+/* `upvalues`, `boxed` (for the name of a nested function) and `boxed_params` are filled in
+ * by analysis::Resolver. A function with upvalues is a closure, created where it is declared.
+ */
 struct Function final : Stmt
 {
-    lexer::Token                                       name;
-    std::vector<std::pair<lexer::Token, lexer::Token>> params;
-    lexer::Token                                       return_type;
-    std::unique_ptr<Stmt>                              body;
-    Function(lexer::Token name, std::vector<std::pair<lexer::Token, lexer::Token>> params,
-             lexer::Token return_type, std::unique_ptr<Stmt> body);
+    static constexpr StmtKind KIND = StmtKind::FUNCTION;
+
+    lexer::TokenIndex         name;
+    ParamList                 params;
+    lexer::TokenIndex         return_type;
+    Stmt                     *body;
+    std::pmr::vector<Upvalue> upvalues;
+    std::pmr::vector<bool>    boxed_params;
+    bool                      boxed = false;
+    Function(lexer::TokenIndex name, ParamList params, lexer::TokenIndex return_type, Stmt *body);
 };
 
+/* `fields` is filled in by analysis::Resolver: the field in every instance slot, parent fields
+ * first, which is how Interpreter::link_class lays out the fields of the module's classes.
+ */
 struct Class final : Stmt
 {
-    lexer::Token                       name;
-    std::vector<std::unique_ptr<Stmt>> methods;
-    std::vector<std::unique_ptr<Stmt>> attributes;
-    lexer::Token                       parent;
-    Class(lexer::Token name, std::vector<std::unique_ptr<Stmt>> methods,
-          std::vector<std::unique_ptr<Stmt>> attributes, lexer::Token parent);
+    static constexpr StmtKind KIND = StmtKind::CLASS;
+
+    lexer::TokenIndex               name;
+    StmtList                        methods;
+    StmtList                        attributes;
+    lexer::TokenIndex               parent;
+    std::pmr::vector<lexer::Symbol> fields;
+    Class(lexer::TokenIndex name, StmtList methods, StmtList attributes, lexer::TokenIndex parent);
 };
 
 struct Block final : Stmt
 {
-    std::vector<std::unique_ptr<Stmt>> statements;
-    explicit Block(std::vector<std::unique_ptr<Stmt>> statements);
+    static constexpr StmtKind KIND = StmtKind::BLOCK;
+
+    StmtList statements;
+    explicit Block(StmtList statements);
 };
-} // namespace cool::compiler::ast
\ No newline at end of file
+} // namespace cool::compiler::ast
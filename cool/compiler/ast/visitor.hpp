@@ -0,0 +1,84 @@
+#pragma once
+
+#include "expr.hpp"
+#include "stmt.hpp"
+
+#include <type_traits>
+
+namespace cool::compiler::ast {
+/* O(1) dispatch on the node Kind. `visit(node, visitor)` calls `visitor(concrete_node)`
+ * with the node downcast to its concrete type (keeping its constness), so a pass is a
+ * struct with one operator() overload per node type. `as<T>(node)` is the checked
+ * downcast for the places that only care about a single node type.
+ */
+template <typename T, typename Node>
+using same_const_t = std::conditional_t<std::is_const_v<Node>, const T, T>;
+
+template <typename T, typename Node>
+same_const_t<T, Node> *as(Node *node)
+{
+    if (node == nullptr || node->kind != T::KIND)
+        return nullptr;
+    return static_cast<same_const_t<T, Node> *>(node);
+}
+
+template <typename Node, typename Visitor>
+std::enable_if_t<std::is_same_v<std::remove_const_t<Node>, Expr>,
+                 std::invoke_result_t<Visitor, same_const_t<Binary, Node> &>>
+visit(Node &expr, Visitor &&visitor)
+{
+    switch (expr.kind)
+    {
+    case ExprKind::BINARY:
+        return visitor(static_cast<same_const_t<Binary, Node> &>(expr));
+    case ExprKind::UNARY:
+        return visitor(static_cast<same_const_t<Unary, Node> &>(expr));
+    case ExprKind::LOGICAL:
+        return visitor(static_cast<same_const_t<Logical, Node> &>(expr));
+    case ExprKind::LITERAL:
+        return visitor(static_cast<same_const_t<Literal, Node> &>(expr));
+    case ExprKind::GROUPING:
+        return visitor(static_cast<same_const_t<Grouping, Node> &>(expr));
+    case ExprKind::VARIABLE:
+        return visitor(static_cast<same_const_t<Variable, Node> &>(expr));
+    case ExprKind::ASSIGNMENT:
+        return visitor(static_cast<same_const_t<Assignment, Node> &>(expr));
+    case ExprKind::CALL:
+        return visitor(static_cast<same_const_t<Call, Node> &>(expr));
+    case ExprKind::GET:
+        return visitor(static_cast<same_const_t<Get, Node> &>(expr));
+    case ExprKind::SET:
+        return visitor(static_cast<same_const_t<Set, Node> &>(expr));
+    }
+    __builtin_unreachable();
+}
+
+template <typename Node, typename Visitor>
+std::enable_if_t<std::is_same_v<std::remove_const_t<Node>, Stmt>,
+                 std::invoke_result_t<Visitor, same_const_t<VarDecl, Node> &>>
+visit(Node &stmt, Visitor &&visitor)
+{
+    switch (stmt.kind)
+    {
+    case StmtKind::VAR_DECL:
+        return visitor(static_cast<same_const_t<VarDecl, Node> &>(stmt));
+    case StmtKind::EXPR_STATEMENT:
+        return visitor(static_cast<same_const_t<ExprStatement, Node> &>(stmt));
+    case StmtKind::IF:
+        return visitor(static_cast<same_const_t<If, Node> &>(stmt));
+    case StmtKind::WHILE:
+        return visitor(static_cast<same_const_t<While, Node> &>(stmt));
+    case StmtKind::RETURN:
+        return visitor(static_cast<same_const_t<Return, Node> &>(stmt));
+    case StmtKind::PRINT:
+        return visitor(static_cast<same_const_t<Print, Node> &>(stmt));
+    case StmtKind::FUNCTION:
+        return visitor(static_cast<same_const_t<Function, Node> &>(stmt));
+    case StmtKind::CLASS:
+        return visitor(static_cast<same_const_t<Class, Node> &>(stmt));
+    case StmtKind::BLOCK:
+        return visitor(static_cast<same_const_t<Block, Node> &>(stmt));
+    }
+    __builtin_unreachable();
+}
+} // namespace cool::compiler::ast
@@ -0,0 +1,979 @@
+#include "code_generator.hpp"
+
+#include "../ast/visitor.hpp"
+#include "../compiler.hpp"
+#include "../ir/builder.hpp"
+#include "../ir/passes.hpp"
+#include "lowering.hpp"
+#include "opcode_forms.hpp"
+#include "peephole.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace cool::compiler::codegen {
+using bytecode::ConstantKind;
+using bytecode::Opcode;
+
+namespace {
+constexpr CodeGenerator::Reg MAX_REGISTERS = 256;
+constexpr std::size_t        MAX_UPVALUES  = 256;
+
+// expressions that read all their inputs before writing the destination register
+bool writes_dest_last(const ast::Expr *expr)
+{
+    switch (expr->kind)
+    {
+    case ast::ExprKind::LOGICAL:
+    case ast::ExprKind::ASSIGNMENT:
+    case ast::ExprKind::SET:
+        return false;
+    case ast::ExprKind::GROUPING:
+        return writes_dest_last(ast::as<ast::Grouping>(expr)->expr);
+    default:
+        return true;
+    }
+}
+
+// whether the type checker proved `expr` a value of `type`
+bool proven(const ast::Expr *expr, const analysis::Type type)
+{
+    return expr->proven && expr->type == type;
+}
+
+// the register opcode of a binary operator, NOP if there is none; `>` and `>=` are LT and LE
+// with the operands swapped
+Opcode binary_opcode(const lexer::TokenType type, bool &swap)
+{
+    swap = type == lexer::GREATER || type == lexer::GREATER_EQUAL;
+    switch (type)
+    {
+    case lexer::PLUS:
+        return Opcode::ADD;
+    case lexer::MINUS:
+        return Opcode::SUB;
+    case lexer::STAR:
+        return Opcode::MUL;
+    case lexer::SLASH:
+        return Opcode::DIV;
+    case lexer::PERCENT:
+        return Opcode::MOD;
+    case lexer::ASTRIX:
+        return Opcode::POW;
+    case lexer::EQUALS_EQUAL:
+        return Opcode::EQ;
+    case lexer::BANG_EQUAL:
+        return Opcode::NE;
+    case lexer::LESS:
+    case lexer::GREATER:
+        return Opcode::LT;
+    case lexer::LESS_EQUAL:
+    case lexer::GREATER_EQUAL:
+        return Opcode::LE;
+    default:
+        return Opcode::NOP;
+    }
+}
+
+// what JMPIF makes of a literal: only nil and false are false
+bool truthy(const lexer::Literal &value)
+{
+    const auto *boolean = std::get_if<bool>(&value);
+    return !std::holds_alternative<std::monostate>(value) && (boolean == nullptr || *boolean);
+}
+} // namespace
+
+// the slot analysis::Resolver laid the field out in
+int CodeGenerator::ClassInfo::field_slot(const lexer::Symbol name) const
+{
+    const auto it = std::find(node->fields.begin(), node->fields.end(), name);
+    return it == node->fields.end() ? -1 : static_cast<int>(it - node->fields.begin());
+}
+
+bool CodeGenerator::ClassInfo::has_method(const std::string_view name) const
+{
+    for (const ClassInfo *klass = this; klass != nullptr; klass = klass->parent)
+        if (std::find(klass->methods.begin(), klass->methods.end(), name) != klass->methods.end())
+            return true;
+    return false;
+}
+
+CodeGenerator::CodeGenerator(const lexer::TokenStream &tokens) : tokens{tokens} {}
+
+bytecode::Module CodeGenerator::generate(const ast::StmtList &program)
+{
+    declare_globals(program);
+    link_classes();
+
+    FunctionState script;
+    begin_function(script, "<script>", nullptr);
+    module.entry = script.index;
+
+    // functions and classes are bound before any top-level statement runs, so they can be
+    // used above their declaration
+    for (const ast::Stmt *stmt : program)
+    {
+        const Reg mark = state->free_reg;
+        if (const auto *fn = ast::as<ast::Function>(stmt))
+        {
+            const std::uint32_t index = function(*fn, nullptr);
+            const Reg           reg   = alloc(fn->name);
+            load_constant(reg, {ConstantKind::FUNCTION, 0, index});
+            emit(bytecode::encode_bx(Opcode::SETGLOBAL, reg, globals.at(lexeme(fn->name))));
+        }
+        else if (const auto *klass = ast::as<ast::Class>(stmt))
+        {
+            const ClassInfo &info = classes.at(lexeme(klass->name));
+            class_declaration(info);
+            const Reg reg = alloc(klass->name);
+            load_constant(reg, {ConstantKind::CLASS, 0, info.index});
+            emit(bytecode::encode_bx(Opcode::SETGLOBAL, reg, info.global));
+        }
+        state->free_reg = mark;
+    }
+
+    for (const ast::Stmt *stmt : program)
+    {
+        if (stmt != nullptr && stmt->kind != ast::StmtKind::FUNCTION &&
+            stmt->kind != ast::StmtKind::CLASS)
+            statement(stmt);
+    }
+    end_function(script);
+    return std::move(module);
+}
+
+void CodeGenerator::declare_globals(const ast::StmtList &program)
+{
+    for (const ast::Stmt *stmt : program)
+    {
+        lexer::TokenIndex name = lexer::NO_TOKEN;
+        if (const auto *var = ast::as<ast::VarDecl>(stmt))
+            name = var->name;
+        else if (const auto *fn = ast::as<ast::Function>(stmt))
+            name = fn->name;
+        else if (const auto *klass = ast::as<ast::Class>(stmt))
+            name = klass->name;
+        if (name == lexer::NO_TOKEN)
+            continue;
+
+        if (globals.size() > UINT16_MAX)
+        {
+            error(name, "Too many global declarations.");
+            return;
+        }
+        const auto global = static_cast<std::uint16_t>(globals.size());
+        if (!globals.try_emplace(lexeme(name), global).second)
+        {
+            error(name, "Already a declaration with this name in the global scope.");
+            continue;
+        }
+        module.globals.push_back(string(lexeme(name)));
+
+        if (const auto *klass = ast::as<ast::Class>(stmt))
+        {
+            ClassInfo info;
+            info.index  = static_cast<std::uint32_t>(module.classes.size());
+            info.global = global;
+            info.node   = klass;
+            for (const ast::Stmt *attribute : klass->attributes)
+                if (const auto *field = ast::as<ast::VarDecl>(attribute))
+                    info.fields.push_back(lexeme(field->name));
+            for (const ast::Stmt *method : klass->methods)
+                if (const auto *fn = ast::as<ast::Function>(method))
+                    info.methods.push_back(lexeme(fn->name));
+            module.classes.emplace_back().name = string(lexeme(name));
+            classes.emplace(lexeme(name), std::move(info));
+        }
+    }
+}
+
+void CodeGenerator::link_classes()
+{
+    for (auto &[name, info] : classes)
+    {
+        const lexer::TokenIndex parent = info.node->parent;
+        if (parent == lexer::NO_TOKEN)
+            continue;
+        const auto it = classes.find(lexeme(parent));
+        if (it == classes.end())
+        {
+            error(parent, "Undefined parent class.");
+            continue;
+        }
+        info.parent                             = &it->second;
+        module.classes[info.index].parent = it->second.index;
+    }
+
+    for (auto &[name, info] : classes)
+    {
+        std::size_t depth = 0;
+        for (const ClassInfo *klass = info.parent; klass != nullptr; klass = klass->parent)
+        {
+            if (++depth > classes.size())
+            {
+                error(info.node->name, "A class cannot inherit from itself.");
+                info.parent                       = nullptr;
+                module.classes[info.index].parent = bytecode::NO_INDEX;
+                break;
+            }
+        }
+    }
+}
+
+void CodeGenerator::begin_function(FunctionState &fs, const std::string_view name,
+                                   const ClassInfo *klass)
+{
+    fs.enclosing          = state;
+    fs.klass              = klass;
+    fs.index              = static_cast<std::uint32_t>(module.functions.size());
+    fs.function.name      = string(name);
+    fs.function.is_method = klass != nullptr;
+    module.functions.emplace_back();
+    state = &fs;
+    if (klass != nullptr)
+        declare_local(lexer::NO_TOKEN);
+}
+
+std::uint32_t CodeGenerator::end_function(FunctionState &fs)
+{
+    emit(bytecode::encode(Opcode::RETURN, 0, 0));
+    if (fuse)
+        fuse_superinstructions(fs.function);
+    fs.function.register_count      = static_cast<std::uint8_t>(std::max(fs.max_reg, 1));
+    module.functions[fs.index]      = std::move(fs.function);
+    state                           = fs.enclosing;
+    return fs.index;
+}
+
+std::uint32_t CodeGenerator::function(const ast::Function &node, const ClassInfo *klass)
+{
+    at(node.name);
+    FunctionState fs;
+    begin_function(fs, lexeme(node.name), klass);
+    fs.function.arity = static_cast<std::uint8_t>(node.params.size());
+    if (node.upvalues.size() > MAX_UPVALUES)
+        error(node.name, "Too many variables captured by one function.");
+    for (const ast::Upvalue &upvalue : node.upvalues)
+        fs.function.upvalues.push_back({static_cast<std::uint8_t>(upvalue.from_upvalue ? 1 : 0),
+                                        static_cast<std::uint8_t>(upvalue.slot),
+                                        {0, 0}});
+    if (optimize && lower(node))
+        return end_function(fs);
+
+    // a boxed parameter is moved into its cell before the body runs
+    for (std::size_t i = 0; i < node.params.size(); ++i)
+    {
+        const auto &[name, type] = node.params[i];
+        const Reg reg            = declare_local(name, declared_type(type));
+        if (node.boxed_params[i])
+            emit(bytecode::encode(Opcode::BOX, reg));
+    }
+
+    if (const auto *body = ast::as<ast::Block>(node.body))
+    {
+        for (const ast::Stmt *stmt : body->statements)
+            statement(stmt);
+    }
+    else if (node.body != nullptr)
+    {
+        statement(node.body);
+    }
+    return end_function(fs);
+}
+
+// compiles the body of the current function through the SSA IR, false leaves the function as
+// it was for the AST path
+bool CodeGenerator::lower(const ast::Function &node)
+{
+    std::optional<ir::Function> body = ir::Builder{*this}.build(node, state->klass != nullptr);
+    if (!body)
+        return false;
+    ir::optimize(*body);
+    if (dump_ir)
+        body->print(std::cout, lexeme(node.name));
+
+    const bytecode::Function                   function  = state->function;
+    const std::map<ConstantKey, std::uint16_t> constants = state->constants;
+    if (Lowering{*this, *body}.lower())
+        return true;
+    state->function  = function;
+    state->constants = constants;
+    return false;
+}
+
+void CodeGenerator::class_declaration(const ClassInfo &info)
+{
+    const ast::Class &node = *info.node;
+    at(node.name);
+
+    if (!node.attributes.empty())
+    {
+        FunctionState fs;
+        begin_function(fs, "<init " + std::string(lexeme(node.name)) + ">", &info);
+        for (const ast::Stmt *attribute : node.attributes)
+        {
+            const auto *field = ast::as<ast::VarDecl>(attribute);
+            if (field == nullptr)
+                continue;
+            at(field->name);
+            const Reg value = alloc(field->name);
+            const int slot  = info.field_slot(tokens.symbol(field->name));
+            expr(field->initializer, value);
+            emit_set_field(0, value, slot, lexeme(field->name));
+            state->free_reg = locals_top();
+        }
+        module.classes[info.index].initializer = end_function(fs);
+    }
+
+    for (const ast::Stmt *method : node.methods)
+    {
+        const auto *fn = ast::as<ast::Function>(method);
+        if (fn == nullptr)
+            continue;
+        const std::uint32_t index = function(*fn, &info);
+        module.classes[info.index].methods.push_back({string(lexeme(fn->name)), index});
+    }
+    for (const std::string_view field : info.fields)
+        module.classes[info.index].fields.push_back(string(field));
+}
+
+void CodeGenerator::statement(const ast::Stmt *stmt)
+{
+    if (stmt == nullptr)
+        return;
+    visit(*stmt, *this);
+    state->free_reg = locals_top();
+}
+
+void CodeGenerator::operator()(const ast::VarDecl &stmt)
+{
+    at(stmt.name);
+    const StaticType type  = declared_type(stmt.type);
+    const Reg        value = alloc(stmt.name);
+
+    // the initializer is compiled before the name is in scope, it may refer to a shadowed
+    // one; an int literal initializing a float is stored as a float constant
+    const auto *literal = ast::as<ast::Literal>(stmt.initializer);
+    if (literal != nullptr && type == analysis::Type::FLOAT &&
+        std::holds_alternative<std::int64_t>(literal->value))
+        emit(bytecode::encode_bx(Opcode::LOADK, value, literal_constant(literal->value, type)));
+    else
+        expr(stmt.initializer, value);
+
+    if (is_top_level())
+    {
+        emit(bytecode::encode_bx(Opcode::SETGLOBAL, value, globals.at(lexeme(stmt.name))));
+        return;
+    }
+    if (stmt.boxed)
+        emit(bytecode::encode(Opcode::BOX, value));
+    state->locals.push_back({value, state->depth, type});
+}
+
+void CodeGenerator::operator()(const ast::ExprStatement &stmt)
+{
+    if (const auto *assignment = ast::as<ast::Assignment>(stmt.expression))
+    {
+        (*this)(*assignment, NO_REG);
+        return;
+    }
+    if (const auto *set = ast::as<ast::Set>(stmt.expression))
+    {
+        (*this)(*set, NO_REG);
+        return;
+    }
+    expr(stmt.expression, alloc());
+}
+
+void CodeGenerator::operator()(const ast::If &stmt)
+{
+    const Reg           condition = operand(stmt.condition);
+    const std::uint32_t to_else   = emit_jump(Opcode::JMPIFNOT, condition);
+    state->free_reg               = locals_top();
+
+    begin_scope();
+    statement(stmt.then_branch);
+    end_scope();
+    if (stmt.else_branch == nullptr)
+    {
+        patch_jump(to_else);
+        return;
+    }
+
+    const std::uint32_t to_end = emit_jump(Opcode::JMP);
+    patch_jump(to_else);
+    begin_scope();
+    statement(stmt.else_branch);
+    end_scope();
+    patch_jump(to_end);
+}
+
+void CodeGenerator::operator()(const ast::While &stmt)
+{
+    // the condition is compiled once, below the body, and the loop is entered by a jump to
+    // it, so every iteration ends in one conditional jump back; a loop on a true literal is
+    // not tested at all
+    const auto *literal = ast::as<ast::Literal>(stmt.condition);
+    if (literal != nullptr && truthy(literal->value))
+    {
+        const auto start = static_cast<std::uint32_t>(state->function.code.size());
+        begin_scope();
+        statement(stmt.body);
+        end_scope();
+        emit_loop(start);
+        return;
+    }
+
+    const std::uint32_t to_condition = emit_jump(Opcode::JMP);
+    const auto          start        = static_cast<std::uint32_t>(state->function.code.size());
+    begin_scope();
+    statement(stmt.body);
+    end_scope();
+    patch_jump(to_condition);
+    emit_loop(start, operand(stmt.condition));
+    state->free_reg = locals_top();
+}
+
+void CodeGenerator::operator()(const ast::Return &stmt)
+{
+    if (stmt.expression == nullptr)
+    {
+        emit(bytecode::encode(Opcode::RETURN, 0, 0));
+        return;
+    }
+    emit(bytecode::encode(Opcode::RETURN, operand(stmt.expression), 1));
+}
+
+void CodeGenerator::operator()(const ast::Print &stmt)
+{
+    emit(bytecode::encode(Opcode::PRINT, operand(stmt.expression)));
+}
+
+/* Top-level functions are bound up front by generate(), nested ones are locals. The local is
+ * declared before the body, which may call the function: a function that captures its own
+ * name is boxed, and its closure is stored into the cell the closure captured.
+ */
+void CodeGenerator::operator()(const ast::Function &stmt)
+{
+    const Reg reg = declare_local(stmt.name);
+    if (stmt.boxed)
+    {
+        emit(bytecode::encode(Opcode::LOADNIL, reg));
+        emit(bytecode::encode(Opcode::BOX, reg));
+    }
+    const std::uint32_t index    = function(stmt, nullptr);
+    const Reg           value    = stmt.boxed ? alloc(stmt.name) : reg;
+    const std::uint16_t function = constant({ConstantKind::FUNCTION, 0, index});
+    at(stmt.name);
+    if (stmt.upvalues.empty())
+        emit(bytecode::encode_bx(Opcode::LOADK, value, function));
+    else
+        emit(bytecode::encode_bx(Opcode::CLOSURE, value, function));
+    if (stmt.boxed)
+        emit(bytecode::encode(Opcode::SETBOX, reg, value));
+}
+
+void CodeGenerator::operator()(const ast::Class &) {} // analysis::Resolver reports it
+
+void CodeGenerator::operator()(const ast::Block &stmt)
+{
+    begin_scope();
+    for (const ast::Stmt *s : stmt.statements)
+        statement(s);
+    end_scope();
+}
+
+void CodeGenerator::expr(const ast::Expr *expr, const Reg dest)
+{
+    const Reg mark = state->free_reg;
+    if (expr == nullptr)
+        emit(bytecode::encode(Opcode::LOADNIL, dest));
+    else
+        visit(*expr, [&](const auto &node) -> void { (*this)(node, dest); });
+    state->free_reg = std::max(mark, dest + 1);
+}
+
+// a local's own register, otherwise `expr` is compiled into `scratch` or a new temporary
+CodeGenerator::Reg CodeGenerator::operand(const ast::Expr *expr, const Reg scratch)
+{
+    if (const auto *variable = ast::as<ast::Variable>(expr))
+    {
+        const ast::Binding &binding = variable->binding;
+        if (binding.kind == ast::Binding::Kind::LOCAL && !binding.boxed)
+            return static_cast<Reg>(binding.slot);
+    }
+    const Reg reg = scratch != NO_REG ? scratch : alloc();
+    this->expr(expr, reg);
+    return reg;
+}
+
+void CodeGenerator::operator()(const ast::Binary &expr, const Reg dest)
+{
+    // the left value is built in `dest` unless that is a local the right side may read, so a
+    // chain like `a + b + c` needs no temporary per operator
+    bool         swap    = false;
+    const Opcode generic = binary_opcode(tokens.type(expr.op), swap);
+    const Reg    lhs     = operand(expr.lhs, dest >= locals_top() ? dest : NO_REG);
+
+    // int operands get the integer opcodes, which still fall back to the generic handler
+    // when a value turns out otherwise at run time, proven floats and strings the typed ones
+    const bool integral = static_type(expr.lhs) == analysis::Type::INT &&
+                          static_type(expr.rhs) == analysis::Type::INT;
+    const bool strings  = proven(expr.lhs, analysis::Type::STRING) &&
+                          proven(expr.rhs, analysis::Type::STRING);
+
+    // a literal right operand is read straight from the constant pool, a number against a
+    // proven float as the float it would be converted to
+    if (const auto *literal = ast::as<ast::Literal>(expr.rhs))
+    {
+        const Opcode op = constant_form(generic, swap, literal->value);
+        if (op != Opcode::NOP)
+        {
+            const bool floats = proven(expr.lhs, analysis::Type::FLOAT) &&
+                                float_form(op) != op &&
+                                !std::holds_alternative<std::string_view>(literal->value);
+            at(expr.op);
+            const std::uint16_t index =
+                    literal_constant(literal->value, floats ? StaticType(analysis::Type::FLOAT)
+                                                            : std::nullopt);
+            if (index <= UINT8_MAX)
+            {
+                emit(bytecode::encode(typed_form(op, floats, strings, integral), dest, lhs, index));
+                return;
+            }
+        }
+    }
+
+    const Reg rhs = operand(expr.rhs);
+    at(expr.op);
+    if (generic == Opcode::NOP)
+    {
+        error(expr.op, "Unsupported binary operator.");
+        return;
+    }
+    const bool   floats = proven(expr.lhs, analysis::Type::FLOAT) &&
+                          proven(expr.rhs, analysis::Type::FLOAT);
+    const Opcode op     = typed_form(generic, floats, strings, integral);
+    emit(bytecode::encode(op, dest, swap ? rhs : lhs, swap ? lhs : rhs));
+}
+
+void CodeGenerator::operator()(const ast::Unary &expr, const Reg dest)
+{
+    const Reg value = operand(expr.operand);
+    at(expr.op);
+    const Opcode op = tokens.type(expr.op) == lexer::MINUS ? Opcode::NEG : Opcode::NOT;
+    emit(bytecode::encode(op, dest, value));
+}
+
+void CodeGenerator::operator()(const ast::Logical &expr, const Reg dest)
+{
+    // the left value is the result when it decides the outcome, `dest` never aliases a
+    // local read on the right (assignments route logical values through a temporary)
+    this->expr(expr.lhs, dest);
+    at(expr.op);
+    const Opcode        op   = tokens.type(expr.op) == lexer::OR ? Opcode::JMPIF : Opcode::JMPIFNOT;
+    const std::uint32_t skip = emit_jump(op, dest);
+    this->expr(expr.rhs, dest);
+    patch_jump(skip);
+}
+
+void CodeGenerator::operator()(const ast::Literal &expr, const Reg dest)
+{
+    std::visit(
+            [&](auto &&value) {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, std::monostate>)
+                    emit(bytecode::encode(Opcode::LOADNIL, dest));
+                else if constexpr (std::is_same_v<T, bool>)
+                    emit(bytecode::encode(Opcode::LOADBOOL, dest, value ? 1 : 0));
+                else
+                    emit(bytecode::encode_bx(Opcode::LOADK, dest, literal_constant(expr.value)));
+            },
+            expr.value);
+}
+
+void CodeGenerator::operator()(const ast::Grouping &expr, const Reg dest)
+{
+    this->expr(expr.expr, dest);
+}
+
+void CodeGenerator::operator()(const ast::Variable &expr, const Reg dest)
+{
+    at(expr.name);
+    const ast::Binding &binding = expr.binding;
+    const auto          slot    = static_cast<Reg>(binding.slot);
+    switch (binding.kind)
+    {
+    case ast::Binding::Kind::LOCAL:
+        if (binding.boxed)
+            emit(bytecode::encode(Opcode::GETBOX, dest, slot));
+        else
+            emit_move(dest, slot);
+        break;
+    case ast::Binding::Kind::UPVALUE:
+        emit(bytecode::encode(Opcode::GETUPVAL, dest, slot));
+        if (binding.boxed)
+            emit(bytecode::encode(Opcode::GETBOX, dest, dest));
+        break;
+    case ast::Binding::Kind::GLOBAL:
+        emit(bytecode::encode_bx(Opcode::GETGLOBAL, dest, static_cast<std::uint16_t>(slot)));
+        break;
+    case ast::Binding::Kind::FIELD:
+        emit_get_field(dest, receiver(binding, dest), slot, lexeme(expr.name));
+        break;
+    case ast::Binding::Kind::METHOD: // analysis::Resolver reports these
+    case ast::Binding::Kind::UNRESOLVED:
+    case ast::Binding::Kind::UNDEFINED:
+        break;
+    }
+}
+
+void CodeGenerator::operator()(const ast::Assignment &expr, const Reg dest)
+{
+    at(expr.name);
+    const ast::Binding &binding = expr.binding;
+    const auto          slot    = static_cast<Reg>(binding.slot);
+
+    // a boxed local, in a cell of this function or in one the closure captured
+    if (binding.boxed)
+    {
+        const Reg value = dest != NO_REG ? dest : alloc(expr.name);
+        this->expr(expr.value, value);
+        at(expr.name);
+        Reg cell = slot;
+        if (binding.kind == ast::Binding::Kind::UPVALUE)
+        {
+            cell = alloc(expr.name);
+            emit(bytecode::encode(Opcode::GETUPVAL, cell, slot));
+        }
+        emit(bytecode::encode(Opcode::SETBOX, cell, value));
+        return;
+    }
+
+    switch (binding.kind)
+    {
+    case ast::Binding::Kind::LOCAL:
+        if (writes_dest_last(expr.value))
+        {
+            this->expr(expr.value, slot);
+        }
+        else
+        {
+            const Reg value = alloc(expr.name);
+            this->expr(expr.value, value);
+            emit_move(slot, value);
+        }
+        if (dest != NO_REG)
+            emit_move(dest, slot);
+        return;
+    case ast::Binding::Kind::GLOBAL:
+    case ast::Binding::Kind::FIELD: {
+        const Reg value = dest != NO_REG ? dest : alloc(expr.name);
+        this->expr(expr.value, value);
+        at(expr.name);
+        if (binding.kind == ast::Binding::Kind::GLOBAL)
+            emit(bytecode::encode_bx(Opcode::SETGLOBAL, value, static_cast<std::uint16_t>(slot)));
+        else if (binding.depth == 0)
+            emit_set_field(0, value, slot, lexeme(expr.name));
+        else
+            emit_set_field(receiver(binding, alloc(expr.name)), value, slot, lexeme(expr.name));
+        return;
+    }
+    case ast::Binding::Kind::UPVALUE: // analysis::Resolver reports these
+    case ast::Binding::Kind::METHOD:
+    case ast::Binding::Kind::UNRESOLVED:
+    case ast::Binding::Kind::UNDEFINED:
+        return;
+    }
+}
+
+void CodeGenerator::operator()(const ast::Call &expr, const Reg dest)
+{
+    // the callee (or receiver) and the arguments must sit in consecutive registers, reuse
+    // `dest` as their base when it is the topmost temporary (never a local the arguments
+    // may still read)
+    const bool reuse = dest >= locals_top() && dest + 1 == state->free_reg;
+    const Reg  base  = reuse ? dest : alloc(expr.paren);
+
+    // `method(...)` inside a class invokes on `this`, `object.method(...)` on the object
+    const auto       *callee = ast::as<ast::Variable>(expr.callee);
+    const auto       *member = ast::as<ast::Get>(expr.callee);
+    lexer::TokenIndex method = lexer::NO_TOKEN;
+    if (callee != nullptr && callee->binding.kind == ast::Binding::Kind::METHOD)
+    {
+        method = callee->name;
+        emit_move(base, receiver(callee->binding, base));
+    }
+    else if (member != nullptr)
+    {
+        method = member->name;
+        this->expr(member->object, base);
+    }
+    else
+    {
+        this->expr(expr.callee, base);
+    }
+
+    for (const ast::Expr *argument : expr.arguments)
+        this->expr(argument, alloc(expr.paren));
+
+    at(expr.paren);
+    const auto count = static_cast<Reg>(expr.arguments.size());
+    if (method != lexer::NO_TOKEN)
+        emit_site(Opcode::INVOKE, base, count, lexeme(method));
+    else
+        emit(bytecode::encode(Opcode::CALL, base, count));
+    emit_move(dest, base);
+}
+
+void CodeGenerator::operator()(const ast::Get &expr, const Reg dest)
+{
+    const Reg object = operand(expr.object);
+    at(expr.name);
+    emit_site(Opcode::GETFIELD, dest, object, lexeme(expr.name));
+}
+
+void CodeGenerator::operator()(const ast::Set &expr, const Reg dest)
+{
+    const Reg object = operand(expr.object);
+    Reg       value  = dest;
+    if (dest == NO_REG)
+        value = operand(expr.value);
+    else
+        this->expr(expr.value, dest);
+    at(expr.name);
+    emit_site(Opcode::SETFIELD, object, value, lexeme(expr.name));
+}
+
+void CodeGenerator::begin_scope()
+{
+    state->depth++;
+}
+
+void CodeGenerator::end_scope()
+{
+    state->depth--;
+    while (!state->locals.empty() && state->locals.back().depth > state->depth)
+        state->locals.pop_back();
+    state->free_reg = locals_top();
+}
+
+CodeGenerator::Reg CodeGenerator::declare_local(const lexer::TokenIndex token,
+                                                const StaticType        type)
+{
+    const Reg reg = alloc(token);
+    state->locals.push_back({reg, state->depth, type});
+    return reg;
+}
+
+CodeGenerator::Reg CodeGenerator::locals_top() const
+{
+    return state->locals.empty() ? 0 : state->locals.back().reg + 1;
+}
+
+CodeGenerator::Reg CodeGenerator::alloc(const lexer::TokenIndex token)
+{
+    const Reg reg = state->free_reg++;
+    if (reg >= MAX_REGISTERS)
+    {
+        if (!state->overflowed)
+            error(token, "Too many locals and temporaries in one function.");
+        state->overflowed = true;
+        return MAX_REGISTERS - 1;
+    }
+    state->max_reg = std::max(state->max_reg, state->free_reg);
+    return reg;
+}
+
+std::uint32_t CodeGenerator::string(const std::string_view value)
+{
+    const auto index          = static_cast<std::uint32_t>(module.strings.size());
+    const auto [it, inserted] = strings.try_emplace(std::string(value), index);
+    if (inserted)
+        module.strings.emplace_back(value);
+    return it->second;
+}
+
+std::uint16_t CodeGenerator::constant(const bytecode::Constant &value)
+{
+    const auto key = std::make_tuple(static_cast<int>(value.kind), value.index, value.number,
+                                     value.integer);
+    const auto [it, inserted] = state->constants.try_emplace(
+            key, static_cast<std::uint16_t>(state->function.constants.size()));
+    if (inserted)
+    {
+        if (state->function.constants.size() > UINT16_MAX)
+            Compiler::error(static_cast<int>(line), "Too many constants in one function.");
+        state->function.constants.push_back(value);
+    }
+    return it->second;
+}
+
+std::uint16_t CodeGenerator::literal_constant(const lexer::Literal &value, const StaticType as)
+{
+    if (const auto *string = std::get_if<std::string_view>(&value))
+        return constant({ConstantKind::STRING, 0, this->string(*string)});
+    if (const auto *integer = std::get_if<std::int64_t>(&value))
+    {
+        if (as == analysis::Type::FLOAT)
+            return constant({ConstantKind::NUMBER, static_cast<double>(*integer), 0});
+        return constant({ConstantKind::INTEGER, 0, 0, *integer});
+    }
+    return constant({ConstantKind::NUMBER, std::get<double>(value), 0});
+}
+
+void CodeGenerator::load_constant(const Reg dest, const bytecode::Constant &value)
+{
+    emit(bytecode::encode_bx(Opcode::LOADK, dest, constant(value)));
+}
+
+std::uint32_t CodeGenerator::emit(const bytecode::Instruction instruction)
+{
+    bytecode::Function &function = state->function;
+    const auto          pc       = static_cast<std::uint32_t>(function.code.size());
+    if (function.lines.empty() || function.lines.back().line != line)
+        function.lines.push_back({pc, line});
+    function.code.push_back(instruction);
+    return pc;
+}
+
+void CodeGenerator::emit_site(const Opcode op, const Reg a, const Reg b,
+                              const std::string_view name)
+{
+    emit(bytecode::encode(op, a, b));
+    state->function.code.push_back(static_cast<std::uint32_t>(state->function.sites.size()));
+    state->function.sites.push_back(string(name));
+}
+
+// a field of `this`: subclasses extend the layout of their parent, so the slot is the same
+// for every receiver and the access is a plain index unless the slot does not fit C
+void CodeGenerator::emit_get_field(const Reg dest, const Reg object, const int slot,
+                                   const std::string_view name)
+{
+    if (slot <= UINT8_MAX)
+        emit(bytecode::encode(Opcode::GETSLOT, dest, object, slot));
+    else
+        emit_site(Opcode::GETFIELD, dest, object, name);
+}
+
+void CodeGenerator::emit_set_field(const Reg object, const Reg value, const int slot,
+                                   const std::string_view name)
+{
+    if (slot <= UINT8_MAX)
+        emit(bytecode::encode(Opcode::SETSLOT, object, value, slot));
+    else
+        emit_site(Opcode::SETFIELD, object, value, name);
+}
+
+// `this` of the method a member is used in, loaded into `scratch` in a function nested in it
+CodeGenerator::Reg CodeGenerator::receiver(const ast::Binding &binding, const Reg scratch)
+{
+    if (binding.depth == 0)
+        return 0;
+    emit(bytecode::encode(Opcode::GETUPVAL, scratch, static_cast<Reg>(binding.receiver)));
+    return scratch;
+}
+
+void CodeGenerator::emit_move(const Reg dest, const Reg source)
+{
+    if (dest != source)
+        emit(bytecode::encode(Opcode::MOVE, dest, source));
+}
+
+std::uint32_t CodeGenerator::emit_jump(const Opcode op, const Reg condition)
+{
+    if (op == Opcode::JMP)
+        return emit(bytecode::encode_sj(op, 0));
+    return emit(bytecode::encode_sbx(op, condition, 0));
+}
+
+void CodeGenerator::patch_jump(const std::uint32_t at)
+{
+    std::vector<bytecode::Instruction> &code   = state->function.code;
+    const auto                          offset = static_cast<std::int32_t>(code.size() - at - 1);
+    const Opcode                        op     = bytecode::op_of(code[at]);
+    if (op == Opcode::JMP)
+    {
+        if (offset > bytecode::SJ_MAX)
+            Compiler::error(static_cast<int>(line), "Too much code to jump over.");
+        code[at] = bytecode::encode_sj(op, offset);
+        return;
+    }
+    if (offset > bytecode::SBX_MAX)
+        Compiler::error(static_cast<int>(line), "Too much code to jump over.");
+    code[at] = bytecode::encode_sbx(op, bytecode::a_of(code[at]),
+                                    static_cast<std::int16_t>(offset));
+}
+
+void CodeGenerator::emit_loop(const std::uint32_t start, const Reg condition)
+{
+    auto offset = static_cast<std::int32_t>(start) -
+                  static_cast<std::int32_t>(state->function.code.size()) - 1;
+    if (condition != NO_REG)
+    {
+        if (-offset <= bytecode::SBX_MAX)
+        {
+            emit(bytecode::encode_sbx(Opcode::JMPIF, condition, static_cast<std::int16_t>(offset)));
+            return;
+        }
+        // too far for sBx, skip over a long jump instead
+        emit(bytecode::encode_sbx(Opcode::JMPIFNOT, condition, 1));
+        offset -= 1;
+    }
+    if (-offset > bytecode::SJ_MAX)
+        Compiler::error(static_cast<int>(line), "Loop body too large.");
+    emit(bytecode::encode_sj(Opcode::JMP, offset));
+}
+
+void CodeGenerator::at(const lexer::TokenIndex token)
+{
+    if (token != lexer::NO_TOKEN)
+        line = static_cast<std::uint32_t>(tokens.line(token));
+}
+
+void CodeGenerator::error(const lexer::TokenIndex token, const std::string &message) const
+{
+    if (token == lexer::NO_TOKEN)
+        Compiler::error(static_cast<int>(line), message);
+    else
+        Compiler::error(tokens.token(token), message);
+}
+
+bool CodeGenerator::is_top_level() const
+{
+    return state->enclosing == nullptr && state->depth == 0;
+}
+
+std::string_view CodeGenerator::lexeme(const lexer::TokenIndex token) const
+{
+    return tokens.lexeme(token);
+}
+
+CodeGenerator::StaticType CodeGenerator::declared_type(const lexer::TokenIndex token) const
+{
+    if (token == lexer::NO_TOKEN)
+        return std::nullopt;
+    switch (tokens.type(token))
+    {
+    case lexer::INT:
+        return analysis::Type::INT;
+    case lexer::FLOAT:
+        return analysis::Type::FLOAT;
+    case lexer::STRING_TYPE:
+        return analysis::Type::STRING;
+    case lexer::BOOL:
+        return analysis::Type::BOOL;
+    case lexer::VOID:
+        return analysis::Type::VOID;
+    default:
+        return std::nullopt;
+    }
+}
+
+// the type checker's, a hint for opcode selection unless the expression is also `proven`
+CodeGenerator::StaticType CodeGenerator::static_type(const ast::Expr *expr) const
+{
+    return expr != nullptr ? expr->type : std::nullopt;
+}
+} // namespace cool::compiler::codegen
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "../analysis/type.hpp"
+#include "../ast/stmt.hpp"
+#include "../lexer/token_stream.hpp"
+#include "bytecode/module.hpp"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace cool::compiler::codegen {
+namespace bytecode = vm::bytecode;
+
+/* Lowers the AST of a compilation unit to a bytecode module for the register VM.
+ *
+ * Every function gets a register window: parameters (after `this` for methods) and
+ * block-scoped locals occupy fixed registers in declaration order and temporaries are
+ * allocated stack-wise above them, so a local is used directly as an instruction operand.
+ * Top-level `val`/`var`, functions and classes become module globals addressed by index.
+ * Names are bound by analysis::Resolver beforehand. A nested function that captures locals
+ * is created by CLOSURE, and a boxed local holds the cell its value lives in.
+ *
+ * With `optimize` set, function and method bodies go through the SSA IR instead (see
+ * ir/builder.hpp and lowering.hpp) unless they use something it does not model. With
+ * `fuse` set, common instruction pairs become superinstructions (see peephole.hpp).
+ */
+struct CodeGenerator
+{
+    using Reg                   = int;
+    static constexpr Reg NO_REG = -1;
+
+    // the type an expression is known to have at compile time, if any
+    using StaticType = std::optional<analysis::Type>;
+
+    // the register a local lives in, which analysis::Resolver numbered the same way
+    struct Local
+    {
+        Reg        reg;
+        int        depth;
+        StaticType type;
+    };
+
+    struct ClassInfo
+    {
+        std::uint32_t                 index  = 0;
+        std::uint16_t                 global = 0;
+        const ast::Class             *node   = nullptr;
+        const ClassInfo              *parent = nullptr;
+        std::vector<std::string_view> fields;
+        std::vector<std::string_view> methods;
+
+        [[nodiscard]] int  field_slot(lexer::Symbol name) const;
+        [[nodiscard]] bool has_method(std::string_view name) const;
+    };
+
+    // kind, index, number and integer of a pooled constant
+    using ConstantKey = std::tuple<int, std::uint32_t, double, std::int64_t>;
+
+    struct FunctionState
+    {
+        FunctionState                       *enclosing = nullptr;
+        std::uint32_t                        index     = 0;
+        const ClassInfo                     *klass     = nullptr;
+        bytecode::Function                   function;
+        std::vector<Local>                   locals;
+        int                                  depth      = 0;
+        Reg                                  free_reg   = 0;
+        Reg                                  max_reg    = 0;
+        bool                                 overflowed = false; // out of registers, reported
+        std::map<ConstantKey, std::uint16_t> constants;
+    };
+
+    const lexer::TokenStream                            &tokens;
+    bytecode::Module                                     module;
+    std::unordered_map<std::string, std::uint32_t>       strings;
+    std::unordered_map<std::string_view, std::uint16_t>  globals;
+    std::unordered_map<std::string_view, ClassInfo>      classes;
+    FunctionState                                       *state    = nullptr;
+    std::uint32_t                                        line     = 0;
+    bool                                                 optimize = false; // through the IR
+    bool                                                 fuse     = false; // superinstructions
+    bool                                                 dump_ir  = false;
+
+    explicit CodeGenerator(const lexer::TokenStream &tokens);
+    bytecode::Module generate(const ast::StmtList &program);
+
+    // declarations
+    void          declare_globals(const ast::StmtList &program);
+    void          link_classes();
+    std::uint32_t function(const ast::Function &node, const ClassInfo *klass);
+    bool          lower(const ast::Function &node);
+    void          class_declaration(const ClassInfo &info);
+    void          begin_function(FunctionState &fs, std::string_view name, const ClassInfo *klass);
+    std::uint32_t end_function(FunctionState &fs);
+
+    // statements
+    void statement(const ast::Stmt *stmt);
+    void operator()(const ast::VarDecl &stmt);
+    void operator()(const ast::ExprStatement &stmt);
+    void operator()(const ast::If &stmt);
+    void operator()(const ast::While &stmt);
+    void operator()(const ast::Return &stmt);
+    void operator()(const ast::Print &stmt);
+    void operator()(const ast::Function &stmt);
+    void operator()(const ast::Class &stmt);
+    void operator()(const ast::Block &stmt);
+
+    // expressions, each writes its value to `dest` and leaves the free register unchanged
+    void expr(const ast::Expr *expr, Reg dest);
+    Reg  operand(const ast::Expr *expr, Reg scratch = NO_REG);
+    void operator()(const ast::Binary &expr, Reg dest);
+    void operator()(const ast::Unary &expr, Reg dest);
+    void operator()(const ast::Logical &expr, Reg dest);
+    void operator()(const ast::Literal &expr, Reg dest);
+    void operator()(const ast::Grouping &expr, Reg dest);
+    void operator()(const ast::Variable &expr, Reg dest);
+    void operator()(const ast::Assignment &expr, Reg dest);
+    void operator()(const ast::Call &expr, Reg dest);
+    void operator()(const ast::Get &expr, Reg dest);
+    void operator()(const ast::Set &expr, Reg dest);
+
+    // helpers
+    void                   begin_scope();
+    void                   end_scope();
+    Reg                    declare_local(lexer::TokenIndex token, StaticType type = std::nullopt);
+    [[nodiscard]] Reg      locals_top() const;
+    Reg                    alloc(lexer::TokenIndex token = lexer::NO_TOKEN);
+    std::uint32_t          string(std::string_view value);
+    std::uint16_t          constant(const bytecode::Constant &value);
+    std::uint16_t          literal_constant(const lexer::Literal &value,
+                                            StaticType      as = std::nullopt);
+    void                   load_constant(Reg dest, const bytecode::Constant &value);
+    std::uint32_t          emit(bytecode::Instruction instruction);
+    void                   emit_site(bytecode::Opcode op, Reg a, Reg b, std::string_view name);
+    void                   emit_get_field(Reg dest, Reg object, int slot, std::string_view name);
+    void                   emit_set_field(Reg object, Reg value, int slot, std::string_view name);
+    Reg                    receiver(const ast::Binding &binding, Reg scratch);
+    void                   emit_move(Reg dest, Reg source);
+    std::uint32_t          emit_jump(bytecode::Opcode op, Reg condition = 0);
+    void                   patch_jump(std::uint32_t at);
+    void                   emit_loop(std::uint32_t start, Reg condition = NO_REG);
+    void                   at(lexer::TokenIndex token);
+    void                   error(lexer::TokenIndex token, const std::string &message) const;
+    [[nodiscard]] bool     is_top_level() const;
+    [[nodiscard]] std::string_view lexeme(lexer::TokenIndex token) const;
+
+    // static types, only used to pick the integer forms of the arithmetic opcodes
+    [[nodiscard]] StaticType declared_type(lexer::TokenIndex token) const;
+    [[nodiscard]] StaticType static_type(const ast::Expr *expr) const;
+};
+} // namespace cool::compiler::codegen
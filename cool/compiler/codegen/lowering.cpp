@@ -0,0 +1,686 @@
+#include "lowering.hpp"
+
+#include "opcode_forms.hpp"
+
+#include <algorithm>
+#include <variant>
+
+namespace cool::compiler::codegen {
+using ir::Block;
+using ir::Instr;
+using ir::Op;
+
+namespace {
+// register_count is a byte
+constexpr CodeGenerator::Reg MAX_REGISTERS = UINT8_MAX;
+
+bool is_call(const Instr *instr)
+{
+    return instr->op == Op::CALL || instr->op == Op::INVOKE;
+}
+
+bool is_binary(const Op op)
+{
+    return op >= Op::ADD && op <= Op::GE;
+}
+
+// the register opcode of a binary IR op; GT and GE are LT and LE with the operands swapped
+Opcode binary_opcode(const Op op, bool &swap)
+{
+    swap = op == Op::GT || op == Op::GE;
+    switch (op)
+    {
+    case Op::ADD:
+        return Opcode::ADD;
+    case Op::SUB:
+        return Opcode::SUB;
+    case Op::MUL:
+        return Opcode::MUL;
+    case Op::DIV:
+        return Opcode::DIV;
+    case Op::MOD:
+        return Opcode::MOD;
+    case Op::POW:
+        return Opcode::POW;
+    case Op::EQ:
+        return Opcode::EQ;
+    case Op::NE:
+        return Opcode::NE;
+    case Op::LT:
+    case Op::GT:
+        return Opcode::LT;
+    default:
+        return Opcode::LE;
+    }
+}
+} // namespace
+
+Lowering::Lowering(CodeGenerator &generator, ir::Function &function)
+    : generator{generator}, function{function}
+{
+}
+
+bool Lowering::lower()
+{
+    split_critical_edges();
+    function.analyze();
+    uses  = function.use_counts();
+    kinds = ir::known_kinds(function);
+    pool_constants();
+    place_operands();
+    liveness();
+    color();
+    if (!open_windows() || registers > MAX_REGISTERS)
+        return false;
+
+    // the entry comes first, empty blocks are jumped through
+    starts.assign(function.blocks.size(), 0);
+    const std::vector<Block *> &order = function.rpo;
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        if (i != 0 && target(order[i]) != order[i])
+            continue;
+        Block *next = nullptr;
+        for (std::size_t j = i + 1; j < order.size() && next == nullptr; ++j)
+            if (target(order[j]) == order[j])
+                next = order[j];
+        starts[order[i]->id] = static_cast<std::uint32_t>(generator.state->function.code.size());
+        emit_block(order[i], next);
+    }
+    if (!patch_jumps() || registers > MAX_REGISTERS)
+        return false;
+    generator.state->max_reg = std::max(generator.state->max_reg, registers);
+    return true;
+}
+
+// an edge from a block with several successors to one with several predecessors gets a
+// block of its own
+void Lowering::split_critical_edges()
+{
+    for (std::size_t i = 0, count = function.blocks.size(); i < count; ++i)
+    {
+        Block *block = function.blocks[i].get();
+        if (block->order < 0 || block->succs.size() < 2)
+            continue;
+        for (Block *&succ : block->succs)
+        {
+            if (succ->preds.size() < 2)
+                continue;
+            Block *edge = function.make_block();
+            function.make(Op::JUMP, edge)->line = block->terminator()->line;
+            *std::find(succ->preds.begin(), succ->preds.end(), block) = edge;
+            edge->preds.push_back(block);
+            edge->succs.push_back(succ);
+            succ = edge;
+        }
+    }
+}
+
+void Lowering::pool_constants()
+{
+    pooled.assign(function.instrs.size(), false);
+    for (const Block *block : function.rpo)
+        for (const Instr *instr : block->instrs)
+            if (instr->op == Op::CONST && uses[instr->id] > 0)
+                pooled[instr->id] = true;
+
+    for (const Block *block : function.rpo)
+    {
+        for (const Instr *instr : block->instrs)
+        {
+            bool         swap    = false;
+            const Opcode generic = is_binary(instr->op) ? binary_opcode(instr->op, swap)
+                                                        : Opcode::NOP;
+            for (std::size_t i = 0; i < instr->operands.size(); ++i)
+            {
+                const Instr *operand = instr->operands[i];
+                if (operand->op != Op::CONST)
+                    continue;
+                if (i != 1 || constant_form(generic, swap, operand->literal) == Opcode::NOP)
+                    pooled[operand->id] = false;
+            }
+        }
+    }
+    for (const Block *block : function.rpo)
+        for (const Instr *instr : block->instrs)
+            if (pooled[instr->id] && generator.literal_constant(instr->literal) > UINT8_MAX)
+                pooled[instr->id] = false;
+}
+
+/* An operand only the call uses, defined in the same block, goes straight into its window.
+ * Placing them is simulated block by block with the windows on a stack: a call whose window
+ * is not on top when it is made, or whose slots would not be filled in order, loses its
+ * placed operands and the simulation runs again.
+ */
+void Lowering::place_operands()
+{
+    slots.assign(function.instrs.size(), {});
+    regs.assign(function.instrs.size(), CodeGenerator::NO_REG);
+    bases.assign(function.instrs.size(), CodeGenerator::NO_REG);
+    for (const Block *block : function.rpo)
+    {
+        for (Instr *instr : block->instrs)
+        {
+            if (!is_call(instr))
+                continue;
+            for (std::size_t i = 0; i < instr->operands.size(); ++i)
+            {
+                const Instr *operand = instr->operands[i];
+                if (operand->block == block && uses[operand->id] == 1 && operand->op != Op::PHI &&
+                    operand->op != Op::PARAM && !pooled[operand->id])
+                    slots[operand->id] = {instr, static_cast<Reg>(i)};
+            }
+        }
+    }
+    while (!simulate())
+    {
+    }
+}
+
+void Lowering::liveness()
+{
+    const std::size_t count = function.instrs.size();
+    live_in.assign(function.blocks.size(), std::vector<bool>(count));
+    live_out.assign(function.blocks.size(), std::vector<bool>(count));
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (auto it = function.rpo.rbegin(); it != function.rpo.rend(); ++it)
+        {
+            Block            *block = *it;
+            std::vector<bool> out(count);
+            for (const Block *succ : block->succs)
+            {
+                const auto edge = static_cast<std::size_t>(
+                        std::find(succ->preds.begin(), succ->preds.end(), block) -
+                        succ->preds.begin());
+                for (std::size_t i = 0; i < count; ++i)
+                    if (live_in[succ->id][i])
+                        out[i] = true;
+                for (std::size_t i = 0; i < succ->phi_count(); ++i)
+                    if (const Instr *operand = succ->instrs[i]->operands[edge];
+                        needs_register(operand))
+                        out[operand->id] = true;
+            }
+
+            std::vector<bool> in = out;
+            for (auto instr = block->instrs.rbegin(); instr != block->instrs.rend(); ++instr)
+            {
+                in[(*instr)->id] = false;
+                if ((*instr)->op == Op::PHI)
+                    continue;
+                for (const Instr *operand : (*instr)->operands)
+                    if (needs_register(operand))
+                        in[operand->id] = true;
+            }
+            if (in != live_in[block->id] || out != live_out[block->id])
+            {
+                live_in[block->id]  = std::move(in);
+                live_out[block->id] = std::move(out);
+                changed             = true;
+            }
+        }
+    }
+}
+
+/* Blocks in reverse postorder see every dominator first, so what is live into a block
+ * already has a register. A value takes the register of the phi it flows into or of an
+ * operand that dies with it when those are free, the lowest free one otherwise.
+ */
+void Lowering::color()
+{
+    const std::size_t count = function.instrs.size();
+
+    // the phi each value flows into, if any
+    std::vector<const Instr *> phi_of(count);
+    for (const Block *block : function.rpo)
+        for (std::size_t i = 0; i < block->phi_count(); ++i)
+            for (const Instr *operand : block->instrs[i]->operands)
+                if (phi_of[operand->id] == nullptr)
+                    phi_of[operand->id] = block->instrs[i];
+
+    // a method returns its receiver from register 0 when it is an initializer, the register
+    // stays with `this` for the whole call as it does in the AST code generator
+    const Reg reserved = generator.state->function.is_method ? 1 : 0;
+    colors             = std::max(colors, reserved);
+
+    for (const Instr *instr : function.entry->instrs)
+    {
+        if (instr->op == Op::PARAM && needs_register(instr))
+        {
+            regs[instr->id] = static_cast<Reg>(instr->index);
+            colors          = std::max(colors, regs[instr->id] + 1);
+        }
+    }
+
+    for (const Block *block : function.rpo)
+    {
+        std::vector<bool> busy(MAX_REGISTERS + 1);
+        for (Reg reg = 0; reg < reserved; ++reg)
+            busy[reg] = true;
+        const auto        take = [&](const Instr *instr, std::vector<Reg> preferred) {
+            Reg reg = CodeGenerator::NO_REG;
+            for (const Reg candidate : preferred)
+            {
+                if (candidate != CodeGenerator::NO_REG && candidate <= MAX_REGISTERS &&
+                    !busy[candidate])
+                {
+                    reg = candidate;
+                    break;
+                }
+            }
+            for (Reg candidate = 0; reg == CodeGenerator::NO_REG; ++candidate)
+                if (candidate > MAX_REGISTERS || !busy[candidate])
+                    reg = candidate;
+            regs[instr->id] = reg;
+            colors          = std::max(colors, reg + 1);
+            if (reg <= MAX_REGISTERS)
+                busy[reg] = true;
+        };
+
+        for (std::size_t i = 0; i < count; ++i)
+            if (live_in[block->id][i] && regs[i] <= MAX_REGISTERS && regs[i] >= 0)
+                busy[regs[i]] = true;
+        for (const Instr *instr : block->instrs)
+            if (instr->op == Op::PARAM && regs[instr->id] >= 0)
+                busy[regs[instr->id]] = true;
+
+        // the values each instruction is the last to read
+        std::vector<std::vector<const Instr *>> dying(block->instrs.size());
+        std::vector<bool>                       live = live_out[block->id];
+        for (std::size_t i = block->instrs.size(); i-- > block->phi_count();)
+        {
+            const Instr *instr = block->instrs[i];
+            live[instr->id]    = false;
+            for (const Instr *operand : instr->operands)
+            {
+                if (needs_register(operand) && !live[operand->id])
+                {
+                    live[operand->id] = true;
+                    dying[i].push_back(operand);
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < block->instrs.size(); ++i)
+        {
+            const Instr *instr = block->instrs[i];
+            if (instr->op == Op::PHI)
+            {
+                std::vector<Reg> preferred;
+                for (const Instr *operand : instr->operands)
+                    preferred.push_back(regs[operand->id]);
+                take(instr, std::move(preferred));
+                continue;
+            }
+            for (const Instr *operand : dying[i])
+                if (regs[operand->id] >= reserved && regs[operand->id] <= MAX_REGISTERS)
+                    busy[regs[operand->id]] = false;
+            if (instr->op == Op::PARAM || !needs_register(instr))
+                continue;
+
+            std::vector<Reg> preferred;
+            if (const Instr *phi = phi_of[instr->id])
+                preferred.push_back(regs[phi->id]);
+            for (const Instr *operand : dying[i])
+                preferred.push_back(regs[operand->id]);
+            take(instr, std::move(preferred));
+            if (uses[instr->id] == 0 && regs[instr->id] >= reserved &&
+                regs[instr->id] <= MAX_REGISTERS)
+                busy[regs[instr->id]] = false;
+        }
+    }
+}
+
+bool Lowering::open_windows()
+{
+    const CodeGenerator::FunctionState &state = *generator.state;
+    registers = std::max<Reg>(colors, state.function.arity + (state.function.is_method ? 1 : 0));
+    return simulate();
+}
+
+/* Walks every block with the open windows on a stack. A window opens with the first operand
+ * placed in it (or at the call), above every register and window in use, or at the slot of
+ * the call it is an operand of when that call's window is on top. A call that breaks the
+ * discipline loses its placed operands, false when any did. Once nothing changes the bases
+ * and registers it records are final.
+ */
+bool Lowering::simulate()
+{
+    bool ok = true;
+    for (const Block *block : function.rpo)
+    {
+        std::vector<Window> stack;
+        const auto          find = [&](const Instr *call) {
+            return std::find_if(stack.begin(), stack.end(),
+                                [&](const Window &window) { return window.call == call; });
+        };
+        const auto open = [&](Instr *call, const auto &self) -> std::size_t {
+            if (const auto it = find(call); it != stack.end())
+                return static_cast<std::size_t>(it - stack.begin());
+            const Slot parent = slots[call->id];
+            if (parent.call != nullptr)
+                self(parent.call, self);
+            Reg base = colors;
+            for (const Window &window : stack)
+                base = std::max(base, window.base + static_cast<Reg>(window.call->operands.size()));
+            if (parent.call != nullptr && !stack.empty() && stack.back().call == parent.call &&
+                parent.index > stack.back().filled)
+                base = stack.back().base + parent.index;
+            stack.push_back({call, base, -1});
+            return stack.size() - 1;
+        };
+        const auto unplace = [&](const Instr *call) {
+            for (const Instr *operand : call->operands)
+                if (slots[operand->id].call == call)
+                    slots[operand->id] = {};
+            ok = false;
+        };
+
+        for (Instr *instr : block->instrs)
+        {
+            if (is_call(instr))
+            {
+                const std::size_t at = open(instr, open);
+                if (at + 1 != stack.size())
+                    unplace(instr);
+                const Window &window = stack[at];
+                bases[instr->id]     = window.base;
+                registers = std::max(registers,
+                                     window.base + static_cast<Reg>(instr->operands.size()));
+                stack.erase(stack.begin() + static_cast<std::ptrdiff_t>(at));
+            }
+            if (const Slot slot = slots[instr->id]; slot.call != nullptr)
+            {
+                Window &window = stack[open(slot.call, open)];
+                if (slot.index <= window.filled)
+                    unplace(slot.call);
+                window.filled   = std::max(window.filled, slot.index);
+                regs[instr->id] = window.base + slot.index;
+            }
+        }
+    }
+    return ok;
+}
+
+bool Lowering::needs_register(const Instr *instr) const
+{
+    if (!ir::defines_value(*instr) || pooled[instr->id] || slots[instr->id].call != nullptr)
+        return false;
+    switch (instr->op)
+    {
+    case Op::CONST:
+    case Op::PARAM:
+    case Op::PHI:
+    case Op::CALL:
+    case Op::INVOKE:
+        return uses[instr->id] > 0;
+    default:
+        return true; // kept for the error it may raise even when unused
+    }
+}
+
+void Lowering::emit_block(Block *block, Block *next)
+{
+    for (Instr *instr : block->instrs)
+    {
+        generator.line = instr->line;
+        switch (instr->op)
+        {
+        case Op::JUMP:
+            emit_copies(block);
+            if (Block *to = target(block->succs[0]); to != next)
+                emit_jump(Opcode::JMP, 0, to);
+            break;
+        case Op::BRANCH: {
+            const Reg condition = reg(instr->operands[0]);
+            Block    *taken     = target(block->succs[0]);
+            Block    *not_taken = target(block->succs[1]);
+            if (not_taken == next)
+            {
+                emit_jump(Opcode::JMPIF, condition, taken);
+            }
+            else if (taken == next)
+            {
+                emit_jump(Opcode::JMPIFNOT, condition, not_taken);
+            }
+            else
+            {
+                emit_jump(Opcode::JMPIF, condition, taken);
+                emit_jump(Opcode::JMP, 0, not_taken);
+            }
+            break;
+        }
+        case Op::RETURN:
+            if (instr->operands.empty())
+                generator.emit(bytecode::encode(Opcode::RETURN, 0, 0));
+            else
+                generator.emit(bytecode::encode(Opcode::RETURN, reg(instr->operands[0]), 1));
+            break;
+        default:
+            emit_instruction(instr);
+            break;
+        }
+    }
+}
+
+void Lowering::emit_instruction(Instr *instr)
+{
+    const auto index = static_cast<std::uint8_t>(instr->index);
+    switch (instr->op)
+    {
+    case Op::CONST:
+        if (!needs_register(instr) && slots[instr->id].call == nullptr)
+            return;
+        std::visit(
+                [&](auto &&value) {
+                    using T = std::decay_t<decltype(value)>;
+                    if constexpr (std::is_same_v<T, std::monostate>)
+                        generator.emit(bytecode::encode(Opcode::LOADNIL, reg(instr)));
+                    else if constexpr (std::is_same_v<T, bool>)
+                        generator.emit(bytecode::encode(Opcode::LOADBOOL, reg(instr), value));
+                    else
+                        generator.emit(bytecode::encode_bx(
+                                Opcode::LOADK, reg(instr),
+                                generator.literal_constant(instr->literal)));
+                },
+                instr->literal);
+        return;
+    case Op::PARAM:
+    case Op::PHI:
+        return;
+    case Op::NEG:
+    case Op::NOT:
+        generator.emit(bytecode::encode(instr->op == Op::NEG ? Opcode::NEG : Opcode::NOT,
+                                        reg(instr), reg(instr->operands[0])));
+        return;
+    case Op::GETGLOBAL:
+        generator.emit(bytecode::encode_bx(Opcode::GETGLOBAL, reg(instr),
+                                           static_cast<std::uint16_t>(instr->index)));
+        return;
+    case Op::SETGLOBAL:
+        generator.emit(bytecode::encode_bx(Opcode::SETGLOBAL, reg(instr->operands[0]),
+                                           static_cast<std::uint16_t>(instr->index)));
+        return;
+    case Op::GETSLOT:
+        if (instr->index <= UINT8_MAX)
+            generator.emit(bytecode::encode(Opcode::GETSLOT, reg(instr), reg(instr->operands[0]),
+                                            index));
+        else
+            generator.emit_site(Opcode::GETFIELD, reg(instr), reg(instr->operands[0]),
+                                instr->name);
+        return;
+    case Op::SETSLOT:
+        if (instr->index <= UINT8_MAX)
+            generator.emit(bytecode::encode(Opcode::SETSLOT, reg(instr->operands[0]),
+                                            reg(instr->operands[1]), index));
+        else
+            generator.emit_site(Opcode::SETFIELD, reg(instr->operands[0]),
+                                reg(instr->operands[1]), instr->name);
+        return;
+    case Op::GETFIELD:
+        generator.emit_site(Opcode::GETFIELD, reg(instr), reg(instr->operands[0]), instr->name);
+        return;
+    case Op::SETFIELD:
+        generator.emit_site(Opcode::SETFIELD, reg(instr->operands[0]), reg(instr->operands[1]),
+                            instr->name);
+        return;
+    case Op::CALL:
+    case Op::INVOKE:
+        emit_call(instr);
+        return;
+    case Op::PRINT:
+        generator.emit(bytecode::encode(Opcode::PRINT, reg(instr->operands[0])));
+        return;
+    default:
+        emit_binary(instr);
+        return;
+    }
+}
+
+void Lowering::emit_binary(Instr *instr)
+{
+    const Instr *lhs = instr->operands[0];
+    const Instr *rhs = instr->operands[1];
+
+    // int operands get the integer opcodes, which still fall back to the generic handler,
+    // known floats and strings the typed ones
+    const bool integral = lhs->type == analysis::Type::INT && rhs->type == analysis::Type::INT;
+    const bool strings  = kinds[lhs->id] == ir::Kind::STRING && kinds[rhs->id] == ir::Kind::STRING;
+    bool       swap     = false;
+    Opcode     op       = binary_opcode(instr->op, swap);
+    if (pooled[rhs->id])
+    {
+        // against a float, a number is pooled as the float it would be converted to
+        const Opcode  form   = constant_form(op, swap, rhs->literal);
+        std::uint16_t index  = generator.literal_constant(rhs->literal);
+        bool          floats = kinds[lhs->id] == ir::Kind::FLOAT && float_form(form) != form &&
+                      (kinds[rhs->id] == ir::Kind::FLOAT || kinds[rhs->id] == ir::Kind::INT);
+        if (floats)
+        {
+            const std::uint16_t converted =
+                    generator.literal_constant(rhs->literal, analysis::Type::FLOAT);
+            floats = converted <= UINT8_MAX;
+            if (floats)
+                index = converted;
+        }
+        generator.emit(bytecode::encode(typed_form(form, floats, strings, integral), reg(instr),
+                                        reg(lhs), static_cast<Reg>(index)));
+        return;
+    }
+
+    const bool floats = kinds[lhs->id] == ir::Kind::FLOAT && kinds[rhs->id] == ir::Kind::FLOAT;
+    op                = typed_form(op, floats, strings, integral);
+    generator.emit(bytecode::encode(op, reg(instr), reg(swap ? rhs : lhs), reg(swap ? lhs : rhs)));
+}
+
+void Lowering::emit_call(Instr *instr)
+{
+    const Reg base = bases[instr->id];
+    for (std::size_t i = 0; i < instr->operands.size(); ++i)
+        generator.emit_move(base + static_cast<Reg>(i), reg(instr->operands[i]));
+
+    const auto count = static_cast<Reg>(instr->operands.size() - 1);
+    if (instr->op == Op::INVOKE)
+        generator.emit_site(Opcode::INVOKE, base, count, instr->name);
+    else
+        generator.emit(bytecode::encode(Opcode::CALL, base, count));
+    if (regs[instr->id] != CodeGenerator::NO_REG)
+        generator.emit_move(regs[instr->id], base);
+}
+
+// the phi copies on the edge out of `block`, as a parallel copy: a cycle is broken by
+// moving one destination aside first
+void Lowering::emit_copies(Block *block)
+{
+    std::vector<std::pair<Reg, Reg>> copies = copies_out(block);
+    while (!copies.empty())
+    {
+        const auto ready = std::find_if(copies.begin(), copies.end(), [&](const auto &copy) {
+            return std::none_of(copies.begin(), copies.end(),
+                                [&](const auto &other) { return other.second == copy.first; });
+        });
+        if (ready != copies.end())
+        {
+            generator.emit_move(ready->first, ready->second);
+            copies.erase(ready);
+            continue;
+        }
+        const Reg temp  = registers;
+        const Reg saved = copies.front().first;
+        registers       = std::max(registers, temp + 1);
+        generator.emit_move(temp, saved);
+        for (auto &copy : copies)
+            if (copy.second == saved)
+                copy.second = temp;
+    }
+}
+
+std::vector<std::pair<Lowering::Reg, Lowering::Reg>> Lowering::copies_out(const Block *block) const
+{
+    std::vector<std::pair<Reg, Reg>> copies;
+    if (block->succs.size() != 1)
+        return copies;
+    const Block *succ = block->succs[0];
+    const auto   edge = static_cast<std::size_t>(
+            std::find(succ->preds.begin(), succ->preds.end(), block) - succ->preds.begin());
+    for (std::size_t i = 0; i < succ->phi_count(); ++i)
+    {
+        const Instr *phi = succ->instrs[i];
+        if (regs[phi->id] != regs[phi->operands[edge]->id])
+            copies.emplace_back(regs[phi->id], regs[phi->operands[edge]->id]);
+    }
+    return copies;
+}
+
+void Lowering::emit_jump(const Opcode op, const Reg condition, Block *target)
+{
+    const std::uint32_t pc = op == Opcode::JMP
+                                     ? generator.emit(bytecode::encode_sj(op, 0))
+                                     : generator.emit(bytecode::encode_sbx(op, condition, 0));
+    jumps.emplace_back(pc, target);
+}
+
+bool Lowering::patch_jumps()
+{
+    std::vector<bytecode::Instruction> &code = generator.state->function.code;
+    for (const auto &[pc, block] : jumps)
+    {
+        const auto   offset = static_cast<std::int32_t>(starts[block->id]) -
+                            static_cast<std::int32_t>(pc) - 1;
+        const Opcode op     = bytecode::op_of(code[pc]);
+        if (op == Opcode::JMP)
+        {
+            if (offset > bytecode::SJ_MAX || -offset > bytecode::SJ_MAX)
+                return false;
+            code[pc] = bytecode::encode_sj(op, offset);
+            continue;
+        }
+        if (offset > bytecode::SBX_MAX || -offset > bytecode::SBX_MAX)
+            return false;
+        code[pc] = bytecode::encode_sbx(op, bytecode::a_of(code[pc]),
+                                        static_cast<std::int16_t>(offset));
+    }
+    return true;
+}
+
+// the block control ends up in from `block` when it only jumps on, `block` itself otherwise
+Block *Lowering::target(Block *block) const
+{
+    Block *to = block;
+    for (std::size_t steps = 0; to->instrs.size() == 1 && to->instrs[0]->op == Op::JUMP &&
+                                to != function.entry && copies_out(to).empty();
+         ++steps)
+    {
+        if (steps == function.blocks.size())
+            return block;
+        to = to->succs[0];
+    }
+    return to;
+}
+
+CodeGenerator::Reg Lowering::reg(const Instr *instr) const
+{
+    return regs[instr->id];
+}
+} // namespace cool::compiler::codegen
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../ir/ir.hpp"
+#include "../ir/passes.hpp"
+#include "code_generator.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cool::compiler::codegen {
+/* Lowers an optimized ir::Function into the current function of the code generator.
+ *
+ * Registers come from coloring the SSA values in dominator order (the interference graph
+ * of an SSA program is chordal, a value takes the first register free where it is defined),
+ * biased so a phi and its operands tend to share one and the copies on the edges vanish.
+ * Parameters keep the registers they arrive in.
+ *
+ * Calls need the callee and the arguments in consecutive registers, and the callee's frame
+ * overwrites everything above the first of them. A call gets a window above every colored
+ * register, and an operand used only by the call, defined in its block, is computed
+ * straight into its slot; a call whose result is such an operand gets its window at that
+ * slot, as nested calls do in the AST code generator. Windows left open across another call
+ * would be overwritten by it, so a call whose window cannot be kept on top gets its
+ * operands moved in right before it instead.
+ *
+ * Constants only used as the right operand of an operator with a *K form stay in the
+ * constant pool. Critical edges are split so the copies for a phi have a block to go in.
+ * Operators on values ir::known_kinds finds to be floats or strings get the typed opcodes.
+ */
+struct Lowering
+{
+    using Reg = CodeGenerator::Reg;
+
+    // where a value used only by a call is computed
+    struct Slot
+    {
+        ir::Instr *call = nullptr;
+        Reg        index = 0;
+    };
+
+    struct Window
+    {
+        ir::Instr *call;
+        Reg        base;
+        Reg        filled; // highest slot holding its operand
+    };
+
+    CodeGenerator                   &generator;
+    ir::Function                    &function;
+    std::vector<std::uint32_t>       uses;
+    std::vector<ir::Kind>            kinds;   // per value, picks the typed opcodes
+    std::vector<bool>                pooled;  // constants read from the pool by every user
+    std::vector<Slot>                slots;   // per value, `call` set when placed in a window
+    std::vector<Reg>                 regs;    // per value
+    std::vector<Reg>                 bases;   // per call, its window
+    std::vector<std::vector<bool>>   live_in; // per block, by value
+    std::vector<std::vector<bool>>   live_out;
+    Reg                              colors    = 0; // registers below the windows
+    Reg                              registers = 0;
+    std::vector<std::uint32_t>       starts;        // per block, its first instruction
+    std::vector<std::pair<std::uint32_t, ir::Block *>> jumps; // to patch
+
+    Lowering(CodeGenerator &generator, ir::Function &function);
+
+    // false when the function cannot be lowered, the caller then discards what was emitted
+    bool lower();
+
+    // register assignment
+    void split_critical_edges();
+    void pool_constants();
+    void place_operands();
+    void liveness();
+    void color();
+    bool open_windows();
+    bool simulate();
+    [[nodiscard]] bool needs_register(const ir::Instr *instr) const;
+
+    // emission
+    void emit_block(ir::Block *block, ir::Block *next);
+    void emit_instruction(ir::Instr *instr);
+    void emit_binary(ir::Instr *instr);
+    void emit_call(ir::Instr *instr);
+    void emit_copies(ir::Block *block);
+    [[nodiscard]] std::vector<std::pair<Reg, Reg>> copies_out(const ir::Block *block) const;
+    void emit_jump(bytecode::Opcode op, Reg condition, ir::Block *target);
+    bool patch_jumps();
+    [[nodiscard]] ir::Block *target(ir::Block *block) const;
+    [[nodiscard]] Reg        reg(const ir::Instr *instr) const;
+};
+} // namespace cool::compiler::codegen
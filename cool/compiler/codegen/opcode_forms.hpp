@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../lexer/token.hpp"
+#include "bytecode/opcode.hpp"
+
+#include <variant>
+
+namespace cool::compiler::codegen {
+using vm::bytecode::Opcode;
+
+// the form of an arithmetic or ordering opcode that expects two int operands
+inline Opcode integer_form(const Opcode op)
+{
+    switch (op)
+    {
+    case Opcode::ADD:
+        return Opcode::ADD_I64;
+    case Opcode::SUB:
+        return Opcode::SUB_I64;
+    case Opcode::MUL:
+        return Opcode::MUL_I64;
+    case Opcode::DIV:
+        return Opcode::DIV_I64;
+    case Opcode::MOD:
+        return Opcode::MOD_I64;
+    case Opcode::LT:
+        return Opcode::LT_I64;
+    case Opcode::LE:
+        return Opcode::LE_I64;
+    case Opcode::ADDK:
+        return Opcode::ADDK_I64;
+    case Opcode::SUBK:
+        return Opcode::SUBK_I64;
+    case Opcode::MULK:
+        return Opcode::MULK_I64;
+    case Opcode::DIVK:
+        return Opcode::DIVK_I64;
+    case Opcode::MODK:
+        return Opcode::MODK_I64;
+    case Opcode::LTK:
+        return Opcode::LTK_I64;
+    case Opcode::LEK:
+        return Opcode::LEK_I64;
+    case Opcode::GTK:
+        return Opcode::GTK_I64;
+    case Opcode::GEK:
+        return Opcode::GEK_I64;
+    default:
+        return op;
+    }
+}
+
+// the form of an arithmetic or ordering opcode that takes two floats without checking them
+inline Opcode float_form(const Opcode op)
+{
+    switch (op)
+    {
+    case Opcode::ADD:
+        return Opcode::ADD_F64;
+    case Opcode::SUB:
+        return Opcode::SUB_F64;
+    case Opcode::MUL:
+        return Opcode::MUL_F64;
+    case Opcode::DIV:
+        return Opcode::DIV_F64;
+    case Opcode::LT:
+        return Opcode::LT_F64;
+    case Opcode::LE:
+        return Opcode::LE_F64;
+    case Opcode::ADDK:
+        return Opcode::ADDK_F64;
+    case Opcode::SUBK:
+        return Opcode::SUBK_F64;
+    case Opcode::MULK:
+        return Opcode::MULK_F64;
+    case Opcode::DIVK:
+        return Opcode::DIVK_F64;
+    case Opcode::LTK:
+        return Opcode::LTK_F64;
+    case Opcode::LEK:
+        return Opcode::LEK_F64;
+    case Opcode::GTK:
+        return Opcode::GTK_F64;
+    case Opcode::GEK:
+        return Opcode::GEK_F64;
+    default:
+        return op;
+    }
+}
+
+// the form of ADD that concatenates two strings
+inline Opcode string_form(const Opcode op)
+{
+    switch (op)
+    {
+    case Opcode::ADD:
+        return Opcode::CONCAT_STR;
+    case Opcode::ADDK:
+        return Opcode::CONCATK_STR;
+    default:
+        return op;
+    }
+}
+
+/* The form the operand types allow: `floats` and `strings` when the type checker proved both
+ * operands of that type, `integral` when both are typed int (a hint, the *_I64 forms still
+ * check).
+ */
+inline Opcode typed_form(const Opcode op, const bool floats, const bool strings,
+                         const bool integral)
+{
+    if (floats && float_form(op) != op)
+        return float_form(op);
+    if (strings && string_form(op) != op)
+        return string_form(op);
+    return integral ? integer_form(op) : op;
+}
+
+/* The *K form of the register opcode `op` whose right operand is the constant `value`, NOP if
+ * there is none. `swapped` is set when `op` takes its operands the other way round, as LT and
+ * LE do for `>` and `>=`.
+ */
+inline Opcode constant_form(const Opcode op, const bool swapped, const lexer::Literal &value)
+{
+    const bool number =
+            std::holds_alternative<double>(value) || std::holds_alternative<std::int64_t>(value);
+    const bool string = std::holds_alternative<std::string_view>(value);
+    switch (op)
+    {
+    case Opcode::ADD:
+        return number || string ? Opcode::ADDK : Opcode::NOP;
+    case Opcode::EQ:
+        return number || string ? Opcode::EQK : Opcode::NOP;
+    case Opcode::NE:
+        return number || string ? Opcode::NEK : Opcode::NOP;
+    case Opcode::SUB:
+        return number ? Opcode::SUBK : Opcode::NOP;
+    case Opcode::MUL:
+        return number ? Opcode::MULK : Opcode::NOP;
+    case Opcode::DIV:
+        return number ? Opcode::DIVK : Opcode::NOP;
+    case Opcode::MOD:
+        return number ? Opcode::MODK : Opcode::NOP;
+    case Opcode::LT:
+        return !number ? Opcode::NOP : swapped ? Opcode::GTK : Opcode::LTK;
+    case Opcode::LE:
+        return !number ? Opcode::NOP : swapped ? Opcode::GEK : Opcode::LEK;
+    default:
+        return Opcode::NOP;
+    }
+}
+} // namespace cool::compiler::codegen
@@ -0,0 +1,31 @@
+#include "peephole.hpp"
+
+#include "bytecode/instruction.hpp"
+
+#include <vector>
+
+namespace cool::compiler::codegen {
+using vm::bytecode::Instruction;
+using vm::bytecode::Opcode;
+
+void fuse_superinstructions(vm::bytecode::Function &function)
+{
+    std::vector<Instruction> &code = function.code;
+    std::vector<bool>         fused(code.size(), false);
+    for (const bool branches : {true, false})
+    {
+        for (std::size_t pc = 0; pc + 1 < code.size();
+             pc += vm::bytecode::length_of(vm::bytecode::op_of(code[pc])))
+        {
+            const Opcode second = vm::bytecode::op_of(code[pc + 1]);
+            const Opcode op     = vm::bytecode::fuse(vm::bytecode::op_of(code[pc]), second);
+            const bool   branch = second == Opcode::JMPIF || second == Opcode::JMPIFNOT;
+            if (op == Opcode::NOP || branch != branches || fused[pc] || fused[pc + 1])
+                continue;
+            code[pc]      = (code[pc] & ~Instruction{0xFF}) | static_cast<Instruction>(op);
+            fused[pc]     = true;
+            fused[pc + 1] = true;
+        }
+    }
+}
+} // namespace cool::compiler::codegen
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "bytecode/module.hpp"
+
+namespace cool::compiler::codegen {
+/* Rewrites the first instruction of every pair that has a superinstruction (see
+ * COOL_FUSED_OPCODES) to it, once the code of the function is final. Only the opcode byte
+ * changes, so jump offsets and the line table stay valid. An instruction is fused at most
+ * once, a comparison with the branch after it before anything with what comes before it.
+ */
+void fuse_superinstructions(vm::bytecode::Function &function);
+} // namespace cool::compiler::codegen
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ast/ast_arena.hpp"
+#include "ast/stmt.hpp"
+#include "lexer/source_buffer.hpp"
+#include "lexer/token_stream.hpp"
+
+#include <string>
+#include <utility>
+
+namespace cool::compiler {
+/* Everything produced while compiling one source file. The tokens are views into
+ * `source` and the AST lives in `arena`, so all of them share the unit's lifetime and
+ * are released together.
+ */
+struct CompilationUnit
+{
+    std::string         file_name;
+    lexer::SourceBuffer source;
+    lexer::TokenStream  tokens;
+    ast::AstArena       arena;
+    ast::StmtList       statements{&arena.resource};
+
+    CompilationUnit(std::string file_name, lexer::SourceBuffer source)
+        : file_name{std::move(file_name)}, source{std::move(source)}
+    {}
+};
+} // namespace cool::compiler
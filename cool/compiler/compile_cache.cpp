@@ -0,0 +1,208 @@
+#include "compile_cache.hpp"
+
+#include "bytecode/serializer.hpp"
+#include "lexer/source_buffer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <system_error>
+#include <utility>
+
+namespace cool::compiler {
+namespace {
+constexpr char          ENTRY_MAGIC[4] = {'C', 'L', 'C', 'E'};
+constexpr std::uint16_t ENTRY_VERSION  = 1;
+
+/* 128 bits in two lanes over 8-byte words, finished with the murmur3 mixer. Not
+ * cryptographic, a key only has to tell apart the inputs of one machine's builds, and an
+ * entry also records the size of its source.
+ */
+struct Hasher
+{
+    std::uint64_t first  = 0x9e3779b97f4a7c15ULL;
+    std::uint64_t second = 0xc2b2ae3d27d4eb4fULL;
+
+    static std::uint64_t rotate(const std::uint64_t value, const int bits)
+    {
+        return value << bits | value >> (64 - bits);
+    }
+
+    static std::uint64_t finish(std::uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        return value ^ value >> 33;
+    }
+
+    void word(const std::uint64_t value)
+    {
+        first  = rotate(first ^ value * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+        second = rotate(second ^ value * 0x165667b19e3779f9ULL, 27) * 0x27d4eb2f165667c5ULL;
+    }
+
+    // the length goes first, so consecutive fields cannot run into each other
+    void update(const std::string_view data)
+    {
+        word(data.size());
+        std::size_t i = 0;
+        for (; i + 8 <= data.size(); i += 8)
+        {
+            std::uint64_t value;
+            std::memcpy(&value, data.data() + i, sizeof value);
+            word(value);
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, data.data() + i, data.size() - i);
+        word(tail);
+    }
+
+    [[nodiscard]] std::array<std::uint64_t, 2> digest() const
+    {
+        return {finish(first ^ rotate(second, 17)), finish(second + first)};
+    }
+};
+
+/* Identifies the compiler that produces the output: the bytes of the running executable,
+ * so any rebuild of coolc misses on the entries of the previous one. Where the executable
+ * cannot be read the build time stands in for it.
+ */
+std::array<std::uint64_t, 2> compiler_fingerprint()
+{
+    static const std::array<std::uint64_t, 2> fingerprint = [] {
+        Hasher hasher;
+        if (std::optional<lexer::SourceBuffer> self = lexer::SourceBuffer::map("/proc/self/exe"))
+            hasher.update(self->view());
+        else
+            hasher.update(__DATE__ " " __TIME__);
+        return hasher.digest();
+    }();
+    return fingerprint;
+}
+
+std::string hex(const std::uint64_t value)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string           out(16, '0');
+    for (int i = 0; i < 16; ++i)
+        out[15 - i] = digits[value >> (4 * i) & 0xf];
+    return out;
+}
+
+void put(std::string &out, std::uint64_t value, const int bytes)
+{
+    for (int i = 0; i < bytes; ++i, value >>= 8)
+        out += static_cast<char>(value & 0xff);
+}
+
+std::uint64_t get(const std::string &in, std::size_t &position, const int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[position++])) << (8 * i);
+    return value;
+}
+
+std::optional<std::string> read_all(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+} // namespace
+
+CompileCache::CompileCache(std::string directory) : directory{std::move(directory)} {}
+
+std::string CompileCache::key(const std::string_view source, const CompilerOptions &options)
+{
+    const std::array<std::uint64_t, 2> compiler = compiler_fingerprint();
+
+    Hasher hasher;
+    hasher.word(compiler[0]);
+    hasher.word(compiler[1]);
+    hasher.word(vm::bytecode::VERSION);
+    hasher.word(options.optimize ? 1 : 0);
+    hasher.word(options.fuse ? 1 : 0);
+    hasher.update(source);
+    const std::array<std::uint64_t, 2> digest = hasher.digest();
+    return hex(digest[0]) + hex(digest[1]);
+}
+
+std::optional<CompileCache::Entry> CompileCache::load(const std::string &key,
+                                                      const std::size_t  source_size) const
+{
+    const std::optional<std::string> data = read_all(directory + "/" + key);
+    if (!data)
+        return std::nullopt;
+
+    // magic, version, source size, then the interface and the module, each after its length
+    const std::string &in       = *data;
+    std::size_t        position = sizeof ENTRY_MAGIC;
+    if (in.size() < sizeof ENTRY_MAGIC + 2 + 8 + 4 ||
+        std::memcmp(in.data(), ENTRY_MAGIC, sizeof ENTRY_MAGIC) != 0 ||
+        get(in, position, 2) != ENTRY_VERSION || get(in, position, 8) != source_size)
+        return std::nullopt;
+
+    Entry entry;
+    for (std::string *field : {&entry.interface, &entry.module})
+    {
+        if (in.size() - position < 4)
+            return std::nullopt;
+        const std::size_t length = get(in, position, 4);
+        if (in.size() - position < length)
+            return std::nullopt;
+        *field = in.substr(position, length);
+        position += length;
+    }
+    if (position != in.size())
+        return std::nullopt;
+    return entry;
+}
+
+bool CompileCache::store(const std::string &key, const std::size_t source_size,
+                         const Entry &entry) const
+{
+    std::string out{ENTRY_MAGIC, sizeof ENTRY_MAGIC};
+    put(out, ENTRY_VERSION, 2);
+    put(out, source_size, 8);
+    for (const std::string *field : {&entry.interface, &entry.module})
+    {
+        put(out, field->size(), 4);
+        out += *field;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    // unique per writer, a compiler on another thread or process may store the same key
+    const std::string path      = directory + "/" + key;
+    const std::string temporary = path + ".tmp" + hex(std::random_device{}());
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.write(out.data(), static_cast<std::streamsize>(out.size())) || !file.flush())
+        {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (!error)
+        return true;
+    std::filesystem::remove(temporary, error);
+    return false;
+}
+
+bool CompileCache::install(const std::string &path, const std::string &bytes)
+{
+    if (const std::optional<std::string> existing = read_all(path); existing && *existing == bytes)
+        return true;
+    std::ofstream file(path, std::ios::binary);
+    return file.write(bytes.data(), static_cast<std::streamsize>(bytes.size())) && file.flush();
+}
+} // namespace cool::compiler
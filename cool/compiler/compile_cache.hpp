@@ -0,0 +1,39 @@
+#pragma once
+
+#include "compiler.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cool::compiler {
+/* A content-addressed store of compiled units, one file per entry in `directory`. The key
+ * hashes everything the output depends on: the source bytes, the compiler itself (the
+ * running executable) and the options that change the bytecode. An entry holds the
+ * serialized module and the unit's exported interface (analysis::describe_interface), so a
+ * hit skips every pass and only copies the module to the output.
+ *
+ * Entries are written to a temporary file and renamed into place, so concurrent compilers
+ * sharing a directory only ever see complete entries. A missing or damaged entry is a miss.
+ */
+struct CompileCache
+{
+    struct Entry
+    {
+        std::string interface;
+        std::string module; // the bytes of the .coolb file
+    };
+
+    std::string directory;
+
+    explicit CompileCache(std::string directory);
+    static std::string                key(std::string_view source, const CompilerOptions &options);
+    [[nodiscard]] std::optional<Entry> load(const std::string &key, std::size_t source_size) const;
+    [[nodiscard]] bool                 store(const std::string &key, std::size_t source_size,
+                                             const Entry &entry) const;
+
+    // writes `bytes` to `path` unless it already holds them, so a no-op rebuild keeps its mtime
+    static bool install(const std::string &path, const std::string &bytes);
+};
+} // namespace cool::compiler
@@ -1,12 +1,22 @@
 #include "compiler.hpp"
 
+#include "analysis/interface.hpp"
+#include "analysis/resolver.hpp"
+#include "analysis/type_checker.hpp"
 #include "ast/ast_printer.hpp"
+#include "bytecode/serializer.hpp"
+#include "codegen/code_generator.hpp"
+#include "compile_cache.hpp"
+#include "compilation_unit.hpp"
 #include "lexer/lexer.hpp"
+#include "lexer/source_buffer.hpp"
+#include "optimizer/optimizer.hpp"
 #include "parser/parser.hpp"
 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -14,9 +24,10 @@
 
 namespace cool::compiler {
 
-bool Compiler::hasError = false;
-
-Compiler::Compiler(std::string file_name) : file_name{std::move(file_name)} {}
+Compiler::Compiler(std::string file_name, CompilerOptions options)
+    : file_name{std::move(file_name)}, options{std::move(options)}
+{
+}
 
 bool Compiler::check_file(const std::string &file_name)
 {
@@ -36,8 +47,25 @@ std::string Compiler::read_file(const std::ifstream &file)
     return content;
 }
 
-CompilationResult Compiler::compile() const
+lexer::SourceBuffer Compiler::load_source(const std::string &file_name)
+{
+    if (std::optional<lexer::SourceBuffer> mapped = lexer::SourceBuffer::map(file_name))
+        return std::move(*mapped);
+
+    const std::ifstream file(file_name);
+    return lexer::SourceBuffer{read_file(file)};
+}
+
+std::string Compiler::output_path() const
 {
+    if (!options.output.empty())
+        return options.output;
+    return std::filesystem::path{file_name}.replace_extension(".coolb").string();
+}
+
+CompilationResult Compiler::compile(Diagnostics &diagnostics) const
+{
+    const Diagnostics::Scope scope{diagnostics};
     if (!check_file(file_name))
     {
         error("Unsupported file extension, please provide a .cl file");
@@ -46,41 +74,111 @@ CompilationResult Compiler::compile() const
 
     if (!std::filesystem::exists(file_name))
     {
-        std::cerr << "Error: File does not exist.\n";
+        error("Error: File does not exist.");
         return FILE_NOT_FOUND;
     }
 
-    std::ifstream file(file_name);
-    std::string   content = read_file(file);
-    lexer::Lexer  lexer{content};
+    CompilationUnit unit{file_name, load_source(file_name)};
+
+    // a hit runs none of the passes, so there is nothing to dump
+    std::optional<CompileCache> cache;
+    std::string                 key;
+    if (!options.cache_dir.empty() && !options.dump_tokens && !options.dump_ast && !options.dump_ir)
+    {
+        cache.emplace(options.cache_dir);
+        key = CompileCache::key(unit.source.view(), options);
+        if (const std::optional<CompileCache::Entry> entry = cache->load(key, unit.source.size))
+        {
+            if (CompileCache::install(output_path(), entry->module))
+                return SUCCESS;
+            error("Could not write " + output_path());
+            return FILE_ERROR;
+        }
+    }
+
+    vm::bytecode::Module module;
+    if (const CompilationResult result = build(unit, options, diagnostics, module);
+        result != SUCCESS)
+        return result;
+
+    if (!cache)
+    {
+        if (!vm::bytecode::write_module(module, output_path()))
+        {
+            error("Could not write " + output_path());
+            return FILE_ERROR;
+        }
+        return SUCCESS;
+    }
+
+    // only units that compiled cleanly are stored, failing ones report their errors again
+    std::ostringstream bytes;
+    vm::bytecode::write_module(module, bytes);
+    CompileCache::Entry entry{analysis::describe_interface(unit.tokens, unit.statements),
+                              std::move(bytes).str()};
+    if (!CompileCache::install(output_path(), entry.module))
+    {
+        error("Could not write " + output_path());
+        return FILE_ERROR;
+    }
+    // a cache that cannot be written only costs the next build its hit
+    static_cast<void>(cache->store(key, unit.source.size, entry));
+    return SUCCESS;
+}
+
+// coolc and the benchmarks share this, so they cannot compile a program differently
+CompilationResult Compiler::build(CompilationUnit &unit, const CompilerOptions &options,
+                                  Diagnostics &diagnostics, vm::bytecode::Module &module)
+{
+    const Diagnostics::Scope scope{diagnostics};
+    lexer::Lexer             lexer{unit.source.view()};
     lexer.scan_tokens();
-    if (hasError)
+    if (diagnostics.has_error())
         return LEXICAL_ERROR;
+    unit.tokens = std::move(lexer.tokens);
 
-    std::vector<lexer::Token> tokens = lexer.tokens;
-    std::cout << "Tokens:\n";
-    for (const auto &token : tokens)
-        std::cout << token.to_string() << '\n';
+    if (options.dump_tokens)
+    {
+        std::cout << "Tokens:\n";
+        for (std::size_t i = 0; i < unit.tokens.size(); ++i)
+            std::cout << unit.tokens.token(i).to_string() << '\n';
+    }
 
-    parser::Parser                          parser{tokens};
-    std::vector<std::unique_ptr<ast::Stmt>> statements = parser.parse();
-    if (hasError)
+    parser::Parser parser{unit.tokens, unit.arena};
+    unit.statements = parser.parse();
+    if (diagnostics.has_error())
         return SYNTAX_ERROR;
 
-    ast::AstPrinter::print(statements);
+    // checked before the optimizer drops dead code, which must be as valid as the rest
+    analysis::Resolver{unit.tokens}.resolve(unit.statements);
+    analysis::TypeChecker{unit.tokens}.check(unit.statements);
+    if (diagnostics.has_error())
+        return SEMANTIC_ERROR;
+
+    if (options.optimize)
+        optimizer::Optimizer{unit.tokens, unit.arena}.optimize(unit.statements);
+
+    if (options.dump_ast)
+        ast::AstPrinter{unit.tokens}.print(unit.statements);
+
+    codegen::CodeGenerator generator{unit.tokens};
+    generator.optimize = options.optimize;
+    generator.fuse     = options.fuse;
+    generator.dump_ir  = options.dump_ir;
+    module             = generator.generate(unit.statements);
+    if (diagnostics.has_error())
+        return SEMANTIC_ERROR;
     return SUCCESS;
 }
 
 void Compiler::error(const std::string &message)
 {
     report(message);
-    hasError = true;
 }
 
 void Compiler::error(const int line, const std::string &message)
 {
     report("[line " + std::to_string(line) + "] Error: " + message);
-    hasError = true;
 }
 
 void Compiler::error(const lexer::Token &token, const std::string &message)
@@ -91,13 +189,17 @@ void Compiler::error(const lexer::Token &token, const std::string &message)
     }
     else
     {
-        report("[line " + std::to_string(token.line) + "] at '" + token.lexeme + "': " + message);
+        report("[line " + std::to_string(token.line) + "] at '" + std::string(token.lexeme) +
+               "': " + message);
     }
-    hasError = true;
 }
 
+// an error reported outside any Diagnostics::Scope has nowhere to be collected, so it is printed
 void Compiler::report(const std::string &message)
 {
-    std::cerr << message << '\n';
+    if (Diagnostics *diagnostics = Diagnostics::current())
+        diagnostics->report(message);
+    else
+        std::cerr << message << '\n';
 }
 } // namespace cool::compiler
\ No newline at end of file
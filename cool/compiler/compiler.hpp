@@ -1,22 +1,52 @@
 #pragma once
 
 #include "compilation_result.hpp"
+#include "diagnostics.hpp"
+#include "lexer/source_buffer.hpp"
 #include "lexer/token.hpp"
 
 #include <string>
+namespace cool::vm::bytecode {
+struct Module;
+}
+
 namespace cool::compiler {
+struct CompilationUnit;
+
+struct CompilerOptions
+{
+    std::string output; // defaults to the input path with a .coolb extension
+    bool        dump_tokens = false;
+    bool        dump_ast    = false;
+    bool        dump_ir     = false;
+    bool        optimize    = true; // run the optimizers on the AST and on the IR
+    bool        fuse        = true; // emit superinstructions
+    std::string cache_dir;          // where CompileCache keeps its entries, none when empty
+};
+
+/* Compiles one unit. The errors of the passes go to the Diagnostics installed on the calling
+ * thread, so several Compilers may run at once on different threads.
+ */
 struct Compiler
 {
-    static bool hasError;
-    std::string file_name;
+    std::string     file_name;
+    CompilerOptions options;
 
-    explicit Compiler(std::string file_name);
+    explicit Compiler(std::string file_name, CompilerOptions options = {});
     static bool                     check_file(const std::string &file_name);
     static void                     report(const std::string &message);
     static void                     error(const std::string &message);
     static void                     error(int line, const std::string &message);
     static void                     error(const lexer::Token &token, const std::string &message);
     static std::string              read_file(const std::ifstream &file);
-    [[nodiscard]] CompilationResult compile() const;
+    static lexer::SourceBuffer      load_source(const std::string &file_name);
+    [[nodiscard]] std::string       output_path() const;
+    [[nodiscard]] CompilationResult compile(Diagnostics &diagnostics) const;
+
+    // every pass over `unit`, whose source is loaded, ending with its module in `module`
+    [[nodiscard]] static CompilationResult build(CompilationUnit       &unit,
+                                                 const CompilerOptions &options,
+                                                 Diagnostics           &diagnostics,
+                                                 vm::bytecode::Module  &module);
 };
 } // namespace cool::compiler
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "diagnostics.hpp"
+
+#include <utility>
+
+namespace cool::compiler {
+namespace {
+thread_local Diagnostics *installed = nullptr;
+} // namespace
+
+Diagnostics::Scope::Scope(Diagnostics &diagnostics) : previous{installed}
+{
+    installed = &diagnostics;
+}
+
+Diagnostics::Scope::~Scope()
+{
+    installed = previous;
+}
+
+Diagnostics *Diagnostics::current()
+{
+    return installed;
+}
+
+void Diagnostics::report(std::string message)
+{
+    messages.push_back(std::move(message));
+}
+} // namespace cool::compiler
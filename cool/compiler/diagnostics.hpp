@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace cool::compiler {
+/* The errors reported while compiling one unit. The passes report through the static
+ * Compiler::error functions, which append to the Diagnostics installed on the calling thread
+ * by a Scope, so units compiled on different threads never share any error state.
+ */
+struct Diagnostics
+{
+    std::vector<std::string> messages;
+
+    // installs `diagnostics` on the current thread for its lifetime
+    struct Scope
+    {
+        Diagnostics *previous;
+
+        explicit Scope(Diagnostics &diagnostics);
+        Scope(const Scope &)            = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope();
+    };
+
+    static Diagnostics *current(); // nullptr outside any Scope
+    void                report(std::string message);
+    [[nodiscard]] bool  has_error() const { return !messages.empty(); }
+};
+} // namespace cool::compiler
@@ -0,0 +1,604 @@
+#include "builder.hpp"
+
+#include "../ast/visitor.hpp"
+
+#include <variant>
+
+namespace cool::compiler::ir {
+using analysis::Type;
+using codegen::CodeGenerator;
+
+namespace {
+Instr::StaticType literal_type(const lexer::Literal &value)
+{
+    if (std::holds_alternative<std::int64_t>(value))
+        return Type::INT;
+    if (std::holds_alternative<double>(value))
+        return Type::FLOAT;
+    if (std::holds_alternative<std::string_view>(value))
+        return Type::STRING;
+    if (std::holds_alternative<bool>(value))
+        return Type::BOOL;
+    return std::nullopt;
+}
+
+bool truthy(const lexer::Literal &value)
+{
+    const auto *boolean = std::get_if<bool>(&value);
+    return !std::holds_alternative<std::monostate>(value) && (boolean == nullptr || *boolean);
+}
+
+bool is_number(const Instr::StaticType type)
+{
+    return type == Type::INT || type == Type::FLOAT;
+}
+} // namespace
+
+Builder::Builder(const CodeGenerator &generator) : generator{generator} {}
+
+std::optional<Function> Builder::build(const ast::Function &node, const bool method)
+{
+    current = function.entry = block();
+    seal(current);
+
+    // `this` is variable 0 of a method, fields are read through whatever it holds
+    std::uint32_t reg = 0;
+    if (method)
+    {
+        Instr *self = emit(Op::PARAM);
+        self->index = reg++;
+        declare(lexer::NO_TOKEN, std::nullopt, self);
+        params.push_back(self);
+    }
+    for (const auto &[name, type] : node.params)
+    {
+        at(name);
+        Instr *param = emit(Op::PARAM);
+        param->index = reg++;
+        param->type  = generator.declared_type(type);
+        declare(name, param->type, param);
+        params.push_back(param);
+    }
+
+    if (const auto *body = ast::as<ast::Block>(node.body))
+    {
+        for (const ast::Stmt *stmt : body->statements)
+            statement(stmt);
+    }
+    else if (node.body != nullptr)
+    {
+        statement(node.body);
+    }
+    emit(Op::RETURN);
+
+    if (failed)
+        return std::nullopt;
+    function.forward();
+    return std::move(function);
+}
+
+void Builder::statement(const ast::Stmt *stmt)
+{
+    if (stmt != nullptr)
+        visit(*stmt, *this);
+}
+
+void Builder::operator()(const ast::VarDecl &stmt)
+{
+    at(stmt.name);
+    const StaticType type = generator.declared_type(stmt.type);
+
+    // the initializer is built before the name is in scope, as CodeGenerator does
+    const auto *literal = ast::as<ast::Literal>(stmt.initializer);
+    const auto *integer = literal != nullptr ? std::get_if<std::int64_t>(&literal->value)
+                                             : nullptr;
+    Instr      *value   = nullptr;
+    if (integer != nullptr && type == Type::FLOAT)
+        value = constant(static_cast<double>(*integer));
+    else
+        value = expr(stmt.initializer);
+    declare(stmt.name, type, value);
+}
+
+void Builder::operator()(const ast::ExprStatement &stmt)
+{
+    expr(stmt.expression);
+}
+
+void Builder::operator()(const ast::If &stmt)
+{
+    Instr *condition  = expr(stmt.condition);
+    Block *then_block = block();
+    Block *join       = block();
+    Block *else_block = stmt.else_branch != nullptr ? block() : join;
+    branch(condition, then_block, else_block);
+    seal(then_block);
+
+    current = then_block;
+    statement(stmt.then_branch);
+    jump(join);
+    if (stmt.else_branch != nullptr)
+    {
+        seal(else_block);
+        current = else_block;
+        statement(stmt.else_branch);
+        jump(join);
+    }
+    seal(join);
+    current = join;
+}
+
+void Builder::operator()(const ast::While &stmt)
+{
+    // rotated: tested on entry and again at the bottom, with a preheader for loop-invariant
+    // code to move to (building the condition twice reports nothing, the IR has no errors)
+    const auto *literal = ast::as<ast::Literal>(stmt.condition);
+    if (literal != nullptr && !truthy(literal->value))
+        return;
+    Block *preheader = block();
+    Block *header    = block();
+    Block *exit      = block();
+    if (literal == nullptr)
+        branch(expr(stmt.condition), preheader, exit);
+    else
+        jump(preheader);
+    seal(preheader);
+    current = preheader;
+    jump(header);
+
+    current = header;
+    statement(stmt.body);
+    if (literal == nullptr)
+        branch(expr(stmt.condition), header, exit);
+    else
+        jump(header);
+    seal(header);
+    seal(exit);
+    current = exit;
+}
+
+void Builder::operator()(const ast::Return &stmt)
+{
+    if (stmt.expression == nullptr)
+        emit(Op::RETURN);
+    else
+        emit(Op::RETURN, {expr(stmt.expression)});
+
+    // whatever follows in the block is unreachable
+    current = block();
+    seal(current);
+}
+
+void Builder::operator()(const ast::Print &stmt)
+{
+    emit(Op::PRINT, {expr(stmt.expression)});
+}
+
+void Builder::operator()(const ast::Function &)
+{
+    fail();
+}
+
+void Builder::operator()(const ast::Class &)
+{
+    fail();
+}
+
+void Builder::operator()(const ast::Block &stmt)
+{
+    for (const ast::Stmt *s : stmt.statements)
+        statement(s);
+}
+
+Instr *Builder::expr(const ast::Expr *expr)
+{
+    if (expr == nullptr)
+        return constant(std::monostate{});
+    return visit(*expr, [&](const auto &node) -> Instr * { return (*this)(node); });
+}
+
+Instr *Builder::operator()(const ast::Binary &expr)
+{
+    Instr *lhs = this->expr(expr.lhs);
+    Instr *rhs = this->expr(expr.rhs);
+    at(expr.op);
+
+    Op op = Op::ADD;
+    switch (generator.tokens.type(expr.op))
+    {
+    case lexer::PLUS:
+        op = Op::ADD;
+        break;
+    case lexer::MINUS:
+        op = Op::SUB;
+        break;
+    case lexer::STAR:
+        op = Op::MUL;
+        break;
+    case lexer::SLASH:
+        op = Op::DIV;
+        break;
+    case lexer::PERCENT:
+        op = Op::MOD;
+        break;
+    case lexer::ASTRIX:
+        op = Op::POW;
+        break;
+    case lexer::EQUALS_EQUAL:
+        op = Op::EQ;
+        break;
+    case lexer::BANG_EQUAL:
+        op = Op::NE;
+        break;
+    case lexer::LESS:
+        op = Op::LT;
+        break;
+    case lexer::LESS_EQUAL:
+        op = Op::LE;
+        break;
+    case lexer::GREATER:
+        op = Op::GT;
+        break;
+    case lexer::GREATER_EQUAL:
+        op = Op::GE;
+        break;
+    default:
+        fail();
+        return lhs;
+    }
+
+    // the same guesses as CodeGenerator::static_type
+    Instr     *result = emit(op, {lhs, rhs});
+    const bool number = is_number(lhs->type) && is_number(rhs->type);
+    switch (op)
+    {
+    case Op::ADD:
+        if (lhs->type == Type::STRING && rhs->type == Type::STRING)
+        {
+            result->type = Type::STRING;
+            break;
+        }
+        [[fallthrough]];
+    case Op::SUB:
+    case Op::MUL:
+    case Op::DIV:
+    case Op::MOD:
+        if (number)
+            result->type = lhs->type == Type::INT && rhs->type == Type::INT ? Type::INT
+                                                                            : Type::FLOAT;
+        break;
+    case Op::POW:
+        if (number)
+            result->type = Type::FLOAT;
+        break;
+    default:
+        result->type = Type::BOOL;
+        break;
+    }
+    return result;
+}
+
+Instr *Builder::operator()(const ast::Unary &expr)
+{
+    Instr *operand = this->expr(expr.operand);
+    at(expr.op);
+    if (generator.tokens.type(expr.op) != lexer::MINUS)
+    {
+        Instr *result = emit(Op::NOT, {operand});
+        result->type  = Type::BOOL;
+        return result;
+    }
+    Instr *result = emit(Op::NEG, {operand});
+    if (is_number(operand->type))
+        result->type = operand->type;
+    return result;
+}
+
+Instr *Builder::operator()(const ast::Logical &expr)
+{
+    // the left value is the result when it decides the outcome
+    Instr *lhs = this->expr(expr.lhs);
+    at(expr.op);
+    Block *rhs_block = block();
+    Block *join      = block();
+    if (generator.tokens.type(expr.op) == lexer::OR)
+        branch(lhs, join, rhs_block);
+    else
+        branch(lhs, rhs_block, join);
+    seal(rhs_block);
+
+    current    = rhs_block;
+    Instr *rhs = this->expr(expr.rhs);
+    jump(join);
+    seal(join);
+    current = join;
+
+    Instr *phi = function.insert(Op::PHI, join, 0, {lhs, rhs});
+    phi->line  = line;
+    return remove_trivial_phi(phi);
+}
+
+Instr *Builder::operator()(const ast::Literal &expr)
+{
+    return constant(expr.value);
+}
+
+Instr *Builder::operator()(const ast::Grouping &expr)
+{
+    return this->expr(expr.expr);
+}
+
+Instr *Builder::operator()(const ast::Variable &expr)
+{
+    at(expr.name);
+    if (const std::uint32_t *variable = find(expr.binding))
+    {
+        // the IR works out the other values of a proven local itself, not its parameter
+        if (expr.proven && *variable < params.size())
+            params[*variable]->proven = true;
+        return read(*variable, current);
+    }
+
+    if (expr.binding.kind == ast::Binding::Kind::GLOBAL)
+    {
+        Instr *value = emit(Op::GETGLOBAL);
+        value->index = expr.binding.slot;
+        typed(value, expr);
+        return value;
+    }
+    if (expr.binding.kind == ast::Binding::Kind::FIELD && expr.binding.depth == 0)
+    {
+        Instr *value = emit(Op::GETSLOT, {read(0, current)});
+        value->index = expr.binding.slot;
+        value->name  = generator.lexeme(expr.name);
+        return value;
+    }
+    fail();
+    return constant(std::monostate{});
+}
+
+Instr *Builder::operator()(const ast::Assignment &expr)
+{
+    at(expr.name);
+    if (const std::uint32_t *variable = find(expr.binding))
+    {
+        Instr *value = this->expr(expr.value);
+        write(*variable, current, value);
+        return value;
+    }
+
+    const ast::Binding::Kind kind = expr.binding.kind;
+    if (kind != ast::Binding::Kind::GLOBAL &&
+        (kind != ast::Binding::Kind::FIELD || expr.binding.depth != 0))
+    {
+        fail();
+        return constant(std::monostate{});
+    }
+    Instr *value = this->expr(expr.value);
+    at(expr.name);
+    if (kind == ast::Binding::Kind::GLOBAL)
+    {
+        emit(Op::SETGLOBAL, {value})->index = expr.binding.slot;
+        return value;
+    }
+    Instr *store = emit(Op::SETSLOT, {read(0, current), value});
+    store->index = expr.binding.slot;
+    store->name  = generator.lexeme(expr.name);
+    return value;
+}
+
+Instr *Builder::operator()(const ast::Call &expr)
+{
+    // `method(...)` inside a class invokes on `this`, `object.method(...)` on the object
+    const auto          *callee = ast::as<ast::Variable>(expr.callee);
+    const auto          *member = ast::as<ast::Get>(expr.callee);
+    std::vector<Instr *> operands;
+    std::string_view     method;
+    if (callee != nullptr && callee->binding.kind == ast::Binding::Kind::METHOD)
+    {
+        if (callee->binding.depth != 0)
+            fail();
+        method = generator.lexeme(callee->name);
+        operands.push_back(read(0, current));
+    }
+    else if (member != nullptr)
+    {
+        method = generator.lexeme(member->name);
+        operands.push_back(this->expr(member->object));
+    }
+    else
+    {
+        operands.push_back(this->expr(expr.callee));
+    }
+    for (const ast::Expr *argument : expr.arguments)
+        operands.push_back(this->expr(argument));
+
+    at(expr.paren);
+    if (!method.empty())
+    {
+        Instr *result = emit(Op::INVOKE, std::move(operands));
+        result->name  = method;
+        return result;
+    }
+    Instr *result = emit(Op::CALL, std::move(operands));
+    typed(result, expr);
+    return result;
+}
+
+Instr *Builder::operator()(const ast::Get &expr)
+{
+    Instr *object = this->expr(expr.object);
+    at(expr.name);
+    Instr *value = emit(Op::GETFIELD, {object});
+    value->name  = generator.lexeme(expr.name);
+    return value;
+}
+
+Instr *Builder::operator()(const ast::Set &expr)
+{
+    Instr *object = this->expr(expr.object);
+    Instr *value  = this->expr(expr.value);
+    at(expr.name);
+    emit(Op::SETFIELD, {object, value})->name = generator.lexeme(expr.name);
+    return value;
+}
+
+// a local is found by the token that declares it, which the resolver records in each binding
+std::uint32_t Builder::declare(const lexer::TokenIndex name, const StaticType type, Instr *value)
+{
+    const auto variable = static_cast<std::uint32_t>(variables.size());
+    variables.push_back(type);
+    locals[name] = variable;
+    write(variable, current, value);
+    return variable;
+}
+
+// the variable of the local `binding` refers to, nothing for other names and for a boxed local
+const std::uint32_t *Builder::find(const ast::Binding &binding) const
+{
+    if (binding.kind != ast::Binding::Kind::LOCAL || binding.boxed)
+        return nullptr;
+    const auto it = locals.find(binding.declaration);
+    return it != locals.end() ? &it->second : nullptr;
+}
+
+// a value stored in a typed local is assumed to have that type, as CodeGenerator assumes
+void Builder::write(const std::uint32_t variable, Block *block, Instr *value)
+{
+    if (!value->type)
+        value->type = variables[variable];
+    definitions[block->id][variable] = value;
+}
+
+Instr *Builder::read(const std::uint32_t variable, Block *block)
+{
+    const auto &defined = definitions[block->id];
+    if (const auto it = defined.find(variable); it != defined.end())
+        return resolve(it->second);
+    return read_recursive(variable, block);
+}
+
+Instr *Builder::read_recursive(const std::uint32_t variable, Block *block)
+{
+    Instr *value = nullptr;
+    if (!sealed[block->id])
+    {
+        value       = function.insert(Op::PHI, block, block->phi_count());
+        value->type = variables[variable];
+        incomplete[block->id].emplace_back(variable, value);
+    }
+    else if (block->preds.size() == 1)
+    {
+        value = read(variable, block->preds[0]);
+    }
+    else if (block->preds.empty())
+    {
+        // only in unreachable code, every local is initialized where it is declared
+        value          = function.insert(Op::CONST, block, 0);
+        value->literal = std::monostate{};
+    }
+    else
+    {
+        // defined before the operands are read, a cycle back to this block ends at the phi
+        Instr *phi                       = function.insert(Op::PHI, block, block->phi_count());
+        phi->type                        = variables[variable];
+        definitions[block->id][variable] = phi;
+        value                            = add_phi_operands(variable, phi);
+    }
+    definitions[block->id][variable] = value;
+    return value;
+}
+
+Instr *Builder::add_phi_operands(const std::uint32_t variable, Instr *phi)
+{
+    for (Block *pred : phi->block->preds)
+        phi->operands.push_back(read(variable, pred));
+    return remove_trivial_phi(phi);
+}
+
+// a phi whose operands are all one value (or itself) is that value; phis that become
+// trivial in turn are left to the cleanup after construction
+Instr *Builder::remove_trivial_phi(Instr *phi)
+{
+    Instr *same = nullptr;
+    for (Instr *operand : phi->operands)
+    {
+        operand = resolve(operand);
+        if (operand == same || operand == phi)
+            continue;
+        if (same != nullptr)
+            return phi;
+        same = operand;
+    }
+    if (same == nullptr)
+    {
+        same          = function.insert(Op::CONST, function.entry, 0);
+        same->literal = std::monostate{};
+    }
+    phi->replacement = same;
+    function.remove(phi);
+    return same;
+}
+
+void Builder::seal(Block *block)
+{
+    auto pending = std::move(incomplete[block->id]);
+    for (const auto &[variable, phi] : pending)
+        add_phi_operands(variable, phi);
+    sealed[block->id] = true;
+}
+
+Block *Builder::block()
+{
+    definitions.emplace_back();
+    sealed.push_back(false);
+    incomplete.emplace_back();
+    return function.make_block();
+}
+
+Instr *Builder::emit(const Op op, std::vector<Instr *> operands)
+{
+    Instr *instr = function.make(op, current, std::move(operands));
+    instr->line  = line;
+    return instr;
+}
+
+Instr *Builder::constant(const lexer::Literal &value)
+{
+    Instr *instr   = emit(Op::CONST);
+    instr->literal = value;
+    instr->type    = literal_type(value);
+    return instr;
+}
+
+// the type the checker gave a value the IR cannot work out itself
+void Builder::typed(Instr *instr, const ast::Expr &expr)
+{
+    instr->type   = expr.type;
+    instr->proven = expr.proven;
+}
+
+void Builder::jump(Block *to)
+{
+    emit(Op::JUMP);
+    function.link(current, to);
+}
+
+void Builder::branch(Instr *condition, Block *then_block, Block *else_block)
+{
+    emit(Op::BRANCH, {condition});
+    function.link(current, then_block);
+    function.link(current, else_block);
+}
+
+void Builder::at(const lexer::TokenIndex token)
+{
+    if (token != lexer::NO_TOKEN)
+        line = static_cast<std::uint32_t>(generator.tokens.line(token));
+}
+
+void Builder::fail()
+{
+    failed = true;
+}
+} // namespace cool::compiler::ir
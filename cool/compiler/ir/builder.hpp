@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../ast/stmt.hpp"
+#include "../codegen/code_generator.hpp"
+#include "ir.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cool::compiler::ir {
+/* Builds the SSA form of a function body straight from the AST with the algorithm of Braun
+ * et al., "Simple and Efficient Construction of Static Single Assignment Form": a read of a
+ * local takes its definition in the current block or asks the predecessors, placing a phi
+ * where they may disagree. A loop header is sealed once its back edge is known, the reads
+ * made before that get operand-less phis that are completed then.
+ *
+ * Names come bound by analysis::Resolver. A body that uses something the IR does not model
+ * (nested functions, upvalues, boxed locals, anything the code generator reports an error
+ * for) is not built, the code generator compiles it from the AST instead.
+ */
+struct Builder
+{
+    using StaticType = Instr::StaticType;
+
+    const codegen::CodeGenerator                              &generator;
+    Function                                                   function;
+    Block                                                     *current = nullptr;
+    std::unordered_map<lexer::TokenIndex, std::uint32_t>       locals; // by declaration
+    std::vector<StaticType>                                    variables; // declared types
+    std::vector<Instr *>                                       params;    // the first variables
+    std::vector<std::unordered_map<std::uint32_t, Instr *>>    definitions; // per block
+    std::vector<bool>                                          sealed;      // per block
+    std::vector<std::vector<std::pair<std::uint32_t, Instr *>>> incomplete; // per block
+    std::uint32_t                                              line   = 0;
+    bool                                                       failed = false;
+
+    explicit Builder(const codegen::CodeGenerator &generator);
+
+    // the SSA form of `node`, nothing when the code generator has to compile it
+    std::optional<Function> build(const ast::Function &node, bool method);
+
+    // statements
+    void statement(const ast::Stmt *stmt);
+    void operator()(const ast::VarDecl &stmt);
+    void operator()(const ast::ExprStatement &stmt);
+    void operator()(const ast::If &stmt);
+    void operator()(const ast::While &stmt);
+    void operator()(const ast::Return &stmt);
+    void operator()(const ast::Print &stmt);
+    void operator()(const ast::Function &stmt);
+    void operator()(const ast::Class &stmt);
+    void operator()(const ast::Block &stmt);
+
+    // expressions, each returns the value it computes
+    Instr *expr(const ast::Expr *expr);
+    Instr *operator()(const ast::Binary &expr);
+    Instr *operator()(const ast::Unary &expr);
+    Instr *operator()(const ast::Logical &expr);
+    Instr *operator()(const ast::Literal &expr);
+    Instr *operator()(const ast::Grouping &expr);
+    Instr *operator()(const ast::Variable &expr);
+    Instr *operator()(const ast::Assignment &expr);
+    Instr *operator()(const ast::Call &expr);
+    Instr *operator()(const ast::Get &expr);
+    Instr *operator()(const ast::Set &expr);
+
+    // SSA construction
+    std::uint32_t                      declare(lexer::TokenIndex name, StaticType type,
+                                               Instr *value);
+    [[nodiscard]] const std::uint32_t *find(const ast::Binding &binding) const;
+    void                               write(std::uint32_t variable, Block *block, Instr *value);
+    Instr                             *read(std::uint32_t variable, Block *block);
+    Instr                             *read_recursive(std::uint32_t variable, Block *block);
+    Instr                             *add_phi_operands(std::uint32_t variable, Instr *phi);
+    Instr                             *remove_trivial_phi(Instr *phi);
+    void                               seal(Block *block);
+
+    // helpers
+    Block *block();
+    Instr *emit(Op op, std::vector<Instr *> operands = {});
+    Instr *constant(const lexer::Literal &value);
+    void   typed(Instr *instr, const ast::Expr &expr);
+    void   jump(Block *to);
+    void   branch(Instr *condition, Block *then_block, Block *else_block);
+    void   at(lexer::TokenIndex token);
+    void   fail();
+};
+} // namespace cool::compiler::ir
@@ -0,0 +1,331 @@
+#include "ir.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <variant>
+
+namespace cool::compiler::ir {
+namespace {
+void print_literal(std::ostream &out, const lexer::Literal &value)
+{
+    std::visit(
+            [&](auto &&literal) {
+                using T = std::decay_t<decltype(literal)>;
+                if constexpr (std::is_same_v<T, std::monostate>)
+                    out << "nil";
+                else if constexpr (std::is_same_v<T, bool>)
+                    out << (literal ? "true" : "false");
+                else if constexpr (std::is_same_v<T, std::string_view>)
+                    out << '"' << literal << '"';
+                else
+                    out << literal;
+            },
+            value);
+}
+} // namespace
+
+Instr *Block::terminator() const
+{
+    return instrs.empty() || !is_terminator(instrs.back()->op) ? nullptr : instrs.back();
+}
+
+bool Block::terminated() const
+{
+    return terminator() != nullptr;
+}
+
+std::size_t Block::phi_count() const
+{
+    std::size_t count = 0;
+    while (count < instrs.size() && instrs[count]->op == Op::PHI)
+        count++;
+    return count;
+}
+
+Block *Function::make_block()
+{
+    blocks.push_back(std::make_unique<Block>(static_cast<std::uint32_t>(blocks.size())));
+    return blocks.back().get();
+}
+
+Instr *Function::make(const Op op, Block *block, std::vector<Instr *> operands)
+{
+    return insert(op, block, block->instrs.size(), std::move(operands));
+}
+
+Instr *Function::insert(const Op op, Block *block, const std::size_t position,
+                        std::vector<Instr *> operands)
+{
+    instrs.push_back(std::make_unique<Instr>(op, static_cast<std::uint32_t>(instrs.size())));
+    Instr *instr    = instrs.back().get();
+    instr->block    = block;
+    instr->operands = std::move(operands);
+    block->instrs.insert(block->instrs.begin() + static_cast<std::ptrdiff_t>(position), instr);
+    return instr;
+}
+
+void Function::link(Block *from, Block *to)
+{
+    from->succs.push_back(to);
+    to->preds.push_back(from);
+}
+
+// drops the edge and the phi operands that came in through it
+void Function::unlink(Block *from, Block *to)
+{
+    from->succs.erase(std::find(from->succs.begin(), from->succs.end(), to));
+    const auto it       = std::find(to->preds.begin(), to->preds.end(), from);
+    const auto position = it - to->preds.begin();
+    to->preds.erase(it);
+    for (std::size_t i = 0; i < to->phi_count(); ++i)
+        to->instrs[i]->operands.erase(to->instrs[i]->operands.begin() + position);
+}
+
+void Function::remove(Instr *instr)
+{
+    std::vector<Instr *> &list = instr->block->instrs;
+    list.erase(std::find(list.begin(), list.end(), instr));
+    instr->block = nullptr;
+}
+
+void Function::analyze()
+{
+    // depth-first from the entry, visiting successors last to first so the first successor
+    // of a branch comes first in reverse postorder
+    for (const auto &block : blocks)
+    {
+        block->order = -1;
+        block->idom  = nullptr;
+        block->loop  = nullptr;
+    }
+    rpo.clear();
+    std::vector<std::pair<Block *, std::size_t>> stack{{entry, 0}};
+    std::unordered_set<Block *>                  seen{entry};
+    while (!stack.empty())
+    {
+        auto &[block, next] = stack.back();
+        if (next < block->succs.size())
+        {
+            Block *succ = block->succs[block->succs.size() - 1 - next++];
+            if (seen.insert(succ).second)
+                stack.emplace_back(succ, 0);
+            continue;
+        }
+        rpo.push_back(block);
+        stack.pop_back();
+    }
+    std::reverse(rpo.begin(), rpo.end());
+    for (std::size_t i = 0; i < rpo.size(); ++i)
+        rpo[i]->order = static_cast<int>(i);
+
+    // Cooper, Harvey and Kennedy's iterative dominators
+    entry->idom = entry;
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (Block *block : rpo)
+        {
+            if (block == entry)
+                continue;
+            Block *idom = nullptr;
+            for (Block *pred : block->preds)
+            {
+                if (pred->idom == nullptr)
+                    continue;
+                if (idom == nullptr)
+                {
+                    idom = pred;
+                    continue;
+                }
+                Block *a = pred;
+                Block *b = idom;
+                while (a != b)
+                {
+                    while (a->order > b->order)
+                        a = a->idom;
+                    while (b->order > a->order)
+                        b = b->idom;
+                }
+                idom = a;
+            }
+            if (block->idom != idom)
+            {
+                block->idom = idom;
+                changed     = true;
+            }
+        }
+    }
+
+    // a back edge goes to a block dominating its source, the loop is everything that reaches
+    // the source without passing through the header
+    loops.clear();
+    for (Block *header : rpo)
+    {
+        std::vector<Block *> body{header};
+        std::vector<Block *> work;
+        for (Block *pred : header->preds)
+            if (pred->order >= 0 && dominates(header, pred))
+                work.push_back(pred);
+        if (work.empty())
+            continue;
+        while (!work.empty())
+        {
+            Block *block = work.back();
+            work.pop_back();
+            if (std::find(body.begin(), body.end(), block) != body.end())
+                continue;
+            body.push_back(block);
+            for (Block *pred : block->preds)
+                if (pred->order >= 0)
+                    work.push_back(pred);
+        }
+        loops.push_back({header, nullptr, std::move(body)});
+    }
+    std::stable_sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    for (std::size_t i = loops.size(); i-- > 0;)
+    {
+        for (Block *block : loops[i].blocks)
+            block->loop = loops[i].header;
+        for (std::size_t j = i + 1; j < loops.size() && loops[i].parent == nullptr; ++j)
+        {
+            const std::vector<Block *> &outer = loops[j].blocks;
+            if (std::find(outer.begin(), outer.end(), loops[i].header) != outer.end())
+                loops[i].parent = loops[j].header;
+        }
+    }
+}
+
+void Function::forward()
+{
+    for (const auto &block : blocks)
+        for (Instr *instr : block->instrs)
+            for (Instr *&operand : instr->operands)
+                operand = resolve(operand);
+}
+
+bool Function::dominates(const Block *a, const Block *b) const
+{
+    while (b != a && b != entry && b->idom != nullptr)
+        b = b->idom;
+    return b == a;
+}
+
+std::vector<std::uint32_t> Function::use_counts() const
+{
+    std::vector<std::uint32_t> counts(instrs.size());
+    for (const Block *block : rpo)
+        for (const Instr *instr : block->instrs)
+            for (const Instr *operand : instr->operands)
+                counts[operand->id]++;
+    return counts;
+}
+
+void Function::print(std::ostream &out, const std::string_view name) const
+{
+    out << "function " << name << '\n';
+    for (const Block *block : rpo)
+    {
+        out << "b" << block->id << ":";
+        if (!block->preds.empty())
+        {
+            out << " ; preds";
+            for (const Block *pred : block->preds)
+                out << " b" << pred->id;
+        }
+        if (block->loop != nullptr)
+            out << " ; loop b" << block->loop->id;
+        out << '\n';
+        for (const Instr *instr : block->instrs)
+        {
+            out << "    ";
+            if (defines_value(*instr))
+                out << "v" << instr->id << " = ";
+            out << name_of(instr->op);
+            if (instr->op == Op::CONST)
+            {
+                out << ' ';
+                print_literal(out, instr->literal);
+            }
+            else if (instr->op == Op::PARAM || instr->op == Op::GETGLOBAL ||
+                     instr->op == Op::SETGLOBAL)
+            {
+                out << ' ' << instr->index;
+            }
+            if (!instr->name.empty())
+                out << " ." << instr->name;
+            for (std::size_t i = 0; i < instr->operands.size(); ++i)
+                out << (i == 0 ? " " : ", ") << "v" << instr->operands[i]->id;
+            for (std::size_t i = 0; i < block->succs.size() && instr == block->terminator(); ++i)
+                out << (i == 0 && instr->operands.empty() ? " " : ", ") << "b"
+                    << block->succs[i]->id;
+            out << '\n';
+        }
+    }
+}
+
+bool is_terminator(const Op op)
+{
+    return op == Op::JUMP || op == Op::BRANCH || op == Op::RETURN;
+}
+
+bool has_side_effects(const Op op)
+{
+    switch (op)
+    {
+    case Op::SETGLOBAL:
+    case Op::SETSLOT:
+    case Op::SETFIELD:
+    case Op::CALL:
+    case Op::INVOKE:
+    case Op::PRINT:
+    case Op::JUMP:
+    case Op::BRANCH:
+    case Op::RETURN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool reads_memory(const Op op)
+{
+    return op == Op::GETGLOBAL || op == Op::GETSLOT || op == Op::GETFIELD;
+}
+
+bool defines_value(const Instr &instr)
+{
+    switch (instr.op)
+    {
+    case Op::SETGLOBAL:
+    case Op::SETSLOT:
+    case Op::SETFIELD:
+    case Op::PRINT:
+    case Op::JUMP:
+    case Op::BRANCH:
+    case Op::RETURN:
+        return false;
+    default:
+        return true;
+    }
+}
+
+const char *name_of(const Op op)
+{
+    static constexpr const char *names[] = {
+            "CONST",    "PARAM",     "PHI",       "ADD",     "SUB",     "MUL",
+            "DIV",      "MOD",       "POW",       "EQ",      "NE",      "LT",
+            "LE",       "GT",        "GE",        "NEG",     "NOT",     "GETGLOBAL",
+            "SETGLOBAL", "GETSLOT",  "SETSLOT",   "GETFIELD", "SETFIELD", "CALL",
+            "INVOKE",   "PRINT",     "JUMP",      "BRANCH",  "RETURN"};
+    return names[static_cast<std::uint8_t>(op)];
+}
+
+Instr *resolve(Instr *instr)
+{
+    while (instr->replacement != nullptr)
+        instr = instr->replacement;
+    return instr;
+}
+} // namespace cool::compiler::ir
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../analysis/type.hpp"
+#include "../lexer/token.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace cool::compiler::ir {
+/* A mid-level IR for the body of one function: a control-flow graph of basic blocks whose
+ * instructions are in SSA form, every value is defined once and an instruction names its
+ * operands by pointer. Phis sit at the top of a block and take one operand per predecessor,
+ * in the order of `preds`; every block ends in exactly one terminator.
+ *
+ * Locals never appear in the IR, only the values they hold. Globals, fields and calls keep
+ * their VM meaning, so lowering maps most instructions to a single opcode.
+ */
+enum class Op : std::uint8_t {
+    CONST, // `literal`
+    PARAM, // the argument in register `index` on entry
+    PHI,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    POW,
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+    NEG,
+    NOT,
+    GETGLOBAL, // global `index`
+    SETGLOBAL, // global `index` = operands[0]
+    GETSLOT,   // field `name` in slot `index` of `this` (operands[0])
+    SETSLOT,   // field `name` in slot `index` of `this` (operands[0]) = operands[1]
+    GETFIELD,  // operands[0].`name`
+    SETFIELD,  // operands[0].`name` = operands[1]
+    CALL,      // operands[0](operands[1...])
+    INVOKE,    // operands[0].`name`(operands[1...])
+    PRINT,     // operands[0]
+    JUMP,      // to succs[0]
+    BRANCH,    // to succs[0] if operands[0] is truthy, succs[1] otherwise
+    RETURN     // operands[0], or nil without operands
+};
+
+struct Block;
+
+struct Instr
+{
+    using StaticType = std::optional<analysis::Type>;
+
+    Op                   op;
+    std::uint32_t        id;
+    Block               *block = nullptr;
+    std::vector<Instr *> operands;
+    lexer::Literal       literal;
+    std::uint32_t        index = 0;
+    std::string_view     name;
+    std::uint32_t        line = 0;
+    StaticType           type; // a hint for opcode selection, like CodeGenerator::static_type
+    bool                 proven = false; // `type` is certain, the type checker proved it
+    Instr               *replacement = nullptr; // set when a pass folds this into another value
+
+    Instr(Op op, std::uint32_t id) : op{op}, id{id} {}
+};
+
+struct Block
+{
+    std::uint32_t        id;
+    std::vector<Instr *> instrs; // phis first, the terminator last
+    std::vector<Block *> preds;
+    std::vector<Block *> succs;  // the targets of the terminator
+
+    // filled in by Function::analyze
+    Block *idom  = nullptr;
+    int    order = -1; // position in reverse postorder, -1 when unreachable
+    Block *loop  = nullptr; // header of the innermost loop containing the block
+
+    explicit Block(std::uint32_t id) : id{id} {}
+
+    [[nodiscard]] Instr *terminator() const;
+    [[nodiscard]] bool   terminated() const;
+    [[nodiscard]] std::size_t phi_count() const;
+};
+
+struct Loop
+{
+    Block               *header;
+    Block               *parent; // header of the enclosing loop, nullptr at the top
+    std::vector<Block *> blocks; // including the header and nested loops
+};
+
+struct Function
+{
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<std::unique_ptr<Instr>> instrs;
+    Block                              *entry = nullptr;
+
+    // filled in by analyze
+    std::vector<Block *> rpo;   // reachable blocks in reverse postorder
+    std::vector<Loop>    loops; // innermost first
+
+    Block *make_block();
+    Instr *make(Op op, Block *block, std::vector<Instr *> operands = {});
+    Instr *insert(Op op, Block *block, std::size_t position, std::vector<Instr *> operands = {});
+    void   link(Block *from, Block *to);
+    void   unlink(Block *from, Block *to);
+    void   remove(Instr *instr);
+
+    // computes reverse postorder, dominators and natural loops
+    void analyze();
+    void forward(); // rewrites every operand through the replacements passes recorded
+    [[nodiscard]] bool dominates(const Block *a, const Block *b) const;
+    [[nodiscard]] std::vector<std::uint32_t> use_counts() const;
+
+    void print(std::ostream &out, std::string_view name) const;
+};
+
+[[nodiscard]] bool        is_terminator(Op op);
+[[nodiscard]] bool        has_side_effects(Op op); // besides a possible runtime error
+[[nodiscard]] bool        reads_memory(Op op);
+[[nodiscard]] bool        defines_value(const Instr &instr);
+[[nodiscard]] const char *name_of(Op op);
+Instr                    *resolve(Instr *instr); // follows replacements
+} // namespace cool::compiler::ir
@@ -0,0 +1,460 @@
+#include "passes.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+#include <variant>
+
+namespace cool::compiler::ir {
+namespace {
+bool truthy(const lexer::Literal &value)
+{
+    const auto *boolean = std::get_if<bool>(&value);
+    return !std::holds_alternative<std::monostate>(value) && (boolean == nullptr || *boolean);
+}
+
+bool is_number(const Kind kind)
+{
+    return kind == Kind::INT || kind == Kind::FLOAT;
+}
+
+// the kind of a value the type checker proved a `type`
+Kind kind_of(const analysis::Type type)
+{
+    switch (type)
+    {
+    case analysis::Type::INT:
+        return Kind::INT;
+    case analysis::Type::FLOAT:
+        return Kind::FLOAT;
+    case analysis::Type::STRING:
+        return Kind::STRING;
+    default:
+        return Kind::OTHER;
+    }
+}
+
+// the kind of the result of an arithmetic operator, from those of its operands
+Kind arithmetic_kind(const Instr &instr, const std::vector<Kind> &kinds)
+{
+    const Kind lhs = kinds[instr.operands[0]->id];
+    const Kind rhs = instr.operands.size() > 1 ? kinds[instr.operands[1]->id] : lhs;
+    if (lhs == Kind::OTHER || rhs == Kind::OTHER)
+        return Kind::OTHER;
+    if (lhs == Kind::UNKNOWN || rhs == Kind::UNKNOWN)
+        return Kind::UNKNOWN;
+    if (lhs == Kind::STRING || rhs == Kind::STRING)
+        return instr.op == Op::ADD && lhs == rhs ? Kind::STRING : Kind::OTHER;
+    if (instr.op == Op::POW || lhs == Kind::FLOAT || rhs == Kind::FLOAT)
+        return Kind::FLOAT;
+    return Kind::INT;
+}
+
+// arithmetic, comparisons and loads, which only compute a value
+bool is_pure(const Op op)
+{
+    return (op >= Op::ADD && op <= Op::NOT) || reads_memory(op);
+}
+
+bool clobbers_memory(const Op op)
+{
+    return op == Op::SETGLOBAL || op == Op::SETSLOT || op == Op::SETFIELD || op == Op::CALL ||
+           op == Op::INVOKE;
+}
+
+// an operand as value numbering sees it: constants by value (floats by bit pattern, so 0.0
+// and -0.0 differ), anything else by identity
+using OperandKey = std::tuple<std::uint32_t, std::size_t, std::uint64_t, std::string_view>;
+
+// the operator, `index` and `name`, the memory epoch for loads and the operands
+using ValueKey = std::tuple<Op, std::uint32_t, std::string_view, std::uint32_t,
+                            std::vector<OperandKey>>;
+
+OperandKey operand_key(const Instr *operand)
+{
+    if (operand->op != Op::CONST)
+        return {operand->id, 0, 0, {}};
+    std::uint64_t    bits = 0;
+    std::string_view text;
+    if (const auto *number = std::get_if<double>(&operand->literal))
+        std::memcpy(&bits, number, sizeof bits);
+    else if (const auto *integer = std::get_if<std::int64_t>(&operand->literal))
+        bits = static_cast<std::uint64_t>(*integer);
+    else if (const auto *boolean = std::get_if<bool>(&operand->literal))
+        bits = *boolean ? 1 : 0;
+    else if (const auto *string = std::get_if<std::string_view>(&operand->literal))
+        text = *string;
+    return {UINT32_MAX, operand->literal.index(), bits, text};
+}
+
+struct ValueNumbering
+{
+    Function                          &function;
+    std::vector<std::vector<Block *>>  children; // in the dominator tree
+    std::map<ValueKey, Instr *>        table{};
+    std::uint32_t                      epochs = 0;
+
+    void walk(Block *block, std::uint32_t epoch)
+    {
+        // memory is only known to be unchanged from a block's single predecessor
+        if (block->preds.size() != 1)
+            epoch = ++epochs;
+
+        std::vector<ValueKey> added;
+        for (std::size_t i = 0; i < block->instrs.size();)
+        {
+            Instr *instr = block->instrs[i];
+            for (Instr *&operand : instr->operands)
+                operand = resolve(operand);
+            if (clobbers_memory(instr->op))
+                epoch = ++epochs;
+            if (!is_pure(instr->op))
+            {
+                ++i;
+                continue;
+            }
+
+            std::vector<OperandKey> operands;
+            for (const Instr *operand : instr->operands)
+                operands.push_back(operand_key(operand));
+            if (instr->op == Op::EQ || instr->op == Op::NE)
+                std::sort(operands.begin(), operands.end());
+            ValueKey key{instr->op, instr->index, instr->name,
+                         reads_memory(instr->op) ? epoch : 0, std::move(operands)};
+            const auto [it, inserted] = table.try_emplace(std::move(key), instr);
+            if (inserted)
+            {
+                added.push_back(it->first);
+                ++i;
+                continue;
+            }
+            instr->replacement = it->second;
+            block->instrs.erase(block->instrs.begin() + static_cast<std::ptrdiff_t>(i));
+            instr->block = nullptr;
+        }
+
+        for (Block *child : children[block->id])
+            walk(child, epoch);
+        for (const ValueKey &key : added)
+            table.erase(key);
+    }
+};
+
+void remove_trivial_phis(Function &function)
+{
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (Block *block : function.rpo)
+        {
+            for (std::size_t i = 0; i < block->phi_count();)
+            {
+                Instr *phi  = block->instrs[i];
+                Instr *same = nullptr;
+                bool   trivial = true;
+                for (Instr *&operand : phi->operands)
+                {
+                    operand = resolve(operand);
+                    if (operand == same || operand == phi)
+                        continue;
+                    if (same != nullptr)
+                        trivial = false;
+                    same = operand;
+                }
+                if (!trivial)
+                {
+                    ++i;
+                    continue;
+                }
+                if (same == nullptr)
+                {
+                    same          = function.insert(Op::CONST, function.entry, 0);
+                    same->literal = std::monostate{};
+                }
+                phi->replacement = same;
+                function.remove(phi);
+                changed = true;
+            }
+        }
+    }
+    function.forward();
+}
+} // namespace
+
+void optimize(Function &function)
+{
+    simplify(function);
+    number_values(function);
+    hoist_invariants(function);
+    eliminate_dead_code(function);
+}
+
+void simplify(Function &function)
+{
+    function.forward();
+    for (const auto &block : function.blocks)
+    {
+        Instr *terminator = block->terminator();
+        if (terminator == nullptr || terminator->op != Op::BRANCH ||
+            terminator->operands[0]->op != Op::CONST)
+            continue;
+        const bool taken = truthy(terminator->operands[0]->literal);
+        function.unlink(block.get(), block->succs[taken ? 1 : 0]);
+        terminator->op = Op::JUMP;
+        terminator->operands.clear();
+    }
+
+    function.analyze();
+    for (const auto &block : function.blocks)
+    {
+        if (block->order >= 0)
+            continue;
+        while (!block->succs.empty())
+            function.unlink(block.get(), block->succs.back());
+        for (Instr *instr : block->instrs)
+            instr->block = nullptr;
+        block->instrs.clear();
+    }
+    remove_trivial_phis(function);
+    function.analyze();
+}
+
+void number_values(Function &function)
+{
+    ValueNumbering numbering{function, std::vector<std::vector<Block *>>(function.blocks.size())};
+    for (Block *block : function.rpo)
+        if (block != function.entry)
+            numbering.children[block->idom->id].push_back(block);
+    numbering.walk(function.entry, 0);
+    function.forward();
+}
+
+void hoist_invariants(Function &function)
+{
+    std::vector<Kind> kinds = known_kinds(function);
+    for (const Loop &loop : function.loops)
+    {
+        const std::unordered_set<const Block *> body(loop.blocks.begin(), loop.blocks.end());
+        Block *preheader = nullptr;
+        int    entries   = 0;
+        for (Block *pred : loop.header->preds)
+        {
+            if (body.count(pred) == 0)
+            {
+                preheader = pred;
+                entries++;
+            }
+        }
+        if (entries != 1 || preheader->succs.size() != 1)
+            continue;
+
+        // what the loop may write, a load of anything else reads the same on every iteration
+        bool                              calls  = false;
+        bool                              fields = false;
+        std::unordered_set<std::uint32_t> globals;
+        for (const Block *block : loop.blocks)
+        {
+            for (const Instr *instr : block->instrs)
+            {
+                calls  = calls || instr->op == Op::CALL || instr->op == Op::INVOKE;
+                fields = fields || instr->op == Op::SETSLOT || instr->op == Op::SETFIELD;
+                if (instr->op == Op::SETGLOBAL)
+                    globals.insert(instr->index);
+            }
+        }
+
+        std::vector<Block *> blocks = loop.blocks;
+        std::sort(blocks.begin(), blocks.end(),
+                  [](const Block *a, const Block *b) { return a->order < b->order; });
+        for (Block *block : blocks)
+        {
+            // nothing observable has happened yet in this iteration while `ahead` holds
+            bool ahead = block == loop.header;
+            for (std::size_t i = block->phi_count(); i < block->instrs.size();)
+            {
+                Instr     *instr = block->instrs[i];
+                const bool fails = may_fail(*instr, kinds);
+                bool       move  = is_pure(instr->op) && (!fails || ahead);
+                if (instr->op == Op::GETGLOBAL)
+                    move = move && !calls && globals.count(instr->index) == 0;
+                else if (instr->op == Op::GETSLOT || instr->op == Op::GETFIELD)
+                    move = move && !calls && !fields;
+                for (const Instr *operand : instr->operands)
+                    move = move && (operand->op == Op::CONST || body.count(operand->block) == 0);
+                if (!move)
+                {
+                    ahead = ahead && !fails && !has_side_effects(instr->op);
+                    ++i;
+                    continue;
+                }
+
+                // constants stay where they are, the hoisted instruction gets its own copies
+                block->instrs.erase(block->instrs.begin() + static_cast<std::ptrdiff_t>(i));
+                const std::size_t end = preheader->instrs.size() - 1;
+                for (Instr *&operand : instr->operands)
+                {
+                    if (operand->op != Op::CONST || body.count(operand->block) == 0)
+                        continue;
+                    Instr *copy   = function.insert(Op::CONST, preheader, end);
+                    copy->literal = operand->literal;
+                    copy->type    = operand->type;
+                    copy->line    = operand->line;
+                    kinds.push_back(kinds[operand->id]);
+                    operand = copy;
+                }
+                preheader->instrs.insert(preheader->instrs.end() - 1, instr);
+                instr->block = preheader;
+            }
+        }
+    }
+}
+
+void eliminate_dead_code(Function &function)
+{
+    const std::vector<Kind> kinds = known_kinds(function);
+    std::vector<bool>       live(function.instrs.size());
+    std::vector<Instr *>    work;
+    for (const Block *block : function.rpo)
+    {
+        for (Instr *instr : block->instrs)
+        {
+            if (has_side_effects(instr->op) || may_fail(*instr, kinds))
+            {
+                live[instr->id] = true;
+                work.push_back(instr);
+            }
+        }
+    }
+    while (!work.empty())
+    {
+        const Instr *instr = work.back();
+        work.pop_back();
+        for (Instr *operand : instr->operands)
+        {
+            if (!live[operand->id])
+            {
+                live[operand->id] = true;
+                work.push_back(operand);
+            }
+        }
+    }
+
+    for (Block *block : function.rpo)
+    {
+        std::vector<Instr *> &instrs = block->instrs;
+        for (Instr *instr : instrs)
+            if (!live[instr->id])
+                instr->block = nullptr;
+        instrs.erase(std::remove_if(instrs.begin(), instrs.end(),
+                                    [&](const Instr *instr) { return !live[instr->id]; }),
+                     instrs.end());
+    }
+}
+
+// an optimistic fixpoint, a phi on a loop takes the kind of its entry value unless the loop
+// changes it
+std::vector<Kind> known_kinds(const Function &function)
+{
+    std::vector<Kind> kinds(function.instrs.size(), Kind::UNKNOWN);
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (const Block *block : function.rpo)
+        {
+            for (const Instr *instr : block->instrs)
+            {
+                Kind kind = Kind::OTHER;
+                switch (instr->op)
+                {
+                case Op::CONST:
+                    if (std::holds_alternative<std::int64_t>(instr->literal))
+                        kind = Kind::INT;
+                    else if (std::holds_alternative<double>(instr->literal))
+                        kind = Kind::FLOAT;
+                    else if (std::holds_alternative<std::string_view>(instr->literal))
+                        kind = Kind::STRING;
+                    break;
+                case Op::ADD:
+                case Op::SUB:
+                case Op::MUL:
+                case Op::DIV:
+                case Op::MOD:
+                case Op::POW:
+                case Op::NEG:
+                    kind = arithmetic_kind(*instr, kinds);
+                    break;
+                case Op::PHI:
+                    kind = Kind::UNKNOWN;
+                    for (const Instr *operand : instr->operands)
+                    {
+                        const Kind of = kinds[operand->id];
+                        if (of == Kind::UNKNOWN || of == kind)
+                            continue;
+                        kind = kind == Kind::UNKNOWN ? of : Kind::OTHER;
+                    }
+                    break;
+                default:
+                    if (instr->proven && instr->type)
+                        kind = kind_of(*instr->type);
+                    break;
+                }
+                if (kinds[instr->id] != kind)
+                {
+                    kinds[instr->id] = kind;
+                    changed          = true;
+                }
+            }
+        }
+    }
+    for (Kind &kind : kinds)
+        if (kind == Kind::UNKNOWN)
+            kind = Kind::OTHER;
+    return kinds;
+}
+
+// whether executing `instr` may stop the program with a runtime error
+bool may_fail(const Instr &instr, const std::vector<Kind> &kinds)
+{
+    const auto numbers = [&] {
+        return std::all_of(instr.operands.begin(), instr.operands.end(),
+                           [&](const Instr *operand) { return is_number(kinds[operand->id]); });
+    };
+    switch (instr.op)
+    {
+    case Op::CONST:
+    case Op::PARAM:
+    case Op::PHI:
+    case Op::EQ:
+    case Op::NE:
+    case Op::NOT:
+    case Op::GETGLOBAL:
+        return false;
+    case Op::ADD:
+        return !numbers() && (kinds[instr.operands[0]->id] != Kind::STRING ||
+                              kinds[instr.operands[1]->id] != Kind::STRING);
+    case Op::SUB:
+    case Op::MUL:
+    case Op::LT:
+    case Op::LE:
+    case Op::GT:
+    case Op::GE:
+    case Op::NEG:
+        return !numbers();
+    case Op::DIV:
+    case Op::MOD: {
+        // only an int divided by an int zero fails
+        if (!numbers())
+            return true;
+        if (kinds[instr.operands[0]->id] != Kind::INT || kinds[instr.operands[1]->id] != Kind::INT)
+            return false;
+        const auto *divisor = std::get_if<std::int64_t>(&instr.operands[1]->literal);
+        return instr.operands[1]->op != Op::CONST || divisor == nullptr || *divisor == 0;
+    }
+    default:
+        return true;
+    }
+}
+} // namespace cool::compiler::ir
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ir.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cool::compiler::ir {
+/* The optimizations on a freshly built function, run in this order by optimize():
+ *
+ * - simplify: a branch on a constant becomes a jump, unreachable blocks are dropped and
+ *   phis left with a single distinct operand are replaced by it;
+ * - number_values: global value numbering over the dominator tree, an operator whose
+ *   operands (and, for a load, the memory it reads) are the same as those of one dominating
+ *   it is replaced by that one;
+ * - hoist_invariants: loop-invariant code motion, innermost loop first, into the preheader
+ *   the builder gives every loop;
+ * - eliminate_dead_code: drops every value nothing observable depends on.
+ *
+ * Nothing may change which runtime error a program stops with or when, so an operator that
+ * can fail is only hoisted from the loop header ahead of anything observable, and only
+ * removed when it provably cannot fail. Whether it can depends on the kinds of values,
+ * which known_kinds works out from constants, the arithmetic on them and the values the
+ * type checker proved.
+ */
+enum class Kind : std::uint8_t { UNKNOWN, INT, FLOAT, STRING, OTHER };
+
+void optimize(Function &function);
+void simplify(Function &function);
+void number_values(Function &function);
+void hoist_invariants(Function &function);
+void eliminate_dead_code(Function &function);
+
+[[nodiscard]] std::vector<Kind> known_kinds(const Function &function);
+[[nodiscard]] bool              may_fail(const Instr &instr, const std::vector<Kind> &kinds);
+} // namespace cool::compiler::ir
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "token_type.hpp"
+
+namespace cool::compiler::lexer::keywords {
+/* Keyword recognition through a perfect hash built at compile time. The hash only looks
+ * at the length and the first, second and last character, a seed for it is searched by a
+ * constexpr loop so that every keyword lands in its own slot, so a lookup is one hash,
+ * one table load and one string compare, with no allocation.
+ */
+struct Entry
+{
+    std::string_view word;
+    TokenType        type;
+};
+
+inline constexpr Entry list[] = {
+        {"class", CLASS},    {"var", VAR},
+        {"val", VAL},        {"print", PRINT},
+        {"fn", FN},          {"true", TRUE},
+        {"false", FALSE},    {"if", IF},
+        {"else", ELSE},      {"while", WHILE},
+        {"for", FOR},        {"return", RETURN},
+        {"int", INT},        {"string", STRING_TYPE},
+        {"bool", BOOL},      {"void", VOID},
+        {"float", FLOAT},    {"extends", EXTENDS}};
+
+inline constexpr std::size_t TABLE_SIZE = 64;
+
+constexpr std::size_t min_length()
+{
+    std::size_t length = SIZE_MAX;
+    for (const Entry &entry : list)
+        length = entry.word.size() < length ? entry.word.size() : length;
+    return length;
+}
+
+constexpr std::size_t max_length()
+{
+    std::size_t length = 0;
+    for (const Entry &entry : list)
+        length = entry.word.size() > length ? entry.word.size() : length;
+    return length;
+}
+
+constexpr std::size_t hash(const std::string_view word, const std::uint32_t seed)
+{
+    const auto first  = static_cast<unsigned char>(word.front());
+    const auto second = static_cast<unsigned char>(word[1]);
+    const auto last   = static_cast<unsigned char>(word.back());
+    return (first * seed + second * 3 + last + word.size() * 7) & (TABLE_SIZE - 1);
+}
+
+constexpr bool is_perfect(const std::uint32_t seed)
+{
+    std::array<bool, TABLE_SIZE> used{};
+    for (const Entry &entry : list)
+    {
+        const std::size_t slot = hash(entry.word, seed);
+        if (used[slot])
+            return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr std::uint32_t find_seed()
+{
+    for (std::uint32_t seed = 1; seed < 1u << 16; ++seed)
+        if (is_perfect(seed))
+            return seed;
+    return 0;
+}
+
+inline constexpr std::uint32_t SEED = find_seed();
+static_assert(SEED != 0, "no perfect hash seed for the keyword set, grow TABLE_SIZE");
+
+constexpr std::array<Entry, TABLE_SIZE> build_table()
+{
+    std::array<Entry, TABLE_SIZE> table{};
+    for (const Entry &entry : list)
+        table[hash(entry.word, SEED)] = entry;
+    return table;
+}
+
+inline constexpr std::array<Entry, TABLE_SIZE> table = build_table();
+
+constexpr std::optional<TokenType> lookup(const std::string_view word)
+{
+    if (word.size() < min_length() || word.size() > max_length())
+        return std::nullopt;
+    const Entry &entry = table[hash(word, SEED)];
+    if (entry.word != word)
+        return std::nullopt;
+    return entry.type;
+}
+
+static_assert(lookup("extends") == EXTENDS && lookup("string") == STRING_TYPE);
+static_assert(!lookup("classy") && !lookup("x") && !lookup("Print"));
+} // namespace cool::compiler::lexer::keywords
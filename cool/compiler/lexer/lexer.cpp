@@ -1,23 +1,27 @@
 #include "lexer.hpp"
 
 #include "../compiler.hpp"
+#include "keywords.hpp"
+#include "scan.hpp"
 
+#include <charconv>
 #include <iostream>
 #include <optional>
-#include <unordered_map>
 
 namespace cool::compiler::lexer {
 
-Lexer::Lexer(std::string content) : content{std::move(content)} {}
+Lexer::Lexer(const std::string_view content) : content{content}, tokens{content} {}
 
 void Lexer::scan_tokens()
 {
+    // a rough tokens-per-byte estimate for typical sources, avoids most regrowth
+    tokens.reserve(content.size() / 6 + 1);
     while (!is_end())
     {
         scan_token();
         start = current;
     }
-    tokens.push_back(Token{END_OF_FILE, {}, "", line});
+    tokens.push(END_OF_FILE, static_cast<std::uint32_t>(content.size()), 0, {});
 }
 
 void Lexer::scan_token()
@@ -83,8 +87,12 @@ void Lexer::scan_token()
         break;
     case '\n':
         line++;
+        skip_whitespace();
         break;
     case ' ':
+    case '\r':
+    case '\t':
+        skip_whitespace();
         break;
     default:
         if (c == '\"')
@@ -102,7 +110,7 @@ char Lexer::peek() const
 {
     if (is_end())
         return '\0';
-    return content.at(current);
+    return content[current];
 }
 bool Lexer::is_end() const
 {
@@ -116,9 +124,24 @@ char Lexer::advance()
     return c;
 }
 
+const char *Lexer::cursor() const
+{
+    return content.data() + current;
+}
+
+const char *Lexer::limit() const
+{
+    return content.data() + content.size();
+}
+
+void Lexer::seek(const char *position)
+{
+    current = static_cast<std::uint32_t>(position - content.data());
+}
+
 bool Lexer::match(char c)
 {
-    if (is_end() || content.at(current) != c)
+    if (is_end() || content[current] != c)
     {
         return false;
     }
@@ -128,45 +151,54 @@ bool Lexer::match(char c)
 
 void Lexer::add_token(const TokenType type, const Literal &literal)
 {
-    const std::string lexeme = content.substr(start, current - start);
-    tokens.push_back(Token{type, literal, lexeme, line});
+    tokens.push(type, start, current - start, literal);
+}
+
+void Lexer::skip_whitespace()
+{
+    if (!scan::is_whitespace(peek()))
+        return;
+    seek(scan::kernels().skip_whitespace(cursor(), limit(), line));
 }
 
 void Lexer::string()
 {
-    while (!is_end() && peek() != '\"')
-    {
-        if (peek() == '\n')
-            line++;
-        advance();
-    }
+    seek(scan::kernels().skip_string_body(cursor(), limit(), line));
     if (is_end())
     {
         Compiler::error(line, "Unterminated string");
         return;
     }
-    const std::string value = content.substr(start + 1, current - start - 1);
+    const std::string_view value = content.substr(start + 1, current - start - 1);
     advance();
     add_token(STRING, value);
 }
 
 void Lexer::number()
 {
-    while (!is_end() && isdigit(peek()))
+    seek(scan::kernels().skip_digits(cursor(), limit()));
+    if (peek() == '.' && current + 1 < content.size() && isdigit(content[current + 1]))
     {
         advance();
+        seek(scan::kernels().skip_digits(cursor(), limit()));
+        double value = 0;
+        std::from_chars(content.data() + start, content.data() + current, value);
+        add_token(NUMBER, value);
+        return;
     }
-    std::string num_str = content.substr(start, current - start);
-    Literal     value   = std::stod(num_str);
+
+    std::int64_t value = 0;
+    const auto [end, ec] = std::from_chars(content.data() + start, content.data() + current, value);
+    if (ec == std::errc::result_out_of_range)
+        Compiler::error(line, "Integer literal out of range.");
     add_token(NUMBER, value);
 }
 
 void Lexer::identifier()
 {
-    while (isalnum(peek()))
-        advance();
+    seek(scan::kernels().skip_identifier(cursor(), limit()));
 
-    const std::string lexeme = content.substr(start, current - start);
+    const std::string_view lexeme = content.substr(start, current - start);
     if (const auto tokenType = get_token_type_for_keyword(lexeme); tokenType.has_value())
     {
         add_token(tokenType.value(), {});
@@ -190,21 +222,8 @@ bool Lexer::isdigit(char c)
     return c >= '0' && c <= '9';
 }
 
-std::optional<TokenType> Lexer::get_token_type_for_keyword(const std::string &word)
+std::optional<TokenType> Lexer::get_token_type_for_keyword(const std::string_view word)
 {
-    static const std::unordered_map<std::string, TokenType> keyword_map = {
-            {"class", CLASS},    {"var", VAR},
-            {"val", VAL},        {"print", PRINT},
-            {"fn", FN},          {"true", TRUE},
-            {"false", FALSE},    {"if", IF},
-            {"else", ELSE},      {"while", WHILE},
-            {"for", FOR},        {"return", RETURN},
-            {"int", INT},        {"string", STRING_TYPE},
-            {"bool", BOOL},      {"void", VOID},
-            {"extends", EXTENDS}};
-
-    if (const auto it = keyword_map.find(word); it != keyword_map.end())
-        return it->second;
-    return std::nullopt;
+    return keywords::lookup(word);
 }
 } // namespace cool::compiler::lexer
\ No newline at end of file
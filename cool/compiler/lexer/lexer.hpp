@@ -1,32 +1,38 @@
 #pragma once
 
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
 #include "token.hpp"
+#include "token_stream.hpp"
 
 #include <optional>
 
 namespace cool::compiler::lexer {
 struct Lexer
 {
-    std::string        content;
-    std::vector<Token> tokens{};
-    int                start   = 0;
-    int                current = 0;
-    int                line    = 1;
+    std::string_view content;
+    TokenStream      tokens;
+    std::uint32_t    start   = 0; // offsets into `content`, as in the tokens
+    std::uint32_t    current = 0;
+    int              line    = 1;
 
-    explicit Lexer(std::string content);
+    explicit Lexer(std::string_view content);
     void                                   scan_tokens();
     void                                   scan_token();
     [[nodiscard]] char                     peek() const;
     [[nodiscard]] bool                     is_end() const;
     char                                   advance();
+    [[nodiscard]] const char              *cursor() const;
+    [[nodiscard]] const char              *limit() const;
+    void                                   seek(const char *position);
     bool                                   match(char c);
     void                                   add_token(TokenType type, const Literal &literal);
+    void                                   skip_whitespace();
     void                                   string();
     void                                   number();
-    static inline std::optional<TokenType> get_token_type_for_keyword(const std::string &string);
+    static inline std::optional<TokenType> get_token_type_for_keyword(std::string_view word);
     void                                   identifier();
     static bool                            isalpha(char c);
     static bool                            isalnum(char c);
@@ -0,0 +1,290 @@
+#include "scan.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define COOL_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace cool::compiler::lexer::scan {
+namespace {
+bool is_ident(const char c)
+{
+    return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+bool is_digit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+const char *scalar_whitespace(const char *p, const char *end, int &newlines)
+{
+    for (; p < end && is_whitespace(*p); ++p)
+        newlines += *p == '\n';
+    return p;
+}
+
+const char *scalar_identifier(const char *p, const char *end)
+{
+    while (p < end && is_ident(*p))
+        ++p;
+    return p;
+}
+
+const char *scalar_digits(const char *p, const char *end)
+{
+    while (p < end && is_digit(*p))
+        ++p;
+    return p;
+}
+
+const char *scalar_string_body(const char *p, const char *end, int &newlines)
+{
+    for (; p < end && *p != '"'; ++p)
+        newlines += *p == '\n';
+    return p;
+}
+
+#ifdef COOL_SCAN_X86
+/* Every kernel builds a mask with one bit per byte that is inside the run, then the
+ * first zero bit ends the run. Newlines inside the consumed prefix are counted with a
+ * popcount of the '\n' mask restricted to that prefix.
+ */
+inline std::uint32_t low_bits(const unsigned count)
+{
+    return count >= 32 ? ~0u : (1u << count) - 1u;
+}
+
+inline unsigned first_zero(const std::uint32_t mask, const unsigned width)
+{
+    const std::uint32_t inverted = ~mask & low_bits(width);
+    return inverted == 0 ? width : static_cast<unsigned>(__builtin_ctz(inverted));
+}
+
+// x in [lo, hi] as an unsigned byte comparison: min(x - lo, hi - lo) == x - lo
+inline __m128i in_range_sse2(const __m128i x, const char lo, const char hi)
+{
+    const __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(static_cast<char>(hi - lo))),
+                          shifted);
+}
+
+const char *sse2_whitespace(const char *p, const char *end, int &newlines)
+{
+    while (end - p >= 16)
+    {
+        const __m128i chunk   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i newline = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+        const __m128i ws      = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), newline),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+        const unsigned run = first_zero(static_cast<std::uint32_t>(_mm_movemask_epi8(ws)), 16);
+        newlines += __builtin_popcount(static_cast<std::uint32_t>(_mm_movemask_epi8(newline)) &
+                                       low_bits(run));
+        p += run;
+        if (run < 16)
+            return p;
+    }
+    return scalar_whitespace(p, end, newlines);
+}
+
+const char *sse2_identifier(const char *p, const char *end)
+{
+    while (end - p >= 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i alpha = in_range_sse2(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z');
+        const __m128i ident =
+                _mm_or_si128(_mm_or_si128(alpha, in_range_sse2(chunk, '0', '9')),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+        const unsigned run = first_zero(static_cast<std::uint32_t>(_mm_movemask_epi8(ident)), 16);
+        p += run;
+        if (run < 16)
+            return p;
+    }
+    return scalar_identifier(p, end);
+}
+
+const char *sse2_digits(const char *p, const char *end)
+{
+    while (end - p >= 16)
+    {
+        const __m128i  chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const unsigned run   = first_zero(
+                static_cast<std::uint32_t>(_mm_movemask_epi8(in_range_sse2(chunk, '0', '9'))), 16);
+        p += run;
+        if (run < 16)
+            return p;
+    }
+    return scalar_digits(p, end);
+}
+
+const char *sse2_string_body(const char *p, const char *end, int &newlines)
+{
+    while (end - p >= 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const auto    quote = static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))));
+        const auto newline = static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+        const unsigned run = first_zero(~quote, 16);
+        newlines += __builtin_popcount(newline & low_bits(run));
+        p += run;
+        if (run < 16)
+            return p;
+    }
+    return scalar_string_body(p, end, newlines);
+}
+
+#define COOL_AVX2 __attribute__((target("avx2")))
+
+COOL_AVX2 inline __m256i in_range_avx2(const __m256i x, const char lo, const char hi)
+{
+    const __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(
+            _mm256_min_epu8(shifted, _mm256_set1_epi8(static_cast<char>(hi - lo))), shifted);
+}
+
+COOL_AVX2 inline std::uint32_t movemask_avx2(const __m256i x)
+{
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(x));
+}
+
+COOL_AVX2 const char *avx2_whitespace(const char *p, const char *end, int &newlines)
+{
+    while (end - p >= 32)
+    {
+        const __m256i chunk   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i newline = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+        const __m256i ws      = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), newline),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')),
+                                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))));
+        const unsigned run = first_zero(movemask_avx2(ws), 32);
+        newlines += __builtin_popcount(movemask_avx2(newline) & low_bits(run));
+        p += run;
+        if (run < 32)
+            return p;
+    }
+    return sse2_whitespace(p, end, newlines);
+}
+
+COOL_AVX2 const char *avx2_identifier(const char *p, const char *end)
+{
+    while (end - p >= 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i alpha =
+                in_range_avx2(_mm256_or_si256(chunk, _mm256_set1_epi8(0x20)), 'a', 'z');
+        const __m256i ident =
+                _mm256_or_si256(_mm256_or_si256(alpha, in_range_avx2(chunk, '0', '9')),
+                                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+        const unsigned run = first_zero(movemask_avx2(ident), 32);
+        p += run;
+        if (run < 32)
+            return p;
+    }
+    return sse2_identifier(p, end);
+}
+
+COOL_AVX2 const char *avx2_digits(const char *p, const char *end)
+{
+    while (end - p >= 32)
+    {
+        const __m256i  chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const unsigned run   = first_zero(movemask_avx2(in_range_avx2(chunk, '0', '9')), 32);
+        p += run;
+        if (run < 32)
+            return p;
+    }
+    return sse2_digits(p, end);
+}
+
+COOL_AVX2 const char *avx2_string_body(const char *p, const char *end, int &newlines)
+{
+    while (end - p >= 32)
+    {
+        const __m256i       chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const std::uint32_t quote = movemask_avx2(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')));
+        const std::uint32_t newline =
+                movemask_avx2(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        const unsigned run = first_zero(~quote, 32);
+        newlines += __builtin_popcount(newline & low_bits(run));
+        p += run;
+        if (run < 32)
+            return p;
+    }
+    return sse2_string_body(p, end, newlines);
+}
+#endif
+
+constexpr Kernels scalar_kernels{Level::SCALAR, scalar_whitespace, scalar_identifier,
+                                 scalar_digits, scalar_string_body};
+#ifdef COOL_SCAN_X86
+constexpr Kernels sse2_kernels{Level::SSE2, sse2_whitespace, sse2_identifier, sse2_digits,
+                               sse2_string_body};
+constexpr Kernels avx2_kernels{Level::AVX2, avx2_whitespace, avx2_identifier, avx2_digits,
+                               avx2_string_body};
+#endif
+
+const Kernels &kernels_for(const Level level)
+{
+    switch (level)
+    {
+#ifdef COOL_SCAN_X86
+    case Level::AVX2:
+        return avx2_kernels;
+    case Level::SSE2:
+        return sse2_kernels;
+#endif
+    default:
+        return scalar_kernels;
+    }
+}
+
+const Kernels *active = &kernels_for(best_level());
+} // namespace
+
+Level best_level()
+{
+#ifdef COOL_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Level::AVX2;
+    return Level::SSE2;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+bool supported(const Level level)
+{
+    return level <= best_level();
+}
+
+const Kernels &kernels()
+{
+    return *active;
+}
+
+void select(const Level level)
+{
+    active = &kernels_for(supported(level) ? level : best_level());
+}
+
+const char *level_name(const Level level)
+{
+    switch (level)
+    {
+    case Level::SCALAR:
+        return "scalar";
+    case Level::SSE2:
+        return "sse2";
+    case Level::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+} // namespace cool::compiler::lexer::scan
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cool::compiler::lexer::scan {
+/* Character-class skipping kernels used by the lexer for runs of whitespace, identifier
+ * characters, digits and string bodies. Each kernel returns the first position in
+ * [begin, end) that is not part of the run (or end), kernels that may cross line breaks
+ * add the number of '\n' they skipped to `newlines`.
+ *
+ * The implementation is picked once at startup from what the CPU supports (AVX2, SSE2 or
+ * plain scalar code) and can be overridden, which the lexer benchmark uses to compare them.
+ */
+enum class Level : std::uint8_t { SCALAR, SSE2, AVX2 };
+
+struct Kernels
+{
+    Level level;
+    const char *(*skip_whitespace)(const char *begin, const char *end, int &newlines);
+    const char *(*skip_identifier)(const char *begin, const char *end);
+    const char *(*skip_digits)(const char *begin, const char *end);
+    const char *(*skip_string_body)(const char *begin, const char *end, int &newlines);
+};
+
+[[nodiscard]] Level          best_level();
+[[nodiscard]] bool           supported(Level level);
+[[nodiscard]] const Kernels &kernels();
+void                         select(Level level);
+[[nodiscard]] const char    *level_name(Level level);
+
+inline bool is_whitespace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+} // namespace cool::compiler::lexer::scan
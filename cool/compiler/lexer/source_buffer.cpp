@@ -0,0 +1,100 @@
+#include "source_buffer.hpp"
+
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define COOL_HAS_MMAP 1
+#endif
+
+namespace cool::compiler::lexer {
+
+SourceBuffer::SourceBuffer(std::string content) : owned{std::move(content)}
+{
+    data = owned.data();
+    size = owned.size();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+    release();
+    mapped = std::exchange(other.mapped, false);
+    size   = std::exchange(other.size, 0);
+    if (mapped)
+    {
+        data = std::exchange(other.data, nullptr);
+    }
+    else
+    {
+        owned      = std::move(other.owned);
+        data       = owned.data();
+        other.data = nullptr;
+    }
+    return *this;
+}
+
+SourceBuffer::~SourceBuffer()
+{
+    release();
+}
+
+void SourceBuffer::release()
+{
+#ifdef COOL_HAS_MMAP
+    if (mapped && data != nullptr)
+        munmap(const_cast<char *>(data), size);
+#endif
+    data   = nullptr;
+    size   = 0;
+    mapped = false;
+    owned.clear();
+}
+
+std::optional<SourceBuffer> SourceBuffer::map(const std::string &file_name)
+{
+#ifdef COOL_HAS_MMAP
+    const int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return std::nullopt;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        // mmap cannot map an empty file, the caller falls back to reading it
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    void *addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return std::nullopt;
+#ifdef MADV_SEQUENTIAL
+    madvise(addr, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+#endif
+
+    SourceBuffer buffer;
+    buffer.data   = static_cast<const char *>(addr);
+    buffer.size   = static_cast<std::size_t>(st.st_size);
+    buffer.mapped = true;
+    return buffer;
+#else
+    return std::nullopt;
+#endif
+}
+
+std::string_view SourceBuffer::view() const
+{
+    return {data, size};
+}
+} // namespace cool::compiler::lexer
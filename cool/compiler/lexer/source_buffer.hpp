@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cool::compiler::lexer {
+/* Read-only contents of a source file. The file is memory-mapped when the platform
+ * allows it, so tokens can be string_view slices into it without copying the source.
+ * Every view handed out by the lexer stays valid for the lifetime of the buffer.
+ */
+struct SourceBuffer
+{
+    const char *data   = nullptr;
+    std::size_t size   = 0;
+    bool        mapped = false;
+    std::string owned;
+
+    SourceBuffer() = default;
+    explicit SourceBuffer(std::string content);
+    SourceBuffer(const SourceBuffer &)            = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+    SourceBuffer(SourceBuffer &&other) noexcept;
+    SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+    ~SourceBuffer();
+
+    static std::optional<SourceBuffer> map(const std::string &file_name);
+    [[nodiscard]] std::string_view     view() const;
+
+private:
+    void release();
+};
+} // namespace cool::compiler::lexer
@@ -1,19 +1,25 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include "token_type.hpp"
 
 namespace cool::compiler::lexer {
-using Literal = std::variant<std::monostate, std::string, bool, double>;
+/* String literals and lexemes are views into the source buffer the tokens were scanned
+ * from, so the buffer has to outlive every token and AST node built from them. Number
+ * literals without a fraction are integers, the others are floats.
+ */
+using Literal = std::variant<std::monostate, std::string_view, bool, double, std::int64_t>;
 
 struct Token
 {
-    TokenType   type;
-    Literal     literal;
-    std::string lexeme;
-    int         line;
+    TokenType        type;
+    Literal          literal;
+    std::string_view lexeme;
+    int              line;
 
     static std::string token_type_to_string(const TokenType type)
     {
@@ -107,6 +113,8 @@ struct Token
             return "CLASS";
         case INT:
             return "INT";
+        case FLOAT:
+            return "FLOAT";
         case STRING_TYPE:
             return "STRING_TYPE";
         case BOOL:
@@ -124,7 +132,7 @@ struct Token
 
     [[nodiscard]] std::string to_string() const
     {
-        return lexeme + " ( " + token_type_to_string(type) + " )";
+        return std::string(lexeme) + " ( " + token_type_to_string(type) + " )";
     }
 };
 } // namespace cool::compiler::lexer
\ No newline at end of file
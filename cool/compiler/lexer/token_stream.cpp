@@ -0,0 +1,109 @@
+#include "token_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cool::compiler::lexer {
+
+TokenStream::TokenStream(const std::string_view source) : source{source} {}
+
+void TokenStream::reserve(const std::size_t count)
+{
+    types.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+    literal_ids.reserve(count);
+}
+
+void TokenStream::push(const TokenType type, const std::uint32_t offset, const std::uint32_t length,
+                       const Literal &literal)
+{
+    types.push_back(static_cast<std::uint8_t>(type));
+    offsets.push_back(offset);
+    lengths.push_back(length);
+    if (type == IDENTIFIER)
+        literal_ids.push_back(intern_symbol(source.substr(offset, length)));
+    else
+        literal_ids.push_back(std::holds_alternative<std::monostate>(literal) ? 0
+                                                                              : intern(literal));
+}
+
+std::uint32_t TokenStream::intern(const Literal &literal)
+{
+    const auto [it, inserted] =
+            literal_table.try_emplace(literal, static_cast<std::uint32_t>(literals.size()));
+    if (inserted)
+        literals.push_back(literal);
+    return it->second;
+}
+
+Symbol TokenStream::intern_symbol(const std::string_view name)
+{
+    const auto [it, inserted] =
+            symbol_table.try_emplace(name, static_cast<Symbol>(symbols.size()));
+    if (inserted)
+        symbols.push_back(name);
+    return it->second;
+}
+
+std::size_t TokenStream::size() const
+{
+    return types.size();
+}
+
+TokenType TokenStream::type(const std::size_t index) const
+{
+    return static_cast<TokenType>(types[index]);
+}
+
+std::string_view TokenStream::lexeme(const std::size_t index) const
+{
+    return source.substr(offsets[index], lengths[index]);
+}
+
+const Literal &TokenStream::literal(const std::size_t index) const
+{
+    return type(index) == IDENTIFIER ? literals[0] : literals[literal_ids[index]];
+}
+
+Symbol TokenStream::symbol(const std::size_t index) const
+{
+    return literal_ids[index];
+}
+
+Symbol TokenStream::find_symbol(const std::string_view name) const
+{
+    const auto it = symbol_table.find(name);
+    return it != symbol_table.end() ? it->second : NO_SYMBOL;
+}
+
+int TokenStream::line(const std::size_t index) const
+{
+    return line_at(offsets[index]);
+}
+
+int TokenStream::line_at(const std::uint32_t offset) const
+{
+    if (line_starts.empty())
+    {
+        line_starts.push_back(0);
+        const char *begin = source.data();
+        const char *end   = begin + source.size();
+        for (const char *p = begin; p < end;)
+        {
+            const auto *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (newline == nullptr)
+                break;
+            line_starts.push_back(static_cast<std::uint32_t>(newline - begin + 1));
+            p = newline + 1;
+        }
+    }
+    const auto it = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+    return static_cast<int>(it - line_starts.begin());
+}
+
+Token TokenStream::token(const std::size_t index) const
+{
+    return Token{type(index), literal(index), lexeme(index), line(index)};
+}
+} // namespace cool::compiler::lexer
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "token.hpp"
+
+namespace cool::compiler::lexer {
+static_assert(END_OF_FILE <= UINT8_MAX, "TokenType must fit into the uint8_t type column");
+
+using TokenIndex                     = std::uint32_t;
+inline constexpr TokenIndex NO_TOKEN = UINT32_MAX;
+
+// an interned identifier, equal names have the same symbol
+using Symbol                      = std::uint32_t;
+inline constexpr Symbol NO_SYMBOL = UINT32_MAX;
+
+/* Tokens of one source buffer stored as parallel arrays, about 13 bytes per token.
+ * Lexemes are (offset, length) slices of the source, literal values live in a side
+ * table where equal literals share one entry (id 0 means "no literal"). An identifier has
+ * no literal, its column holds its symbol instead, so later passes compare names as
+ * integers. Line numbers are only needed for diagnostics, so they are recovered from the
+ * offset on demand.
+ */
+struct TokenStream
+{
+    std::string_view                             source;
+    std::vector<std::uint8_t>                    types;
+    std::vector<std::uint32_t>                   offsets;
+    std::vector<std::uint32_t>                   lengths;
+    std::vector<std::uint32_t>                   literal_ids;
+    std::vector<Literal>                         literals{Literal{}};
+    std::unordered_map<Literal, std::uint32_t>   literal_table;
+    std::vector<std::string_view>                symbols; // the name of every symbol
+    std::unordered_map<std::string_view, Symbol> symbol_table;
+    mutable std::vector<std::uint32_t>           line_starts;
+
+    TokenStream() = default;
+    explicit TokenStream(std::string_view source);
+    void                           reserve(std::size_t count);
+    void                           push(TokenType type, std::uint32_t offset, std::uint32_t length,
+                                        const Literal &literal);
+    std::uint32_t                  intern(const Literal &literal);
+    Symbol                         intern_symbol(std::string_view name);
+    [[nodiscard]] std::size_t      size() const;
+    [[nodiscard]] TokenType        type(std::size_t index) const;
+    [[nodiscard]] std::string_view lexeme(std::size_t index) const;
+    [[nodiscard]] const Literal   &literal(std::size_t index) const;
+    [[nodiscard]] Symbol           symbol(std::size_t index) const; // of an identifier
+    [[nodiscard]] Symbol           find_symbol(std::string_view name) const;
+    [[nodiscard]] int              line(std::size_t index) const;
+    [[nodiscard]] int              line_at(std::uint32_t offset) const;
+    [[nodiscard]] Token            token(std::size_t index) const;
+};
+} // namespace cool::compiler::lexer
@@ -1,18 +1,100 @@
 #include "compiler.hpp"
+#include "thread_pool.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+bool parse_jobs(const char *text, unsigned &jobs)
+{
+    char      *end   = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 1)
+        return false;
+    jobs = static_cast<unsigned>(std::min(value, 1024L));
+    return true;
+}
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    /* TODO: additional argument for output file */
-    if (argc != 2)
+    cool::compiler::CompilerOptions options;
+    std::vector<std::string>        paths;
+    unsigned                        jobs  = std::max(std::thread::hardware_concurrency(), 1U);
+    bool                            usage = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            options.output = argv[++i];
+        else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            usage = !parse_jobs(argv[++i], jobs) || usage;
+        else if (std::strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc)
+            options.cache_dir = argv[++i];
+        else if (std::strcmp(argv[i], "--dump-tokens") == 0)
+            options.dump_tokens = true;
+        else if (std::strcmp(argv[i], "--dump-ast") == 0)
+            options.dump_ast = true;
+        else if (std::strcmp(argv[i], "--dump-ir") == 0)
+            options.dump_ir = true;
+        else if (std::strcmp(argv[i], "--no-optimize") == 0)
+            options.optimize = false;
+        else if (std::strcmp(argv[i], "--no-fuse") == 0)
+            options.fuse = false;
+        else if (argv[i][0] != '-')
+            paths.emplace_back(argv[i]);
+        else
+            usage = true;
+    }
+
+    // every unit gets a module of its own, so -o only names one
+    if (usage || paths.empty() || (!options.output.empty() && paths.size() > 1))
+    {
+        std::cerr << "Usage: coolc [-o <file.coolb>] [-j <jobs>] [--cache-dir <dir>] "
+                     "[--dump-tokens] [--dump-ast] [--dump-ir] [--no-optimize] [--no-fuse] "
+                     "<filePath>...\n";
+        return 1;
+    }
+
+    // the dumps are printed while compiling, so they only make sense one unit after another
+    if (options.dump_tokens || options.dump_ast || options.dump_ir)
+        jobs = 1;
+    jobs = std::min(jobs, static_cast<unsigned>(paths.size()));
+
+    std::vector<cool::compiler::Diagnostics>       diagnostics(paths.size());
+    std::vector<cool::compiler::CompilationResult> results(paths.size());
+    const auto compile = [&](const std::size_t i) {
+        results[i] = cool::compiler::Compiler{paths[i], options}.compile(diagnostics[i]);
+    };
+    if (jobs == 1)
     {
-        std::cerr << "Usage: coolc <filePath>\n";
-        exit(1);
+        for (std::size_t i = 0; i < paths.size(); ++i)
+            compile(i);
+    }
+    else
+    {
+        cool::compiler::ThreadPool pool{jobs};
+        for (std::size_t i = 0; i < paths.size(); ++i)
+            pool.submit([&compile, i] { compile(i); });
+        pool.wait();
     }
 
-    cool::compiler::Compiler          compiler{argv[1]};
-    cool::compiler::CompilationResult result = compiler.compile();
+    // in the order of the command line, whichever unit finished first
+    int status = 0;
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        for (const std::string &message : diagnostics[i].messages)
+        {
+            if (paths.size() > 1)
+                std::cerr << paths[i] << ": ";
+            std::cerr << message << '\n';
+        }
+        if (results[i] != cool::compiler::SUCCESS)
+            status = 1;
+    }
+    return status;
 }
@@ -0,0 +1,496 @@
+#include "optimizer.hpp"
+
+#include "../ast/visitor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace cool::compiler::optimizer {
+using analysis::Type;
+
+namespace {
+bool truthy(const lexer::Literal &value)
+{
+    if (std::holds_alternative<std::monostate>(value))
+        return false;
+    const auto *boolean = std::get_if<bool>(&value);
+    return boolean == nullptr || *boolean;
+}
+
+// as analysis::TypeChecker types a literal
+Optimizer::StaticType literal_type(const lexer::Literal &value)
+{
+    if (std::holds_alternative<std::int64_t>(value))
+        return Type::INT;
+    if (std::holds_alternative<double>(value))
+        return Type::FLOAT;
+    if (std::holds_alternative<std::string_view>(value))
+        return Type::STRING;
+    if (std::holds_alternative<bool>(value))
+        return Type::BOOL;
+    return std::nullopt;
+}
+
+bool number(const lexer::Literal &value, double &result)
+{
+    if (const auto *integer = std::get_if<std::int64_t>(&value))
+    {
+        result = static_cast<double>(*integer);
+        return true;
+    }
+    if (const auto *real = std::get_if<double>(&value))
+    {
+        result = *real;
+        return true;
+    }
+    return false;
+}
+
+// the constant pool keys floats by value, so NaN and -0.0 are left to the run time
+std::optional<lexer::Literal> float_result(const double value)
+{
+    if (std::isnan(value) || (value == 0 && std::signbit(value)))
+        return std::nullopt;
+    return lexer::Literal{value};
+}
+
+template <typename T>
+std::optional<lexer::Literal> compare(const lexer::TokenType op, const T x, const T y)
+{
+    switch (op)
+    {
+    case lexer::EQUALS_EQUAL:
+        return lexer::Literal{x == y};
+    case lexer::BANG_EQUAL:
+        return lexer::Literal{x != y};
+    case lexer::LESS:
+        return lexer::Literal{x < y};
+    case lexer::LESS_EQUAL:
+        return lexer::Literal{x <= y};
+    case lexer::GREATER:
+        return lexer::Literal{x > y};
+    case lexer::GREATER_EQUAL:
+        return lexer::Literal{x >= y};
+    default:
+        return std::nullopt;
+    }
+}
+
+// as Interpreter::integer_operation: wrapping arithmetic, a division by zero stays an error
+std::optional<lexer::Literal> fold_integers(const lexer::TokenType op, const std::int64_t x,
+                                            const std::int64_t y)
+{
+    const auto ux = static_cast<std::uint64_t>(x);
+    const auto uy = static_cast<std::uint64_t>(y);
+    switch (op)
+    {
+    case lexer::PLUS:
+        return lexer::Literal{static_cast<std::int64_t>(ux + uy)};
+    case lexer::MINUS:
+        return lexer::Literal{static_cast<std::int64_t>(ux - uy)};
+    case lexer::STAR:
+        return lexer::Literal{static_cast<std::int64_t>(ux * uy)};
+    case lexer::SLASH:
+    case lexer::PERCENT:
+        if (y == 0)
+            return std::nullopt;
+        if (y == -1) // INT64_MIN / -1 overflows
+            return lexer::Literal{op == lexer::SLASH ? static_cast<std::int64_t>(0 - ux)
+                                                     : std::int64_t{0}};
+        return lexer::Literal{op == lexer::SLASH ? x / y : x % y};
+    case lexer::ASTRIX:
+        return float_result(std::pow(static_cast<double>(x), static_cast<double>(y)));
+    default:
+        return compare(op, x, y);
+    }
+}
+
+std::optional<lexer::Literal> fold_floats(const lexer::TokenType op, const double x,
+                                          const double y)
+{
+    switch (op)
+    {
+    case lexer::PLUS:
+        return float_result(x + y);
+    case lexer::MINUS:
+        return float_result(x - y);
+    case lexer::STAR:
+        return float_result(x * y);
+    case lexer::SLASH:
+        return float_result(x / y);
+    case lexer::PERCENT:
+        return float_result(std::fmod(x, y));
+    case lexer::ASTRIX:
+        return float_result(std::pow(x, y));
+    default:
+        return compare(op, x, y);
+    }
+}
+
+std::optional<lexer::Literal> fold_unary(const lexer::TokenType op, const lexer::Literal &value)
+{
+    if (op != lexer::MINUS)
+        return lexer::Literal{!truthy(value)};
+    if (const auto *integer = std::get_if<std::int64_t>(&value))
+        return lexer::Literal{static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(*integer))};
+    if (const auto *real = std::get_if<double>(&value))
+        return float_result(-*real);
+    return std::nullopt;
+}
+
+/* Whether `x op k` (`k op x` when `left`) is `x` itself for every `x` of `type`. An int
+ * constant keeps ints ints and floats floats, a float one turns an int into a float, and
+ * -0.0 + 0 is 0.0, so adding zero is only an identity on ints.
+ */
+bool neutral(const lexer::TokenType op, const lexer::Literal &k, const Optimizer::StaticType type,
+             const bool left)
+{
+    double value;
+    if (!number(k, value) || (type != Type::INT && type != Type::FLOAT))
+        return false;
+    if (std::holds_alternative<double>(k) && type != Type::FLOAT)
+        return false;
+    switch (op)
+    {
+    case lexer::PLUS:
+        return value == 0 && type == Type::INT;
+    case lexer::MINUS:
+        return !left && value == 0 && !std::signbit(value);
+    case lexer::STAR:
+        return value == 1;
+    case lexer::SLASH:
+        return !left && value == 1;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+Optimizer::Optimizer(const lexer::TokenStream &tokens, ast::AstArena &arena)
+    : tokens{tokens}, arena{arena}
+{
+}
+
+// functions and classes first, CodeGenerator::generate compiles them before any statement
+void Optimizer::optimize(ast::StmtList &program)
+{
+    declare_globals(program);
+    for (ast::Stmt *stmt : program)
+    {
+        if (auto *fn = ast::as<ast::Function>(stmt))
+            function(*fn);
+        else if (auto *klass = ast::as<ast::Class>(stmt))
+            class_declaration(*klass);
+    }
+
+    for (ast::Stmt *&stmt : program)
+    {
+        if (stmt != nullptr && stmt->kind != ast::StmtKind::FUNCTION &&
+            stmt->kind != ast::StmtKind::CLASS)
+            stmt = statement(stmt);
+    }
+    program.erase(std::remove(program.begin(), program.end(), nullptr), program.end());
+}
+
+/* The `val`s declared before any top-level code that could call a function are set by the
+ * time any function runs, so they are propagated everywhere. Their initializers are
+ * folded here, in order, so one may use the ones above it.
+ */
+void Optimizer::declare_globals(const ast::StmtList &program)
+{
+    for (ast::Stmt *stmt : program)
+    {
+        if (stmt == nullptr || stmt->kind == ast::StmtKind::FUNCTION ||
+            stmt->kind == ast::StmtKind::CLASS)
+            continue;
+        auto *var = ast::as<ast::VarDecl>(stmt);
+        if (var == nullptr)
+            return;
+        var->initializer    = expr(var->initializer);
+        ast::Literal *value = constant(*var);
+        if (value == nullptr)
+            return;
+        constants.emplace(var->name, value);
+    }
+}
+
+void Optimizer::function(ast::Function &node)
+{
+    if (auto *body = ast::as<ast::Block>(node.body))
+        statements(body->statements);
+    else
+        node.body = statement(node.body);
+}
+
+void Optimizer::class_declaration(ast::Class &node)
+{
+    for (ast::Stmt *attribute : node.attributes)
+        if (auto *field = ast::as<ast::VarDecl>(attribute))
+            field->initializer = expr(field->initializer);
+    for (ast::Stmt *method : node.methods)
+        if (auto *fn = ast::as<ast::Function>(method))
+            function(*fn);
+}
+
+ast::Stmt *Optimizer::statement(ast::Stmt *stmt)
+{
+    if (stmt == nullptr)
+        return nullptr;
+    return visit(*stmt, *this);
+}
+
+void Optimizer::statements(ast::StmtList &list)
+{
+    for (ast::Stmt *&stmt : list)
+        stmt = statement(stmt);
+    list.erase(std::remove(list.begin(), list.end(), nullptr), list.end());
+}
+
+// the initializer is optimized before the name is in scope, as CodeGenerator compiles it
+ast::Stmt *Optimizer::operator()(ast::VarDecl &stmt)
+{
+    stmt.initializer = expr(stmt.initializer);
+    if (ast::Literal *value = constant(stmt))
+        constants.emplace(stmt.name, value);
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::ExprStatement &stmt)
+{
+    stmt.expression = expr(stmt.expression);
+    if (ast::as<ast::Literal>(stmt.expression) != nullptr)
+        return nullptr;
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::If &stmt)
+{
+    stmt.condition = expr(stmt.condition);
+    if (const auto *condition = ast::as<ast::Literal>(stmt.condition))
+    {
+        ast::Stmt *taken =
+                statement(truthy(condition->value) ? stmt.then_branch : stmt.else_branch);
+        if (taken == nullptr || taken->kind == ast::StmtKind::BLOCK)
+            return taken;
+        ast::StmtList block = arena.list<ast::Stmt *>();
+        block.push_back(taken);
+        return arena.make<ast::Block>(std::move(block));
+    }
+    stmt.then_branch = statement(stmt.then_branch);
+    stmt.else_branch = statement(stmt.else_branch);
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::While &stmt)
+{
+    stmt.condition = expr(stmt.condition);
+    if (const auto *condition = ast::as<ast::Literal>(stmt.condition))
+    {
+        if (!truthy(condition->value))
+            return nullptr;
+    }
+    stmt.body = statement(stmt.body);
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::Return &stmt)
+{
+    stmt.expression = expr(stmt.expression);
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::Print &stmt)
+{
+    stmt.expression = expr(stmt.expression);
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::Function &stmt)
+{
+    function(stmt);
+    return &stmt;
+}
+
+ast::Stmt *Optimizer::operator()(ast::Class &stmt)
+{
+    return &stmt; // only valid at the top level, CodeGenerator reports it
+}
+
+ast::Stmt *Optimizer::operator()(ast::Block &stmt)
+{
+    statements(stmt.statements);
+    return &stmt;
+}
+
+ast::Expr *Optimizer::expr(ast::Expr *expr)
+{
+    if (expr == nullptr)
+        return nullptr;
+    return visit(*expr, *this);
+}
+
+ast::Expr *Optimizer::operator()(ast::Binary &expr)
+{
+    expr.lhs        = this->expr(expr.lhs);
+    expr.rhs        = this->expr(expr.rhs);
+    const auto *lhs = ast::as<ast::Literal>(expr.lhs);
+    const auto *rhs = ast::as<ast::Literal>(expr.rhs);
+    if (lhs == nullptr || rhs == nullptr)
+    {
+        ast::Expr *operand = identity(expr);
+        return operand != nullptr ? operand : &expr;
+    }
+
+    const lexer::TokenType        op = tokens.type(expr.op);
+    const auto                   *x  = std::get_if<std::int64_t>(&lhs->value);
+    const auto                   *y  = std::get_if<std::int64_t>(&rhs->value);
+    std::optional<lexer::Literal> value;
+    double                        a;
+    double                        b;
+    if (x != nullptr && y != nullptr)
+        value = fold_integers(op, *x, *y);
+    else if (number(lhs->value, a) && number(rhs->value, b))
+        value = fold_floats(op, a, b);
+    else if (op == lexer::EQUALS_EQUAL || op == lexer::BANG_EQUAL)
+        value = lexer::Literal{(lhs->value == rhs->value) == (op == lexer::EQUALS_EQUAL)};
+    else if (op == lexer::PLUS && std::holds_alternative<std::string_view>(lhs->value) &&
+             std::holds_alternative<std::string_view>(rhs->value))
+        value = lexer::Literal{concatenate(std::get<std::string_view>(lhs->value),
+                                           std::get<std::string_view>(rhs->value))};
+    if (!value)
+        return &expr;
+    return literal(*value);
+}
+
+ast::Expr *Optimizer::operator()(ast::Unary &expr)
+{
+    expr.operand = this->expr(expr.operand);
+    if (const auto *operand = ast::as<ast::Literal>(expr.operand))
+    {
+        if (const std::optional<lexer::Literal> value =
+                    fold_unary(tokens.type(expr.op), operand->value))
+            return literal(*value);
+    }
+    return &expr;
+}
+
+// a literal left operand decides on its own or hands the result to the right one
+ast::Expr *Optimizer::operator()(ast::Logical &expr)
+{
+    expr.lhs = this->expr(expr.lhs);
+    expr.rhs = this->expr(expr.rhs);
+    if (const auto *lhs = ast::as<ast::Literal>(expr.lhs))
+    {
+        const bool decides = (tokens.type(expr.op) == lexer::OR) == truthy(lhs->value);
+        return decides ? expr.lhs : expr.rhs;
+    }
+    return &expr;
+}
+
+ast::Expr *Optimizer::operator()(ast::Literal &expr)
+{
+    return &expr;
+}
+
+ast::Expr *Optimizer::operator()(ast::Grouping &expr)
+{
+    expr.expr = this->expr(expr.expr);
+    if (ast::as<ast::Literal>(expr.expr) != nullptr)
+        return expr.expr;
+    return &expr;
+}
+
+/* A `val` read after its declaration ran, which has been visited by then. Functions and
+ * methods are optimized before the top-level code, so the only globals they see are those
+ * declare_globals found set before any of it runs.
+ */
+ast::Expr *Optimizer::operator()(ast::Variable &expr)
+{
+    const ast::Binding::Kind kind = expr.binding.kind;
+    if (kind != ast::Binding::Kind::LOCAL && kind != ast::Binding::Kind::UPVALUE &&
+        kind != ast::Binding::Kind::GLOBAL)
+        return &expr;
+    if (const auto it = constants.find(expr.binding.declaration); it != constants.end())
+        return it->second;
+    return &expr;
+}
+
+ast::Expr *Optimizer::operator()(ast::Assignment &expr)
+{
+    expr.value = this->expr(expr.value);
+    return &expr;
+}
+
+ast::Expr *Optimizer::operator()(ast::Call &expr)
+{
+    expr.callee = this->expr(expr.callee);
+    for (ast::Expr *&argument : expr.arguments)
+        argument = this->expr(argument);
+    return &expr;
+}
+
+ast::Expr *Optimizer::operator()(ast::Get &expr)
+{
+    expr.object = this->expr(expr.object);
+    return &expr;
+}
+
+ast::Expr *Optimizer::operator()(ast::Set &expr)
+{
+    expr.object = this->expr(expr.object);
+    expr.value  = this->expr(expr.value);
+    return &expr;
+}
+
+/* The operand of an identity operation, nullptr if `expr` is none. The VM does not enforce
+ * declared types, so only an operand analysis::TypeChecker proved to be a number is kept
+ * bare: a variable declared int that holds a string at run time fails `x + 0` but not `x`,
+ * and one declared float that holds an int gives a float for `x * 1.0` but not for `x`.
+ */
+ast::Expr *Optimizer::identity(const ast::Binary &expr) const
+{
+    const lexer::TokenType op  = tokens.type(expr.op);
+    const auto            *lhs = ast::as<ast::Literal>(expr.lhs);
+    const auto            *rhs = ast::as<ast::Literal>(expr.rhs);
+    if (rhs != nullptr && expr.lhs->proven && neutral(op, rhs->value, expr.lhs->type, false))
+        return expr.lhs;
+    if (lhs != nullptr && expr.rhs->proven && neutral(op, lhs->value, expr.rhs->type, true))
+        return expr.rhs;
+    return nullptr;
+}
+
+// the literal reads of `stmt` can be replaced with, an int initializing a float is a float
+ast::Literal *Optimizer::constant(const ast::VarDecl &stmt)
+{
+    auto *initializer = ast::as<ast::Literal>(stmt.initializer);
+    if (!stmt.immutable || initializer == nullptr)
+        return nullptr;
+    const auto *integer = std::get_if<std::int64_t>(&initializer->value);
+    if (integer != nullptr && stmt.type != lexer::NO_TOKEN &&
+        tokens.type(stmt.type) == lexer::FLOAT)
+        return literal(static_cast<double>(*integer));
+    return initializer;
+}
+
+// typed like analysis::TypeChecker types a literal, it has run already
+ast::Literal *Optimizer::literal(const lexer::Literal &value)
+{
+    ast::Literal *node = arena.make<ast::Literal>(value);
+    node->type         = literal_type(value);
+    node->proven       = node->type.has_value();
+    return node;
+}
+
+// the AST only holds views, the joined string lives in the arena with the nodes
+std::string_view Optimizer::concatenate(const std::string_view lhs, const std::string_view rhs)
+{
+    const std::size_t size  = lhs.size() + rhs.size();
+    auto             *chars = static_cast<char *>(arena.resource.allocate(size, 1));
+    std::memcpy(chars, lhs.data(), lhs.size());
+    std::memcpy(chars + lhs.size(), rhs.data(), rhs.size());
+    return {chars, size};
+}
+} // namespace cool::compiler::optimizer
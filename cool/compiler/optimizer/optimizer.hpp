@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../analysis/type.hpp"
+#include "../ast/ast_arena.hpp"
+#include "../ast/stmt.hpp"
+#include "../lexer/token_stream.hpp"
+
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace cool::compiler::optimizer {
+/* Rewrites the AST of a compilation unit in place once it has been checked, before code
+ * generation:
+ *
+ * - operators on literals are folded into a literal with the value the VM would compute,
+ *   unless the VM would fail (division by zero, mismatched operands) or the result is a
+ *   float the constant pool cannot key (NaN, -0.0);
+ * - reads of a `val` whose initializer folds to a literal are replaced by that literal;
+ * - `x + 0`, `x - 0`, `x * 1` and `x / 1` become `x` when the type checker proved `x`
+ *   a number the identity holds for;
+ * - an `if` on a literal keeps only the branch taken and a `while (false)` disappears.
+ *
+ * Names come bound by analysis::Resolver and typed by analysis::TypeChecker, which reports
+ * any assignment to a `val`. A global one is only propagated into functions and methods when
+ * it is initialized before any top-level code runs, since a function called earlier would
+ * otherwise read it unset.
+ */
+struct Optimizer
+{
+    using StaticType = std::optional<analysis::Type>;
+
+    const lexer::TokenStream                              &tokens;
+    ast::AstArena                                         &arena;
+    std::unordered_map<lexer::TokenIndex, ast::Literal *> constants; // `val`s by declaration
+
+    Optimizer(const lexer::TokenStream &tokens, ast::AstArena &arena);
+    void optimize(ast::StmtList &program);
+
+    // declarations
+    void declare_globals(const ast::StmtList &program);
+    void function(ast::Function &node);
+    void class_declaration(ast::Class &node);
+
+    // statements, each returns the statement that replaces it (nullptr to drop it)
+    ast::Stmt *statement(ast::Stmt *stmt);
+    void       statements(ast::StmtList &list);
+    ast::Stmt *operator()(ast::VarDecl &stmt);
+    ast::Stmt *operator()(ast::ExprStatement &stmt);
+    ast::Stmt *operator()(ast::If &stmt);
+    ast::Stmt *operator()(ast::While &stmt);
+    ast::Stmt *operator()(ast::Return &stmt);
+    ast::Stmt *operator()(ast::Print &stmt);
+    ast::Stmt *operator()(ast::Function &stmt);
+    ast::Stmt *operator()(ast::Class &stmt);
+    ast::Stmt *operator()(ast::Block &stmt);
+
+    // expressions, each returns the expression that replaces it
+    ast::Expr *expr(ast::Expr *expr);
+    ast::Expr *operator()(ast::Binary &expr);
+    ast::Expr *operator()(ast::Unary &expr);
+    ast::Expr *operator()(ast::Logical &expr);
+    ast::Expr *operator()(ast::Literal &expr);
+    ast::Expr *operator()(ast::Grouping &expr);
+    ast::Expr *operator()(ast::Variable &expr);
+    ast::Expr *operator()(ast::Assignment &expr);
+    ast::Expr *operator()(ast::Call &expr);
+    ast::Expr *operator()(ast::Get &expr);
+    ast::Expr *operator()(ast::Set &expr);
+
+    // helpers
+    [[nodiscard]] ast::Expr *identity(const ast::Binary &expr) const;
+    ast::Literal            *constant(const ast::VarDecl &stmt);
+    ast::Literal            *literal(const lexer::Literal &value);
+    std::string_view         concatenate(std::string_view lhs, std::string_view rhs);
+};
+} // namespace cool::compiler::optimizer
@@ -1,5 +1,6 @@
 #include "parser.hpp"
 
+#include "../ast/visitor.hpp"
 #include "../compiler.hpp"
 #include "parse_error.hpp"
 
@@ -7,11 +8,13 @@
 #include <iostream>
 #include <stdexcept>
 namespace cool::compiler::parser {
-Parser::Parser(std::vector<lexer::Token> tokens) : tokens{std::move(tokens)} {}
+Parser::Parser(const lexer::TokenStream &tokens, ast::AstArena &arena)
+    : tokens{tokens}, arena{arena}
+{}
 
-std::vector<std::unique_ptr<ast::Stmt>> Parser::parse()
+ast::StmtList Parser::parse()
 {
-    std::vector<std::unique_ptr<ast::Stmt>> statements;
+    ast::StmtList statements = arena.list<ast::Stmt *>();
     while (!is_at_end())
     {
         statements.push_back(declaration());
@@ -19,7 +22,7 @@ std::vector<std::unique_ptr<ast::Stmt>> Parser::parse()
     return statements;
 }
 
-std::unique_ptr<ast::Stmt> Parser::declaration()
+ast::Stmt *Parser::declaration()
 {
     try
     {
@@ -40,30 +43,30 @@ std::unique_ptr<ast::Stmt> Parser::declaration()
     }
 }
 
-std::unique_ptr<ast::Stmt> Parser::var_declaration()
+ast::Stmt *Parser::var_declaration()
 {
-    // TODO: we don't know if it is var or val
-    lexer::Token name = consume(lexer::IDENTIFIER, "Expected variable name.");
+    const bool        immutable = tokens.type(previous()) == lexer::VAL;
+    lexer::TokenIndex name      = consume(lexer::IDENTIFIER, "Expected variable name.");
     consume(lexer::COLON, "Expected ':' after variable name.");
-    lexer::Token type = consume_any(type_tokens, "Expected type after ':'.");
+    lexer::TokenIndex type = consume_any(type_tokens, "Expected type after ':'.");
     consume(lexer::EQUAL, "Expected '=' after variable name.");
-    std::unique_ptr<ast::Expr> initializer = expression();
+    ast::Expr *initializer = expression();
     consume(lexer::SEMICOLON, "Expected ';' after variable declaration.");
-    return std::make_unique<ast::VarDecl>(name, type, std::move(initializer));
+    return arena.make<ast::VarDecl>(name, type, initializer, immutable);
 }
 
-std::unique_ptr<ast::Stmt> Parser::class_declaration()
+ast::Stmt *Parser::class_declaration()
 {
-    lexer::Token name = consume(lexer::IDENTIFIER, "Expected class name.");
-    lexer::Token parent;
-    if (match({lexer::EXTENDS}))
+    lexer::TokenIndex name   = consume(lexer::IDENTIFIER, "Expected class name.");
+    lexer::TokenIndex parent = lexer::NO_TOKEN;
+    if (match({lexer::EXTENDS, lexer::COLON}))
     {
         consume(lexer::IDENTIFIER, "Expected parent class name.");
         parent = previous();
     }
     consume(lexer::LBRACE, "Expected '{' after class name.");
-    std::vector<std::unique_ptr<ast::Stmt>> methods;
-    std::vector<std::unique_ptr<ast::Stmt>> attributes;
+    ast::StmtList methods    = arena.list<ast::Stmt *>();
+    ast::StmtList attributes = arena.list<ast::Stmt *>();
     while (!check(lexer::RBRACE) && !is_at_end())
     {
         if (match({lexer::FN}))
@@ -80,14 +83,14 @@ std::unique_ptr<ast::Stmt> Parser::class_declaration()
         }
     }
     consume(lexer::RBRACE, "Expected '}' after class body.");
-    return std::make_unique<ast::Class>(name, std::move(methods), std::move(attributes), parent);
+    return arena.make<ast::Class>(name, std::move(methods), std::move(attributes), parent);
 }
 
-std::unique_ptr<ast::Stmt> Parser::function_declaration()
+ast::Stmt *Parser::function_declaration()
 {
-    lexer::Token name = consume(lexer::IDENTIFIER, "Expected function name.");
+    lexer::TokenIndex name = consume(lexer::IDENTIFIER, "Expected function name.");
     consume(lexer::LPAREN, "Expected '(' after function name.");
-    std::vector<std::pair<lexer::Token, lexer::Token>> parameters;
+    ast::ParamList parameters = arena.list<std::pair<lexer::TokenIndex, lexer::TokenIndex>>();
     if (!check(lexer::RPAREN))
     {
         do
@@ -96,20 +99,22 @@ std::unique_ptr<ast::Stmt> Parser::function_declaration()
             {
                 error(peek(), "Cannot have more than 255 parameters.");
             }
-            lexer::Token param_name = consume(lexer::IDENTIFIER, "Expected parameter name.");
+            lexer::TokenIndex param_name = consume(lexer::IDENTIFIER, "Expected parameter name.");
             consume(lexer::COLON, "Expected ':' after parameter name.");
-            lexer::Token param_type = consume_any(type_tokens, "Expected parameter type.");
+            lexer::TokenIndex param_type = consume_any(type_tokens, "Expected parameter type.");
             parameters.emplace_back(param_name, param_type);
         } while (match({lexer::COMMA}));
     }
     consume(lexer::RPAREN, "Expected ')' after parameters.");
-    consume(lexer::ARROW, "Expected '->' after parameters.");
-    lexer::Token               return_type = consume_any(type_tokens, "Expected return type.");
-    std::unique_ptr<ast::Stmt> body        = block();
-    return std::make_unique<ast::Function>(name, parameters, return_type, std::move(body));
+    if (!match({lexer::COLON}))
+        consume(lexer::ARROW, "Expected ':' after parameters.");
+    lexer::TokenIndex return_type = consume_any(type_tokens, "Expected return type.");
+    consume(lexer::LBRACE, "Expected '{' before function body.");
+    ast::Stmt *body = block();
+    return arena.make<ast::Function>(name, std::move(parameters), return_type, body);
 }
 
-std::unique_ptr<ast::Stmt> Parser::statement()
+ast::Stmt *Parser::statement()
 {
     if (match({lexer::FN}))
         return function_declaration();
@@ -128,51 +133,50 @@ std::unique_ptr<ast::Stmt> Parser::statement()
     return expr_statement();
 }
 
-std::unique_ptr<ast::Stmt> Parser::print_statement()
+ast::Stmt *Parser::print_statement()
 {
     consume(lexer::LPAREN, "Expected '(' after 'print'.");
-    std::unique_ptr<ast::Expr> expr = expression();
+    ast::Expr *expr = expression();
     consume(lexer::RPAREN, "Expected ')' after value.");
     consume(lexer::SEMICOLON, "Expected ';' after value.");
-    return std::make_unique<ast::Print>(std::move(expr));
+    return arena.make<ast::Print>(expr);
 }
 
-std::unique_ptr<ast::Stmt> Parser::expr_statement()
+ast::Stmt *Parser::expr_statement()
 {
-    std::unique_ptr<ast::Expr> expr = expression();
+    ast::Expr *expr = expression();
     consume(lexer::SEMICOLON, "Expected ';' after expression.");
-    return std::make_unique<ast::ExprStatement>(std::move(expr));
+    return arena.make<ast::ExprStatement>(expr);
 }
 
-std::unique_ptr<ast::Stmt> Parser::if_statement()
+ast::Stmt *Parser::if_statement()
 {
     consume(lexer::LPAREN, "Expected '(' after 'if'.");
-    std::unique_ptr<ast::Expr> condition = expression();
+    ast::Expr *condition = expression();
     consume(lexer::RPAREN, "Expected ')' after if condition.");
-    std::unique_ptr<ast::Stmt> then_branch = statement();
-    std::unique_ptr<ast::Stmt> else_branch;
+    ast::Stmt *then_branch = statement();
+    ast::Stmt *else_branch = nullptr;
     if (match({lexer::ELSE}))
     {
         else_branch = statement();
     }
-    return std::make_unique<ast::If>(std::move(condition), std::move(then_branch),
-                                     std::move(else_branch));
+    return arena.make<ast::If>(condition, then_branch, else_branch);
 }
 
-std::unique_ptr<ast::Stmt> Parser::while_statement()
+ast::Stmt *Parser::while_statement()
 {
     consume(lexer::LPAREN, "Expected '(' after 'while'.");
-    std::unique_ptr<ast::Expr> condition = expression();
+    ast::Expr *condition = expression();
     consume(lexer::RPAREN, "Expected ')' after while condition.");
-    std::unique_ptr<ast::Stmt> body = statement();
-    return std::make_unique<ast::While>(std::move(condition), std::move(body));
+    ast::Stmt *body = statement();
+    return arena.make<ast::While>(condition, body);
 }
 
-std::unique_ptr<ast::Stmt> Parser::for_statement()
+ast::Stmt *Parser::for_statement()
 {
     consume(lexer::LPAREN, "Expected '(' after 'for'.");
 
-    std::unique_ptr<ast::Stmt> initializer;
+    ast::Stmt *initializer;
     if (match({lexer::SEMICOLON}))
         initializer = nullptr;
     else if (match({lexer::VAL, lexer::VAR}))
@@ -180,186 +184,186 @@ std::unique_ptr<ast::Stmt> Parser::for_statement()
     else
         initializer = expr_statement();
 
-    std::unique_ptr<ast::Expr> condition;
+    ast::Expr *condition = nullptr;
     if (!check(lexer::SEMICOLON))
         condition = expression();
     consume(lexer::SEMICOLON, "Expected ';' after loop condition.");
 
-    std::unique_ptr<ast::Expr> increment;
+    ast::Expr *increment = nullptr;
     if (!check(lexer::RPAREN))
         increment = expression();
 
     consume(lexer::RPAREN, "Expected ')' after for clauses.");
-    std::unique_ptr<ast::Stmt> body = statement();
+    ast::Stmt *body = statement();
     if (increment)
     {
-        std::vector<std::unique_ptr<ast::Stmt>> statements;
-        statements.push_back(std::move(body));
-        statements.push_back(std::make_unique<ast::ExprStatement>(std::move(increment)));
-        body = std::make_unique<ast::Block>(std::move(statements));
+        ast::StmtList statements = arena.list<ast::Stmt *>();
+        statements.push_back(body);
+        statements.push_back(arena.make<ast::ExprStatement>(increment));
+        body = arena.make<ast::Block>(std::move(statements));
     }
 
     if (!condition)
-        condition = std::make_unique<ast::Literal>(true);
+        condition = arena.make<ast::Literal>(true);
 
-    body = std::make_unique<ast::While>(std::move(condition), std::move(body));
+    body = arena.make<ast::While>(condition, body);
     if (initializer)
     {
-        std::vector<std::unique_ptr<ast::Stmt>> statements;
-        statements.push_back(std::move(initializer));
-        statements.push_back(std::move(body));
-        body = std::make_unique<ast::Block>(std::move(statements));
+        ast::StmtList statements = arena.list<ast::Stmt *>();
+        statements.push_back(initializer);
+        statements.push_back(body);
+        body = arena.make<ast::Block>(std::move(statements));
     }
     return body;
 }
 
-std::unique_ptr<ast::Stmt> Parser::return_statement()
+ast::Stmt *Parser::return_statement()
 {
-    std::unique_ptr<ast::Expr> expr = expression();
+    ast::Expr *expr = expression();
     consume(lexer::SEMICOLON, "Expected ';' after return value.");
-    return std::make_unique<ast::Return>(std::move(expr));
+    return arena.make<ast::Return>(expr);
 }
 
-std::unique_ptr<ast::Stmt> Parser::block()
+ast::Stmt *Parser::block()
 {
-    std::vector<std::unique_ptr<ast::Stmt>> statements;
+    ast::StmtList statements = arena.list<ast::Stmt *>();
     while (!check(lexer::RBRACE) && !is_at_end())
         statements.push_back(declaration());
 
     consume(lexer::RBRACE, "Expected '}' after block.");
-    return std::make_unique<ast::Block>(std::move(statements));
+    return arena.make<ast::Block>(std::move(statements));
 }
 
-std::unique_ptr<ast::Expr> Parser::expression()
+ast::Expr *Parser::expression()
 {
     return assignment();
 }
 
-std::unique_ptr<ast::Expr> Parser::assignment()
+ast::Expr *Parser::assignment()
 {
-    std::unique_ptr<ast::Expr> expr = logic_or();
+    ast::Expr *expr = logic_or();
     if (match({lexer::EQUAL}))
     {
-        lexer::Token               equals = previous();
-        std::unique_ptr<ast::Expr> value  = assignment();
-        if (const auto *var = dynamic_cast<ast::Variable *>(expr.get()))
+        lexer::TokenIndex equals = previous();
+        ast::Expr        *value  = assignment();
+        if (const auto *var = ast::as<ast::Variable>(expr))
         {
-            lexer::Token name = var->name;
-            return std::make_unique<ast::Assignment>(name, std::move(value));
+            lexer::TokenIndex name = var->name;
+            return arena.make<ast::Assignment>(name, value);
         }
-        // TODO: one se have set/get we will add field assignment here
-        error(peek(), "Invalid assignment target.");
+        if (const auto *get = ast::as<ast::Get>(expr))
+            return arena.make<ast::Set>(get->object, get->name, value);
+        error(equals, "Invalid assignment target.");
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::logic_or()
+ast::Expr *Parser::logic_or()
 {
-    std::unique_ptr<ast::Expr> expr = logic_and();
+    ast::Expr *expr = logic_and();
     while (match({lexer::OR}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> value = logic_and();
-        expr = std::make_unique<ast::Logical>(std::move(expr), op, std::move(value));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *value = logic_and();
+        expr                    = arena.make<ast::Logical>(expr, op, value);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::logic_and()
+ast::Expr *Parser::logic_and()
 {
-    std::unique_ptr<ast::Expr> expr = equality();
+    ast::Expr *expr = equality();
     while (match({lexer::AND}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> value = equality();
-        expr = std::make_unique<ast::Logical>(std::move(expr), op, std::move(value));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *value = equality();
+        expr                    = arena.make<ast::Logical>(expr, op, value);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::equality()
+ast::Expr *Parser::equality()
 {
-    std::unique_ptr<ast::Expr> expr = comparison();
+    ast::Expr *expr = comparison();
     while (match({lexer::BANG_EQUAL, lexer::EQUALS_EQUAL}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> value = comparison();
-        expr = std::make_unique<ast::Binary>(std::move(expr), op, std::move(value));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *value = comparison();
+        expr                    = arena.make<ast::Binary>(expr, op, value);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::comparison()
+ast::Expr *Parser::comparison()
 {
-    std::unique_ptr<ast::Expr> expr = term();
+    ast::Expr *expr = term();
     while (match({lexer::GREATER, lexer::GREATER_EQUAL, lexer::LESS, lexer::LESS_EQUAL}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> value = term();
-        expr = std::make_unique<ast::Binary>(std::move(expr), op, std::move(value));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *value = term();
+        expr                    = arena.make<ast::Binary>(expr, op, value);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::term()
+ast::Expr *Parser::term()
 {
-    std::unique_ptr<ast::Expr> expr = factor();
+    ast::Expr *expr = factor();
     while (match({lexer::MINUS, lexer::PLUS}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> value = factor();
-        expr = std::make_unique<ast::Binary>(std::move(expr), op, std::move(value));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *value = factor();
+        expr                    = arena.make<ast::Binary>(expr, op, value);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::factor()
+ast::Expr *Parser::factor()
 {
-    std::unique_ptr<ast::Expr> expr = power();
+    ast::Expr *expr = power();
     while (match({lexer::SLASH, lexer::STAR, lexer::PERCENT}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> value = power();
-        expr = std::make_unique<ast::Binary>(std::move(expr), op, std::move(value));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *value = power();
+        expr                    = arena.make<ast::Binary>(expr, op, value);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::power()
+ast::Expr *Parser::power()
 {
-    std::unique_ptr<ast::Expr> expr = unary();
+    ast::Expr *expr = unary();
     // TODO: astrix should be bitwise xor, we should not have explicit power operator
     while (match({lexer::ASTRIX}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> right = unary();
-        expr = std::make_unique<ast::Binary>(std::move(expr), op, std::move(right));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *right = unary();
+        expr                    = arena.make<ast::Binary>(expr, op, right);
     }
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::unary()
+ast::Expr *Parser::unary()
 {
     if (match({lexer::MINUS, lexer::BANG}))
     {
-        lexer::Token               op    = previous();
-        std::unique_ptr<ast::Expr> right = unary();
-        return std::make_unique<ast::Unary>(op, std::move(right));
+        lexer::TokenIndex op    = previous();
+        ast::Expr        *right = unary();
+        return arena.make<ast::Unary>(op, right);
     }
     return call();
 }
 
-std::unique_ptr<ast::Expr> Parser::call()
+ast::Expr *Parser::call()
 {
-    std::unique_ptr<ast::Expr> expr = primary();
+    ast::Expr *expr = primary();
     while (true)
     {
         if (match({lexer::LPAREN}))
         {
-            std::vector<std::unique_ptr<ast::Expr>> arguments;
+            ast::ExprList arguments = arena.list<ast::Expr *>();
             if (!check(lexer::RPAREN))
             {
-                // TODO: fields access can have dot
                 do
                 {
                     if (arguments.size() > 255)
@@ -367,9 +371,13 @@ std::unique_ptr<ast::Expr> Parser::call()
                     arguments.push_back(expression());
                 } while (match({lexer::COMMA}));
             }
-            lexer::Token paren = consume(lexer::RPAREN, "Expected ')' after arguments.");
-            expr               = std::make_unique<ast::Call>(std::move(expr), std::move(paren),
-                                                             std::move(arguments));
+            lexer::TokenIndex paren = consume(lexer::RPAREN, "Expected ')' after arguments.");
+            expr = arena.make<ast::Call>(expr, paren, std::move(arguments));
+        }
+        else if (match({lexer::DOT}))
+        {
+            lexer::TokenIndex name = consume(lexer::IDENTIFIER, "Expected member name after '.'.");
+            expr                   = arena.make<ast::Get>(expr, name);
         }
         else
         {
@@ -379,23 +387,23 @@ std::unique_ptr<ast::Expr> Parser::call()
     return expr;
 }
 
-std::unique_ptr<ast::Expr> Parser::primary()
+ast::Expr *Parser::primary()
 {
     // Debug output: print current token type and value
     if (match({lexer::TRUE}))
-        return std::make_unique<ast::Literal>(true);
+        return arena.make<ast::Literal>(true);
     if (match({lexer::FALSE}))
-        return std::make_unique<ast::Literal>(false);
+        return arena.make<ast::Literal>(false);
     if (match({lexer::NUMBER, lexer::STRING}))
-        return std::make_unique<ast::Literal>(previous().literal);
+        return arena.make<ast::Literal>(tokens.literal(previous()));
     if (match({lexer::LPAREN}))
     {
-        std::unique_ptr<ast::Expr> expr = expression();
+        ast::Expr *expr = expression();
         consume(lexer::RPAREN, "Expected ')' after expression.");
-        return std::make_unique<ast::Grouping>(std::move(expr));
+        return arena.make<ast::Grouping>(expr);
     }
     if (match({lexer::IDENTIFIER}))
-        return std::make_unique<ast::Variable>(previous());
+        return arena.make<ast::Variable>(previous());
 
     error(previous(), "Invalid primary.");
     return nullptr;
@@ -407,76 +415,77 @@ bool Parser::match(const std::vector<lexer::TokenType> &types)
     {
         if (check(type))
         {
-            advance();
+            current++;
             return true;
         }
     }
     return false;
 }
 
-bool Parser::check(const lexer::TokenType type)
+bool Parser::check(const lexer::TokenType type) const
 {
     if (is_at_end())
         return false;
-    return peek().type == type;
+    return tokens.type(current) == type;
 }
 
 bool Parser::check_next(const lexer::TokenType token) const
 {
     if (is_at_end())
         return false;
-    if (tokens[current + 1].type == lexer::TokenType::END_OF_FILE)
+    if (tokens.type(current + 1) == lexer::TokenType::END_OF_FILE)
         return false;
-    return tokens[current + 1].type == token;
+    return tokens.type(current + 1) == token;
 }
 
-void Parser::error(const lexer::Token &token, const std::string &message)
+void Parser::error(const lexer::TokenIndex token, const std::string &message) const
 {
-    Compiler::error(token, message);
+    // previous() is out of range when the very first token is the offending one
+    Compiler::error(tokens.token(token < tokens.size() ? token : peek()), message);
     throw ParseError{message};
 }
 
-lexer::Token Parser::advance()
+lexer::TokenIndex Parser::advance()
 {
-    lexer::Token curr_token = peek();
-    if (!is_at_end())
-        current++;
-    return curr_token;
+    if (is_at_end())
+        return peek();
+    current++;
+    return previous();
 }
 
 bool Parser::is_at_end() const
 {
-    return tokens[current].type == lexer::TokenType::END_OF_FILE;
+    return tokens.type(current) == lexer::TokenType::END_OF_FILE;
 }
 
-lexer::Token Parser::peek()
+lexer::TokenIndex Parser::peek() const
 {
-    return tokens[current];
+    return static_cast<lexer::TokenIndex>(current);
 }
 
-lexer::Token Parser::previous()
+lexer::TokenIndex Parser::previous() const
 {
-    return tokens[current - 1];
+    return static_cast<lexer::TokenIndex>(current - 1);
 }
 
-lexer::Token Parser::consume(const lexer::TokenType type, const std::string &message)
+lexer::TokenIndex Parser::consume(const lexer::TokenType type, const std::string &message)
 {
     if (check(type))
         return advance();
 
     error(peek(), message);
-    return lexer::Token{};
+    return lexer::NO_TOKEN;
 }
 
-lexer::Token Parser::consume_any(const std::vector<lexer::TokenType> &types,
-                                 const std::string                   &message)
+lexer::TokenIndex Parser::consume_any(const std::vector<lexer::TokenType> &types,
+                                      const std::string                   &message)
 {
     for (const auto &type : types)
         if (check(type))
             return advance();
 
     error(peek(), message);
-    return lexer::Token{};
+    return lexer::NO_TOKEN;
 }
 
 void Parser::synchronize()
@@ -484,9 +493,9 @@ void Parser::synchronize()
     advance();
     while (!is_at_end())
     {
-        if (previous().type == lexer::SEMICOLON)
+        if (tokens.type(current - 1) == lexer::SEMICOLON)
             return;
-        switch (peek().type)
+        switch (tokens.type(current))
         {
         case lexer::CLASS:
         case lexer::FN:
@@ -505,4 +514,4 @@ void Parser::synchronize()
     }
 }
 
-} // namespace cool::compiler::parser
\ No newline at end of file
+} // namespace cool::compiler::parser
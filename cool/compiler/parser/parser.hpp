@@ -3,59 +3,62 @@
 #include <memory>
 #include <vector>
 
+#include "../ast/ast_arena.hpp"
 #include "../ast/expr.hpp"
 #include "../ast/stmt.hpp"
 #include "../lexer/token.hpp"
+#include "../lexer/token_stream.hpp"
 
 #include <stdexcept>
 
 namespace cool::compiler::parser {
 struct Parser
 {
-    // TODO: add a way to extend types in the language
-    std::vector<lexer::TokenType> type_tokens = {lexer::INT, lexer::FLOAT, lexer::STRING_TYPE,
-                                                 lexer::BOOL, lexer::VOID};
+    // an identifier names a class
+    std::vector<lexer::TokenType> type_tokens = {lexer::INT,  lexer::FLOAT, lexer::STRING_TYPE,
+                                                 lexer::BOOL, lexer::VOID,  lexer::IDENTIFIER};
 
-    std::vector<lexer::Token> tokens;
+    const lexer::TokenStream &tokens;
+    ast::AstArena            &arena;
     int                       current = 0;
 
-    explicit Parser(std::vector<lexer::Token> tokens);
-    std::vector<std::unique_ptr<ast::Stmt>> parse();
-    std::unique_ptr<ast::Stmt>              declaration();
-    std::unique_ptr<ast::Stmt>              var_declaration();
-    std::unique_ptr<ast::Stmt>              class_declaration();
-    std::unique_ptr<ast::Stmt>              function_declaration();
-    std::unique_ptr<ast::Stmt>              statement();
-    std::unique_ptr<ast::Stmt>              print_statement();
-    std::unique_ptr<ast::Stmt>              expr_statement();
-    std::unique_ptr<ast::Stmt>              if_statement();
-    std::unique_ptr<ast::Stmt>              while_statement();
-    std::unique_ptr<ast::Stmt>              for_statement();
-    std::unique_ptr<ast::Stmt>              return_statement();
-    std::unique_ptr<ast::Stmt>              block();
-    std::unique_ptr<ast::Expr>              expression();
-    std::unique_ptr<ast::Expr>              assignment();
-    std::unique_ptr<ast::Expr>              logic_or();
-    std::unique_ptr<ast::Expr>              logic_and();
-    std::unique_ptr<ast::Expr>              equality();
-    std::unique_ptr<ast::Expr>              comparison();
-    std::unique_ptr<ast::Expr>              term();
-    std::unique_ptr<ast::Expr>              factor();
-    std::unique_ptr<ast::Expr>              power();
-    std::unique_ptr<ast::Expr>              unary();
-    std::unique_ptr<ast::Expr>              call();
-    std::unique_ptr<ast::Expr>              primary();
-    bool                                    match(const std::vector<lexer::TokenType> &types);
-    bool                                    check(lexer::TokenType type);
-    [[nodiscard]] bool                      check_next(lexer::TokenType token) const;
-    static void        error(const lexer::Token &token, const std::string &message);
-    lexer::Token       advance();
-    [[nodiscard]] bool is_at_end() const;
-    lexer::Token       peek();
-    lexer::Token       previous();
-    lexer::Token       consume(lexer::TokenType type, const std::string &message);
-    lexer::Token       consume_any(const std::vector<lexer::TokenType> &types,
-                                   const std::string                   &message);
-    void               synchronize();
+    Parser(const lexer::TokenStream &tokens, ast::AstArena &arena);
+    ast::StmtList                  parse();
+    ast::Stmt                     *declaration();
+    ast::Stmt                     *var_declaration();
+    ast::Stmt                     *class_declaration();
+    ast::Stmt                     *function_declaration();
+    ast::Stmt                     *statement();
+    ast::Stmt                     *print_statement();
+    ast::Stmt                     *expr_statement();
+    ast::Stmt                     *if_statement();
+    ast::Stmt                     *while_statement();
+    ast::Stmt                     *for_statement();
+    ast::Stmt                     *return_statement();
+    ast::Stmt                     *block();
+    ast::Expr                     *expression();
+    ast::Expr                     *assignment();
+    ast::Expr                     *logic_or();
+    ast::Expr                     *logic_and();
+    ast::Expr                     *equality();
+    ast::Expr                     *comparison();
+    ast::Expr                     *term();
+    ast::Expr                     *factor();
+    ast::Expr                     *power();
+    ast::Expr                     *unary();
+    ast::Expr                     *call();
+    ast::Expr                     *primary();
+    bool                           match(const std::vector<lexer::TokenType> &types);
+    [[nodiscard]] bool             check(lexer::TokenType type) const;
+    [[nodiscard]] bool             check_next(lexer::TokenType token) const;
+    void                           error(lexer::TokenIndex token, const std::string &message) const;
+    lexer::TokenIndex              advance();
+    [[nodiscard]] bool             is_at_end() const;
+    [[nodiscard]] lexer::TokenIndex peek() const;
+    [[nodiscard]] lexer::TokenIndex previous() const;
+    lexer::TokenIndex              consume(lexer::TokenType type, const std::string &message);
+    lexer::TokenIndex              consume_any(const std::vector<lexer::TokenType> &types,
+                                               const std::string                   &message);
+    void                           synchronize();
 };
-} // namespace cool::compiler::parser
\ No newline at end of file
+} // namespace cool::compiler::parser
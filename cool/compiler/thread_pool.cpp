@@ -0,0 +1,105 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace cool::compiler {
+namespace {
+// the pool and deque of the worker running on this thread
+thread_local const ThreadPool *owner = nullptr;
+thread_local std::size_t       own   = 0;
+} // namespace
+
+ThreadPool::ThreadPool(const unsigned count)
+{
+    const unsigned size = std::max(count, 1U);
+    for (unsigned i = 0; i < size; ++i)
+        workers.push_back(std::make_unique<Worker>());
+    for (unsigned i = 0; i < size; ++i)
+        threads.emplace_back([this, i] { run(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        const std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Task task)
+{
+    const std::size_t index = owner == this ? own : next++ % workers.size();
+    ++pending;
+    {
+        const std::lock_guard lock{workers[index]->mutex};
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    // counted under the pool's lock, so a worker about to sleep sees it
+    {
+        const std::lock_guard lock{mutex};
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock lock{mutex};
+    done.wait(lock, [this] { return pending == 0; });
+}
+
+void ThreadPool::run(const std::size_t self)
+{
+    owner = this;
+    own   = self;
+    for (;;)
+    {
+        Task task;
+        if (take(self, task))
+        {
+            task();
+            if (--pending == 0)
+            {
+                const std::lock_guard lock{mutex};
+                done.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock lock{mutex};
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
+
+// the newest task of the worker's own deque, otherwise the oldest of the first other worker
+// that has one
+bool ThreadPool::take(const std::size_t self, Task &task)
+{
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        Worker               &worker = *workers[(self + i) % workers.size()];
+        const std::lock_guard lock{worker.mutex};
+        if (worker.tasks.empty())
+            continue;
+        if (i == 0)
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        --queued;
+        return true;
+    }
+    return false;
+}
+} // namespace cool::compiler
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cool::compiler {
+/* A work-stealing pool. Every worker has a deque of its own: a task submitted from a worker
+ * goes on that worker's deque, one submitted from outside on the next deque in turn. A worker
+ * runs its own tasks newest first and, once it has none, steals the oldest task of another,
+ * so a few large units do not leave the remaining workers idle.
+ */
+struct ThreadPool
+{
+    using Task = std::function<void()>;
+
+    struct Worker
+    {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread>             threads;
+    std::mutex                           mutex; // guards sleeping, waiting and `stopping`
+    std::condition_variable              wake;
+    std::condition_variable              done;
+    std::atomic<std::size_t>             queued{0};  // tasks on some deque
+    std::atomic<std::size_t>             pending{0}; // tasks submitted and not finished
+    std::atomic<std::size_t>             next{0};    // the deque of the next outside task
+    bool                                 stopping = false;
+
+    // at least one worker
+    explicit ThreadPool(unsigned count);
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool();
+
+    void submit(Task task);
+    void wait(); // until every submitted task has finished
+
+    void run(std::size_t self);
+    bool take(std::size_t self, Task &task);
+};
+} // namespace cool::compiler
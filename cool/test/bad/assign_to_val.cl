@@ -0,0 +1,19 @@
+val limit: int = 10;
+limit = 20;
+
+fn bump(): void {
+    val step: int = 1;
+    step = step + 1;
+}
+
+class Point {
+    val x: int = 0;
+
+    fn move(): void {
+        x = 1;
+        this.x = 2;
+    }
+}
+
+val p: Point = Point();
+p.x = 3;
@@ -0,0 +1,4 @@
+if (false) {
+    print(nope + 1);
+}
+print("unreachable");
@@ -0,0 +1,3 @@
+while (false) {
+    val q: bool = 1 + "x";
+}
@@ -0,0 +1,4 @@
+class B { var v: string = "s"; }
+val b: B = B();
+var x: int = b.v;
+print(x + 0);
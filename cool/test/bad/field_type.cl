@@ -0,0 +1,12 @@
+class A {
+    var q: int = 0;
+    var name: string = "a";
+
+    fn rename(): void {
+        name = 1;
+    }
+}
+
+val a: A = A();
+a.q = "s";
+print(a.q);
@@ -0,0 +1,20 @@
+fn f(): int {
+}
+
+fn sign(x: int): int {
+    if (x < 0) {
+        return -1;
+    } else if (x > 0) {
+        return 1;
+    }
+}
+
+class Counter {
+    var n: int = 0;
+
+    fn next(): int {
+        n = n + 1;
+    }
+}
+
+print(f());
@@ -0,0 +1,4 @@
+var i: int = 0;
+while (i < limit) {
+    i = i + 1;
+}
@@ -0,0 +1,16 @@
+class Animal {
+    fn speak(): void {
+        print("...");
+    }
+}
+
+class Dog : Animal {
+    fn fetch(): void {
+        print("fetching");
+    }
+}
+
+val d: Dog = Dog();
+d.speak();
+d.meow();
+Dog().fly();
@@ -0,0 +1,8 @@
+fn f(): int {
+    fn g(): int {
+        return later;
+    }
+    var later: int = 1;
+    return g();
+}
+print(f());
@@ -0,0 +1,45 @@
+class Animal {
+    val name: string = "";
+    var legs: int = 4;
+
+    fn init(name: string): void {
+        this.name = name;
+    }
+
+    fn describe(): string {
+        return name + " has " + "legs";
+    }
+}
+
+class Bird : Animal {
+    fn init(name: string): void {
+        this.name = name;
+        legs = 2;
+    }
+
+    fn fly(): string {
+        return name + " flies";
+    }
+}
+
+fn fly(a: Animal): string {
+    return a.fly();
+}
+
+fn first_even(from: int): int {
+    var n: int = from;
+    while (true) {
+        if (n % 2 == 0) {
+            return n;
+        }
+        n = n + 1;
+    }
+}
+
+val b: Bird = Bird("Tweety");
+print(b.describe());
+print(fly(b));
+print(b.legs);
+b.legs = 3;
+print(b.legs);
+print(first_even(7));
@@ -0,0 +1,58 @@
+fn counter(): Fn {
+    var count: int = 0;
+    fn next(): int {
+        count = count + 1;
+        return count;
+    }
+    return next;
+}
+val a: Fn = counter();
+val b: Fn = counter();
+a();
+a();
+print(a());
+print(b());
+
+fn fib(n: int): int {
+    fn go(k: int): int {
+        if (k < 2) {
+            return k;
+        }
+        return go(k - 1) + go(k - 2);
+    }
+    return go(n);
+}
+print(fib(15));
+
+fn adder(x: int): Fn {
+    fn middle(): Fn {
+        fn inner(y: int): int { return x + y; }
+        return inner;
+    }
+    return middle();
+}
+val add5: Fn = adder(5);
+print(add5(10));
+
+fn shared(): int {
+    var total: int = 1;
+    fn double(): void { total = total * 2; }
+    fn add(n: int): void { total = total + n; }
+    double();
+    add(3);
+    double();
+    return total;
+}
+print(shared());
+
+var x: int = 1;
+fn shadow(): int {
+    var x: int = 2;
+    {
+        var x: int = 3;
+        print(x);
+    }
+    return x;
+}
+print(shadow());
+print(x);
@@ -1,3 +1,3 @@
-for ( var x: int = 0; i < 10; x = x + 1 ) {
+for ( var x: int = 0; x < 10; x = x + 1 ) {
     print(x);
 }
@@ -0,0 +1,57 @@
+class Entry {
+    var key: string = "";
+    var value: int = 0;
+    var next: Entry = 0;
+}
+class Table {
+    var head: Entry = 0;
+    var size: int = 0;
+    fn put(key: string, value: int): void {
+        val entry: Entry = Entry();
+        entry.key = key;
+        entry.value = value;
+        entry.next = head;
+        head = entry;
+        size = size + 1;
+    }
+    fn sum(): int {
+        var total: int = 0;
+        var entry: Entry = head;
+        while (entry != 0) {
+            total = total + entry.value;
+            entry = entry.next;
+        }
+        return total;
+    }
+}
+fn counter(): Fn {
+    var count: int = 0;
+    fn next(): int {
+        count = count + 1;
+        return count;
+    }
+    return next;
+}
+val table: Table = Table();
+val tick: Fn = counter();
+var name: string = "k";
+var i: int = 0;
+while (i < 2000) {
+    table.put(name, i);
+    name = name + "x";
+    if (name == "kxxxxxxxxxx") {
+        name = "k";
+    }
+    tick();
+    i = i + 1;
+}
+print(table.size);
+print(table.sum());
+print(table.head.key);
+print(tick());
+var garbage: int = 0;
+while (garbage < 50000) {
+    Entry();
+    garbage = garbage + 1;
+}
+print(table.sum());
@@ -0,0 +1,27 @@
+val x: int = 100;
+class K {
+    var x: int = 5;
+    fn m(): int {
+        fn inner(): int { return x; }
+        return inner();
+    }
+    fn bump(by: int): void {
+        fn add(): void { x = x + by; }
+        add();
+        add();
+    }
+    fn twice(): int {
+        fn outer(): Fn {
+            fn deep(): int { return m() * 2; }
+            return deep;
+        }
+        val f: Fn = outer();
+        return f();
+    }
+}
+val k: K = K();
+print(k.m());
+k.bump(3);
+print(k.x);
+print(k.twice());
+print(x);
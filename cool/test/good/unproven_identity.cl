@@ -0,0 +1,9 @@
+fn three(): int {
+    return 3;
+}
+val make: Fn = three;
+var x: float = make();
+print(x * 1.0);
+print(x);
+var y: float = 3;
+print(y * 1.0);
@@ -0,0 +1,36 @@
+class Unused {
+    var label: string = "never";
+    fn describe(): string { return label + " built"; }
+}
+class Used {
+    var n: int = 4;
+    fn twice(): int { return n * 2; }
+}
+fn never(): int {
+    val u: Unused = Unused();
+    print(u.describe());
+    return 1;
+}
+fn late(x: int): int {
+    return x * x;
+}
+fn pick(flag: bool): Fn {
+    fn yes(): string { return "yes"; }
+    fn no(): string { return "no"; }
+    if (flag) {
+        return yes;
+    }
+    return no;
+}
+print(Used().twice());
+val choice: Fn = pick(true);
+print(choice());
+var i: int = 0;
+var sum: int = 0;
+while (i < 10) {
+    if (i == 9) {
+        sum = sum + late(i);
+    }
+    i = i + 1;
+}
+print(sum);
@@ -0,0 +1,103 @@
+#!/bin/sh
+# Compiles and runs the sample programs next to this script.
+#
+# Usage: run_tests.sh [--cache] [--snapshot] <coolc> <cool> [coolc option...] [-- cool option...]
+#
+# Every program under good/ must compile and print what its .out file holds. They are
+# compiled in one coolc run, on several threads. Every program under bad/ must fail to
+# compile with the diagnostics its .err file holds.
+#
+# --cache    compiles the good programs twice through one cache directory, the second run
+#            must be served from the cache without storing anything
+# --snapshot takes a snapshot of each good program after its initialization and prints the
+#            rest of its output from that snapshot
+
+cache=0
+snapshot=0
+while [ $# -gt 0 ]; do
+    case $1 in
+    --cache) cache=1 ;;
+    --snapshot) snapshot=1 ;;
+    *) break ;;
+    esac
+    shift
+done
+if [ $# -lt 2 ]; then
+    echo "Usage: run_tests.sh [--cache] [--snapshot] <coolc> <cool> [coolc option...]" \
+         "[-- cool option...]" >&2
+    exit 2
+fi
+coolc=$1
+cool=$2
+shift 2
+compile_options=
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    compile_options="$compile_options $1"
+    shift
+done
+[ $# -gt 0 ] && shift
+run_options="$*"
+
+tests=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+fail()
+{
+    echo "FAIL $1: $2"
+    failures=$((failures + 1))
+}
+
+cp "$tests"/good/*.cl "$work"
+passes=1
+[ $cache = 1 ] && passes=2 && compile_options="$compile_options --cache-dir $work/cache"
+while [ $passes -gt 0 ]; do
+    rm -f "$work"/*.coolb
+    touch "$work/compiled"
+    # shellcheck disable=SC2086
+    "$coolc" -j 4 $compile_options "$work"/*.cl 2>"$work/diagnostics" || cat "$work/diagnostics"
+    passes=$((passes - 1))
+done
+if [ $cache = 1 ]; then
+    [ -n "$(ls "$work/cache")" ] || fail cache "nothing was stored"
+    stored=$(find "$work/cache" -type f -newer "$work/compiled")
+    [ -z "$stored" ] || fail cache "the second run missed: $stored"
+fi
+
+for program in "$tests"/good/*.cl; do
+    name=$(basename "$program" .cl)
+    module=$work/$name.coolb
+    if [ ! -f "$module" ]; then
+        fail "good/$name" "does not compile"
+        continue
+    fi
+    # shellcheck disable=SC2086
+    if [ $snapshot = 1 ]; then
+        "$cool" --snapshot "$work/$name.img" "$module" >/dev/null 2>&1 &&
+            "$cool" $run_options --from-snapshot "$work/$name.img" >"$work/output" 2>&1
+    else
+        "$cool" $run_options "$module" >"$work/output" 2>&1
+    fi
+    status=$?
+    if [ $status != 0 ]; then
+        fail "good/$name" "exited with $status"
+        cat "$work/output"
+    elif ! diff -u "${program%.cl}.out" "$work/output"; then
+        fail "good/$name" "unexpected output"
+    fi
+done
+
+for program in "$tests"/bad/*.cl; do
+    [ -f "$program" ] || continue
+    name=$(basename "$program" .cl)
+    # shellcheck disable=SC2086
+    if "$coolc" $compile_options -o "$work/bad.coolb" "$program" >"$work/output" 2>&1; then
+        fail "bad/$name" "compiles"
+    elif ! diff -u "${program%.cl}.err" "$work/output"; then
+        fail "bad/$name" "unexpected diagnostics"
+    fi
+done
+
+[ $failures = 0 ] || echo "$failures failed"
+[ $failures = 0 ]
@@ -0,0 +1,162 @@
+#include "disassembler.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+namespace cool::vm::bytecode {
+namespace {
+const std::string &string_at(const Module &module, const std::uint32_t index)
+{
+    static const std::string invalid = "<invalid>";
+    return index < module.strings.size() ? module.strings[index] : invalid;
+}
+
+void print_constant(const Module &module, const Constant &constant, std::ostream &out)
+{
+    switch (constant.kind)
+    {
+    case ConstantKind::NUMBER:
+        out << constant.number;
+        if (std::isfinite(constant.number) && std::floor(constant.number) == constant.number &&
+            std::fabs(constant.number) < 1e15)
+            out << ".0";
+        break;
+    case ConstantKind::INTEGER:
+        out << constant.integer;
+        break;
+    case ConstantKind::STRING:
+        out << '"' << string_at(module, constant.index) << '"';
+        break;
+    case ConstantKind::FUNCTION:
+        out << "<fn ";
+        if (constant.index < module.functions.size())
+            out << string_at(module, module.functions[constant.index].name);
+        out << '>';
+        break;
+    case ConstantKind::CLASS:
+        out << "<class ";
+        if (constant.index < module.classes.size())
+            out << string_at(module, module.classes[constant.index].name);
+        out << '>';
+        break;
+    }
+}
+} // namespace
+
+void disassemble(const Module &module, const Function &function, std::ostream &out)
+{
+    out << "function " << string_at(module, function.name) << " (arity "
+        << static_cast<int>(function.arity) << ", registers "
+        << static_cast<int>(function.register_count) << ")\n";
+
+    for (std::uint32_t pc = 0; pc < function.code.size();)
+    {
+        const Instruction instruction = function.code[pc];
+        const Opcode      op          = op_of(instruction);
+        out << std::setw(6) << pc << std::setw(6) << function.line_at(pc) << "  ";
+        if (op >= Opcode::COUNT)
+        {
+            out << "<bad opcode " << static_cast<int>(op) << ">\n";
+            ++pc;
+            continue;
+        }
+        out << std::left << std::setw(12) << name_of(op) << std::right;
+        if (std::strlen(name_of(op)) >= 12)
+            out << ' '; // superinstruction names are longer than the column
+
+        const int a = a_of(instruction);
+        const int b = b_of(instruction);
+        switch (format_of(op))
+        {
+        case Format::NONE:
+            break;
+        case Format::A:
+            out << a;
+            break;
+        case Format::AB:
+            out << a << ' ' << b;
+            break;
+        case Format::ABC:
+            out << a << ' ' << b << ' ' << static_cast<int>(c_of(instruction));
+            if (has_constant_c(op) && c_of(instruction) < function.constants.size())
+            {
+                out << "    ; ";
+                print_constant(module, function.constants[c_of(instruction)], out);
+            }
+            break;
+        case Format::ABX:
+            out << a << ' ' << bx_of(instruction);
+            if ((first_of(op) == Opcode::LOADK || op == Opcode::CLOSURE) &&
+                bx_of(instruction) < function.constants.size())
+            {
+                out << "    ; ";
+                print_constant(module, function.constants[bx_of(instruction)], out);
+            }
+            else if (first_of(op) != Opcode::LOADK && op != Opcode::CLOSURE &&
+                     bx_of(instruction) < module.globals.size())
+            {
+                out << "    ; " << string_at(module, module.globals[bx_of(instruction)]);
+            }
+            break;
+        case Format::ASBX:
+            out << a << ' ' << sbx_of(instruction) << "    ; -> "
+                << static_cast<std::int64_t>(pc) + 1 + sbx_of(instruction);
+            break;
+        case Format::SJ:
+            out << sj_of(instruction) << "    ; -> "
+                << static_cast<std::int64_t>(pc) + 1 + sj_of(instruction);
+            break;
+        case Format::ABN:
+            out << a << ' ' << b;
+            if (pc + 1 < function.code.size() && function.code[pc + 1] < function.sites.size())
+                out << "    ; " << string_at(module, function.sites[function.code[pc + 1]]);
+            break;
+        }
+        out << '\n';
+        pc += length_of(op);
+    }
+
+    if (!function.constants.empty())
+    {
+        out << "  constants:\n";
+        for (std::size_t i = 0; i < function.constants.size(); ++i)
+        {
+            out << std::setw(6) << i << "  ";
+            print_constant(module, function.constants[i], out);
+            out << '\n';
+        }
+    }
+    if (!function.upvalues.empty())
+    {
+        out << "  upvalues:\n";
+        for (std::size_t i = 0; i < function.upvalues.size(); ++i)
+            out << std::setw(6) << i << "  "
+                << (function.upvalues[i].from_upvalue != 0 ? "upvalue " : "register ")
+                << static_cast<int>(function.upvalues[i].index) << '\n';
+    }
+}
+
+void disassemble(const Module &module, std::ostream &out)
+{
+    for (const Class &klass : module.classes)
+    {
+        out << "class " << string_at(module, klass.name);
+        if (klass.parent < module.classes.size())
+            out << " extends " << string_at(module, module.classes[klass.parent].name);
+        out << "\n  fields:";
+        for (const std::uint32_t field : klass.fields)
+            out << ' ' << string_at(module, field);
+        out << "\n  methods:";
+        for (const Method &method : klass.methods)
+            out << ' ' << string_at(module, method.name);
+        out << "\n\n";
+    }
+    for (const Function &function : module.functions)
+    {
+        disassemble(module, function, out);
+        out << '\n';
+    }
+}
+} // namespace cool::vm::bytecode
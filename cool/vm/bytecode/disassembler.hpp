@@ -0,0 +1,10 @@
+#pragma once
+
+#include "module.hpp"
+
+#include <iosfwd>
+
+namespace cool::vm::bytecode {
+void disassemble(const Module &module, std::ostream &out);
+void disassemble(const Module &module, const Function &function, std::ostream &out);
+} // namespace cool::vm::bytecode
@@ -0,0 +1,206 @@
+#include "image.hpp"
+
+#include "serializer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define COOL_HAS_MMAP 1
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "images are read in place, which needs a little-endian host"
+#endif
+
+namespace cool::vm::bytecode {
+
+std::uint32_t FunctionView::line_at(const std::uint32_t pc) const
+{
+    const auto it = std::upper_bound(lines.begin(), lines.end(), pc,
+                                     [](const std::uint32_t value, const LineEntry &entry) {
+                                         return value < entry.pc;
+                                     });
+    return it == lines.begin() ? 0 : std::prev(it)->line;
+}
+
+Image::Image(Image &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+Image &Image::operator=(Image &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+    release();
+    // the records point into `owned`, whose buffer the move hands over as it is
+    data      = std::exchange(other.data, nullptr);
+    size      = std::exchange(other.size, 0);
+    mapped    = std::exchange(other.mapped, false);
+    owned     = std::move(other.owned);
+    entry     = other.entry;
+    strings   = std::exchange(other.strings, {});
+    globals   = std::exchange(other.globals, {});
+    classes   = std::exchange(other.classes, {});
+    functions = std::exchange(other.functions, {});
+    return *this;
+}
+
+Image::~Image()
+{
+    release();
+}
+
+void Image::release()
+{
+#ifdef COOL_HAS_MMAP
+    if (mapped && data != nullptr)
+        munmap(const_cast<std::uint8_t *>(data), size);
+#endif
+    data   = nullptr;
+    size   = 0;
+    mapped = false;
+    owned.clear();
+}
+
+std::optional<Image> Image::open(const std::string &path, std::string &error,
+                                 const std::uint64_t offset)
+{
+#ifdef COOL_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "cannot open " + path;
+        return std::nullopt;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) <= offset)
+    {
+        // mmap cannot map an empty file, which is no image either
+        ::close(fd);
+        error = "not a cool bytecode file";
+        return std::nullopt;
+    }
+
+    const auto size = static_cast<std::size_t>(static_cast<std::uint64_t>(st.st_size) - offset);
+    void      *addr = MAP_FAILED;
+    if (offset % static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) == 0)
+        addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+    ::close(fd);
+    if (addr != MAP_FAILED)
+    {
+        Image image;
+        image.data   = static_cast<const std::uint8_t *>(addr);
+        image.size   = size;
+        image.mapped = true;
+        if (!image.parse(error))
+            return std::nullopt;
+        return image;
+    }
+#endif
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !in.seekg(static_cast<std::streamoff>(offset)))
+    {
+        error = "cannot open " + path;
+        return std::nullopt;
+    }
+    const std::string bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    return load(bytes, error);
+}
+
+std::optional<Image> Image::load(const std::string_view bytes, std::string &error)
+{
+    Image image;
+    image.owned.resize((bytes.size() + 7) / 8);
+    std::copy(bytes.begin(), bytes.end(), reinterpret_cast<char *>(image.owned.data()));
+    image.data = reinterpret_cast<const std::uint8_t *>(image.owned.data());
+    image.size = bytes.size();
+    if (!image.parse(error))
+        return std::nullopt;
+    return image;
+}
+
+bool Image::parse(std::string &error)
+{
+    if (size < sizeof(Header) || std::memcmp(data, MAGIC, sizeof MAGIC) != 0)
+    {
+        error = "not a cool bytecode file";
+        return false;
+    }
+    const auto *header = reinterpret_cast<const Header *>(data);
+    if (header->version != VERSION)
+    {
+        error = "unsupported bytecode version " + std::to_string(header->version);
+        return false;
+    }
+    if (!span(header->strings, strings) || !span(header->globals, globals) ||
+        !span(header->classes, classes) || !span(header->functions, functions))
+    {
+        error = "truncated bytecode file";
+        return false;
+    }
+
+    // the only function the VM runs before anything has checked a call to it
+    entry = header->entry;
+    if (entry >= functions.size() || functions[entry].is_method != 0 ||
+        functions[entry].arity != 0 || functions[entry].upvalues.count != 0)
+    {
+        error = "invalid entry function";
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool Image::span(const Range range, Span<T> &out) const
+{
+    if (range.offset % alignof(T) != 0 || range.offset > size ||
+        (size - range.offset) / sizeof(T) < range.count)
+        return false;
+    out = {reinterpret_cast<const T *>(data + range.offset), range.count};
+    return true;
+}
+
+bool Image::string(const std::uint32_t index, std::string_view &out) const
+{
+    Span<char> bytes;
+    if (index >= strings.size() || !span(strings[index], bytes))
+        return false;
+    out = {bytes.data(), bytes.size()};
+    return true;
+}
+
+bool Image::function(const std::uint32_t index, FunctionView &out) const
+{
+    if (index >= functions.size())
+        return false;
+    const FunctionRecord &record = functions[index];
+    out.name                     = record.name;
+    out.arity                    = record.arity;
+    out.register_count           = record.register_count;
+    out.is_method                = record.is_method != 0;
+    return span(record.code, out.code) && span(record.constants, out.constants) &&
+           span(record.lines, out.lines) && span(record.sites, out.sites) &&
+           span(record.upvalues, out.upvalues);
+}
+
+bool Image::klass(const std::uint32_t index, ClassView &out) const
+{
+    if (index >= classes.size())
+        return false;
+    const ClassRecord &record = classes[index];
+    out.name                  = record.name;
+    out.parent                = record.parent;
+    out.initializer           = record.initializer;
+    return span(record.fields, out.fields) && span(record.methods, out.methods);
+}
+} // namespace cool::vm::bytecode
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "module.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cool::vm::bytecode {
+// a run of records inside an image
+template <typename T>
+struct Span
+{
+    const T      *items = nullptr;
+    std::uint32_t count = 0;
+
+    [[nodiscard]] const T      *data() const { return items; }
+    [[nodiscard]] std::uint32_t size() const { return count; }
+    [[nodiscard]] bool          empty() const { return count == 0; }
+    [[nodiscard]] const T      *begin() const { return items; }
+    [[nodiscard]] const T      *end() const { return items + count; }
+    const T                    &operator[](const std::size_t index) const { return items[index]; }
+};
+
+/* The records of a `.coolb` file exactly as they are laid out in it, see
+ * docs/bytecode_specification.md. Offsets count from the start of the file.
+ */
+struct Range
+{
+    std::uint32_t offset;
+    std::uint32_t count;
+};
+
+struct ConstantRecord
+{
+    ConstantKind  kind;
+    std::uint8_t  reserved[3];
+    std::uint32_t index; // into the string, function or class table
+    std::uint64_t bits;  // the f64 of a NUMBER, the i64 of an INTEGER
+
+    [[nodiscard]] double number() const
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    [[nodiscard]] std::int64_t integer() const { return static_cast<std::int64_t>(bits); }
+};
+
+struct ClassRecord
+{
+    std::uint32_t name;
+    std::uint32_t parent;
+    std::uint32_t initializer;
+    Range         fields;  // u32 string indices
+    Range         methods; // Method
+};
+
+struct FunctionRecord
+{
+    std::uint32_t name;
+    std::uint8_t  arity;
+    std::uint8_t  register_count;
+    std::uint8_t  is_method;
+    std::uint8_t  reserved;
+    Range         code;      // Instruction
+    Range         constants; // ConstantRecord
+    Range         lines;     // LineEntry
+    Range         sites;     // u32 string indices
+    Range         upvalues;  // Upvalue
+};
+
+struct Header
+{
+    char          magic[4];
+    std::uint16_t version;
+    std::uint16_t reserved;
+    std::uint32_t entry;
+    Range         strings;   // Range, the bytes of each string
+    Range         globals;   // u32 string indices
+    Range         classes;   // ClassRecord
+    Range         functions; // FunctionRecord
+};
+
+static_assert(sizeof(ConstantRecord) == 16 && sizeof(ClassRecord) == 28 &&
+                      sizeof(FunctionRecord) == 48 && sizeof(Header) == 44 &&
+                      sizeof(Method) == 8 && sizeof(LineEntry) == 8 && sizeof(Upvalue) == 4,
+              "the records must have the layout of the file");
+
+// a function as the VM runs it, its arrays point into the image
+struct FunctionView
+{
+    std::uint32_t        name           = NO_INDEX;
+    std::uint8_t         arity          = 0;
+    std::uint8_t         register_count = 0;
+    bool                 is_method      = false;
+    Span<Instruction>    code;
+    Span<ConstantRecord> constants;
+    Span<LineEntry>      lines;
+    Span<std::uint32_t>  sites;
+    Span<Upvalue>        upvalues;
+
+    [[nodiscard]] std::uint32_t line_at(std::uint32_t pc) const;
+};
+
+struct ClassView
+{
+    std::uint32_t       name        = NO_INDEX;
+    std::uint32_t       parent      = NO_INDEX;
+    std::uint32_t       initializer = NO_INDEX;
+    Span<std::uint32_t> fields;
+    Span<Method>        methods;
+};
+
+/* A `.coolb` file as the VM uses it. The file is mapped read-only where the platform allows
+ * it, so code, constant pools and strings are used in place and every process running the
+ * same file shares its pages. Opening only checks the header and that the four tables lie
+ * inside the file; the arrays a record points to are checked when it is viewed, which the
+ * VM does for a function on its first call and for a class when it is first used.
+ *
+ * The records are read as they are, so the VM needs a little-endian host, like the file.
+ */
+struct Image
+{
+    const std::uint8_t        *data   = nullptr;
+    std::size_t                size   = 0;
+    bool                       mapped = false;
+    std::vector<std::uint64_t> owned; // the bytes when not mapped, 8-aligned for the records
+    std::uint32_t              entry  = 0;
+    Span<Range>                strings;
+    Span<std::uint32_t>        globals;
+    Span<ClassRecord>          classes;
+    Span<FunctionRecord>       functions;
+
+    Image() = default;
+    Image(const Image &)            = delete;
+    Image &operator=(const Image &) = delete;
+    Image(Image &&other) noexcept;
+    Image &operator=(Image &&other) noexcept;
+    ~Image();
+
+    // the image starts `offset` bytes into the file, which is mapped if that is page aligned
+    static std::optional<Image> open(const std::string &path, std::string &error,
+                                     std::uint64_t offset = 0);
+    static std::optional<Image> load(std::string_view bytes, std::string &error);
+
+    // false when the record's arrays do not lie inside the image
+    [[nodiscard]] bool string(std::uint32_t index, std::string_view &out) const;
+    [[nodiscard]] bool function(std::uint32_t index, FunctionView &out) const;
+    [[nodiscard]] bool klass(std::uint32_t index, ClassView &out) const;
+
+private:
+    bool parse(std::string &error);
+    void release();
+    template <typename T>
+    bool span(Range range, Span<T> &out) const;
+};
+} // namespace cool::vm::bytecode
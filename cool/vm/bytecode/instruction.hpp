@@ -0,0 +1,73 @@
+#pragma once
+
+#include "opcode.hpp"
+
+#include <cstdint>
+
+namespace cool::vm::bytecode {
+using Instruction = std::uint32_t;
+
+inline constexpr int SBX_MAX = INT16_MAX;
+inline constexpr int SJ_MAX  = (1 << 23) - 1;
+
+constexpr Instruction encode(const Opcode op, const std::uint8_t a = 0, const std::uint8_t b = 0,
+                             const std::uint8_t c = 0)
+{
+    return static_cast<Instruction>(op) | static_cast<Instruction>(a) << 8 |
+           static_cast<Instruction>(b) << 16 | static_cast<Instruction>(c) << 24;
+}
+
+constexpr Instruction encode_bx(const Opcode op, const std::uint8_t a, const std::uint16_t bx)
+{
+    return static_cast<Instruction>(op) | static_cast<Instruction>(a) << 8 |
+           static_cast<Instruction>(bx) << 16;
+}
+
+constexpr Instruction encode_sbx(const Opcode op, const std::uint8_t a, const std::int16_t sbx)
+{
+    return encode_bx(op, a, static_cast<std::uint16_t>(sbx));
+}
+
+constexpr Instruction encode_sj(const Opcode op, const std::int32_t sj)
+{
+    return static_cast<Instruction>(op) | static_cast<Instruction>(sj) << 8;
+}
+
+constexpr Opcode op_of(const Instruction i)
+{
+    return static_cast<Opcode>(i & 0xFF);
+}
+
+constexpr std::uint8_t a_of(const Instruction i)
+{
+    return static_cast<std::uint8_t>(i >> 8);
+}
+
+constexpr std::uint8_t b_of(const Instruction i)
+{
+    return static_cast<std::uint8_t>(i >> 16);
+}
+
+constexpr std::uint8_t c_of(const Instruction i)
+{
+    return static_cast<std::uint8_t>(i >> 24);
+}
+
+constexpr std::uint16_t bx_of(const Instruction i)
+{
+    return static_cast<std::uint16_t>(i >> 16);
+}
+
+constexpr std::int16_t sbx_of(const Instruction i)
+{
+    return static_cast<std::int16_t>(i >> 16);
+}
+
+constexpr std::int32_t sj_of(const Instruction i)
+{
+    return static_cast<std::int32_t>(i) >> 8;
+}
+
+static_assert(sj_of(encode_sj(Opcode::JMP, -5)) == -5);
+static_assert(sbx_of(encode_sbx(Opcode::JMPIF, 3, -7)) == -7);
+} // namespace cool::vm::bytecode
@@ -0,0 +1,14 @@
+#include "module.hpp"
+
+#include <algorithm>
+
+namespace cool::vm::bytecode {
+std::uint32_t Function::line_at(const std::uint32_t pc) const
+{
+    const auto it = std::upper_bound(lines.begin(), lines.end(), pc,
+                                     [](const std::uint32_t value, const LineEntry &entry) {
+                                         return value < entry.pc;
+                                     });
+    return it == lines.begin() ? 0 : std::prev(it)->line;
+}
+} // namespace cool::vm::bytecode
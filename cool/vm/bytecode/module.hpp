@@ -0,0 +1,93 @@
+#pragma once
+
+#include "instruction.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cool::vm::bytecode {
+inline constexpr std::uint32_t NO_INDEX = UINT32_MAX;
+
+enum class ConstantKind : std::uint8_t { NUMBER, STRING, FUNCTION, CLASS, INTEGER };
+
+/* A constant pool entry. Floats (NUMBER) and 64-bit integers are stored inline, strings,
+ * functions and classes refer to the module tables by index.
+ */
+struct Constant
+{
+    ConstantKind  kind;
+    double        number  = 0;
+    std::uint32_t index   = 0;
+    std::int64_t  integer = 0;
+
+    bool operator==(const Constant &other) const
+    {
+        return kind == other.kind && index == other.index && integer == other.integer &&
+               (kind != ConstantKind::NUMBER || number == other.number);
+    }
+};
+
+// the source line of every instruction from `pc` up to the next entry
+struct LineEntry
+{
+    std::uint32_t pc;
+    std::uint32_t line;
+};
+
+/* What a closure captures when CLOSURE creates it in the function enclosing it: register
+ * `index` of that function, or entry `index` of the upvalues of that function's own closure.
+ */
+struct Upvalue
+{
+    std::uint8_t from_upvalue;
+    std::uint8_t index;
+    std::uint8_t reserved[2];
+};
+
+/* `sites` names the member of every INVOKE, GETFIELD and SETFIELD in `code`, whose second
+ * word indexes it. Each site gets its own inline cache in the VM. A function with
+ * `upvalues` is only ever called as a closure.
+ */
+struct Function
+{
+    std::uint32_t              name           = NO_INDEX;
+    std::uint8_t               arity          = 0;
+    std::uint8_t               register_count = 0;
+    bool                       is_method      = false;
+    std::vector<Instruction>   code;
+    std::vector<Constant>      constants;
+    std::vector<LineEntry>     lines;
+    std::vector<std::uint32_t> sites; // string index of each site's member name
+    std::vector<Upvalue>       upvalues;
+
+    [[nodiscard]] std::uint32_t line_at(std::uint32_t pc) const;
+};
+
+struct Method
+{
+    std::uint32_t name;
+    std::uint32_t function;
+};
+
+/* Fields and methods only list what the class itself declares, the VM merges them with
+ * the parent chain. `initializer` runs the field initializers on a new instance.
+ */
+struct Class
+{
+    std::uint32_t              name;
+    std::uint32_t              parent      = NO_INDEX;
+    std::uint32_t              initializer = NO_INDEX;
+    std::vector<std::uint32_t> fields;
+    std::vector<Method>        methods;
+};
+
+struct Module
+{
+    std::vector<std::string>   strings;
+    std::vector<std::uint32_t> globals;
+    std::vector<Class>         classes;
+    std::vector<Function>      functions;
+    std::uint32_t              entry = 0;
+};
+} // namespace cool::vm::bytecode
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cool::vm::bytecode {
+/* Operand layouts of a 32-bit instruction word, op is always the low byte.
+ *   A      op | A
+ *   AB     op | A | B
+ *   ABC    op | A | B | C
+ *   ABX    op | A | Bx (16 bit unsigned)
+ *   ASBX   op | A | sBx (16 bit signed)
+ *   SJ     op | sJ (24 bit signed)
+ *   ABN    op | A | B, followed by a second word holding a member site index (see Function)
+ */
+enum class Format : std::uint8_t { NONE, A, AB, ABC, ABX, ASBX, SJ, ABN };
+
+// clang-format off
+#define COOL_OPCODES(X)     \
+    X(NOP,       NONE)      \
+    X(MOVE,      AB)        \
+    X(LOADK,     ABX)       \
+    X(LOADNIL,   A)         \
+    X(LOADBOOL,  AB)        \
+    X(GETGLOBAL, ABX)       \
+    X(SETGLOBAL, ABX)       \
+    X(ADD,       ABC)       \
+    X(SUB,       ABC)       \
+    X(MUL,       ABC)       \
+    X(DIV,       ABC)       \
+    X(MOD,       ABC)       \
+    X(POW,       ABC)       \
+    X(EQ,        ABC)       \
+    X(NE,        ABC)       \
+    X(LT,        ABC)       \
+    X(LE,        ABC)       \
+    X(ADDK,      ABC)       \
+    X(SUBK,      ABC)       \
+    X(MULK,      ABC)       \
+    X(DIVK,      ABC)       \
+    X(MODK,      ABC)       \
+    X(EQK,       ABC)       \
+    X(NEK,       ABC)       \
+    X(LTK,       ABC)       \
+    X(LEK,       ABC)       \
+    X(GTK,       ABC)       \
+    X(GEK,       ABC)       \
+    X(ADD_I64,   ABC)       \
+    X(SUB_I64,   ABC)       \
+    X(MUL_I64,   ABC)       \
+    X(DIV_I64,   ABC)       \
+    X(MOD_I64,   ABC)       \
+    X(LT_I64,    ABC)       \
+    X(LE_I64,    ABC)       \
+    X(ADDK_I64,  ABC)       \
+    X(SUBK_I64,  ABC)       \
+    X(MULK_I64,  ABC)       \
+    X(DIVK_I64,  ABC)       \
+    X(MODK_I64,  ABC)       \
+    X(LTK_I64,   ABC)       \
+    X(LEK_I64,   ABC)       \
+    X(GTK_I64,   ABC)       \
+    X(GEK_I64,   ABC)       \
+    X(ADD_F64,   ABC)       \
+    X(SUB_F64,   ABC)       \
+    X(MUL_F64,   ABC)       \
+    X(DIV_F64,   ABC)       \
+    X(LT_F64,    ABC)       \
+    X(LE_F64,    ABC)       \
+    X(ADDK_F64,  ABC)       \
+    X(SUBK_F64,  ABC)       \
+    X(MULK_F64,  ABC)       \
+    X(DIVK_F64,  ABC)       \
+    X(LTK_F64,   ABC)       \
+    X(LEK_F64,   ABC)       \
+    X(GTK_F64,   ABC)       \
+    X(GEK_F64,   ABC)       \
+    X(CONCAT_STR,  ABC)     \
+    X(CONCATK_STR, ABC)     \
+    X(NEG,       AB)        \
+    X(NOT,       AB)        \
+    X(JMP,       SJ)        \
+    X(JMPIF,     ASBX)      \
+    X(JMPIFNOT,  ASBX)      \
+    X(CALL,      AB)        \
+    X(INVOKE,    ABN)       \
+    X(GETFIELD,  ABN)       \
+    X(SETFIELD,  ABN)       \
+    X(GETSLOT,   ABC)       \
+    X(SETSLOT,   ABC)       \
+    X(CLOSURE,   ABX)       \
+    X(GETUPVAL,  AB)        \
+    X(BOX,       A)         \
+    X(GETBOX,    AB)        \
+    X(SETBOX,    AB)        \
+    X(RETURN,    AB)        \
+    X(PRINT,     A)
+
+/* Superinstructions, picked from the pairs executed most in the benchmark programs. The
+ * compiler puts one in place of the opcode of the first instruction of a pair and leaves
+ * the second word as it was, so no code moves and a jump may still land on the second
+ * instruction. The handler executes both and skips the second. A fused opcode has the
+ * operand format of the first opcode and must be followed by the second.
+ */
+#define COOL_FUSED_OPCODES(X)                         \
+    X(LT_I64_JMPIF,        ABC, LT_I64,    JMPIF)     \
+    X(LT_I64_JMPIFNOT,     ABC, LT_I64,    JMPIFNOT)  \
+    X(LE_I64_JMPIF,        ABC, LE_I64,    JMPIF)     \
+    X(LE_I64_JMPIFNOT,     ABC, LE_I64,    JMPIFNOT)  \
+    X(LTK_I64_JMPIF,       ABC, LTK_I64,   JMPIF)     \
+    X(LTK_I64_JMPIFNOT,    ABC, LTK_I64,   JMPIFNOT)  \
+    X(LEK_I64_JMPIF,       ABC, LEK_I64,   JMPIF)     \
+    X(LEK_I64_JMPIFNOT,    ABC, LEK_I64,   JMPIFNOT)  \
+    X(GTK_I64_JMPIF,       ABC, GTK_I64,   JMPIF)     \
+    X(GTK_I64_JMPIFNOT,    ABC, GTK_I64,   JMPIFNOT)  \
+    X(GEK_I64_JMPIF,       ABC, GEK_I64,   JMPIF)     \
+    X(GEK_I64_JMPIFNOT,    ABC, GEK_I64,   JMPIFNOT)  \
+    X(EQK_JMPIF,           ABC, EQK,       JMPIF)     \
+    X(EQK_JMPIFNOT,        ABC, EQK,       JMPIFNOT)  \
+    X(NEK_JMPIF,           ABC, NEK,       JMPIF)     \
+    X(NEK_JMPIFNOT,        ABC, NEK,       JMPIFNOT)  \
+    X(GETGLOBAL_ADDK_I64,  ABX, GETGLOBAL, ADDK_I64)  \
+    X(SETGLOBAL_GETGLOBAL, ABX, SETGLOBAL, GETGLOBAL) \
+    X(GETSLOT_ADD,         ABC, GETSLOT,   ADD)       \
+    X(LOADK_SETSLOT,       ABX, LOADK,     SETSLOT)
+// clang-format on
+
+enum class Opcode : std::uint8_t {
+#define COOL_OPCODE_ENUM(name, format) name,
+#define COOL_FUSED_ENUM(name, format, first, second) name,
+    COOL_OPCODES(COOL_OPCODE_ENUM)
+    COOL_FUSED_OPCODES(COOL_FUSED_ENUM)
+#undef COOL_OPCODE_ENUM
+#undef COOL_FUSED_ENUM
+            COUNT
+};
+
+inline constexpr Opcode FIRST_FUSED = Opcode::LT_I64_JMPIF;
+
+inline constexpr Format formats[] = {
+#define COOL_OPCODE_FORMAT(name, format) Format::format,
+#define COOL_FUSED_FORMAT(name, format, first, second) Format::format,
+        COOL_OPCODES(COOL_OPCODE_FORMAT)
+        COOL_FUSED_OPCODES(COOL_FUSED_FORMAT)
+#undef COOL_OPCODE_FORMAT
+#undef COOL_FUSED_FORMAT
+};
+
+inline constexpr const char *names[] = {
+#define COOL_OPCODE_NAME(name, format) #name,
+#define COOL_FUSED_NAME(name, format, first, second) #name,
+        COOL_OPCODES(COOL_OPCODE_NAME)
+        COOL_FUSED_OPCODES(COOL_FUSED_NAME)
+#undef COOL_OPCODE_NAME
+#undef COOL_FUSED_NAME
+};
+
+// the pair each fused opcode stands for, indexed from FIRST_FUSED
+inline constexpr Opcode fused_pairs[][2] = {
+#define COOL_FUSED_PAIR(name, format, first, second) {Opcode::first, Opcode::second},
+        COOL_FUSED_OPCODES(COOL_FUSED_PAIR)
+#undef COOL_FUSED_PAIR
+};
+
+constexpr Format format_of(const Opcode op)
+{
+    return formats[static_cast<std::uint8_t>(op)];
+}
+
+constexpr const char *name_of(const Opcode op)
+{
+    return names[static_cast<std::uint8_t>(op)];
+}
+
+constexpr bool is_fused(const Opcode op)
+{
+    return op >= FIRST_FUSED && op < Opcode::COUNT;
+}
+
+// the opcode whose operands a (possibly fused) opcode has
+constexpr Opcode first_of(const Opcode op)
+{
+    return is_fused(op) ? fused_pairs[static_cast<int>(op) - static_cast<int>(FIRST_FUSED)][0]
+                        : op;
+}
+
+// the opcode that must follow a fused one
+constexpr Opcode second_of(const Opcode op)
+{
+    return fused_pairs[static_cast<int>(op) - static_cast<int>(FIRST_FUSED)][1];
+}
+
+// the superinstruction for `first` followed by `second`, NOP when there is none
+constexpr Opcode fuse(const Opcode first, const Opcode second)
+{
+    for (int i = static_cast<int>(FIRST_FUSED); i < static_cast<int>(Opcode::COUNT); ++i)
+    {
+        const auto op = static_cast<Opcode>(i);
+        if (first_of(op) == first && second_of(op) == second)
+            return op;
+    }
+    return Opcode::NOP;
+}
+
+// the *K arithmetic and comparison forms take a constant index in C instead of a register
+constexpr bool has_constant_c(const Opcode op)
+{
+    const Opcode first = first_of(op);
+    return (first >= Opcode::ADDK && first <= Opcode::GEK) ||
+           (first >= Opcode::ADDK_I64 && first <= Opcode::GEK_I64) ||
+           (first >= Opcode::ADDK_F64 && first <= Opcode::GEK_F64) ||
+           first == Opcode::CONCATK_STR;
+}
+
+// number of 32-bit words the instruction occupies
+constexpr unsigned length_of(const Opcode op)
+{
+    return format_of(op) == Format::ABN ? 2 : 1;
+}
+
+static_assert(first_of(Opcode::GETSLOT_ADD) == Opcode::GETSLOT);
+static_assert(fuse(Opcode::LTK_I64, Opcode::JMPIF) == Opcode::LTK_I64_JMPIF);
+static_assert(static_cast<int>(Opcode::COUNT) <= 256);
+} // namespace cool::vm::bytecode
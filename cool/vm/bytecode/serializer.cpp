@@ -0,0 +1,245 @@
+#include "serializer.hpp"
+
+#include "image.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+namespace cool::vm::bytecode {
+namespace {
+/* Builds the image in memory: the tables are written first with their records zeroed, and
+ * every record is filled in once the arrays it points to have been placed after them.
+ * The bytes are stored little-endian one at a time, so any host writes the same file.
+ */
+struct Writer
+{
+    std::string out;
+
+    [[nodiscard]] std::uint32_t here() const
+    {
+        return static_cast<std::uint32_t>(out.size());
+    }
+
+    void align(const std::size_t alignment)
+    {
+        out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+    }
+
+    // `size` zeroed bytes, aligned to `alignment`, returns where they start
+    std::uint32_t reserve(const std::size_t size, const std::size_t alignment)
+    {
+        align(alignment);
+        const std::uint32_t start = here();
+        out.resize(out.size() + size, '\0');
+        return start;
+    }
+
+    void put(const std::uint32_t position, std::uint64_t value, const int bytes)
+    {
+        for (int i = 0; i < bytes; ++i, value >>= 8)
+            out[position + i] = static_cast<char>(value & 0xff);
+    }
+
+    void range(const std::uint32_t position, const std::uint32_t offset, const std::size_t count)
+    {
+        put(position, offset, 4);
+        put(position + 4, count, 4);
+    }
+
+    // the elements as consecutive `bytes`-wide integers, returns where they start
+    template <typename T, typename Field>
+    std::uint32_t array(const std::vector<T> &items, const int bytes, const std::size_t alignment,
+                        Field field)
+    {
+        const std::uint32_t start = reserve(items.size() * bytes, alignment);
+        for (std::size_t i = 0; i < items.size(); ++i)
+            put(static_cast<std::uint32_t>(start + i * bytes), field(items[i]), bytes);
+        return start;
+    }
+};
+
+constexpr auto identity = [](const std::uint32_t value) { return std::uint64_t{value}; };
+} // namespace
+
+bool write_module(const Module &module, std::ostream &out)
+{
+    Writer writer;
+    writer.reserve(sizeof(Header), 8);
+    std::memcpy(writer.out.data(), MAGIC, sizeof MAGIC);
+    writer.put(4, VERSION, 2);
+    writer.put(8, module.entry, 4);
+
+    const std::uint32_t strings = writer.reserve(module.strings.size() * sizeof(Range), 4);
+    const std::uint32_t globals = writer.array(module.globals, 4, 4, identity);
+    const std::uint32_t classes = writer.reserve(module.classes.size() * sizeof(ClassRecord), 4);
+    const std::uint32_t functions =
+            writer.reserve(module.functions.size() * sizeof(FunctionRecord), 4);
+    writer.range(12, strings, module.strings.size());
+    writer.range(20, globals, module.globals.size());
+    writer.range(28, classes, module.classes.size());
+    writer.range(36, functions, module.functions.size());
+
+    for (std::size_t i = 0; i < module.classes.size(); ++i)
+    {
+        const Class        &klass  = module.classes[i];
+        const std::uint32_t record = classes + static_cast<std::uint32_t>(i * sizeof(ClassRecord));
+        writer.put(record, klass.name, 4);
+        writer.put(record + 4, klass.parent, 4);
+        writer.put(record + 8, klass.initializer, 4);
+        writer.range(record + 12, writer.array(klass.fields, 4, 4, identity), klass.fields.size());
+        std::uint32_t at = writer.reserve(klass.methods.size() * sizeof(Method), 4);
+        writer.range(record + 20, at, klass.methods.size());
+        for (const Method &method : klass.methods)
+        {
+            writer.put(at, method.name, 4);
+            writer.put(at + 4, method.function, 4);
+            at += sizeof(Method);
+        }
+    }
+
+    // everything a function needs lies together, so running it touches few pages
+    for (std::size_t i = 0; i < module.functions.size(); ++i)
+    {
+        const Function     &function = module.functions[i];
+        const std::uint32_t record =
+                functions + static_cast<std::uint32_t>(i * sizeof(FunctionRecord));
+        writer.put(record, function.name, 4);
+        writer.put(record + 4, function.arity, 1);
+        writer.put(record + 5, function.register_count, 1);
+        writer.put(record + 6, function.is_method ? 1 : 0, 1);
+        writer.range(record + 8, writer.array(function.code, 4, 4, identity),
+                     function.code.size());
+
+        std::uint32_t at = writer.reserve(function.constants.size() * sizeof(ConstantRecord), 8);
+        writer.range(record + 16, at, function.constants.size());
+        for (const Constant &constant : function.constants)
+        {
+            std::uint64_t bits = 0;
+            if (constant.kind == ConstantKind::NUMBER)
+                std::memcpy(&bits, &constant.number, sizeof bits);
+            else if (constant.kind == ConstantKind::INTEGER)
+                bits = static_cast<std::uint64_t>(constant.integer);
+            writer.put(at, static_cast<std::uint8_t>(constant.kind), 1);
+            writer.put(at + 4, constant.index, 4);
+            writer.put(at + 8, bits, 8);
+            at += sizeof(ConstantRecord);
+        }
+
+        at = writer.reserve(function.lines.size() * sizeof(LineEntry), 4);
+        writer.range(record + 24, at, function.lines.size());
+        for (const LineEntry &entry : function.lines)
+        {
+            writer.put(at, entry.pc, 4);
+            writer.put(at + 4, entry.line, 4);
+            at += sizeof(LineEntry);
+        }
+        writer.range(record + 32, writer.array(function.sites, 4, 4, identity),
+                     function.sites.size());
+        writer.range(record + 40,
+                     writer.array(function.upvalues, 4, 4,
+                                  [](const Upvalue &upvalue) {
+                                      return std::uint64_t{upvalue.from_upvalue} |
+                                             std::uint64_t{upvalue.index} << 8;
+                                  }),
+                     function.upvalues.size());
+    }
+
+    for (std::size_t i = 0; i < module.strings.size(); ++i)
+    {
+        writer.range(strings + static_cast<std::uint32_t>(i * sizeof(Range)), writer.here(),
+                     module.strings[i].size());
+        writer.out += module.strings[i];
+    }
+
+    out.write(writer.out.data(), static_cast<std::streamsize>(writer.out.size()));
+    return static_cast<bool>(out);
+}
+
+bool write_module(const Module &module, const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary);
+    return out && write_module(module, out);
+}
+
+// copies every record of the image out, checking each one like the VM does on first use
+std::optional<Module> read_module(std::istream &in, std::string &error)
+{
+    const std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    const std::optional<Image> image = Image::load(data, error);
+    if (!image)
+        return std::nullopt;
+
+    Module module;
+    module.entry = image->entry;
+    bool ok      = true;
+
+    module.strings.resize(image->strings.size());
+    for (std::uint32_t i = 0; i < image->strings.size(); ++i)
+    {
+        std::string_view string;
+        ok                = image->string(i, string) && ok;
+        module.strings[i] = std::string{string};
+    }
+    module.globals.assign(image->globals.begin(), image->globals.end());
+
+    module.classes.resize(image->classes.size());
+    for (std::uint32_t i = 0; i < image->classes.size(); ++i)
+    {
+        ClassView view;
+        ok                = image->klass(i, view) && ok;
+        Class &klass      = module.classes[i];
+        klass.name        = view.name;
+        klass.parent      = view.parent;
+        klass.initializer = view.initializer;
+        klass.fields.assign(view.fields.begin(), view.fields.end());
+        klass.methods.assign(view.methods.begin(), view.methods.end());
+    }
+
+    module.functions.resize(image->functions.size());
+    for (std::uint32_t i = 0; i < image->functions.size(); ++i)
+    {
+        FunctionView view;
+        ok                      = image->function(i, view) && ok;
+        Function &function      = module.functions[i];
+        function.name           = view.name;
+        function.arity          = view.arity;
+        function.register_count = view.register_count;
+        function.is_method      = view.is_method;
+        function.code.assign(view.code.begin(), view.code.end());
+        for (const ConstantRecord &record : view.constants)
+        {
+            Constant &constant = function.constants.emplace_back();
+            constant.kind      = record.kind;
+            if (record.kind == ConstantKind::NUMBER)
+                constant.number = record.number();
+            else if (record.kind == ConstantKind::INTEGER)
+                constant.integer = record.integer();
+            else
+                constant.index = record.index;
+        }
+        function.lines.assign(view.lines.begin(), view.lines.end());
+        function.sites.assign(view.sites.begin(), view.sites.end());
+        function.upvalues.assign(view.upvalues.begin(), view.upvalues.end());
+    }
+
+    if (!ok)
+    {
+        error = "truncated bytecode file";
+        return std::nullopt;
+    }
+    return module;
+}
+
+std::optional<Module> read_module(const std::string &path, std::string &error)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        error = "cannot open " + path;
+        return std::nullopt;
+    }
+    return read_module(in, error);
+}
+} // namespace cool::vm::bytecode
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "module.hpp"
+
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+namespace cool::vm::bytecode {
+/* `.coolb` files, see docs/bytecode_specification.md for the layout. All integers are
+ * little-endian regardless of the host. The VM runs a file in place (Image), read_module
+ * copies one back into a Module.
+ */
+inline constexpr char          MAGIC[4] = {'C', 'O', 'O', 'L'};
+inline constexpr std::uint16_t VERSION  = 6;
+
+bool                  write_module(const Module &module, std::ostream &out);
+bool                  write_module(const Module &module, const std::string &path);
+std::optional<Module> read_module(std::istream &in, std::string &error);
+std::optional<Module> read_module(const std::string &path, std::string &error);
+} // namespace cool::vm::bytecode
@@ -0,0 +1,284 @@
+#include "verifier.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace cool::vm::bytecode {
+namespace {
+struct Verifier
+{
+    const Image &image;
+    std::string &error;
+
+    bool fail(const std::string &message)
+    {
+        error = message;
+        return false;
+    }
+
+    bool fail(const FunctionView &function, const std::uint32_t pc, const std::string &message)
+    {
+        std::string_view name = "<invalid>";
+        static_cast<void>(image.string(function.name, name));
+        return fail("function " + std::string{name} + ", pc " + std::to_string(pc) + ": " +
+                    message);
+    }
+
+    [[nodiscard]] bool valid_string(const std::uint32_t index) const
+    {
+        std::string_view string;
+        return image.string(index, string);
+    }
+
+    // a function of the right kind whose name can be printed
+    [[nodiscard]] bool valid_function(const std::uint32_t index, const bool method) const
+    {
+        return index < image.functions.size() &&
+               (image.functions[index].is_method != 0) == method &&
+               valid_string(image.functions[index].name);
+    }
+
+    [[nodiscard]] bool verify_constant(const ConstantRecord &constant) const
+    {
+        switch (constant.kind)
+        {
+        case ConstantKind::NUMBER:
+        case ConstantKind::INTEGER:
+            return true;
+        case ConstantKind::STRING:
+            return valid_string(constant.index);
+        case ConstantKind::FUNCTION:
+            return valid_function(constant.index, false);
+        case ConstantKind::CLASS:
+            return constant.index < image.classes.size();
+        }
+        return false;
+    }
+
+    // whether a closure of function `index` created in `function` captures what is there
+    [[nodiscard]] bool valid_captures(const FunctionView &function, const std::uint32_t index) const
+    {
+        FunctionView closure;
+        if (!image.function(index, closure))
+            return false;
+        for (const Upvalue &upvalue : closure.upvalues)
+            if (upvalue.index >= (upvalue.from_upvalue != 0 ? function.upvalues.size()
+                                                            : function.register_count))
+                return false;
+        return true;
+    }
+
+    bool verify_function(const std::uint32_t index)
+    {
+        FunctionView function;
+        if (!image.function(index, function))
+            return fail("function " + std::to_string(index) + " out of range");
+        const unsigned registers = function.register_count;
+        if (!valid_string(function.name))
+            return fail("function name out of range");
+        if (registers == 0 || function.arity + (function.is_method ? 1u : 0u) > registers)
+            return fail(function, 0, "parameters do not fit the register window");
+        for (const ConstantRecord &constant : function.constants)
+            if (!verify_constant(constant))
+                return fail(function, 0, "constant out of range");
+        for (const std::uint32_t name : function.sites)
+            if (!valid_string(name))
+                return fail(function, 0, "member name out of range");
+        // GETUPVAL reads the closure from the callee slot, which a method has no claim to
+        if (function.is_method && !function.upvalues.empty())
+            return fail(function, 0, "method with upvalues");
+
+        // instruction boundaries, the site word of a two word instruction is not one
+        const Span<Instruction> code = function.code;
+        std::vector<bool>       starts(code.size(), false);
+        for (std::uint32_t pc = 0; pc < code.size(); pc += length_of(op_of(code[pc])))
+        {
+            if (op_of(code[pc]) >= Opcode::COUNT)
+                return fail(function, pc, "invalid opcode");
+            starts[pc] = true;
+        }
+        if (code.empty())
+            return fail(function, 0, "empty function");
+
+        for (std::uint32_t pc = 0; pc < code.size(); pc += length_of(op_of(code[pc])))
+        {
+            const Instruction instruction = code[pc];
+            const Opcode      op          = first_of(op_of(instruction));
+            const unsigned    a           = a_of(instruction);
+            const unsigned    b           = b_of(instruction);
+            const unsigned    c           = c_of(instruction);
+            const auto        next        = static_cast<std::int64_t>(pc) + 1;
+
+            // the second half of a superinstruction is checked as the instruction it is
+            if (is_fused(op_of(instruction)) &&
+                (pc + 1 >= code.size() || op_of(code[pc + 1]) != second_of(op_of(instruction))))
+                return fail(function, pc, "superinstruction without its second instruction");
+
+            bool        valid  = true;
+            std::int64_t target = -1;
+            switch (op)
+            {
+            case Opcode::NOP:
+                break;
+            case Opcode::MOVE:
+            case Opcode::NEG:
+            case Opcode::NOT:
+            case Opcode::GETBOX:
+            case Opcode::SETBOX:
+                valid = a < registers && b < registers;
+                break;
+            case Opcode::LOADK:
+                // a function with upvalues only exists as a closure
+                valid = a < registers && bx_of(instruction) < function.constants.size() &&
+                        (function.constants[bx_of(instruction)].kind != ConstantKind::FUNCTION ||
+                         image.functions[function.constants[bx_of(instruction)].index]
+                                         .upvalues.count == 0);
+                break;
+            case Opcode::CLOSURE:
+                valid = a < registers && bx_of(instruction) < function.constants.size() &&
+                        function.constants[bx_of(instruction)].kind == ConstantKind::FUNCTION &&
+                        valid_captures(function,
+                                       function.constants[bx_of(instruction)].index);
+                break;
+            case Opcode::GETUPVAL:
+                valid = a < registers && b < function.upvalues.size();
+                break;
+            case Opcode::LOADNIL:
+            case Opcode::LOADBOOL:
+            case Opcode::BOX:
+            case Opcode::RETURN:
+            case Opcode::PRINT:
+                valid = a < registers;
+                break;
+            case Opcode::GETGLOBAL:
+            case Opcode::SETGLOBAL:
+                valid = a < registers && bx_of(instruction) < image.globals.size();
+                break;
+            case Opcode::JMP:
+                target = next + sj_of(instruction);
+                break;
+            case Opcode::JMPIF:
+            case Opcode::JMPIFNOT:
+                valid  = a < registers;
+                target = next + sbx_of(instruction);
+                break;
+            case Opcode::CALL:
+                valid = a + b < registers;
+                break;
+            case Opcode::INVOKE:
+            case Opcode::GETFIELD:
+            case Opcode::SETFIELD:
+                if (pc + 1 >= code.size() || code[pc + 1] >= function.sites.size())
+                    return fail(function, pc, "member site out of range");
+                valid = op == Opcode::INVOKE ? a + b < registers : a < registers && b < registers;
+                break;
+            case Opcode::GETSLOT:
+            case Opcode::SETSLOT:
+                // C is a field slot, the VM checks it against the instance
+                valid = a < registers && b < registers;
+                break;
+            case Opcode::ADDK_F64:
+            case Opcode::SUBK_F64:
+            case Opcode::MULK_F64:
+            case Opcode::DIVK_F64:
+            case Opcode::LTK_F64:
+            case Opcode::LEK_F64:
+            case Opcode::GTK_F64:
+            case Opcode::GEK_F64:
+            case Opcode::CONCATK_STR:
+            {
+                // the typed forms read their constant without looking at its type
+                const ConstantKind kind =
+                        op == Opcode::CONCATK_STR ? ConstantKind::STRING : ConstantKind::NUMBER;
+                valid = a < registers && b < registers && c < function.constants.size() &&
+                        function.constants[c].kind == kind;
+                break;
+            }
+            default:
+                valid = a < registers && b < registers &&
+                        (has_constant_c(op) ? c < function.constants.size() : c < registers);
+                break;
+            }
+            if (!valid)
+                return fail(function, pc, std::string("operand out of range for ") + name_of(op));
+            if (target != -1 && (target < 0 || target >= static_cast<std::int64_t>(code.size()) ||
+                                 !starts[target]))
+                return fail(function, pc, "jump target out of range");
+        }
+
+        // the last instruction must leave the function or loop back
+        std::uint32_t last = 0;
+        for (std::uint32_t pc = 0; pc < code.size(); pc += length_of(op_of(code[pc])))
+            last = pc;
+        const Opcode op = op_of(code[last]);
+        if (op != Opcode::RETURN && op != Opcode::JMP)
+            return fail(function, last, "code falls off the end of the function");
+        return true;
+    }
+
+    bool verify_class(const std::uint32_t index)
+    {
+        ClassView klass;
+        if (!image.klass(index, klass))
+            return fail("class " + std::to_string(index) + " out of range");
+        if (!valid_string(klass.name))
+            return fail("class name out of range");
+        if (klass.parent != NO_INDEX && klass.parent >= image.classes.size())
+            return fail("parent class out of range");
+        if (klass.initializer != NO_INDEX && !valid_function(klass.initializer, true))
+            return fail("class initializer out of range");
+        for (const std::uint32_t field : klass.fields)
+            if (!valid_string(field))
+                return fail("field name out of range");
+        for (const Method &method : klass.methods)
+            if (!valid_string(method.name) || !valid_function(method.function, true))
+                return fail("method out of range");
+
+        // the ancestors are checked when they are used, but the chain has to end
+        std::size_t depth = 0;
+        for (std::uint32_t parent = klass.parent; parent != NO_INDEX;
+             parent           = image.classes[parent].parent)
+        {
+            if (parent >= image.classes.size())
+                return fail("parent class out of range");
+            if (++depth > image.classes.size())
+                return fail("cyclic class hierarchy");
+        }
+        return true;
+    }
+};
+} // namespace
+
+bool verify_function(const Image &image, const std::uint32_t index, std::string &error)
+{
+    return Verifier{image, error}.verify_function(index);
+}
+
+bool verify_class(const Image &image, const std::uint32_t index, std::string &error)
+{
+    return Verifier{image, error}.verify_class(index);
+}
+
+bool verify(const Image &image, std::string &error)
+{
+    Verifier verifier{image, error};
+    for (const std::uint32_t name : image.globals)
+        if (!verifier.valid_string(name))
+            return verifier.fail("global name out of range");
+    for (std::uint32_t i = 0; i < image.classes.size(); ++i)
+        if (!verifier.verify_class(i))
+            return false;
+    for (std::uint32_t i = 0; i < image.functions.size(); ++i)
+        if (!verifier.verify_function(i))
+            return false;
+    return true;
+}
+
+bool is_instruction_start(const FunctionView &function, const std::uint32_t pc)
+{
+    std::uint32_t at = 0;
+    while (at < pc && at < function.code.size())
+        at += length_of(op_of(function.code[at]));
+    return at == pc && pc < function.code.size();
+}
+} // namespace cool::vm::bytecode
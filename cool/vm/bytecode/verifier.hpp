@@ -0,0 +1,24 @@
+#pragma once
+
+#include "image.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace cool::vm::bytecode {
+/* Checks that an image is well formed before any of it runs: every register operand lies
+ * inside the function's register window, every constant, global, string, function, class
+ * and upvalue index is in range, a function with upvalues is only ever made into a closure,
+ * jumps land on an instruction boundary and code cannot fall off the end of a function.
+ * The interpreter relies on this and does no bounds checks of its own.
+ *
+ * The VM checks a function before its first call and a class (with its parents) before its
+ * first use, so a run only pays for the code it reaches. verify checks the whole image.
+ */
+bool verify_function(const Image &image, std::uint32_t index, std::string &error);
+bool verify_class(const Image &image, std::uint32_t index, std::string &error);
+bool verify(const Image &image, std::string &error);
+
+// whether `pc` is the first word of an instruction of a verified function
+bool is_instruction_start(const FunctionView &function, std::uint32_t pc);
+} // namespace cool::vm::bytecode
@@ -0,0 +1,1252 @@
+#include "interpreter.hpp"
+
+#include "bytecode/verifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace cool::vm::interpreter {
+using bytecode::Opcode;
+using runtime::Value;
+
+namespace {
+template <typename T>
+inline bool compare(const Operator op, const T x, const T y)
+{
+    switch (op)
+    {
+    case Operator::LT:
+        return x < y;
+    case Operator::LE:
+        return x <= y;
+    case Operator::GT:
+        return x > y;
+    case Operator::GE:
+        return x >= y;
+    default:
+        return false;
+    }
+}
+
+inline Value float_operation(const Operator op, const double x, const double y)
+{
+    switch (op)
+    {
+    case Operator::ADD:
+        return Value::float_value(x + y);
+    case Operator::SUB:
+        return Value::float_value(x - y);
+    case Operator::MUL:
+        return Value::float_value(x * y);
+    case Operator::DIV:
+        return Value::float_value(x / y);
+    case Operator::MOD:
+        return Value::float_value(std::fmod(x, y));
+    case Operator::POW:
+        return Value::float_value(std::pow(x, y));
+    default:
+        return Value::boolean_value(compare(op, x, y));
+    }
+}
+
+bool store_integer(const std::int64_t value, Value &result)
+{
+    if (!Value::fits_int(value))
+        return false;
+    result = Value::int_value(value);
+    return true;
+}
+
+// the payload of an inline integer scaled by 2^16, so 64-bit overflow is 48-bit overflow
+constexpr std::int64_t scaled(const Value value)
+{
+    return static_cast<std::int64_t>(value.bits << 16);
+}
+
+constexpr Value from_scaled(const std::int64_t value)
+{
+    return Value::from_bits(Value::INT_TAG | static_cast<std::uint64_t>(value) >> 16);
+}
+
+// both operands inline integers and an inline result, otherwise the slow path takes over
+template <Operator OP>
+inline bool fast_integer(const Value lhs, const Value rhs, Value &result)
+{
+    if (!lhs.is_int() || !rhs.is_int())
+        return false;
+    const std::int64_t x = scaled(lhs);
+    const std::int64_t y = scaled(rhs);
+    std::int64_t       r;
+    if constexpr (OP == Operator::ADD)
+    {
+        if (__builtin_add_overflow(x, y, &r))
+            return false;
+    }
+    else if constexpr (OP == Operator::SUB)
+    {
+        if (__builtin_sub_overflow(x, y, &r))
+            return false;
+    }
+    else if constexpr (OP == Operator::MUL)
+    {
+        if (__builtin_mul_overflow(x, rhs.as_int(), &r))
+            return false;
+    }
+    else if constexpr (OP == Operator::DIV)
+        return y != 0 && store_integer(lhs.as_int() / rhs.as_int(), result);
+    else if constexpr (OP == Operator::MOD)
+        return y != 0 && store_integer(lhs.as_int() % rhs.as_int(), result);
+    else if constexpr (OP == Operator::POW)
+        return false;
+    else
+    {
+        result = Value::boolean_value(compare(OP, x, y));
+        return true;
+    }
+    result = from_scaled(r);
+    return true;
+}
+
+template <Operator OP>
+inline bool fast_number(const Value lhs, const Value rhs, Value &result)
+{
+    if (fast_integer<OP>(lhs, rhs, result))
+        return true;
+    if (!lhs.is_float() || !rhs.is_float())
+        return false;
+    result = float_operation(OP, lhs.as_float(), rhs.as_float());
+    return true;
+}
+} // namespace
+
+Interpreter::Interpreter(const bytecode::Image &image, std::ostream &out)
+    : image{image}, out{out}
+{
+    heap.roots = [this] { trace_roots(); };
+    strings.resize(image.strings.size());
+    functions.resize(image.functions.size());
+    views.resize(image.functions.size());
+    classes.resize(image.classes.size());
+    constants.resize(image.functions.size());
+    caches.resize(image.functions.size());
+    jit.profiles.resize(image.functions.size());
+    globals.resize(image.globals.size());
+    stack.resize(STACK_SIZE);
+    frames.reserve(MAX_FRAMES);
+}
+
+// verifies the function and builds what its frames point to
+bool Interpreter::link_function(const std::uint32_t index)
+{
+    std::string error;
+    if (!bytecode::verify_function(image, index, error))
+    {
+        runtime_error("invalid module: " + error);
+        return false;
+    }
+    bytecode::FunctionView function;
+    static_cast<void>(image.function(index, function));
+
+    std::vector<Value> pool;
+    pool.reserve(function.constants.size());
+    for (const bytecode::ConstantRecord &constant : function.constants)
+    {
+        runtime::Object *object = nullptr;
+        switch (constant.kind)
+        {
+        case bytecode::ConstantKind::NUMBER:
+            pool.push_back(Value::float_value(constant.number()));
+            continue;
+        case bytecode::ConstantKind::INTEGER:
+            if (Value::fits_int(constant.integer()))
+            {
+                pool.push_back(Value::int_value(constant.integer()));
+                continue;
+            }
+            object = heap.make_tenured<runtime::IntegerObject>(constant.integer());
+            break;
+        case bytecode::ConstantKind::STRING:
+            object = string_object(constant.index);
+            break;
+        case bytecode::ConstantKind::FUNCTION:
+            object = function_object(constant.index);
+            break;
+        case bytecode::ConstantKind::CLASS:
+            object = class_object(constant.index);
+            break;
+        }
+        if (object == nullptr)
+            return false;
+        pool.push_back(Value::object_value(object));
+    }
+    constants[index] = std::move(pool);
+
+    std::vector<runtime::InlineCache> &sites = caches[index];
+    sites.reserve(function.sites.size());
+    for (const std::uint32_t name : function.sites)
+        sites.emplace_back(name);
+
+    // published last, an empty `code` is what marks the function as not linked yet
+    views[index] = function;
+    return true;
+}
+
+// the function is not linked, only its name and arity are needed before its first call
+runtime::FunctionObject *Interpreter::function_object(const std::uint32_t index)
+{
+    if (functions[index] != nullptr)
+        return functions[index];
+    const bytecode::FunctionRecord &record = image.functions[index];
+    bytecode::FunctionView         &view   = views[index];
+    view.name                              = record.name;
+    view.arity                             = record.arity;
+    view.register_count                    = record.register_count;
+    view.is_method                         = record.is_method != 0;
+    // CLOSURE reads the upvalue descriptors, which the verifier checked, before any call
+    bytecode::FunctionView linked;
+    if (image.function(index, linked))
+        view.upvalues = linked.upvalues;
+    functions[index] = heap.make_tenured<runtime::FunctionObject>(&view, name(record.name));
+    return functions[index];
+}
+
+runtime::StringObject *Interpreter::string_object(const std::uint32_t index)
+{
+    if (strings[index] == nullptr)
+        strings[index] = intern(name(index));
+    return strings[index];
+}
+
+runtime::StringObject *Interpreter::intern(const std::string_view value)
+{
+    const std::size_t hash = runtime::hash_string(value);
+    if (runtime::StringObject *string = interned.find(value, hash))
+        return string;
+    auto *string      = heap.make_tenured<runtime::StringObject>(std::string{value});
+    string->hash_code = hash;
+    string->hashed    = true;
+    interned.add(string);
+    return string;
+}
+
+// verifies the class and lays it out after its parent
+runtime::ClassObject *Interpreter::class_object(const std::uint32_t index)
+{
+    if (classes[index] != nullptr)
+        return classes[index];
+    std::string error;
+    if (!bytecode::verify_class(image, index, error))
+    {
+        runtime_error("invalid module: " + error);
+        return nullptr;
+    }
+    bytecode::ClassView source;
+    static_cast<void>(image.klass(index, source));
+
+    // the parent chain is verified to end, so this recursion does too
+    runtime::ClassObject *parent = nullptr;
+    if (source.parent != bytecode::NO_INDEX && (parent = class_object(source.parent)) == nullptr)
+        return nullptr;
+
+    auto *klass = heap.make_tenured<runtime::ClassObject>(name(source.name));
+    if (parent != nullptr)
+    {
+        klass->parent       = parent;
+        klass->fields       = parent->fields;
+        klass->field_slots  = parent->field_slots;
+        klass->vtable       = parent->vtable;
+        klass->method_slots = parent->method_slots;
+    }
+    if (source.initializer != bytecode::NO_INDEX)
+        klass->initializer = function_object(source.initializer);
+
+    // new members are appended, a redeclared field or overridden method keeps its slot
+    for (const std::uint32_t field : source.fields)
+    {
+        const auto slot = static_cast<std::uint32_t>(klass->fields.size());
+        if (klass->field_slots.emplace(field, slot).second)
+            klass->fields.push_back(field);
+    }
+    for (const bytecode::Method &method : source.methods)
+    {
+        // the string table holds every name once, so the first `init` seen is the only one
+        if (init_name == bytecode::NO_INDEX && name(method.name) == "init")
+            init_name = method.name;
+        const auto slot          = static_cast<std::uint32_t>(klass->vtable.size());
+        const auto [it, created] = klass->method_slots.emplace(method.name, slot);
+        if (created)
+            klass->vtable.push_back(function_object(method.function));
+        else
+            klass->vtable[it->second] = function_object(method.function);
+    }
+
+    const auto init = klass->method_slots.find(init_name);
+    klass->init     = init == klass->method_slots.end() ? nullptr : klass->vtable[init->second];
+    classes[index]  = klass;
+    return klass;
+}
+
+InterpretResult Interpreter::run(const Dispatch dispatch)
+{
+    this->dispatch = dispatch;
+    frames.clear();
+    if (!push_frame(function_object(image.entry), stack.data(), &result, false))
+        return InterpretResult::RUNTIME_ERROR;
+    return resume();
+}
+
+// continues the frames a paused run or a restored snapshot left, if the program has any left
+InterpretResult Interpreter::resume()
+{
+    const InterpretResult status = frames.empty() ? InterpretResult::OK : execute_nested(0);
+    out.flush();
+    return status;
+}
+
+InterpretResult Interpreter::execute_nested(const std::size_t exit_depth)
+{
+    return dispatch == Dispatch::THREADED ? execute<Dispatch::THREADED>(exit_depth)
+                                          : execute<Dispatch::SWITCH>(exit_depth);
+}
+
+/* Every handler ends in NEXT(). In threaded mode it fetches the next instruction and jumps
+ * straight to its handler, in switch mode it continues the loop and the `switch` dispatches.
+ * Handlers are labelled both ways, so one body serves both modes.
+ */
+#if COOL_HAS_COMPUTED_GOTO
+#define CASE(name) case Opcode::name: op_##name:
+#define NEXT()                                                                                 \
+    if constexpr (D == Dispatch::THREADED)                                                     \
+    {                                                                                          \
+        instruction = *ip++;                                                                   \
+        goto *labels[instruction & 0xFF];                                                      \
+    }                                                                                          \
+    else                                                                                       \
+        continue
+#else
+#define CASE(name) case Opcode::name:
+#define NEXT() continue
+#endif
+
+#define RA base[bytecode::a_of(instruction)]
+#define RB base[bytecode::b_of(instruction)]
+#define RC base[bytecode::c_of(instruction)]
+#define KC k[bytecode::c_of(instruction)]
+
+#define LOAD_FRAME()                                                                           \
+    frame = &frames.back();                                                                    \
+    ip    = frame->ip;                                                                         \
+    base  = frame->base;                                                                       \
+    k     = frame->constants
+
+// native code runs from the frame's pc (see jit::Jit) once its function is compiled
+#define ENTER_NATIVE()                                                                         \
+    if (frame->profile->code != nullptr)                                                       \
+    ip = enter_native(*frame, ip)
+
+/* A jump back is a loop iteration, which counts towards compiling the function. Once it is
+ * compiled the loop continues in native code (on-stack replacement): native code works on
+ * the interpreter's frame, so the jump target is all it needs.
+ */
+#define BACK_EDGE(offset)                                                                      \
+    if ((offset) < 0)                                                                          \
+    {                                                                                          \
+        jit.count(*this, *frame->profile);                                                     \
+        if (frame->profile->code != nullptr)                                                   \
+        {                                                                                      \
+            ++jit.loop_entries;                                                                \
+            ip = enter_native(*frame, ip);                                                     \
+        }                                                                                      \
+    }
+
+#define FAIL(message)                                                                          \
+    do                                                                                         \
+    {                                                                                          \
+        frame->ip = ip;                                                                        \
+        runtime_error(message);                                                                \
+        return InterpretResult::RUNTIME_ERROR;                                                 \
+    } while (0)
+
+/* Arithmetic and comparisons try an inline fast path first (`fast_number` for the generic
+ * opcodes, `fast_integer` for the *_I64 ones the compiler emits when both operands are
+ * typed int) and fall back to `binary`, which handles mixed and boxed operands, string
+ * concatenation and errors.
+ */
+#define BINARY_BODY(rhs, fast, operation)                                                      \
+    {                                                                                          \
+        const Value lhs_ = RB;                                                                 \
+        const Value rhs_ = rhs;                                                                \
+        if (!fast<operation>(lhs_, rhs_, RA))                                                  \
+        {                                                                                      \
+            frame->ip = ip;                                                                    \
+            if (!binary(operation, lhs_, rhs_, RA))                                            \
+                return InterpretResult::RUNTIME_ERROR;                                         \
+        }                                                                                      \
+    }
+
+#define BINARY(name, rhs, fast, operation)                                                     \
+    CASE(name)                                                                                 \
+    BINARY_BODY(rhs, fast, operation)                                                          \
+    NEXT();
+
+/* The *_F64 forms are only emitted where the type checker proved both operands floats, so
+ * they skip the tags. Any bits read as a double still give a valid value, a hand-written
+ * module misusing one computes nonsense but nothing unsafe.
+ */
+#define FLOAT_BINARY(name, rhs, operation)                                                     \
+    CASE(name)                                                                                 \
+    RA = float_operation(operation, RB.as_float(), (rhs).as_float());                          \
+    NEXT();
+
+// the same goes for CONCAT_STR, except strings are pointers, so it keeps one check
+#define CONCAT_BODY(rhs)                                                                       \
+    {                                                                                          \
+        const Value lhs_ = RB;                                                                 \
+        const Value rhs_ = rhs;                                                                \
+        if (runtime::as<runtime::StringObject>(lhs_) == nullptr ||                             \
+            runtime::as<runtime::StringObject>(rhs_) == nullptr)                               \
+            FAIL("Operands must be two numbers or two strings.");                              \
+        frame->ip = ip;                                                                        \
+        RA        = concatenate(lhs_, rhs_);                                                   \
+    }
+
+// the compiler only emits these on `this` with a slot of the method's own class
+#define GETSLOT_BODY()                                                                         \
+    {                                                                                          \
+        const auto   *instance = runtime::as<runtime::InstanceObject>(RB);                     \
+        const unsigned slot     = bytecode::c_of(instruction);                                 \
+        if (instance == nullptr || slot >= instance->field_count)                              \
+            FAIL("Invalid field slot.");                                                       \
+        RA = instance->fields()[slot];                                                         \
+    }
+
+#define SETSLOT_BODY()                                                                         \
+    {                                                                                          \
+        auto          *instance = runtime::as<runtime::InstanceObject>(RA);                    \
+        const unsigned slot     = bytecode::c_of(instruction);                                 \
+        if (instance == nullptr || slot >= instance->field_count)                              \
+            FAIL("Invalid field slot.");                                                       \
+        Value &field = instance->fields()[slot];                                               \
+        heap.write_barrier(instance, field, RB);                                               \
+        field = RB;                                                                            \
+    }
+
+/* A superinstruction runs the handler of its first opcode, then decodes the word after it,
+ * which holds the second instruction unchanged, and runs that one without a dispatch.
+ */
+#define SECOND() instruction = *ip++
+
+#define COMPARE_JUMP(name, compare, taken)                                                     \
+    CASE(name)                                                                                 \
+    compare;                                                                                   \
+    SECOND();                                                                                  \
+    if (RA.truthy() == (taken))                                                                \
+    {                                                                                          \
+        ip += bytecode::sbx_of(instruction);                                                   \
+        BACK_EDGE(bytecode::sbx_of(instruction));                                              \
+    }                                                                                          \
+    NEXT();
+
+template <Dispatch D>
+InterpretResult Interpreter::execute(const std::size_t exit_depth)
+{
+#if COOL_HAS_COMPUTED_GOTO
+    static const void *const labels[] = {
+#define COOL_OPCODE_LABEL(name, format) &&op_##name,
+#define COOL_FUSED_LABEL(name, format, first, second) &&op_##name,
+            COOL_OPCODES(COOL_OPCODE_LABEL)
+            COOL_FUSED_OPCODES(COOL_FUSED_LABEL)
+#undef COOL_OPCODE_LABEL
+#undef COOL_FUSED_LABEL
+    };
+#endif
+
+    CallFrame                   *frame;
+    const bytecode::Instruction *ip;
+    Value                       *base;
+    const Value                 *k;
+    bytecode::Instruction        instruction;
+    LOAD_FRAME();
+    ENTER_NATIVE();
+
+    for (;;)
+    {
+        instruction = *ip++;
+        switch (bytecode::op_of(instruction))
+        {
+        CASE(NOP)
+        NEXT();
+
+        CASE(MOVE)
+        RA = RB;
+        NEXT();
+
+        CASE(LOADK)
+        RA = k[bytecode::bx_of(instruction)];
+        NEXT();
+
+        CASE(LOADNIL)
+        RA = Value::nil();
+        NEXT();
+
+        CASE(LOADBOOL)
+        RA = Value::boolean_value(bytecode::b_of(instruction) != 0);
+        NEXT();
+
+        CASE(GETGLOBAL)
+        RA = globals[bytecode::bx_of(instruction)];
+        NEXT();
+
+        CASE(SETGLOBAL)
+        globals[bytecode::bx_of(instruction)] = RA;
+        NEXT();
+
+        BINARY(ADD, RC, fast_number, Operator::ADD)
+        BINARY(SUB, RC, fast_number, Operator::SUB)
+        BINARY(MUL, RC, fast_number, Operator::MUL)
+        BINARY(DIV, RC, fast_number, Operator::DIV)
+        BINARY(MOD, RC, fast_number, Operator::MOD)
+        BINARY(POW, RC, fast_number, Operator::POW)
+
+        CASE(EQ)
+        RA = Value::boolean_value(equal(RB, RC));
+        NEXT();
+
+        CASE(NE)
+        RA = Value::boolean_value(!equal(RB, RC));
+        NEXT();
+
+        BINARY(LT, RC, fast_number, Operator::LT)
+        BINARY(LE, RC, fast_number, Operator::LE)
+
+        BINARY(ADDK, KC, fast_number, Operator::ADD)
+        BINARY(SUBK, KC, fast_number, Operator::SUB)
+        BINARY(MULK, KC, fast_number, Operator::MUL)
+        BINARY(DIVK, KC, fast_number, Operator::DIV)
+        BINARY(MODK, KC, fast_number, Operator::MOD)
+
+        CASE(EQK)
+        RA = Value::boolean_value(equal(RB, KC));
+        NEXT();
+
+        CASE(NEK)
+        RA = Value::boolean_value(!equal(RB, KC));
+        NEXT();
+
+        BINARY(LTK, KC, fast_number, Operator::LT)
+        BINARY(LEK, KC, fast_number, Operator::LE)
+        BINARY(GTK, KC, fast_number, Operator::GT)
+        BINARY(GEK, KC, fast_number, Operator::GE)
+
+        BINARY(ADD_I64, RC, fast_integer, Operator::ADD)
+        BINARY(SUB_I64, RC, fast_integer, Operator::SUB)
+        BINARY(MUL_I64, RC, fast_integer, Operator::MUL)
+        BINARY(DIV_I64, RC, fast_integer, Operator::DIV)
+        BINARY(MOD_I64, RC, fast_integer, Operator::MOD)
+        BINARY(LT_I64, RC, fast_integer, Operator::LT)
+        BINARY(LE_I64, RC, fast_integer, Operator::LE)
+
+        BINARY(ADDK_I64, KC, fast_integer, Operator::ADD)
+        BINARY(SUBK_I64, KC, fast_integer, Operator::SUB)
+        BINARY(MULK_I64, KC, fast_integer, Operator::MUL)
+        BINARY(DIVK_I64, KC, fast_integer, Operator::DIV)
+        BINARY(MODK_I64, KC, fast_integer, Operator::MOD)
+        BINARY(LTK_I64, KC, fast_integer, Operator::LT)
+        BINARY(LEK_I64, KC, fast_integer, Operator::LE)
+        BINARY(GTK_I64, KC, fast_integer, Operator::GT)
+        BINARY(GEK_I64, KC, fast_integer, Operator::GE)
+
+        FLOAT_BINARY(ADD_F64, RC, Operator::ADD)
+        FLOAT_BINARY(SUB_F64, RC, Operator::SUB)
+        FLOAT_BINARY(MUL_F64, RC, Operator::MUL)
+        FLOAT_BINARY(DIV_F64, RC, Operator::DIV)
+        FLOAT_BINARY(LT_F64, RC, Operator::LT)
+        FLOAT_BINARY(LE_F64, RC, Operator::LE)
+
+        FLOAT_BINARY(ADDK_F64, KC, Operator::ADD)
+        FLOAT_BINARY(SUBK_F64, KC, Operator::SUB)
+        FLOAT_BINARY(MULK_F64, KC, Operator::MUL)
+        FLOAT_BINARY(DIVK_F64, KC, Operator::DIV)
+        FLOAT_BINARY(LTK_F64, KC, Operator::LT)
+        FLOAT_BINARY(LEK_F64, KC, Operator::LE)
+        FLOAT_BINARY(GTK_F64, KC, Operator::GT)
+        FLOAT_BINARY(GEK_F64, KC, Operator::GE)
+
+        CASE(CONCAT_STR)
+        CONCAT_BODY(RC)
+        NEXT();
+
+        CASE(CONCATK_STR)
+        CONCAT_BODY(KC)
+        NEXT();
+
+        CASE(NEG)
+        {
+            const Value value = RB;
+            if (value.is_int() && value.as_int() != Value::INLINE_MIN)
+            {
+                RA = Value::int_value(-value.as_int());
+            }
+            else if (value.is_float())
+            {
+                RA = Value::float_value(-value.as_float());
+            }
+            else
+            {
+                frame->ip = ip;
+                if (!negate(value, RA))
+                    return InterpretResult::RUNTIME_ERROR;
+            }
+        }
+        NEXT();
+
+        CASE(NOT)
+        RA = Value::boolean_value(!RB.truthy());
+        NEXT();
+
+        CASE(JMP)
+        ip += bytecode::sj_of(instruction);
+        BACK_EDGE(bytecode::sj_of(instruction));
+        NEXT();
+
+        CASE(JMPIF)
+        if (RA.truthy())
+        {
+            ip += bytecode::sbx_of(instruction);
+            BACK_EDGE(bytecode::sbx_of(instruction));
+        }
+        NEXT();
+
+        CASE(JMPIFNOT)
+        if (!RA.truthy())
+        {
+            ip += bytecode::sbx_of(instruction);
+            BACK_EDGE(bytecode::sbx_of(instruction));
+        }
+        NEXT();
+
+        CASE(CALL)
+        frame->ip = ip;
+        if (!call(&RA, bytecode::b_of(instruction)))
+            return InterpretResult::RUNTIME_ERROR;
+        LOAD_FRAME();
+        ENTER_NATIVE();
+        NEXT();
+
+        CASE(INVOKE)
+        frame->ip = ip + 1;
+        if (!invoke(&RA, bytecode::b_of(instruction), frame->caches[*ip]))
+            return InterpretResult::RUNTIME_ERROR;
+        LOAD_FRAME();
+        ENTER_NATIVE();
+        NEXT();
+
+        CASE(GETFIELD)
+        {
+            const auto *instance = runtime::as<runtime::InstanceObject>(RB);
+            if (instance == nullptr)
+                FAIL("Only instances have fields.");
+            runtime::InlineCache &cache = frame->caches[*ip];
+            std::uint32_t         slot;
+            if (!cache.lookup(instance->klass, instance->klass->field_slots, slot))
+                FAIL("Undefined field '" + std::string{name(cache.name)} + "'.");
+            RA = instance->fields()[slot];
+            ip++;
+        }
+        NEXT();
+
+        CASE(SETFIELD)
+        {
+            auto *instance = runtime::as<runtime::InstanceObject>(RA);
+            if (instance == nullptr)
+                FAIL("Only instances have fields.");
+            runtime::InlineCache &cache = frame->caches[*ip];
+            std::uint32_t         slot;
+            if (!cache.lookup(instance->klass, instance->klass->field_slots, slot))
+                FAIL("Undefined field '" + std::string{name(cache.name)} + "'.");
+            Value &field = instance->fields()[slot];
+            heap.write_barrier(instance, field, RB);
+            field = RB;
+            ip++;
+        }
+        NEXT();
+
+        CASE(GETSLOT)
+        GETSLOT_BODY()
+        NEXT();
+
+        CASE(SETSLOT)
+        SETSLOT_BODY()
+        NEXT();
+
+        /* The upvalues are copied once the closure is allocated, a collection may move what
+         * they refer to. Verified code only reads upvalues (GETUPVAL, or CLOSURE capturing
+         * one) in a function with upvalues, whose frames always hold a closure in the callee
+         * slot.
+         */
+        CASE(CLOSURE)
+        {
+            auto *function = static_cast<runtime::FunctionObject *>(
+                    k[bytecode::bx_of(instruction)].as_object());
+            const bytecode::Span<bytecode::Upvalue> upvalues = function->function->upvalues;
+            frame->ip                                        = ip;
+            auto *closure = heap.make_sized<runtime::ClosureObject>(
+                    runtime::ClosureObject::size(upvalues.size()), function, upvalues.size());
+            for (std::uint32_t i = 0; i < upvalues.size(); ++i)
+            {
+                const bytecode::Upvalue &upvalue = upvalues[i];
+                Value                    value;
+                if (upvalue.from_upvalue != 0)
+                    value = static_cast<runtime::ClosureObject *>(base[-1].as_object())
+                                    ->upvalues()[upvalue.index];
+                else
+                    value = base[upvalue.index];
+                heap.write_barrier(closure, Value::nil(), value);
+                closure->upvalues()[i] = value;
+            }
+            RA = Value::object_value(closure);
+        }
+        NEXT();
+
+        CASE(GETUPVAL)
+        RA = static_cast<runtime::ClosureObject *>(base[-1].as_object())
+                     ->upvalues()[bytecode::b_of(instruction)];
+        NEXT();
+
+        CASE(BOX)
+        {
+            frame->ip  = ip;
+            auto *cell = heap.make<runtime::CellObject>();
+            cell->value = RA;
+            RA          = Value::object_value(cell);
+        }
+        NEXT();
+
+        CASE(GETBOX)
+        {
+            const auto *cell = runtime::as<runtime::CellObject>(RB);
+            if (cell == nullptr)
+                FAIL("Invalid cell.");
+            RA = cell->value;
+        }
+        NEXT();
+
+        CASE(SETBOX)
+        {
+            auto *cell = runtime::as<runtime::CellObject>(RA);
+            if (cell == nullptr)
+                FAIL("Invalid cell.");
+            heap.write_barrier(cell, cell->value, RB);
+            cell->value = RB;
+        }
+        NEXT();
+
+        CASE(RETURN)
+        {
+            Value value = bytecode::b_of(instruction) != 0 ? RA : Value::nil();
+            if (frame->returns_receiver)
+                value = base[0];
+            *frame->result = value;
+            frames.pop_back();
+            if (frames.size() == exit_depth)
+                return InterpretResult::OK;
+            LOAD_FRAME();
+            ENTER_NATIVE();
+        }
+        NEXT();
+
+        CASE(PRINT)
+        // a nested run has C++ frames below it, so only the outermost one can stop here
+        if (pause_before_output && exit_depth == 0)
+        {
+            frame->ip = ip - 1;
+            return InterpretResult::OK;
+        }
+        print(RA);
+        out << '\n';
+        NEXT();
+
+        COMPARE_JUMP(LT_I64_JMPIF, BINARY_BODY(RC, fast_integer, Operator::LT), true)
+        COMPARE_JUMP(LT_I64_JMPIFNOT, BINARY_BODY(RC, fast_integer, Operator::LT), false)
+        COMPARE_JUMP(LE_I64_JMPIF, BINARY_BODY(RC, fast_integer, Operator::LE), true)
+        COMPARE_JUMP(LE_I64_JMPIFNOT, BINARY_BODY(RC, fast_integer, Operator::LE), false)
+        COMPARE_JUMP(LTK_I64_JMPIF, BINARY_BODY(KC, fast_integer, Operator::LT), true)
+        COMPARE_JUMP(LTK_I64_JMPIFNOT, BINARY_BODY(KC, fast_integer, Operator::LT), false)
+        COMPARE_JUMP(LEK_I64_JMPIF, BINARY_BODY(KC, fast_integer, Operator::LE), true)
+        COMPARE_JUMP(LEK_I64_JMPIFNOT, BINARY_BODY(KC, fast_integer, Operator::LE), false)
+        COMPARE_JUMP(GTK_I64_JMPIF, BINARY_BODY(KC, fast_integer, Operator::GT), true)
+        COMPARE_JUMP(GTK_I64_JMPIFNOT, BINARY_BODY(KC, fast_integer, Operator::GT), false)
+        COMPARE_JUMP(GEK_I64_JMPIF, BINARY_BODY(KC, fast_integer, Operator::GE), true)
+        COMPARE_JUMP(GEK_I64_JMPIFNOT, BINARY_BODY(KC, fast_integer, Operator::GE), false)
+        COMPARE_JUMP(EQK_JMPIF, RA = Value::boolean_value(equal(RB, KC)), true)
+        COMPARE_JUMP(EQK_JMPIFNOT, RA = Value::boolean_value(equal(RB, KC)), false)
+        COMPARE_JUMP(NEK_JMPIF, RA = Value::boolean_value(!equal(RB, KC)), true)
+        COMPARE_JUMP(NEK_JMPIFNOT, RA = Value::boolean_value(!equal(RB, KC)), false)
+
+        CASE(GETGLOBAL_ADDK_I64)
+        RA = globals[bytecode::bx_of(instruction)];
+        SECOND();
+        BINARY_BODY(KC, fast_integer, Operator::ADD)
+        NEXT();
+
+        CASE(SETGLOBAL_GETGLOBAL)
+        globals[bytecode::bx_of(instruction)] = RA;
+        SECOND();
+        RA = globals[bytecode::bx_of(instruction)];
+        NEXT();
+
+        CASE(GETSLOT_ADD)
+        GETSLOT_BODY()
+        SECOND();
+        BINARY_BODY(RC, fast_number, Operator::ADD)
+        NEXT();
+
+        CASE(LOADK_SETSLOT)
+        RA = k[bytecode::bx_of(instruction)];
+        SECOND();
+        SETSLOT_BODY()
+        NEXT();
+
+        case Opcode::COUNT:
+            break;
+        }
+        // verified code never reaches this
+        __builtin_unreachable();
+    }
+}
+
+#undef CASE
+#undef NEXT
+#undef RA
+#undef RB
+#undef RC
+#undef KC
+#undef LOAD_FRAME
+#undef ENTER_NATIVE
+#undef BACK_EDGE
+#undef FAIL
+#undef BINARY_BODY
+#undef BINARY
+#undef FLOAT_BINARY
+#undef CONCAT_BODY
+#undef GETSLOT_BODY
+#undef SETSLOT_BODY
+#undef SECOND
+#undef COMPARE_JUMP
+
+template InterpretResult Interpreter::execute<Dispatch::SWITCH>(std::size_t);
+template InterpretResult Interpreter::execute<Dispatch::THREADED>(std::size_t);
+
+/* A compiled frame leaves native code at calls and returns, which the interpreter performs,
+ * and at anything its templates do not handle, which is a deoptimization.
+ */
+const bytecode::Instruction *Interpreter::enter_native(const CallFrame            &frame,
+                                                       const bytecode::Instruction *ip)
+{
+    const bytecode::Instruction *code   = frame.function->code.data();
+    const std::uint8_t          *target = frame.profile->code->targets[ip - code];
+    if (target == nullptr)
+        return ip;
+    const std::uint32_t pc =
+            frame.profile->code->entry(frame.base, frame.constants, globals.data(), target, this);
+    const Opcode op = bytecode::op_of(code[pc]);
+    if (op != Opcode::CALL && op != Opcode::INVOKE && op != Opcode::RETURN)
+        jit.deoptimized(*frame.profile);
+    return code + pc;
+}
+
+bool Interpreter::push_frame(const runtime::FunctionObject *callee, Value *base, Value *result,
+                             const bool returns_receiver)
+{
+    const auto index = static_cast<std::uint32_t>(callee->function - views.data());
+    if (callee->function->code.empty() && !link_function(index))
+        return false;
+
+    const bytecode::FunctionView &function = *callee->function;
+    if (frames.size() == MAX_FRAMES ||
+        base + function.register_count > stack.data() + stack.size())
+    {
+        runtime_error("Stack overflow.");
+        return false;
+    }
+
+    // registers past the parameters may hold stale values from an earlier call
+    const int parameters = function.arity + (function.is_method ? 1 : 0);
+    std::fill(base + parameters, base + function.register_count, Value::nil());
+
+    jit.count(*this, jit.profiles[index]);
+    frames.push_back({&function, function.code.data(), base, constants[index].data(),
+                      caches[index].data(), &jit.profiles[index], result, returns_receiver});
+    return true;
+}
+
+bool Interpreter::call(Value *slot, const int argc)
+{
+    if (const auto *callee = runtime::as<runtime::FunctionObject>(*slot))
+    {
+        if (argc != callee->function->arity)
+        {
+            runtime_error("Expected " + std::to_string(callee->function->arity) +
+                          " arguments but got " + std::to_string(argc) + ".");
+            return false;
+        }
+        return push_frame(callee, slot + 1, slot, false);
+    }
+    if (const auto *closure = runtime::as<runtime::ClosureObject>(*slot))
+    {
+        if (argc != closure->function->function->arity)
+        {
+            runtime_error("Expected " + std::to_string(closure->function->function->arity) +
+                          " arguments but got " + std::to_string(argc) + ".");
+            return false;
+        }
+        // the closure stays in the callee slot, where GETUPVAL finds it
+        return push_frame(closure->function, slot + 1, slot, false);
+    }
+    if (auto *klass = runtime::as<runtime::ClassObject>(*slot))
+        return instantiate(klass, slot, argc);
+
+    runtime_error("Can only call functions and classes.");
+    return false;
+}
+
+bool Interpreter::invoke(Value *slot, const int argc, runtime::InlineCache &cache)
+{
+    const auto *instance = runtime::as<runtime::InstanceObject>(*slot);
+    if (instance == nullptr)
+    {
+        runtime_error("Only instances have methods.");
+        return false;
+    }
+    std::uint32_t index;
+    if (!cache.lookup(instance->klass, instance->klass->method_slots, index))
+    {
+        runtime_error("Undefined method '" + std::string{name(cache.name)} + "'.");
+        return false;
+    }
+    const runtime::FunctionObject *method = instance->klass->vtable[index];
+    if (argc != method->function->arity)
+    {
+        runtime_error("Expected " + std::to_string(method->function->arity) +
+                      " arguments but got " + std::to_string(argc) + ".");
+        return false;
+    }
+    return push_frame(method, slot, slot, false);
+}
+
+bool Interpreter::instantiate(runtime::ClassObject *klass, Value *slot, const int argc)
+{
+    const auto fields = static_cast<std::uint32_t>(klass->fields.size());
+    *slot             = Value::object_value(heap.make_sized<runtime::InstanceObject>(
+            runtime::InstanceObject::size(fields), klass));
+
+    // the initializers may collect and move the instance, `slot` keeps track of it
+    if (!run_initializers(klass, slot))
+        return false;
+
+    const int arity = klass->init != nullptr ? klass->init->function->arity : 0;
+    if (argc != arity)
+    {
+        runtime_error("Expected " + std::to_string(arity) + " arguments but got " +
+                      std::to_string(argc) + ".");
+        return false;
+    }
+    if (klass->init == nullptr)
+        return true;
+    return push_frame(klass->init, slot, slot, true);
+}
+
+bool Interpreter::run_initializers(runtime::ClassObject *klass, const Value *instance)
+{
+    if (klass->parent != nullptr && !run_initializers(klass->parent, instance))
+        return false;
+    if (klass->initializer == nullptr)
+        return true;
+
+    // run above the caller's registers so the pending call's arguments stay untouched
+    const CallFrame &caller = frames.back();
+    Value           *base   = caller.base + caller.function->register_count;
+    Value            ignored;
+    *base = *instance;
+    if (!push_frame(klass->initializer, base, &ignored, false))
+        return false;
+    return execute_nested(frames.size() - 1) == InterpretResult::OK;
+}
+
+// the registers of every live frame, the globals and, for a full collection, the objects
+// the module was linked to
+void Interpreter::trace_roots()
+{
+    Value *top = stack.data();
+    for (const CallFrame &frame : frames)
+        top = std::max(top, frame.base + frame.function->register_count);
+    for (Value *value = stack.data(); value < top; ++value)
+        heap.visit(*value);
+    for (Value &value : globals)
+        heap.visit(value);
+    heap.visit(result);
+    for (Value &value : operands)
+        heap.visit(value);
+
+    if (heap.phase != runtime::Heap::Phase::MAJOR)
+        return;
+    for (runtime::StringObject *string : strings)
+        if (string != nullptr)
+            heap.mark(string);
+    for (runtime::FunctionObject *function : functions)
+        if (function != nullptr)
+            heap.mark(function);
+    for (runtime::ClassObject *klass : classes)
+        if (klass != nullptr)
+            heap.mark(klass);
+    for (std::vector<Value> &pool : constants)
+        for (Value &value : pool)
+            heap.visit(value);
+}
+
+bool Interpreter::binary(const Operator op, const Value lhs, const Value rhs, Value &result)
+{
+    if (op == Operator::ADD && runtime::as<runtime::StringObject>(lhs) &&
+        runtime::as<runtime::StringObject>(rhs))
+    {
+        result = concatenate(lhs, rhs);
+        return true;
+    }
+
+    std::int64_t x;
+    std::int64_t y;
+    if (integer(lhs, x) && integer(rhs, y))
+        return integer_operation(op, x, y, result);
+
+    double a;
+    double b;
+    if (to_float(lhs, a) && to_float(rhs, b))
+    {
+        result = float_operation(op, a, b);
+        return true;
+    }
+
+    runtime_error(op == Operator::ADD ? "Operands must be two numbers or two strings."
+                                      : "Operands must be numbers.");
+    return false;
+}
+
+// integers wrap around on overflow like the machine does, only division by zero is an error
+bool Interpreter::integer_operation(const Operator op, const std::int64_t x, const std::int64_t y,
+                                    Value &result)
+{
+    const auto ux = static_cast<std::uint64_t>(x);
+    const auto uy = static_cast<std::uint64_t>(y);
+    switch (op)
+    {
+    case Operator::ADD:
+        result = make_integer(static_cast<std::int64_t>(ux + uy));
+        return true;
+    case Operator::SUB:
+        result = make_integer(static_cast<std::int64_t>(ux - uy));
+        return true;
+    case Operator::MUL:
+        result = make_integer(static_cast<std::int64_t>(ux * uy));
+        return true;
+    case Operator::DIV:
+    case Operator::MOD:
+        if (y == 0)
+        {
+            runtime_error("Division by zero.");
+            return false;
+        }
+        if (y == -1) // INT64_MIN / -1 overflows
+            result = make_integer(op == Operator::DIV ? static_cast<std::int64_t>(0 - ux) : 0);
+        else
+            result = make_integer(op == Operator::DIV ? x / y : x % y);
+        return true;
+    case Operator::POW:
+        result = Value::float_value(std::pow(static_cast<double>(x), static_cast<double>(y)));
+        return true;
+    default:
+        result = Value::boolean_value(compare(op, x, y));
+        return true;
+    }
+}
+
+bool Interpreter::negate(const Value value, Value &result)
+{
+    if (std::int64_t x; integer(value, x))
+    {
+        result = make_integer(static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(x)));
+        return true;
+    }
+    if (value.is_float())
+    {
+        result = Value::float_value(-value.as_float());
+        return true;
+    }
+    runtime_error("Operand must be a number.");
+    return false;
+}
+
+Value Interpreter::make_integer(const std::int64_t value)
+{
+    if (Value::fits_int(value))
+        return Value::int_value(value);
+    return Value::object_value(heap.make<runtime::IntegerObject>(value));
+}
+
+bool Interpreter::integer(const Value value, std::int64_t &result)
+{
+    if (value.is_int())
+    {
+        result = value.as_int();
+        return true;
+    }
+    if (const auto *boxed = runtime::as<runtime::IntegerObject>(value))
+    {
+        result = boxed->value;
+        return true;
+    }
+    return false;
+}
+
+bool Interpreter::to_float(const Value value, double &result)
+{
+    if (value.is_float())
+    {
+        result = value.as_float();
+        return true;
+    }
+    std::int64_t integral;
+    if (!integer(value, integral))
+        return false;
+    result = static_cast<double>(integral);
+    return true;
+}
+
+Value Interpreter::concatenate(const Value lhs, const Value rhs)
+{
+    const auto *a = runtime::as<runtime::StringObject>(lhs);
+    const auto *b = runtime::as<runtime::StringObject>(rhs);
+    if (a->length + b->length < runtime::StringObject::MIN_ROPE)
+        return Value::object_value(heap.make<runtime::StringObject>(a->value + b->value));
+
+    // the node reads its halves from `operands` once the allocation has updated them
+    operands   = {lhs, rhs};
+    auto *rope = heap.make<runtime::StringObject>(operands[0], operands[1]);
+    operands   = {Value::nil(), Value::nil()};
+    return Value::object_value(rope);
+}
+
+bool Interpreter::equal(const Value lhs, const Value rhs)
+{
+    if (lhs.bits == rhs.bits)
+        return !lhs.is_float() || lhs.as_float() == lhs.as_float();
+
+    std::int64_t x;
+    std::int64_t y;
+    if (integer(lhs, x) && integer(rhs, y))
+        return x == y;
+    double a;
+    double b;
+    if (to_float(lhs, a) && to_float(rhs, b))
+        return a == b;
+
+    auto *s = runtime::as<runtime::StringObject>(lhs);
+    auto *t = runtime::as<runtime::StringObject>(rhs);
+    if (s == nullptr || t == nullptr || (s->interned && t->interned) || s->length != t->length)
+        return false;
+    if (s->hashed && t->hashed && s->hash_code != t->hash_code)
+        return false;
+    return s->flat() == t->flat();
+}
+
+void Interpreter::print(const Value value)
+{
+    switch (value.type())
+    {
+    case runtime::ValueType::NIL:
+        out << "nil";
+        return;
+    case runtime::ValueType::BOOL:
+        out << (value.as_bool() ? "true" : "false");
+        return;
+    case runtime::ValueType::INT:
+        out << value.as_int();
+        return;
+    case runtime::ValueType::FLOAT: {
+        // floats always show a fraction or exponent so they read differently from ints
+        char buffer[32];
+        std::snprintf(buffer, sizeof buffer, "%.14g", value.as_float());
+        out << buffer;
+        if (std::strpbrk(buffer, ".eni") == nullptr)
+            out << ".0";
+        return;
+    }
+    case runtime::ValueType::OBJECT:
+        break;
+    }
+
+    runtime::Object *object = value.as_object();
+    switch (object->type)
+    {
+    case runtime::ObjectType::STRING:
+        out << static_cast<runtime::StringObject *>(object)->flat();
+        break;
+    case runtime::ObjectType::INTEGER:
+        out << static_cast<const runtime::IntegerObject *>(object)->value;
+        break;
+    case runtime::ObjectType::FUNCTION:
+        out << "<fn " << static_cast<const runtime::FunctionObject *>(object)->name << '>';
+        break;
+    case runtime::ObjectType::CLOSURE:
+        out << "<fn " << static_cast<const runtime::ClosureObject *>(object)->function->name
+            << '>';
+        break;
+    case runtime::ObjectType::CELL: // never in a register the program reads
+        out << "<cell>";
+        break;
+    case runtime::ObjectType::CLASS:
+        out << "<class " << static_cast<const runtime::ClassObject *>(object)->name << '>';
+        break;
+    case runtime::ObjectType::INSTANCE:
+        out << '<' << static_cast<const runtime::InstanceObject *>(object)->klass->name
+            << " instance>";
+        break;
+    }
+}
+
+// only called with indices the verifier checked
+std::string_view Interpreter::name(const std::uint32_t string) const
+{
+    std::string_view value;
+    static_cast<void>(image.string(string, value));
+    return value;
+}
+
+void Interpreter::runtime_error(const std::string &message)
+{
+    out.flush();
+    if (frames.empty())
+    {
+        std::cerr << "Error: " << message << '\n';
+        return;
+    }
+
+    const CallFrame &top = frames.back();
+    const auto       pc  = static_cast<std::uint32_t>(top.ip - top.function->code.data() - 1);
+    std::cerr << "[line " << top.function->line_at(pc) << "] Error: " << message << '\n';
+    constexpr std::size_t TRACE_LIMIT = 16;
+    for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame)
+    {
+        if (const auto shown = static_cast<std::size_t>(frame - frames.rbegin());
+            shown == TRACE_LIMIT)
+        {
+            std::cerr << "    ... " << frames.size() - shown << " more\n";
+            break;
+        }
+        const auto at = static_cast<std::uint32_t>(frame->ip - frame->function->code.data() - 1);
+        std::cerr << "    [line " << frame->function->line_at(at) << "] in "
+                  << name(frame->function->name) << '\n';
+    }
+}
+} // namespace cool::vm::interpreter
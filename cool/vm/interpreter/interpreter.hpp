@@ -0,0 +1,137 @@
+#pragma once
+
+#include "bytecode/image.hpp"
+#include "jit/jit.hpp"
+#include "runtime/heap.hpp"
+#include "runtime/inline_cache.hpp"
+#include "runtime/intern_table.hpp"
+#include "runtime/object.hpp"
+#include "runtime/value.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Threaded dispatch needs the labels-as-values extension, COOL_COMPUTED_GOTO=0 (the CMake
+ * option of the same name) forces the portable switch loop on compilers that have it.
+ */
+#ifndef COOL_COMPUTED_GOTO
+#define COOL_COMPUTED_GOTO 1
+#endif
+#if COOL_COMPUTED_GOTO && (defined(__GNUC__) || defined(__clang__))
+#define COOL_HAS_COMPUTED_GOTO 1
+#else
+#define COOL_HAS_COMPUTED_GOTO 0
+#endif
+
+namespace cool::vm::interpreter {
+/* SWITCH jumps back to one `switch` after every instruction, THREADED ends every handler
+ * with its own indirect jump through a label table. Without computed goto both run the
+ * switch loop.
+ */
+enum class Dispatch : std::uint8_t { SWITCH, THREADED };
+
+inline constexpr Dispatch DEFAULT_DISPATCH =
+        COOL_HAS_COMPUTED_GOTO ? Dispatch::THREADED : Dispatch::SWITCH;
+
+enum class InterpretResult : std::uint8_t { OK, RUNTIME_ERROR };
+
+// the operation behind the arithmetic and comparison opcodes, whatever their operand forms
+enum class Operator : std::uint8_t { ADD, SUB, MUL, DIV, MOD, POW, LT, LE, GT, GE };
+
+struct CallFrame
+{
+    const bytecode::FunctionView *function;
+    const bytecode::Instruction  *ip;
+    runtime::Value               *base;
+    const runtime::Value         *constants;
+    runtime::InlineCache         *caches;           // one per member site of the function
+    jit::Profile                 *profile;
+    runtime::Value               *result;           // the caller register receiving the result
+    bool                          returns_receiver; // `init` calls evaluate to the new instance
+};
+
+/* Executes an image. A call frame is a window into one register stack: the callee's
+ * registers start right after the callee slot of the caller (at the receiver for methods),
+ * so arguments are passed without copying.
+ *
+ * Linking is lazy. The tables indexed by string, function and class are sized up front but
+ * an entry is only filled in when it is first needed: a function is verified, gets its
+ * constant pool and inline caches on its first call, a class is verified and laid out when
+ * a constant first names it, and a string becomes a heap object when a pool first holds it.
+ */
+struct Interpreter
+{
+    static constexpr std::size_t STACK_SIZE = 1 << 18;
+    static constexpr std::size_t MAX_FRAMES = 4096;
+
+    const bytecode::Image                          &image;
+    std::ostream                                   &out;
+    Dispatch                                       dispatch = DEFAULT_DISPATCH;
+    runtime::Heap                                  heap;
+    runtime::InternTable                           interned;
+    std::vector<runtime::StringObject *>           strings;
+    std::vector<runtime::FunctionObject *>         functions;
+    std::vector<runtime::ClassObject *>            classes;
+    std::vector<bytecode::FunctionView>            views; // `code` is empty until linked
+    std::vector<std::vector<runtime::Value>>       constants;
+    std::vector<std::vector<runtime::InlineCache>> caches;
+    std::vector<runtime::Value>                    globals;
+    std::vector<runtime::Value>                    stack;
+    std::vector<CallFrame>                         frames;
+    runtime::Value                                 result;
+    std::array<runtime::Value, 2>                  operands; // rooted across an allocation
+    std::uint32_t                                  init_name           = bytecode::NO_INDEX;
+    bool                                           pause_before_output = false; // see snapshot.hpp
+    jit::Jit                                       jit;
+
+    explicit Interpreter(const bytecode::Image &image, std::ostream &out = std::cout);
+    InterpretResult run(Dispatch dispatch = DEFAULT_DISPATCH);
+    InterpretResult resume();
+
+    template <Dispatch D>
+    InterpretResult execute(std::size_t exit_depth);
+    InterpretResult execute_nested(std::size_t exit_depth);
+    // runs the frame's native code from `ip`, returns where the interpreter continues
+    const bytecode::Instruction *enter_native(const CallFrame            &frame,
+                                              const bytecode::Instruction *ip);
+
+    // loading, the functions returning a pointer give nullptr after reporting a runtime error
+    bool                     link_function(std::uint32_t index);
+    runtime::FunctionObject *function_object(std::uint32_t index);
+    runtime::ClassObject    *class_object(std::uint32_t index);
+    runtime::StringObject   *string_object(std::uint32_t index);
+    runtime::StringObject   *intern(std::string_view value);
+
+    // calls, false after reporting a runtime error
+    bool push_frame(const runtime::FunctionObject *callee, runtime::Value *base,
+                    runtime::Value *result, bool returns_receiver);
+    bool call(runtime::Value *slot, int argc);
+    bool invoke(runtime::Value *slot, int argc, runtime::InlineCache &cache);
+    bool instantiate(runtime::ClassObject *klass, runtime::Value *slot, int argc);
+    bool run_initializers(runtime::ClassObject *klass, const runtime::Value *instance);
+
+    // collection
+    void trace_roots();
+
+    // values, false after reporting a runtime error
+    bool           binary(Operator op, runtime::Value lhs, runtime::Value rhs,
+                          runtime::Value &result);
+    bool           integer_operation(Operator op, std::int64_t x, std::int64_t y,
+                                     runtime::Value &result);
+    bool           negate(runtime::Value value, runtime::Value &result);
+    runtime::Value make_integer(std::int64_t value);
+    static bool    integer(runtime::Value value, std::int64_t &result);
+    static bool    to_float(runtime::Value value, double &result);
+    runtime::Value concatenate(runtime::Value lhs, runtime::Value rhs);
+    [[nodiscard]] static bool   equal(runtime::Value lhs, runtime::Value rhs);
+    void                        print(runtime::Value value);
+    [[nodiscard]] std::string_view name(std::uint32_t string) const;
+
+    void runtime_error(const std::string &message);
+};
+} // namespace cool::vm::interpreter
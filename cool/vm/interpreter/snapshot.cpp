@@ -0,0 +1,443 @@
+#include "snapshot.hpp"
+
+#include "bytecode/verifier.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace cool::vm::interpreter {
+using runtime::Value;
+
+namespace {
+/* The header holds the magic, the version, the output size, the object, global, frame and
+ * stack value counts and where the module starts. The sections follow it in that order and
+ * the module starts on a page boundary, so it can be mapped where it lies. Every number is
+ * little-endian.
+ */
+constexpr std::size_t HEADER_SIZE      = 40;
+constexpr std::size_t MODULE_ALIGNMENT = 4096;
+
+struct Writer
+{
+    std::string out;
+
+    void put(std::uint64_t value, const int bytes)
+    {
+        for (int i = 0; i < bytes; ++i, value >>= 8)
+            out.push_back(static_cast<char>(value & 0xff));
+    }
+};
+
+struct Reader
+{
+    std::string_view in;
+    std::size_t      at = 0;
+
+    template <typename T>
+    bool get(T &value)
+    {
+        if (in.size() - at < sizeof(T))
+            return false;
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i)
+            bits |= std::uint64_t{static_cast<std::uint8_t>(in[at + i])} << (8 * i);
+        at += sizeof(T);
+        value = static_cast<T>(bits);
+        return true;
+    }
+
+    bool bytes(const std::size_t count, std::string_view &value)
+    {
+        if (in.size() - at < count)
+            return false;
+        value = in.substr(at, count);
+        at += count;
+        return true;
+    }
+};
+
+// numbers every object reachable from the roots in the order its record is written
+struct Encoder
+{
+    Interpreter                                                    &vm;
+    std::unordered_map<const runtime::Object *, std::uint32_t>      ids;
+    std::unordered_map<const runtime::ClassObject *, std::uint32_t> classes;
+    std::vector<runtime::Object *>                                  pending;
+
+    explicit Encoder(Interpreter &vm) : vm{vm}
+    {
+        for (std::uint32_t i = 0; i < vm.classes.size(); ++i)
+            if (vm.classes[i] != nullptr)
+                classes.emplace(vm.classes[i], i);
+    }
+
+    std::uint64_t value(const Value value)
+    {
+        if (!value.is_object())
+            return value.bits;
+        const auto [it, created] =
+                ids.emplace(value.as_object(), static_cast<std::uint32_t>(ids.size()));
+        if (created)
+            pending.push_back(value.as_object());
+        return Value::OBJECT_TAG | it->second;
+    }
+
+    // the records of the pending objects, which may add more
+    void records(Writer &writer)
+    {
+        for (std::size_t i = 0; i < pending.size(); ++i)
+        {
+            runtime::Object *object = pending[i];
+            writer.put(static_cast<std::uint8_t>(object->type), 1);
+            switch (object->type)
+            {
+            case runtime::ObjectType::STRING: {
+                auto              *string = static_cast<runtime::StringObject *>(object);
+                const std::string &value  = string->flat();
+                writer.put(string->interned ? 1 : 0, 1);
+                writer.put(value.size(), 4);
+                writer.out += value;
+                break;
+            }
+            case runtime::ObjectType::INTEGER: {
+                const std::int64_t value = static_cast<runtime::IntegerObject *>(object)->value;
+                writer.put(static_cast<std::uint64_t>(value), 8);
+                break;
+            }
+            case runtime::ObjectType::FUNCTION: {
+                const auto *function = static_cast<runtime::FunctionObject *>(object)->function;
+                writer.put(function - vm.views.data(), 4);
+                break;
+            }
+            case runtime::ObjectType::CLASS:
+                writer.put(classes.at(static_cast<runtime::ClassObject *>(object)), 4);
+                break;
+            case runtime::ObjectType::INSTANCE: {
+                auto *instance = static_cast<runtime::InstanceObject *>(object);
+                writer.put(classes.at(instance->klass), 4);
+                writer.put(instance->field_count, 4);
+                for (std::uint32_t slot = 0; slot < instance->field_count; ++slot)
+                    writer.put(value(instance->fields()[slot]), 8);
+                break;
+            }
+            case runtime::ObjectType::CELL:
+                writer.put(value(static_cast<runtime::CellObject *>(object)->value), 8);
+                break;
+            case runtime::ObjectType::CLOSURE: {
+                auto *closure = static_cast<runtime::ClosureObject *>(object);
+                writer.put(closure->function->function - vm.views.data(), 4);
+                writer.put(closure->upvalue_count, 4);
+                for (std::uint32_t i = 0; i < closure->upvalue_count; ++i)
+                    writer.put(value(closure->upvalues()[i]), 8);
+                break;
+            }
+            }
+        }
+    }
+};
+
+// where a frame below the top one continues once its callee returns
+bool after_call(const bytecode::FunctionView &function, const std::uint32_t pc)
+{
+    const auto is = [&](const std::uint32_t at, const bytecode::Opcode op) {
+        return pc >= at && bytecode::is_instruction_start(function, pc - at) &&
+               bytecode::op_of(function.code[pc - at]) == op;
+    };
+    return is(1, bytecode::Opcode::CALL) || is(2, bytecode::Opcode::INVOKE);
+}
+
+bool invalid(Interpreter &vm)
+{
+    vm.frames.clear();
+    vm.runtime_error("invalid snapshot");
+    return false;
+}
+} // namespace
+
+bool write_snapshot(Interpreter &interpreter, const std::string_view module,
+                    const std::string_view output, const std::string &path)
+{
+    Encoder encoder{interpreter};
+    Writer  roots;
+    for (const Value value : interpreter.globals)
+        roots.put(encoder.value(value), 8);
+
+    Value *top = interpreter.stack.data();
+    for (const CallFrame &frame : interpreter.frames)
+    {
+        top = std::max(top, frame.base + frame.function->register_count);
+        roots.put(frame.function - interpreter.views.data(), 4);
+        roots.put(frame.ip - frame.function->code.data(), 4);
+        roots.put(frame.base - interpreter.stack.data(), 4);
+        roots.put(frame.result == &interpreter.result ? bytecode::NO_INDEX
+                                                      : frame.result - interpreter.stack.data(),
+                  4);
+        roots.put(frame.returns_receiver ? 1 : 0, 1);
+    }
+    for (const Value *value = interpreter.stack.data(); value < top; ++value)
+        roots.put(encoder.value(*value), 8);
+
+    Writer objects;
+    encoder.records(objects);
+
+    const std::size_t state = HEADER_SIZE + output.size() + objects.out.size() + roots.out.size();
+    const std::size_t start = (state + MODULE_ALIGNMENT - 1) / MODULE_ALIGNMENT * MODULE_ALIGNMENT;
+    Writer            file;
+    file.out.append(SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC);
+    file.put(SNAPSHOT_VERSION, 2);
+    file.put(0, 2);
+    file.put(output.size(), 4);
+    file.put(encoder.pending.size(), 4);
+    file.put(interpreter.globals.size(), 4);
+    file.put(interpreter.frames.size(), 4);
+    file.put(static_cast<std::uint64_t>(top - interpreter.stack.data()), 4);
+    file.put(0, 4);
+    file.put(start, 8);
+    file.out += output;
+    file.out += objects.out;
+    file.out += roots.out;
+    file.out.resize(start, '\0');
+    file.out += module;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(file.out.data(), static_cast<std::streamsize>(file.out.size()));
+    return static_cast<bool>(out);
+}
+
+std::optional<Snapshot> Snapshot::open(const std::string &path, std::string &error)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        error = "cannot open " + path;
+        return std::nullopt;
+    }
+
+    in.seekg(0, std::ios::end);
+    const auto size = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0);
+
+    Snapshot snapshot;
+    snapshot.state.resize(HEADER_SIZE);
+    in.read(snapshot.state.data(), HEADER_SIZE);
+    Reader        reader{snapshot.state, sizeof SNAPSHOT_MAGIC};
+    std::uint16_t version = 0;
+    std::uint64_t module  = 0;
+    if (!in || std::memcmp(snapshot.state.data(), SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC) != 0)
+    {
+        error = "not a cool snapshot";
+        return std::nullopt;
+    }
+    static_cast<void>(reader.get(version));
+    if (version != SNAPSHOT_VERSION)
+    {
+        error = "unsupported snapshot version " + std::to_string(version);
+        return std::nullopt;
+    }
+    reader.at = HEADER_SIZE - sizeof module;
+    static_cast<void>(reader.get(module));
+
+    // the records are read into memory, the module stays where it is in the file
+    if (module < HEADER_SIZE || module >= size || module % MODULE_ALIGNMENT != 0)
+    {
+        error = "truncated snapshot";
+        return std::nullopt;
+    }
+    snapshot.state.resize(module);
+    if (!in.read(snapshot.state.data() + HEADER_SIZE,
+                 static_cast<std::streamsize>(module - HEADER_SIZE)))
+    {
+        error = "truncated snapshot";
+        return std::nullopt;
+    }
+    std::optional<bytecode::Image> image = bytecode::Image::open(path, error, module);
+    if (!image)
+        return std::nullopt;
+    snapshot.image = std::move(*image);
+    return snapshot;
+}
+
+/* Objects are made tenured, which never collects, so the ones built so far need no roots.
+ * Instances, cells and closures are made first and filled in once every object exists,
+ * since the values they hold may refer to objects further on in the stream.
+ */
+bool Snapshot::restore(Interpreter &interpreter) const
+{
+    Reader           reader{state, sizeof SNAPSHOT_MAGIC + 4};
+    std::uint32_t    output_size  = 0;
+    std::uint32_t    object_count = 0;
+    std::uint32_t    global_count = 0;
+    std::uint32_t    frame_count  = 0;
+    std::uint32_t    stack_count  = 0;
+    std::string_view output;
+    if (!reader.get(output_size) || !reader.get(object_count) || !reader.get(global_count) ||
+        !reader.get(frame_count) || !reader.get(stack_count))
+        return invalid(interpreter);
+    reader.at = HEADER_SIZE;
+    if (!reader.bytes(output_size, output) || global_count != interpreter.globals.size() ||
+        frame_count > Interpreter::MAX_FRAMES || stack_count > Interpreter::STACK_SIZE ||
+        object_count > state.size())
+        return invalid(interpreter);
+
+    std::vector<runtime::Object *>                               objects(object_count);
+    std::vector<std::tuple<Value *, std::uint32_t, std::size_t>> contents; // values to fill in
+    runtime::Heap                                               &heap = interpreter.heap;
+    for (runtime::Object *&object : objects)
+    {
+        std::uint8_t  type  = 0;
+        std::uint32_t index = 0;
+        if (!reader.get(type))
+            return invalid(interpreter);
+        switch (static_cast<runtime::ObjectType>(type))
+        {
+        case runtime::ObjectType::STRING: {
+            std::uint8_t     interned = 0;
+            std::string_view value;
+            if (!reader.get(interned) || !reader.get(index) || !reader.bytes(index, value))
+                return invalid(interpreter);
+            object = interned != 0 ? interpreter.intern(value)
+                                   : heap.make_tenured<runtime::StringObject>(std::string{value});
+            break;
+        }
+        case runtime::ObjectType::INTEGER: {
+            std::uint64_t value = 0;
+            if (!reader.get(value))
+                return invalid(interpreter);
+            object = heap.make_tenured<runtime::IntegerObject>(static_cast<std::int64_t>(value));
+            break;
+        }
+        case runtime::ObjectType::FUNCTION:
+            if (!reader.get(index) || index >= interpreter.functions.size())
+                return invalid(interpreter);
+            object = interpreter.function_object(index);
+            break;
+        case runtime::ObjectType::CLASS:
+            if (!reader.get(index) || index >= interpreter.classes.size())
+                return invalid(interpreter);
+            if ((object = interpreter.class_object(index)) == nullptr)
+                return false;
+            break;
+        case runtime::ObjectType::INSTANCE: {
+            std::uint32_t         fields = 0;
+            runtime::ClassObject *klass  = nullptr;
+            if (!reader.get(index) || index >= interpreter.classes.size() ||
+                !reader.get(fields))
+                return invalid(interpreter);
+            if ((klass = interpreter.class_object(index)) == nullptr)
+                return false;
+            std::string_view values;
+            if (fields != klass->fields.size() || !reader.bytes(fields * sizeof(Value), values))
+                return invalid(interpreter);
+            auto *instance = heap.make_tenured_sized<runtime::InstanceObject>(
+                    runtime::InstanceObject::size(fields), klass);
+            contents.emplace_back(instance->fields(), fields, reader.at - values.size());
+            object = instance;
+            break;
+        }
+        case runtime::ObjectType::CELL: {
+            std::string_view value;
+            if (!reader.bytes(sizeof(Value), value))
+                return invalid(interpreter);
+            auto *cell = heap.make_tenured<runtime::CellObject>();
+            contents.emplace_back(&cell->value, 1, reader.at - value.size());
+            object = cell;
+            break;
+        }
+        case runtime::ObjectType::CLOSURE: {
+            std::uint32_t upvalues = 0;
+            if (!reader.get(index) || index >= interpreter.functions.size() ||
+                !reader.get(upvalues) ||
+                upvalues != interpreter.image.functions[index].upvalues.count)
+                return invalid(interpreter);
+            std::string_view values;
+            if (!reader.bytes(upvalues * sizeof(Value), values))
+                return invalid(interpreter);
+            auto *closure = heap.make_tenured_sized<runtime::ClosureObject>(
+                    runtime::ClosureObject::size(upvalues), interpreter.function_object(index),
+                    upvalues);
+            contents.emplace_back(closure->upvalues(), upvalues, reader.at - values.size());
+            object = closure;
+            break;
+        }
+        default:
+            return invalid(interpreter);
+        }
+    }
+
+    const auto value = [&](Reader &from, Value &out) {
+        std::uint64_t bits = 0;
+        if (!from.get(bits))
+            return false;
+        out = Value::from_bits(bits);
+        if (!out.is_object())
+            return true;
+        if ((bits & Value::PAYLOAD_MASK) >= objects.size())
+            return false;
+        out = Value::object_value(objects[bits & Value::PAYLOAD_MASK]);
+        return true;
+    };
+    for (const auto &[values, count, at] : contents)
+    {
+        Reader from{state, at};
+        for (std::uint32_t i = 0; i < count; ++i)
+            if (!value(from, values[i]))
+                return invalid(interpreter);
+    }
+    for (Value &global : interpreter.globals)
+        if (!value(reader, global))
+            return invalid(interpreter);
+
+    // the top frame stops at the PRINT it paused before, the ones below it after a call
+    for (std::uint32_t i = 0; i < frame_count; ++i)
+    {
+        std::uint32_t index            = 0;
+        std::uint32_t pc               = 0;
+        std::uint32_t base             = 0;
+        std::uint32_t result           = 0;
+        std::uint8_t  returns_receiver = 0;
+        if (!reader.get(index) || !reader.get(pc) || !reader.get(base) || !reader.get(result) ||
+            !reader.get(returns_receiver) || index >= interpreter.functions.size())
+            return invalid(interpreter);
+        if (interpreter.views[index].code.empty() && !interpreter.link_function(index))
+            return false;
+        const bytecode::FunctionView &function = interpreter.views[index];
+        bool                          resumes  = after_call(function, pc);
+        if (i + 1 == frame_count)
+            resumes = bytecode::is_instruction_start(function, pc) &&
+                      bytecode::op_of(function.code[pc]) == bytecode::Opcode::PRINT;
+        if (!resumes || base + std::size_t{function.register_count} > Interpreter::STACK_SIZE ||
+            (result != bytecode::NO_INDEX && result >= Interpreter::STACK_SIZE))
+            return invalid(interpreter);
+        interpreter.frames.push_back(
+                {&function, function.code.data() + pc, interpreter.stack.data() + base,
+                 interpreter.constants[index].data(), interpreter.caches[index].data(),
+                 &interpreter.jit.profiles[index],
+                 result == bytecode::NO_INDEX ? &interpreter.result
+                                              : interpreter.stack.data() + result,
+                 returns_receiver != 0});
+    }
+    for (std::uint32_t i = 0; i < stack_count; ++i)
+        if (!value(reader, interpreter.stack[i]))
+            return invalid(interpreter);
+
+    // GETUPVAL trusts the callee slot of a function with upvalues to hold its closure
+    for (const CallFrame &frame : interpreter.frames)
+    {
+        if (frame.function->upvalues.empty())
+            continue;
+        const runtime::ClosureObject *closure = nullptr;
+        const Value *callee = frame.base - 1;
+        if (callee >= interpreter.stack.data() && callee < interpreter.stack.data() + stack_count)
+            closure = runtime::as<runtime::ClosureObject>(*callee);
+        if (closure == nullptr || closure->function->function != frame.function)
+            return invalid(interpreter);
+    }
+
+    interpreter.out << output;
+    return true;
+}
+} // namespace cool::vm::interpreter
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "bytecode/image.hpp"
+#include "interpreter.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cool::vm::interpreter {
+inline constexpr char          SNAPSHOT_MAGIC[4] = {'C', 'L', 'S', 'N'};
+inline constexpr std::uint16_t SNAPSHOT_VERSION  = 2;
+
+/* A program paused where its initialization ends, see docs/vm_architecture.md. Cool
+ * programs read no input, so everything a program computes before it first prints is the
+ * same on every run: `cool --snapshot` runs that far with `pause_before_output` set and
+ * writes the live heap, the globals and the call frames next to a copy of the module, and
+ * `cool --from-snapshot` continues from there.
+ *
+ * Runtime objects hold C++ containers and pointers into the module, so the heap is stored
+ * as a stream of records that name functions and classes by index and other objects by
+ * their position in the stream, and is rebuilt on restore. That costs time linear in the
+ * live heap rather than in the work the initialization did. Constant pools, inline caches
+ * and JIT profiles start cold, like those of a fresh run.
+ */
+struct Snapshot
+{
+    bytecode::Image image; // mapped from the end of the snapshot file
+    std::string     state; // the header and records before it
+
+    static std::optional<Snapshot> open(const std::string &path, std::string &error);
+
+    /* Prints what the program printed before the pause and rebuilds the heap, globals and
+     * frames in a fresh interpreter on `image`, whose resume() then continues the program.
+     * False after reporting a runtime error.
+     */
+    bool restore(Interpreter &interpreter) const;
+};
+
+/* Writes the state a run with `pause_before_output` set stopped in, or finished in,
+ * together with `module`, the bytes of the image it runs, and `output`, what it printed
+ * from nested calls before the pause.
+ */
+bool write_snapshot(Interpreter &interpreter, std::string_view module, std::string_view output,
+                    const std::string &path);
+} // namespace cool::vm::interpreter
@@ -0,0 +1,292 @@
+#include "assembler.hpp"
+
+namespace cool::vm::jit {
+namespace {
+constexpr unsigned low(const Reg reg)
+{
+    return static_cast<unsigned>(reg) & 7;
+}
+} // namespace
+
+Assembler::Label Assembler::make_label()
+{
+    labels.push_back(UNBOUND);
+    return static_cast<Label>(labels.size() - 1);
+}
+
+void Assembler::bind(const Label label)
+{
+    labels[label] = static_cast<std::uint32_t>(code.size());
+}
+
+bool Assembler::resolve()
+{
+    for (const Fixup &fixup : fixups)
+    {
+        if (labels[fixup.label] == UNBOUND)
+            return false;
+        const auto displacement = static_cast<std::uint32_t>(
+                static_cast<std::int64_t>(labels[fixup.label]) - (fixup.at + 4));
+        for (int i = 0; i < 4; ++i)
+            code[fixup.at + i] = static_cast<std::uint8_t>(displacement >> (8 * i));
+    }
+    fixups.clear();
+    return true;
+}
+
+void Assembler::byte(const std::uint8_t value)
+{
+    code.push_back(value);
+}
+
+void Assembler::u32(const std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        byte(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+// `force` emits an empty REX so a byte register operand means SPL..DIL rather than AH..BH
+void Assembler::rex(const bool wide, const unsigned reg, const unsigned index, const unsigned base,
+                    const bool force)
+{
+    const unsigned value = (wide ? 8u : 0u) | (reg >> 3) << 2 | (index >> 3) << 1 | base >> 3;
+    if (value != 0 || force)
+        byte(static_cast<std::uint8_t>(0x40 | value));
+}
+
+void Assembler::modrm(const unsigned mod, const unsigned reg, const unsigned rm)
+{
+    byte(static_cast<std::uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7)));
+}
+
+// [base + disp], RSP and R12 as a base need a SIB byte, RBP and R13 always a displacement
+void Assembler::memory(const unsigned reg, const Reg base, const std::int32_t disp)
+{
+    const bool short_disp = disp >= INT8_MIN && disp <= INT8_MAX;
+    modrm(short_disp ? 1 : 2, reg, low(base));
+    if (low(base) == low(Reg::RSP))
+        byte(0x24);
+    if (short_disp)
+        byte(static_cast<std::uint8_t>(disp));
+    else
+        u32(static_cast<std::uint32_t>(disp));
+}
+
+void Assembler::rel32(const Label label)
+{
+    fixups.push_back({static_cast<std::uint32_t>(code.size()), label});
+    u32(0);
+}
+
+void Assembler::mov(const Reg dst, const Reg src)
+{
+    rex(true, static_cast<unsigned>(src), 0, static_cast<unsigned>(dst));
+    byte(0x89);
+    modrm(3, low(src), low(dst));
+}
+
+void Assembler::mov(const Reg dst, const Reg base, const std::int32_t disp)
+{
+    rex(true, static_cast<unsigned>(dst), 0, static_cast<unsigned>(base));
+    byte(0x8B);
+    memory(low(dst), base, disp);
+}
+
+void Assembler::mov(const Reg base, const std::int32_t disp, const Reg src)
+{
+    rex(true, static_cast<unsigned>(src), 0, static_cast<unsigned>(base));
+    byte(0x89);
+    memory(low(src), base, disp);
+}
+
+void Assembler::mov(const Reg dst, const std::uint64_t imm)
+{
+    if (imm <= UINT32_MAX)
+    {
+        // a 32-bit move zero-extends
+        rex(false, 0, 0, static_cast<unsigned>(dst));
+        byte(static_cast<std::uint8_t>(0xB8 + low(dst)));
+        u32(static_cast<std::uint32_t>(imm));
+        return;
+    }
+    rex(true, 0, 0, static_cast<unsigned>(dst));
+    byte(static_cast<std::uint8_t>(0xB8 + low(dst)));
+    u32(static_cast<std::uint32_t>(imm));
+    u32(static_cast<std::uint32_t>(imm >> 32));
+}
+
+void Assembler::movzx8(const Reg dst, const Reg src)
+{
+    rex(false, static_cast<unsigned>(dst), 0, static_cast<unsigned>(src), low(src) >= 4);
+    byte(0x0F);
+    byte(0xB6);
+    modrm(3, low(dst), low(src));
+}
+
+void Assembler::movq(const Xmm dst, const Reg src)
+{
+    byte(0x66);
+    rex(true, static_cast<unsigned>(dst), 0, static_cast<unsigned>(src));
+    byte(0x0F);
+    byte(0x6E);
+    modrm(3, static_cast<unsigned>(dst), low(src));
+}
+
+void Assembler::movq(const Reg dst, const Xmm src)
+{
+    byte(0x66);
+    rex(true, static_cast<unsigned>(src), 0, static_cast<unsigned>(dst));
+    byte(0x0F);
+    byte(0x7E);
+    modrm(3, static_cast<unsigned>(src), low(dst));
+}
+
+void Assembler::alu(const Alu op, const Reg dst, const Reg src)
+{
+    rex(true, static_cast<unsigned>(src), 0, static_cast<unsigned>(dst));
+    byte(static_cast<std::uint8_t>(static_cast<unsigned>(op) << 3 | 1));
+    modrm(3, low(src), low(dst));
+}
+
+void Assembler::alu(const Alu op, const Reg dst, const std::int32_t imm)
+{
+    rex(true, 0, 0, static_cast<unsigned>(dst));
+    if (imm >= INT8_MIN && imm <= INT8_MAX)
+    {
+        byte(0x83);
+        modrm(3, static_cast<unsigned>(op), low(dst));
+        byte(static_cast<std::uint8_t>(imm));
+        return;
+    }
+    byte(0x81);
+    modrm(3, static_cast<unsigned>(op), low(dst));
+    u32(static_cast<std::uint32_t>(imm));
+}
+
+void Assembler::imul(const Reg dst, const Reg src)
+{
+    rex(true, static_cast<unsigned>(dst), 0, static_cast<unsigned>(src));
+    byte(0x0F);
+    byte(0xAF);
+    modrm(3, low(dst), low(src));
+}
+
+void Assembler::shl(const Reg dst, const std::uint8_t count)
+{
+    rex(true, 0, 0, static_cast<unsigned>(dst));
+    byte(0xC1);
+    modrm(3, 4, low(dst));
+    byte(count);
+}
+
+void Assembler::shr(const Reg dst, const std::uint8_t count)
+{
+    rex(true, 0, 0, static_cast<unsigned>(dst));
+    byte(0xC1);
+    modrm(3, 5, low(dst));
+    byte(count);
+}
+
+void Assembler::sar(const Reg dst, const std::uint8_t count)
+{
+    rex(true, 0, 0, static_cast<unsigned>(dst));
+    byte(0xC1);
+    modrm(3, 7, low(dst));
+    byte(count);
+}
+
+void Assembler::neg(const Reg dst)
+{
+    rex(true, 0, 0, static_cast<unsigned>(dst));
+    byte(0xF7);
+    modrm(3, 3, low(dst));
+}
+
+void Assembler::test(const Reg a, const Reg b)
+{
+    rex(true, static_cast<unsigned>(b), 0, static_cast<unsigned>(a));
+    byte(0x85);
+    modrm(3, low(b), low(a));
+}
+
+void Assembler::cqo()
+{
+    byte(0x48);
+    byte(0x99);
+}
+
+void Assembler::idiv(const Reg divisor)
+{
+    rex(true, 0, 0, static_cast<unsigned>(divisor));
+    byte(0xF7);
+    modrm(3, 7, low(divisor));
+}
+
+void Assembler::setcc(const Cond cond, const Reg dst)
+{
+    rex(false, 0, 0, static_cast<unsigned>(dst), low(dst) >= 4);
+    byte(0x0F);
+    byte(static_cast<std::uint8_t>(0x90 + static_cast<unsigned>(cond)));
+    modrm(3, 0, low(dst));
+}
+
+void Assembler::sse(const SseOp op, const Xmm dst, const Xmm src)
+{
+    byte(0xF2);
+    byte(0x0F);
+    byte(static_cast<std::uint8_t>(op));
+    modrm(3, static_cast<unsigned>(dst), static_cast<unsigned>(src));
+}
+
+void Assembler::ucomisd(const Xmm a, const Xmm b)
+{
+    byte(0x66);
+    byte(0x0F);
+    byte(0x2E);
+    modrm(3, static_cast<unsigned>(a), static_cast<unsigned>(b));
+}
+
+void Assembler::jmp(const Label label)
+{
+    byte(0xE9);
+    rel32(label);
+}
+
+void Assembler::jcc(const Cond cond, const Label label)
+{
+    byte(0x0F);
+    byte(static_cast<std::uint8_t>(0x80 + static_cast<unsigned>(cond)));
+    rel32(label);
+}
+
+void Assembler::jmp(const Reg target)
+{
+    rex(false, 0, 0, static_cast<unsigned>(target));
+    byte(0xFF);
+    modrm(3, 4, low(target));
+}
+
+void Assembler::call(const Reg target)
+{
+    rex(false, 0, 0, static_cast<unsigned>(target));
+    byte(0xFF);
+    modrm(3, 2, low(target));
+}
+
+void Assembler::push(const Reg reg)
+{
+    rex(false, 0, 0, static_cast<unsigned>(reg));
+    byte(static_cast<std::uint8_t>(0x50 + low(reg)));
+}
+
+void Assembler::pop(const Reg reg)
+{
+    rex(false, 0, 0, static_cast<unsigned>(reg));
+    byte(static_cast<std::uint8_t>(0x58 + low(reg)));
+}
+
+void Assembler::ret()
+{
+    byte(0xC3);
+}
+} // namespace cool::vm::jit
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace cool::vm::jit {
+// general purpose registers, in encoding order
+enum class Reg : std::uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+enum class Xmm : std::uint8_t { XMM0, XMM1 };
+
+// x86 condition codes, in encoding order
+enum class Cond : std::uint8_t { O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G };
+
+// the two-operand integer instructions sharing the 01/81 encoding scheme, by their /digit
+enum class Alu : std::uint8_t { ADD = 0, OR = 1, AND = 4, SUB = 5, XOR = 6, CMP = 7 };
+
+enum class SseOp : std::uint8_t { ADD = 0x58, MUL = 0x59, SUB = 0x5C, DIV = 0x5E };
+
+/* Encodes the few x86-64 instructions the JIT templates use into a byte buffer. Memory
+ * operands are always `[base + disp]`. A label is a position in the buffer; jumps to a
+ * label that is not bound yet get a 32-bit displacement patched in by bind().
+ */
+struct Assembler
+{
+    using Label = std::uint32_t;
+
+    struct Fixup
+    {
+        std::uint32_t at; // the displacement to patch
+        Label         label;
+    };
+
+    static constexpr std::uint32_t UNBOUND = UINT32_MAX;
+
+    std::vector<std::uint8_t>  code;
+    std::vector<std::uint32_t> labels; // position of each label, UNBOUND until bound
+    std::vector<Fixup>         fixups;
+
+    Label make_label();
+    void  bind(Label label);
+    // patches every jump to a label, false when one was never bound
+    bool  resolve();
+
+    // moves
+    void mov(Reg dst, Reg src);
+    void mov(Reg dst, Reg base, std::int32_t disp);
+    void mov(Reg base, std::int32_t disp, Reg src);
+    void mov(Reg dst, std::uint64_t imm);
+    void movzx8(Reg dst, Reg src);
+    void movq(Xmm dst, Reg src);
+    void movq(Reg dst, Xmm src);
+
+    // arithmetic
+    void alu(Alu op, Reg dst, Reg src);
+    void alu(Alu op, Reg dst, std::int32_t imm);
+    void imul(Reg dst, Reg src);
+    void shl(Reg dst, std::uint8_t count);
+    void shr(Reg dst, std::uint8_t count);
+    void sar(Reg dst, std::uint8_t count);
+    void neg(Reg dst);
+    void test(Reg a, Reg b);
+    void cqo();
+    void idiv(Reg divisor);
+    void setcc(Cond cond, Reg dst);
+    void sse(SseOp op, Xmm dst, Xmm src);
+    void ucomisd(Xmm a, Xmm b);
+
+    // control flow
+    void jmp(Label label);
+    void jcc(Cond cond, Label label);
+    void jmp(Reg target);
+    void call(Reg target);
+    void push(Reg reg);
+    void pop(Reg reg);
+    void ret();
+
+private:
+    void byte(std::uint8_t value);
+    void u32(std::uint32_t value);
+    void rex(bool wide, unsigned reg, unsigned index, unsigned base, bool force = false);
+    void modrm(unsigned mod, unsigned reg, unsigned rm);
+    void memory(unsigned reg, Reg base, std::int32_t disp);
+    void rel32(Label label);
+};
+} // namespace cool::vm::jit
@@ -0,0 +1,43 @@
+#include "code_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace cool::vm::jit {
+CodeBuffer::~CodeBuffer()
+{
+    for (const Chunk &chunk : chunks)
+        munmap(chunk.memory, chunk.size);
+}
+
+const std::uint8_t *CodeBuffer::add(const std::vector<std::uint8_t> &code)
+{
+    constexpr std::size_t ALIGNMENT = 16;
+    if (chunks.empty() || chunks.back().size - chunks.back().used < code.size())
+    {
+        const auto  page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t size = CHUNK_SIZE;
+        if (code.size() > size)
+            size = (code.size() + page - 1) / page * page;
+        void *memory = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                            0);
+        if (memory == MAP_FAILED)
+            return nullptr;
+        chunks.push_back({static_cast<std::uint8_t *>(memory), size, 0});
+    }
+
+    Chunk &chunk = chunks.back();
+    if (mprotect(chunk.memory, chunk.size, PROT_READ | PROT_WRITE) != 0)
+        return nullptr;
+    std::uint8_t *start = chunk.memory + chunk.used;
+    std::memcpy(start, code.data(), code.size());
+    chunk.used = std::min(chunk.size, (chunk.used + code.size() + ALIGNMENT - 1) / ALIGNMENT *
+                                              ALIGNMENT);
+    bytes += code.size();
+    if (mprotect(chunk.memory, chunk.size, PROT_READ | PROT_EXEC) != 0)
+        return nullptr;
+    return start;
+}
+} // namespace cool::vm::jit
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cool::vm::jit {
+/* Executable memory for compiled functions, mapped in chunks. A chunk is never writable
+ * and executable at once: it is made writable to append code and executable again after.
+ * Code stays mapped until the buffer is destroyed.
+ */
+struct CodeBuffer
+{
+    static constexpr std::size_t CHUNK_SIZE = std::size_t{1} << 20;
+
+    struct Chunk
+    {
+        std::uint8_t *memory;
+        std::size_t   size;
+        std::size_t   used;
+    };
+
+    std::vector<Chunk> chunks;
+    std::size_t        bytes = 0; // code added so far
+
+    CodeBuffer() = default;
+    CodeBuffer(const CodeBuffer &) = delete;
+    CodeBuffer &operator=(const CodeBuffer &) = delete;
+    ~CodeBuffer();
+
+    // copies `code` into executable memory, nullptr when no memory could be mapped
+    const std::uint8_t *add(const std::vector<std::uint8_t> &code);
+};
+} // namespace cool::vm::jit
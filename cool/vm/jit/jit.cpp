@@ -0,0 +1,825 @@
+#include "jit.hpp"
+
+#include "assembler.hpp"
+#include "bytecode/instruction.hpp"
+#include "interpreter/interpreter.hpp"
+
+namespace cool::vm::jit {
+#if COOL_HAS_JIT
+namespace {
+using bytecode::Instruction;
+using bytecode::Opcode;
+using interpreter::Interpreter;
+using interpreter::Operator;
+using runtime::Value;
+using Label = Assembler::Label;
+
+// pinned for the whole run of native code, all callee-saved
+constexpr Reg BASE      = Reg::RBX;
+constexpr Reg CONSTANTS = Reg::R12;
+constexpr Reg GLOBALS   = Reg::R13;
+constexpr Reg VM        = Reg::R14;
+
+constexpr std::int32_t slot(const unsigned index)
+{
+    return static_cast<std::int32_t>(index * sizeof(Value));
+}
+
+// called from native code, they return false without side effects where the interpreter
+// would raise a runtime error, native code then leaves for the interpreter to raise it
+
+bool get_slot(Interpreter *, Value *base, const Instruction instruction)
+{
+    const auto    *instance =
+            runtime::as<runtime::InstanceObject>(base[bytecode::b_of(instruction)]);
+    const unsigned index    = bytecode::c_of(instruction);
+    if (instance == nullptr || index >= instance->field_count)
+        return false;
+    base[bytecode::a_of(instruction)] = instance->fields()[index];
+    return true;
+}
+
+bool set_slot(Interpreter *vm, Value *base, const Instruction instruction)
+{
+    auto          *instance =
+            runtime::as<runtime::InstanceObject>(base[bytecode::a_of(instruction)]);
+    const unsigned index    = bytecode::c_of(instruction);
+    if (instance == nullptr || index >= instance->field_count)
+        return false;
+    Value      &field = instance->fields()[index];
+    const Value value = base[bytecode::b_of(instruction)];
+    vm->heap.write_barrier(instance, field, value);
+    field = value;
+    return true;
+}
+
+bool get_field(Interpreter *, Value *base, const Instruction instruction,
+               runtime::InlineCache *cache)
+{
+    const auto *instance =
+            runtime::as<runtime::InstanceObject>(base[bytecode::b_of(instruction)]);
+    std::uint32_t index;
+    if (instance == nullptr || !cache->lookup(instance->klass, instance->klass->field_slots, index))
+        return false;
+    base[bytecode::a_of(instruction)] = instance->fields()[index];
+    return true;
+}
+
+bool set_field(Interpreter *vm, Value *base, const Instruction instruction,
+               runtime::InlineCache *cache)
+{
+    auto         *instance =
+            runtime::as<runtime::InstanceObject>(base[bytecode::a_of(instruction)]);
+    std::uint32_t index;
+    if (instance == nullptr || !cache->lookup(instance->klass, instance->klass->field_slots, index))
+        return false;
+    Value      &field = instance->fields()[index];
+    const Value value = base[bytecode::b_of(instruction)];
+    vm->heap.write_barrier(instance, field, value);
+    field = value;
+    return true;
+}
+
+bool concat(Interpreter *vm, Value *base, const Instruction instruction, const Value *constants)
+{
+    const Value lhs = base[bytecode::b_of(instruction)];
+    const Value rhs = bytecode::op_of(instruction) == Opcode::CONCATK_STR
+                              ? constants[bytecode::c_of(instruction)]
+                              : base[bytecode::c_of(instruction)];
+    if (runtime::as<runtime::StringObject>(lhs) == nullptr ||
+        runtime::as<runtime::StringObject>(rhs) == nullptr)
+        return false;
+    base[bytecode::a_of(instruction)] = vm->concatenate(lhs, rhs);
+    return true;
+}
+
+void print(Interpreter *vm, const std::uint64_t bits)
+{
+    vm->print(Value::from_bits(bits));
+    vm->out << '\n';
+}
+
+bool equal(const std::uint64_t lhs, const std::uint64_t rhs)
+{
+    return Interpreter::equal(Value::from_bits(lhs), Value::from_bits(rhs));
+}
+
+// the right operand of a binary instruction, a register or a pooled constant
+struct Operand
+{
+    bool     constant;
+    unsigned index;
+};
+
+// what a helper takes after the instruction word
+enum class Extra : std::uint8_t { NONE, SITE, CONSTANTS };
+
+struct Translator
+{
+    Interpreter                  &vm;
+    const bytecode::FunctionView &function;
+    std::uint32_t                 index;
+    Assembler                     as{};
+    std::vector<Label>            labels{};  // per pc
+    std::vector<Label>            exits{};   // per pc, made when first needed
+    std::vector<bool>             jumped{};  // per pc, the target of some jump
+    std::vector<bool>             emitted{}; // per pc, has code of its own
+    std::vector<bool>             folded{};  // per pc, a branch folded into the comparison ahead
+    Label                         epilogue = 0;
+
+    bool translate(Code &code);
+    void instruction(std::uint32_t pc);
+
+    Label exit(std::uint32_t pc);
+    Label jump_target(std::uint32_t pc, std::int32_t offset);
+    void  load(Reg reg, unsigned index);
+    void  store(unsigned index, Reg reg);
+    void  load_operand(Reg reg, Operand operand);
+    bool  inline_int(Operand operand) const;
+    void  guard_int(Reg reg, Label fail);
+    void  guard_float(Reg reg, Label fail);
+    void  tag_int(Reg reg);
+    void  boolean(Reg condition);
+    void  call(const void *helper);
+
+    void arithmetic(std::uint32_t pc, Operator op, Operand rhs, bool integer_only);
+    void integer_arithmetic(Operator op, Label fail);
+    void float_arithmetic(Operator op, Label fail, bool guarded = true);
+    void typed_float(std::uint32_t pc, Operator op, Operand rhs);
+    void equality(std::uint32_t pc, Operand rhs, bool negated);
+    void branch_on(std::uint32_t pc);
+    void truthiness(Cond falsy_or_truthy, Label target);
+    void helper(std::uint32_t pc, const void *function, Extra extra);
+};
+
+bool Translator::translate(Code &code)
+{
+    const bytecode::Span<Instruction> words = function.code;
+    labels.resize(words.size());
+    exits.assign(words.size(), Assembler::UNBOUND);
+    jumped.assign(words.size(), false);
+    emitted.assign(words.size(), false);
+    folded.assign(words.size(), false);
+    for (Label &label : labels)
+        label = as.make_label();
+    for (std::uint32_t pc = 0; pc < words.size();
+         pc += bytecode::length_of(bytecode::op_of(words[pc])))
+    {
+        const Instruction word = words[pc];
+        switch (bytecode::op_of(word))
+        {
+        case Opcode::JMP:
+            jumped[pc + 1 + bytecode::sj_of(word)] = true;
+            break;
+        case Opcode::JMPIF:
+        case Opcode::JMPIFNOT:
+            jumped[pc + 1 + bytecode::sbx_of(word)] = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // entry: save what the templates use, pin the frame and jump to the target
+    as.push(Reg::RBP);
+    as.push(BASE);
+    as.push(CONSTANTS);
+    as.push(GLOBALS);
+    as.push(VM);
+    as.push(Reg::R15);
+    as.alu(Alu::SUB, Reg::RSP, 8); // keeps calls to the helpers 16-byte aligned
+    as.mov(BASE, Reg::RDI);
+    as.mov(CONSTANTS, Reg::RSI);
+    as.mov(GLOBALS, Reg::RDX);
+    as.mov(VM, Reg::R8);
+    as.jmp(Reg::RCX);
+
+    epilogue = as.make_label();
+    for (std::uint32_t pc = 0; pc < words.size();
+         pc += bytecode::length_of(bytecode::op_of(words[pc])))
+    {
+        instruction(pc);
+    }
+
+    // exits: the pc to continue with in eax
+    for (std::uint32_t pc = 0; pc < words.size(); ++pc)
+    {
+        if (exits[pc] == Assembler::UNBOUND)
+            continue;
+        as.bind(exits[pc]);
+        as.mov(Reg::RAX, std::uint64_t{pc});
+        as.jmp(epilogue);
+    }
+    as.bind(epilogue);
+    as.alu(Alu::ADD, Reg::RSP, 8);
+    as.pop(Reg::R15);
+    as.pop(VM);
+    as.pop(GLOBALS);
+    as.pop(CONSTANTS);
+    as.pop(BASE);
+    as.pop(Reg::RBP);
+    as.ret();
+    if (!as.resolve())
+        return false;
+
+    const std::uint8_t *start = vm.jit.buffer.add(as.code);
+    if (start == nullptr)
+        return false;
+    code.entry = reinterpret_cast<Entry>(const_cast<std::uint8_t *>(start));
+    code.targets.assign(words.size(), nullptr);
+    for (std::uint32_t pc = 0; pc < words.size(); ++pc)
+        if (emitted[pc])
+            code.targets[pc] = start + as.labels[labels[pc]];
+    return true;
+}
+
+Label Translator::exit(const std::uint32_t pc)
+{
+    if (exits[pc] == Assembler::UNBOUND)
+        exits[pc] = as.make_label();
+    return exits[pc];
+}
+
+Label Translator::jump_target(const std::uint32_t pc, const std::int32_t offset)
+{
+    return labels[static_cast<std::uint32_t>(static_cast<std::int64_t>(pc) + 1 + offset)];
+}
+
+void Translator::load(const Reg reg, const unsigned index)
+{
+    as.mov(reg, BASE, slot(index));
+}
+
+void Translator::store(const unsigned index, const Reg reg)
+{
+    as.mov(BASE, slot(index), reg);
+}
+
+void Translator::load_operand(const Reg reg, const Operand operand)
+{
+    if (inline_int(operand))
+        as.mov(reg, Value::int_value(function.constants[operand.index].integer()).bits);
+    else if (operand.constant)
+        as.mov(reg, CONSTANTS, slot(operand.index));
+    else
+        load(reg, operand.index);
+}
+
+// a constant that is known to be an inline int needs no guard
+bool Translator::inline_int(const Operand operand) const
+{
+    return operand.constant &&
+           function.constants[operand.index].kind == bytecode::ConstantKind::INTEGER &&
+           Value::fits_int(function.constants[operand.index].integer());
+}
+
+void Translator::guard_int(const Reg reg, const Label fail)
+{
+    as.mov(Reg::R8, reg);
+    as.shr(Reg::R8, 48);
+    as.alu(Alu::CMP, Reg::R8, static_cast<std::int32_t>(Value::INT_TAG >> 48));
+    as.jcc(Cond::NE, fail);
+}
+
+void Translator::guard_float(const Reg reg, const Label fail)
+{
+    as.mov(Reg::R8, Value::QNAN);
+    as.mov(Reg::R9, reg);
+    as.alu(Alu::AND, Reg::R9, Reg::R8);
+    as.alu(Alu::CMP, Reg::R9, Reg::R8);
+    as.jcc(Cond::E, fail);
+}
+
+// a result scaled by 2^16 (see fast_integer in the interpreter) to an int value
+void Translator::tag_int(const Reg reg)
+{
+    as.shr(reg, 16);
+    as.mov(Reg::R9, Value::INT_TAG);
+    as.alu(Alu::OR, reg, Reg::R9);
+}
+
+// rax = the bool value of `condition`, which holds 0 or 1 and is left as it is
+void Translator::boolean(const Reg condition)
+{
+    as.mov(Reg::RAX, Value::FALSE_BITS);
+    as.alu(Alu::OR, Reg::RAX, condition);
+}
+
+void Translator::call(const void *helper)
+{
+    as.mov(Reg::RAX, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(helper)));
+    as.call(Reg::RAX);
+}
+
+void Translator::instruction(const std::uint32_t pc)
+{
+    const Instruction word = function.code[pc];
+    const Opcode      op   = bytecode::first_of(bytecode::op_of(word));
+    const unsigned    a    = bytecode::a_of(word);
+    const unsigned    b    = bytecode::b_of(word);
+    const unsigned    c    = bytecode::c_of(word);
+    const Operand     rc   = {false, c};
+    const Operand     kc   = {true, c};
+
+    if (folded[pc])
+        return;
+    as.bind(labels[pc]);
+    emitted[pc] = true;
+    switch (op)
+    {
+    case Opcode::NOP:
+        break;
+    case Opcode::MOVE:
+        load(Reg::RAX, b);
+        store(a, Reg::RAX);
+        break;
+    case Opcode::LOADK:
+        as.mov(Reg::RAX, CONSTANTS, slot(bytecode::bx_of(word)));
+        store(a, Reg::RAX);
+        break;
+    case Opcode::LOADNIL:
+        as.mov(Reg::RAX, Value::NIL);
+        store(a, Reg::RAX);
+        break;
+    case Opcode::LOADBOOL:
+        as.mov(Reg::RAX, Value::boolean_value(b != 0).bits);
+        store(a, Reg::RAX);
+        break;
+    case Opcode::GETGLOBAL:
+        as.mov(Reg::RAX, GLOBALS, slot(bytecode::bx_of(word)));
+        store(a, Reg::RAX);
+        break;
+    case Opcode::SETGLOBAL:
+        load(Reg::RAX, a);
+        as.mov(GLOBALS, slot(bytecode::bx_of(word)), Reg::RAX);
+        break;
+
+    case Opcode::ADD:
+        arithmetic(pc, Operator::ADD, rc, false);
+        break;
+    case Opcode::SUB:
+        arithmetic(pc, Operator::SUB, rc, false);
+        break;
+    case Opcode::MUL:
+        arithmetic(pc, Operator::MUL, rc, false);
+        break;
+    case Opcode::DIV:
+        arithmetic(pc, Operator::DIV, rc, false);
+        break;
+    case Opcode::MOD:
+        arithmetic(pc, Operator::MOD, rc, false);
+        break;
+    case Opcode::LT:
+        arithmetic(pc, Operator::LT, rc, false);
+        break;
+    case Opcode::LE:
+        arithmetic(pc, Operator::LE, rc, false);
+        break;
+    case Opcode::ADDK:
+        arithmetic(pc, Operator::ADD, kc, false);
+        break;
+    case Opcode::SUBK:
+        arithmetic(pc, Operator::SUB, kc, false);
+        break;
+    case Opcode::MULK:
+        arithmetic(pc, Operator::MUL, kc, false);
+        break;
+    case Opcode::DIVK:
+        arithmetic(pc, Operator::DIV, kc, false);
+        break;
+    case Opcode::MODK:
+        arithmetic(pc, Operator::MOD, kc, false);
+        break;
+    case Opcode::LTK:
+        arithmetic(pc, Operator::LT, kc, false);
+        break;
+    case Opcode::LEK:
+        arithmetic(pc, Operator::LE, kc, false);
+        break;
+    case Opcode::GTK:
+        arithmetic(pc, Operator::GT, kc, false);
+        break;
+    case Opcode::GEK:
+        arithmetic(pc, Operator::GE, kc, false);
+        break;
+    case Opcode::ADD_I64:
+        arithmetic(pc, Operator::ADD, rc, true);
+        break;
+    case Opcode::SUB_I64:
+        arithmetic(pc, Operator::SUB, rc, true);
+        break;
+    case Opcode::MUL_I64:
+        arithmetic(pc, Operator::MUL, rc, true);
+        break;
+    case Opcode::DIV_I64:
+        arithmetic(pc, Operator::DIV, rc, true);
+        break;
+    case Opcode::MOD_I64:
+        arithmetic(pc, Operator::MOD, rc, true);
+        break;
+    case Opcode::LT_I64:
+        arithmetic(pc, Operator::LT, rc, true);
+        break;
+    case Opcode::LE_I64:
+        arithmetic(pc, Operator::LE, rc, true);
+        break;
+    case Opcode::ADDK_I64:
+        arithmetic(pc, Operator::ADD, kc, true);
+        break;
+    case Opcode::SUBK_I64:
+        arithmetic(pc, Operator::SUB, kc, true);
+        break;
+    case Opcode::MULK_I64:
+        arithmetic(pc, Operator::MUL, kc, true);
+        break;
+    case Opcode::DIVK_I64:
+        arithmetic(pc, Operator::DIV, kc, true);
+        break;
+    case Opcode::MODK_I64:
+        arithmetic(pc, Operator::MOD, kc, true);
+        break;
+    case Opcode::LTK_I64:
+        arithmetic(pc, Operator::LT, kc, true);
+        break;
+    case Opcode::LEK_I64:
+        arithmetic(pc, Operator::LE, kc, true);
+        break;
+    case Opcode::GTK_I64:
+        arithmetic(pc, Operator::GT, kc, true);
+        break;
+    case Opcode::GEK_I64:
+        arithmetic(pc, Operator::GE, kc, true);
+        break;
+    case Opcode::ADD_F64:
+        typed_float(pc, Operator::ADD, rc);
+        break;
+    case Opcode::SUB_F64:
+        typed_float(pc, Operator::SUB, rc);
+        break;
+    case Opcode::MUL_F64:
+        typed_float(pc, Operator::MUL, rc);
+        break;
+    case Opcode::DIV_F64:
+        typed_float(pc, Operator::DIV, rc);
+        break;
+    case Opcode::LT_F64:
+        typed_float(pc, Operator::LT, rc);
+        break;
+    case Opcode::LE_F64:
+        typed_float(pc, Operator::LE, rc);
+        break;
+    case Opcode::ADDK_F64:
+        typed_float(pc, Operator::ADD, kc);
+        break;
+    case Opcode::SUBK_F64:
+        typed_float(pc, Operator::SUB, kc);
+        break;
+    case Opcode::MULK_F64:
+        typed_float(pc, Operator::MUL, kc);
+        break;
+    case Opcode::DIVK_F64:
+        typed_float(pc, Operator::DIV, kc);
+        break;
+    case Opcode::LTK_F64:
+        typed_float(pc, Operator::LT, kc);
+        break;
+    case Opcode::LEK_F64:
+        typed_float(pc, Operator::LE, kc);
+        break;
+    case Opcode::GTK_F64:
+        typed_float(pc, Operator::GT, kc);
+        break;
+    case Opcode::GEK_F64:
+        typed_float(pc, Operator::GE, kc);
+        break;
+    case Opcode::CONCAT_STR:
+    case Opcode::CONCATK_STR:
+        helper(pc, reinterpret_cast<const void *>(&concat), Extra::CONSTANTS);
+        break;
+    case Opcode::EQ:
+        equality(pc, rc, false);
+        break;
+    case Opcode::NE:
+        equality(pc, rc, true);
+        break;
+    case Opcode::EQK:
+        equality(pc, kc, false);
+        break;
+    case Opcode::NEK:
+        equality(pc, kc, true);
+        break;
+
+    case Opcode::NEG:
+        load(Reg::RAX, b);
+        guard_int(Reg::RAX, exit(pc));
+        as.shl(Reg::RAX, 16);
+        as.neg(Reg::RAX);
+        as.jcc(Cond::O, exit(pc));
+        tag_int(Reg::RAX);
+        store(a, Reg::RAX);
+        break;
+    case Opcode::NOT:
+        load(Reg::RAX, b);
+        as.mov(Reg::R8, Value::NIL);
+        as.alu(Alu::SUB, Reg::RAX, Reg::R8);
+        as.alu(Alu::CMP, Reg::RAX, static_cast<std::int32_t>(Value::FALSE_BITS - Value::NIL));
+        as.setcc(Cond::BE, Reg::RDX);
+        as.movzx8(Reg::RDX, Reg::RDX);
+        boolean(Reg::RDX);
+        store(a, Reg::RAX);
+        break;
+
+    case Opcode::JMP:
+        as.jmp(jump_target(pc, bytecode::sj_of(word)));
+        break;
+    case Opcode::JMPIF:
+        load(Reg::RAX, a);
+        truthiness(Cond::A, jump_target(pc, bytecode::sbx_of(word)));
+        break;
+    case Opcode::JMPIFNOT:
+        load(Reg::RAX, a);
+        truthiness(Cond::BE, jump_target(pc, bytecode::sbx_of(word)));
+        break;
+
+    case Opcode::GETSLOT:
+        helper(pc, reinterpret_cast<const void *>(&get_slot), Extra::NONE);
+        break;
+    case Opcode::SETSLOT:
+        helper(pc, reinterpret_cast<const void *>(&set_slot), Extra::NONE);
+        break;
+    case Opcode::GETFIELD:
+        helper(pc, reinterpret_cast<const void *>(&get_field), Extra::SITE);
+        break;
+    case Opcode::SETFIELD:
+        helper(pc, reinterpret_cast<const void *>(&set_field), Extra::SITE);
+        break;
+    case Opcode::PRINT:
+        as.mov(Reg::RDI, VM);
+        load(Reg::RSI, a);
+        call(reinterpret_cast<const void *>(&print));
+        break;
+
+    // the interpreter makes calls and returns, native code is entered again after a call
+    default:
+        as.jmp(exit(pc));
+        break;
+    }
+}
+
+/* Operands in rax and rcx. Ints take the same fast path as fast_integer in the interpreter,
+ * two floats the one of fast_number (not for the *_I64 forms), anything else leaves.
+ */
+void Translator::arithmetic(const std::uint32_t pc, const Operator op, const Operand rhs,
+                            const bool integer_only)
+{
+    const Instruction word   = function.code[pc];
+    const Label       fail   = exit(pc);
+    const Label       floats = integer_only ? fail : as.make_label();
+    const Label       done   = as.make_label();
+    load(Reg::RAX, bytecode::b_of(word));
+    load_operand(Reg::RCX, rhs);
+    guard_int(Reg::RAX, floats);
+    if (!inline_int(rhs))
+        guard_int(Reg::RCX, floats);
+    integer_arithmetic(op, fail);
+    if (!integer_only)
+    {
+        as.jmp(done);
+        as.bind(floats);
+        float_arithmetic(op, fail);
+    }
+    as.bind(done);
+    store(bytecode::a_of(word), Reg::RAX);
+    if (op >= Operator::LT)
+        branch_on(pc);
+}
+
+void Translator::integer_arithmetic(const Operator op, const Label fail)
+{
+    switch (op)
+    {
+    case Operator::ADD:
+    case Operator::SUB:
+        as.shl(Reg::RAX, 16);
+        as.shl(Reg::RCX, 16);
+        as.alu(op == Operator::ADD ? Alu::ADD : Alu::SUB, Reg::RAX, Reg::RCX);
+        as.jcc(Cond::O, fail);
+        tag_int(Reg::RAX);
+        break;
+    case Operator::MUL:
+        as.shl(Reg::RAX, 16);
+        as.shl(Reg::RCX, 16);
+        as.sar(Reg::RCX, 16);
+        as.imul(Reg::RAX, Reg::RCX);
+        as.jcc(Cond::O, fail);
+        tag_int(Reg::RAX);
+        break;
+    case Operator::DIV:
+    case Operator::MOD:
+        as.shl(Reg::RAX, 16);
+        as.sar(Reg::RAX, 16);
+        as.shl(Reg::RCX, 16);
+        as.sar(Reg::RCX, 16);
+        as.test(Reg::RCX, Reg::RCX);
+        as.jcc(Cond::E, fail);
+        as.cqo();
+        as.idiv(Reg::RCX);
+        if (op == Operator::MOD)
+            as.mov(Reg::RAX, Reg::RDX);
+        // the quotient of the smallest int by -1 does not fit inline
+        as.mov(Reg::R8, Reg::RAX);
+        as.shl(Reg::R8, 16);
+        as.sar(Reg::R8, 16);
+        as.alu(Alu::CMP, Reg::R8, Reg::RAX);
+        as.jcc(Cond::NE, fail);
+        as.shl(Reg::RAX, 16);
+        tag_int(Reg::RAX);
+        break;
+    case Operator::POW:
+        as.jmp(fail);
+        break;
+    case Operator::LT:
+    case Operator::LE:
+    case Operator::GT:
+    case Operator::GE:
+    {
+        static constexpr Cond conditions[] = {Cond::L, Cond::LE, Cond::G, Cond::GE};
+        as.shl(Reg::RAX, 16);
+        as.shl(Reg::RCX, 16);
+        as.alu(Alu::CMP, Reg::RAX, Reg::RCX);
+        as.setcc(conditions[static_cast<int>(op) - static_cast<int>(Operator::LT)], Reg::RDX);
+        as.movzx8(Reg::RDX, Reg::RDX);
+        boolean(Reg::RDX);
+        break;
+    }
+    }
+}
+
+void Translator::float_arithmetic(const Operator op, const Label fail, const bool guarded)
+{
+    if (guarded)
+    {
+        guard_float(Reg::RAX, fail);
+        guard_float(Reg::RCX, fail);
+    }
+    as.movq(Xmm::XMM0, Reg::RAX);
+    as.movq(Xmm::XMM1, Reg::RCX);
+    switch (op)
+    {
+    case Operator::ADD:
+    case Operator::SUB:
+    case Operator::MUL:
+    case Operator::DIV:
+    {
+        static constexpr SseOp operations[] = {SseOp::ADD, SseOp::SUB, SseOp::MUL, SseOp::DIV};
+        as.sse(operations[static_cast<int>(op)], Xmm::XMM0, Xmm::XMM1);
+        as.movq(Reg::RAX, Xmm::XMM0);
+        // NaN results are canonicalized, as Value::float_value does
+        const Label ordered = as.make_label();
+        as.ucomisd(Xmm::XMM0, Xmm::XMM0);
+        as.jcc(Cond::NP, ordered);
+        as.mov(Reg::RAX, Value::CANONICAL_NAN);
+        as.bind(ordered);
+        break;
+    }
+    case Operator::MOD:
+    case Operator::POW:
+        as.jmp(fail);
+        break;
+    case Operator::LT:
+    case Operator::LE:
+    case Operator::GT:
+    case Operator::GE:
+        // unordered sets CF, so "above" is false for NaN either way round
+        if (op == Operator::LT || op == Operator::LE)
+            as.ucomisd(Xmm::XMM1, Xmm::XMM0);
+        else
+            as.ucomisd(Xmm::XMM0, Xmm::XMM1);
+        as.setcc(op == Operator::LT || op == Operator::GT ? Cond::A : Cond::AE, Reg::RDX);
+        as.movzx8(Reg::RDX, Reg::RDX);
+        boolean(Reg::RDX);
+        break;
+    }
+}
+
+// the *_F64 forms, whose operands the compiler proved floats, never leave
+void Translator::typed_float(const std::uint32_t pc, const Operator op, const Operand rhs)
+{
+    const Instruction word = function.code[pc];
+    load(Reg::RAX, bytecode::b_of(word));
+    load_operand(Reg::RCX, rhs);
+    float_arithmetic(op, exit(pc), false);
+    store(bytecode::a_of(word), Reg::RAX);
+    if (op >= Operator::LT)
+        branch_on(pc);
+}
+
+// two ints are equal when their bits are, anything else asks Interpreter::equal
+void Translator::equality(const std::uint32_t pc, const Operand rhs, const bool negated)
+{
+    const Instruction word  = function.code[pc];
+    const Label       slow  = as.make_label();
+    const Label       done  = as.make_label();
+    load(Reg::RAX, bytecode::b_of(word));
+    load_operand(Reg::RCX, rhs);
+    guard_int(Reg::RAX, slow);
+    if (!inline_int(rhs))
+        guard_int(Reg::RCX, slow);
+    as.alu(Alu::CMP, Reg::RAX, Reg::RCX);
+    as.setcc(negated ? Cond::NE : Cond::E, Reg::RDX);
+    as.movzx8(Reg::RDX, Reg::RDX);
+    as.jmp(done);
+
+    as.bind(slow);
+    as.mov(Reg::RDI, Reg::RAX);
+    as.mov(Reg::RSI, Reg::RCX);
+    call(reinterpret_cast<const void *>(&equal));
+    as.movzx8(Reg::RDX, Reg::RAX);
+    if (negated)
+        as.alu(Alu::XOR, Reg::RDX, 1);
+
+    as.bind(done);
+    boolean(Reg::RDX);
+    store(bytecode::a_of(word), Reg::RAX);
+    branch_on(pc);
+}
+
+// a comparison left its truth (0 or 1) in rdx, a branch on its result right after it is folded
+// in unless something jumps to the branch
+void Translator::branch_on(const std::uint32_t pc)
+{
+    const std::uint32_t next = pc + 1;
+    if (next >= function.code.size() || jumped[next])
+        return;
+    const Instruction word = function.code[next];
+    const Opcode      op   = bytecode::op_of(word);
+    if ((op != Opcode::JMPIF && op != Opcode::JMPIFNOT) ||
+        bytecode::a_of(word) != bytecode::a_of(function.code[pc]))
+        return;
+    as.test(Reg::RDX, Reg::RDX);
+    as.jcc(op == Opcode::JMPIF ? Cond::NE : Cond::E, jump_target(next, bytecode::sbx_of(word)));
+    folded[next] = true;
+}
+
+// jumps to `target` when the value in rax is truthy (A) or falsy (BE)
+void Translator::truthiness(const Cond cond, const Label target)
+{
+    as.mov(Reg::R8, Value::NIL);
+    as.alu(Alu::SUB, Reg::RAX, Reg::R8);
+    as.alu(Alu::CMP, Reg::RAX, static_cast<std::int32_t>(Value::FALSE_BITS - Value::NIL));
+    as.jcc(cond, target);
+}
+
+void Translator::helper(const std::uint32_t pc, const void *function_, const Extra extra)
+{
+    as.mov(Reg::RDI, VM);
+    as.mov(Reg::RSI, BASE);
+    as.mov(Reg::RDX, std::uint64_t{function.code[pc]});
+    if (extra == Extra::SITE)
+    {
+        runtime::InlineCache *cache = &vm.caches[index][function.code[pc + 1]];
+        as.mov(Reg::RCX, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(cache)));
+    }
+    else if (extra == Extra::CONSTANTS)
+    {
+        as.mov(Reg::RCX, CONSTANTS);
+    }
+    call(function_);
+    as.movzx8(Reg::RAX, Reg::RAX);
+    as.test(Reg::RAX, Reg::RAX);
+    as.jcc(Cond::E, exit(pc));
+}
+} // namespace
+
+void Jit::compile(interpreter::Interpreter &vm, const std::uint32_t function)
+{
+    if (!enabled)
+        return;
+    auto       code = std::make_unique<Code>();
+    Translator translator{vm, vm.views[function], function};
+    if (!translator.translate(*code))
+        return;
+    profiles[function].code = code.get();
+    compiled.push_back(std::move(code));
+}
+#else
+void Jit::compile(interpreter::Interpreter &, std::uint32_t) {}
+#endif
+
+void Jit::deoptimized(Profile &profile)
+{
+    ++deopts;
+    if (++profile.deopts == MAX_DEOPTS)
+    {
+        profile.code = nullptr;
+        ++abandoned;
+    }
+}
+
+void Jit::report(std::ostream &out) const
+{
+    out << "jit: " << compiled.size() << " functions compiled to " << buffer.bytes
+        << " bytes of code, " << loop_entries << " loop entries, " << deopts
+        << " deoptimizations, " << abandoned << " functions given up on\n";
+}
+} // namespace cool::vm::jit
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "code_buffer.hpp"
+#include "runtime/value.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+/* The JIT emits x86-64 code and needs mmap, COOL_JIT=0 (the CMake option of the same name)
+ * leaves it out on platforms that have both.
+ */
+#ifndef COOL_JIT
+#define COOL_JIT 1
+#endif
+#if COOL_JIT && defined(__x86_64__) && defined(__linux__)
+#define COOL_HAS_JIT 1
+#else
+#define COOL_HAS_JIT 0
+#endif
+
+namespace cool::vm::interpreter {
+struct Interpreter;
+}
+
+namespace cool::vm::jit {
+inline constexpr std::uint32_t HOT        = 1000; // calls plus loop back-edges before compiling
+inline constexpr std::uint32_t MAX_DEOPTS = 100;  // deoptimizations before the code is dropped
+
+/* Runs the native code of a function from `target` (the code of one of its instructions)
+ * on the frame's registers until it leaves, and returns the pc of the instruction the
+ * interpreter continues with.
+ */
+using Entry = std::uint32_t (*)(runtime::Value *base, const runtime::Value *constants,
+                                runtime::Value *globals, const std::uint8_t *target,
+                                interpreter::Interpreter *vm);
+
+struct Code
+{
+    Entry                             entry = nullptr;
+    std::vector<const std::uint8_t *> targets; // per pc, nullptr where it cannot be entered
+};
+
+struct Profile
+{
+    std::uint32_t hotness = 0; // saturates at HOT
+    std::uint32_t deopts  = 0;
+    const Code   *code    = nullptr; // until compiled, and again once given up on
+};
+
+/* A baseline compiler: each instruction of a hot function becomes a fixed template of
+ * machine code working on the same registers as the interpreter, so the interpreter can
+ * take over at any instruction without translating state, and native code can take over a
+ * running frame at a loop back-edge the same way. Native code leaves at every call and
+ * return, which the interpreter performs, and enters again when a call returns into it.
+ * Anything the templates do not cover (a failed type guard, an overflow, an operand that
+ * would raise a runtime error) deoptimizes: native code leaves at the instruction and the
+ * interpreter runs it, entering native code again at the next call, return or back-edge.
+ */
+struct Jit
+{
+    bool                               enabled = COOL_HAS_JIT != 0;
+    CodeBuffer                         buffer;
+    std::vector<Profile>               profiles; // per function of the module
+    std::vector<std::unique_ptr<Code>> compiled;
+    std::uint64_t                      loop_entries = 0; // on-stack replacements at a back-edge
+    std::uint64_t                      deopts       = 0;
+    std::uint64_t                      abandoned    = 0;
+
+    // counts a call or a loop back-edge of the function, compiling it once it is hot
+    void count(interpreter::Interpreter &vm, Profile &profile)
+    {
+        if (profile.hotness < HOT && ++profile.hotness == HOT)
+            compile(vm, static_cast<std::uint32_t>(&profile - profiles.data()));
+    }
+
+    void compile(interpreter::Interpreter &vm, std::uint32_t function);
+    void deoptimized(Profile &profile);
+    void report(std::ostream &out) const;
+};
+} // namespace cool::vm::jit
@@ -1,7 +1,164 @@
+#include "bytecode/disassembler.hpp"
+#include "bytecode/image.hpp"
+#include "bytecode/serializer.hpp"
+#include "interpreter/interpreter.hpp"
+#include "interpreter/snapshot.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+// a duration such as `500us`, `1ms` or `0.5s`
+bool parse_duration(const char *text, std::chrono::nanoseconds &duration)
+{
+    char        *unit  = nullptr;
+    const double value = std::strtod(text, &unit);
+    double       scale = 0;
+    if (std::strcmp(unit, "ns") == 0)
+        scale = 1;
+    else if (std::strcmp(unit, "us") == 0)
+        scale = 1e3;
+    else if (std::strcmp(unit, "ms") == 0)
+        scale = 1e6;
+    else if (std::strcmp(unit, "s") == 0)
+        scale = 1e9;
+    if (unit == text || scale == 0 || !(value > 0))
+        return false;
+    duration = std::chrono::nanoseconds{static_cast<std::int64_t>(value * scale)};
+    return true;
+}
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    std::cout << "Hello world \n";
-    return 0;
+    constexpr std::string_view MAX_PAUSE = "--gc-max-pause=";
+
+    bool                     disassemble = false;
+    bool                     gc_stats    = false;
+    bool                     jit         = true;
+    bool                     jit_stats   = false;
+    std::chrono::nanoseconds max_pause{0};
+    const char              *path     = nullptr;
+    const char              *snapshot = nullptr; // written by --snapshot
+    const char              *restore  = nullptr; // read by --from-snapshot
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--disassemble") == 0)
+        {
+            disassemble = true;
+        }
+        else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+        {
+            snapshot = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--from-snapshot") == 0 && i + 1 < argc)
+        {
+            restore = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--gc-stats") == 0)
+        {
+            gc_stats = true;
+        }
+        else if (std::strcmp(argv[i], "--no-jit") == 0)
+        {
+            jit = false;
+        }
+        else if (std::strcmp(argv[i], "--jit-stats") == 0)
+        {
+            jit_stats = true;
+        }
+        else if (std::strncmp(argv[i], MAX_PAUSE.data(), MAX_PAUSE.size()) == 0)
+        {
+            if (!parse_duration(argv[i] + MAX_PAUSE.size(), max_pause))
+            {
+                std::cerr << "Error: invalid pause budget '" << argv[i] + MAX_PAUSE.size()
+                          << "', expected e.g. 500us or 1ms\n";
+                return 1;
+            }
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    // a snapshot carries its module, so it is run on its own
+    if ((path == nullptr) == (restore == nullptr) || (restore != nullptr && disassemble) ||
+        (snapshot != nullptr && disassemble))
+    {
+        std::cerr << "Usage: cool [--disassemble] [--gc-max-pause=<duration>] [--gc-stats] "
+                     "[--no-jit] [--jit-stats] [--snapshot <file.img>] <file.coolb>\n"
+                     "       cool [--gc-max-pause=<duration>] [--gc-stats] [--no-jit] "
+                     "[--jit-stats] --from-snapshot <file.img>\n"
+                     "--gc-max-pause is a target for each collection pause, not a bound\n";
+        return 1;
+    }
+
+    std::string error;
+    if (disassemble)
+    {
+        const auto module = cool::vm::bytecode::read_module(path, error);
+        if (!module)
+        {
+            std::cerr << "Error: " << error << '\n';
+            return 1;
+        }
+        cool::vm::bytecode::disassemble(*module, std::cout);
+        return 0;
+    }
+
+    // functions and classes are verified as the program first reaches them
+    std::optional<cool::vm::interpreter::Snapshot> restored;
+    std::optional<cool::vm::bytecode::Image>       opened;
+    if (restore != nullptr)
+        restored = cool::vm::interpreter::Snapshot::open(restore, error);
+    else
+        opened = cool::vm::bytecode::Image::open(path, error);
+    if (!restored && !opened)
+    {
+        std::cerr << "Error: " << error << '\n';
+        return 1;
+    }
+    const cool::vm::bytecode::Image &image = restored ? restored->image : *opened;
+
+    // the output of the paused run is kept in the snapshot and printed when it is restored
+    std::ostringstream                 output;
+    cool::vm::interpreter::Interpreter interpreter{image, snapshot != nullptr ? output : std::cout};
+    interpreter.heap.max_pause      = max_pause;
+    interpreter.pause_before_output = snapshot != nullptr;
+    // native code runs past a PRINT, so a run that pauses is interpreted
+    interpreter.jit.enabled = interpreter.jit.enabled && jit && snapshot == nullptr;
+
+    cool::vm::interpreter::InterpretResult result;
+    if (restored)
+    {
+        if (!restored->restore(interpreter))
+            return 1;
+        result = interpreter.resume();
+    }
+    else
+    {
+        result = interpreter.run();
+    }
+
+    if (snapshot != nullptr && result == cool::vm::interpreter::InterpretResult::OK)
+    {
+        const std::string_view module{reinterpret_cast<const char *>(image.data), image.size};
+        if (!cool::vm::interpreter::write_snapshot(interpreter, module, output.str(), snapshot))
+        {
+            std::cerr << "Error: cannot write " << snapshot << '\n';
+            return 1;
+        }
+    }
+    if (gc_stats)
+        interpreter.heap.report(std::cerr);
+    if (jit_stats)
+        interpreter.jit.report(std::cerr);
+    return result == cool::vm::interpreter::InterpretResult::OK ? 0 : 70;
 }
@@ -0,0 +1,354 @@
+#include "heap.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+namespace cool::vm::runtime {
+namespace {
+// calls `f` with `object` cast to its dynamic type
+template <typename F>
+auto with_type(Object *object, F &&f)
+{
+    switch (object->type)
+    {
+    case ObjectType::STRING:
+        return f(static_cast<StringObject *>(object));
+    case ObjectType::INTEGER:
+        return f(static_cast<IntegerObject *>(object));
+    case ObjectType::FUNCTION:
+        return f(static_cast<FunctionObject *>(object));
+    case ObjectType::CLASS:
+        return f(static_cast<ClassObject *>(object));
+    case ObjectType::CELL:
+        return f(static_cast<CellObject *>(object));
+    case ObjectType::CLOSURE:
+        return f(static_cast<ClosureObject *>(object));
+    case ObjectType::INSTANCE:
+        break;
+    }
+    return f(static_cast<InstanceObject *>(object));
+}
+
+template <typename T>
+using Pointee = std::remove_pointer_t<T>;
+
+// how many objects are traced or swept between two looks at the clock
+constexpr int CLOCK_INTERVAL = 64;
+} // namespace
+
+Heap::Heap(const std::size_t nursery_size)
+    : nursery{static_cast<std::byte *>(::operator new(nursery_size, std::align_val_t{ALIGNMENT}))},
+      top{nursery}, limit{nursery + nursery_size}, end{nursery + nursery_size}
+{
+}
+
+Heap::~Heap()
+{
+    empty_nursery();
+    ::operator delete(nursery, std::align_val_t{ALIGNMENT});
+
+    for (Object *list : {objects, unswept})
+    {
+        while (list != nullptr)
+        {
+            Object *next = list->next;
+            free(list);
+            list = next;
+        }
+    }
+}
+
+void Heap::visit(StringObject *&string)
+{
+    Value value = Value::object_value(string);
+    visit(value);
+    string = static_cast<StringObject *>(value.as_object());
+}
+
+void Heap::visit(Value &value)
+{
+    if (!value.is_object())
+        return;
+    Object *object = value.as_object();
+    if (phase == Phase::MINOR)
+    {
+        if (is_young(object))
+            value = Value::object_value(promote(object));
+        return;
+    }
+    mark(object);
+}
+
+void Heap::collect()
+{
+    const Clock::time_point start = Clock::now();
+    collect_minor();
+    if (max_pause.count() > 0)
+        resize_nursery(Clock::now() - start);
+
+    if (cycle == Cycle::IDLE && allocated > next_major)
+        begin_major();
+    if (cycle != Cycle::IDLE)
+    {
+        // a cycle that let the old generation grow past twice its trigger runs to the end,
+        // otherwise marking gets what the minor collection left of the budget, if anything
+        const bool              behind   = allocated > 2 * next_major;
+        const Clock::time_point deadline = start + max_pause;
+        if (max_pause.count() == 0 || behind)
+            forced_cycles += step_major(Clock::time_point::max()) && max_pause.count() > 0;
+        else if (Clock::now() < deadline)
+            step_major(deadline);
+    }
+
+    const Clock::duration pause = Clock::now() - start;
+    pauses.record(pause);
+    if (max_pause.count() > 0 && pause > max_pause)
+        long_pauses++;
+}
+
+/* Sizes the nursery for the next minor collection to take half the pause budget, the other
+ * half is for marking. Taking its pause to grow with the part of the nursery in use, that
+ * part shrinks in proportion to how far the last one overran, and doubles back while they
+ * are short.
+ */
+void Heap::resize_nursery(const std::chrono::nanoseconds minor_pause)
+{
+    const auto size     = static_cast<std::size_t>(limit - nursery);
+    const auto capacity = static_cast<std::size_t>(end - nursery);
+    const auto target   = max_pause / 2;
+    if (minor_pause > target)
+    {
+        const double scaled = static_cast<double>(size) * static_cast<double>(target.count()) /
+                              static_cast<double>(minor_pause.count());
+        const std::size_t wanted = std::max(MIN_NURSERY_SIZE, static_cast<std::size_t>(scaled));
+        limit = nursery + std::min(align(wanted), capacity);
+    }
+    else if (minor_pause < max_pause / 8 && size < capacity)
+    {
+        limit = nursery + std::min(size * 2, capacity);
+    }
+}
+
+void Heap::collect_minor()
+{
+    phase = Phase::MINOR;
+    roots();
+    for (Object *object : remembered)
+    {
+        object->flags &= ~Object::REMEMBERED;
+        trace(object);
+    }
+    remembered.clear();
+    while (!promoted.empty())
+    {
+        Object *object = promoted.back();
+        promoted.pop_back();
+        trace(object);
+    }
+
+    empty_nursery();
+    phase = Phase::IDLE;
+    minor_collections++;
+}
+
+// runs right after a minor collection, so the snapshot of the roots only holds old objects
+void Heap::begin_major()
+{
+    cycle = Cycle::MARKING;
+    phase = Phase::MAJOR;
+    roots();
+    phase = Phase::IDLE;
+}
+
+// advances the major collection until `deadline`, true once the cycle is complete
+bool Heap::step_major(const Clock::time_point deadline)
+{
+    if (cycle == Cycle::MARKING)
+    {
+        phase           = Phase::MAJOR;
+        const bool done = drain(deadline);
+        phase           = Phase::IDLE;
+        if (!done)
+            return false;
+
+        // survivors are linked back into `objects` as the sweep reaches them
+        cycle   = Cycle::SWEEPING;
+        unswept = objects;
+        objects = nullptr;
+    }
+    if (!sweep(deadline))
+        return false;
+
+    cycle      = Cycle::IDLE;
+    next_major = std::max(MIN_MAJOR_THRESHOLD, allocated * 2);
+    major_collections++;
+    return true;
+}
+
+void Heap::report(std::ostream &out) const
+{
+    out << "gc: " << minor_collections << " minor and " << major_collections
+        << " major collections (" << forced_cycles << " finished over the budget), "
+        << long_pauses << " pauses over the budget, " << allocated
+        << " bytes in the old generation\n";
+    pauses.report(out);
+}
+
+// after a minor collection only garbage and the moved-from survivors are left to destroy
+void Heap::empty_nursery()
+{
+    for (std::byte *address = nursery; address < top;)
+    {
+        address += with_type(reinterpret_cast<Object *>(address), [](auto *object) {
+            using T                = Pointee<decltype(object)>;
+            const std::size_t size = size_of(object);
+            object->~T();
+            return align(size);
+        });
+    }
+    top = nursery;
+}
+
+// allocated while marking means allocated black, the sweep that follows keeps it
+void Heap::tenure(Object *object, const std::size_t size)
+{
+    if (cycle == Cycle::MARKING)
+        object->flags |= Object::MARKED;
+    object->next = objects;
+    objects      = object;
+    allocated += size;
+}
+
+Object *Heap::promote(Object *object)
+{
+    if ((object->flags & Object::FORWARDED) != 0)
+        return object->next;
+
+    Object *copy = with_type(object, [this](auto *young) -> Object * {
+        using T                = Pointee<decltype(young)>;
+        const std::size_t size = size_of(young);
+        auto             *old  = new (::operator new(size)) T(std::move(*young));
+        std::memcpy(reinterpret_cast<std::byte *>(old) + sizeof(T),
+                    reinterpret_cast<const std::byte *>(young) + sizeof(T), size - sizeof(T));
+        old->flags = 0;
+        tenure(old, size);
+        return old;
+    });
+    object->flags |= Object::FORWARDED;
+    object->next = copy;
+    if (copy->type == ObjectType::INSTANCE || copy->type == ObjectType::CELL ||
+        copy->type == ObjectType::CLOSURE ||
+        (copy->type == ObjectType::STRING && static_cast<StringObject *>(copy)->is_rope()))
+        promoted.push_back(copy);
+    return copy;
+}
+
+// young objects are left to minor collections, anything old they reach was reachable at the
+// snapshot
+void Heap::mark(Object *object)
+{
+    if (object == nullptr || (object->flags & Object::MARKED) != 0 || is_young(object))
+        return;
+    object->flags |= Object::MARKED;
+    gray.push_back(object);
+}
+
+// visits the references held by `object`, the raw pointers only matter to a major collection
+void Heap::trace(Object *object)
+{
+    const bool major = phase == Phase::MAJOR;
+    switch (object->type)
+    {
+    case ObjectType::INSTANCE: {
+        auto *instance = static_cast<InstanceObject *>(object);
+        if (major)
+            mark(instance->klass);
+        Value *fields = instance->fields();
+        for (std::uint32_t slot = 0; slot < instance->field_count; ++slot)
+            visit(fields[slot]);
+        break;
+    }
+    case ObjectType::CELL:
+        visit(static_cast<CellObject *>(object)->value);
+        break;
+    case ObjectType::CLOSURE: {
+        auto *closure = static_cast<ClosureObject *>(object);
+        if (major)
+            mark(closure->function);
+        Value *upvalues = closure->upvalues();
+        for (std::uint32_t index = 0; index < closure->upvalue_count; ++index)
+            visit(upvalues[index]);
+        break;
+    }
+    case ObjectType::CLASS: {
+        auto *klass = static_cast<ClassObject *>(object);
+        if (!major)
+            break;
+        mark(klass->parent);
+        mark(klass->initializer);
+        mark(klass->init);
+        for (FunctionObject *method : klass->vtable)
+            mark(method);
+        break;
+    }
+    case ObjectType::STRING: {
+        auto *string = static_cast<StringObject *>(object);
+        if (!string->is_rope())
+            break;
+        visit(string->left);
+        visit(string->right);
+        break;
+    }
+    case ObjectType::INTEGER:
+    case ObjectType::FUNCTION:
+        break;
+    }
+}
+
+bool Heap::drain(const Clock::time_point deadline)
+{
+    for (int traced = 1; !gray.empty(); ++traced)
+    {
+        Object *object = gray.back();
+        gray.pop_back();
+        trace(object);
+        if (traced % CLOCK_INTERVAL == 0 && Clock::now() >= deadline)
+            return gray.empty();
+    }
+    return true;
+}
+
+bool Heap::sweep(const Clock::time_point deadline)
+{
+    for (int swept = 1; unswept != nullptr; ++swept)
+    {
+        Object *object = unswept;
+        unswept        = object->next;
+        if ((object->flags & Object::MARKED) != 0)
+        {
+            object->flags &= ~Object::MARKED;
+            object->next = objects;
+            objects      = object;
+        }
+        else
+        {
+            allocated -= with_type(object, [](auto *typed) { return size_of(typed); });
+            free(object);
+        }
+        if (swept % CLOCK_INTERVAL == 0 && Clock::now() >= deadline)
+            return unswept == nullptr;
+    }
+    return true;
+}
+
+void Heap::free(Object *object)
+{
+    with_type(object, [](auto *typed) {
+        using T = Pointee<decltype(typed)>;
+        typed->~T();
+        ::operator delete(typed);
+    });
+}
+} // namespace cool::vm::runtime
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "object.hpp"
+#include "pause_histogram.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cool::vm::runtime {
+/* A generational heap. New objects are bump allocated in a fixed nursery; a minor
+ * collection copies the survivors out into the old generation (everything that survives
+ * one collection is promoted) and empties the nursery in one step. Old objects are
+ * allocated individually, chained through `next`, and reclaimed by mark-sweep once the old
+ * generation has doubled since the last major collection.
+ *
+ * With a pause budget the major collection is incremental: it snapshots the roots right
+ * after a minor collection (when every live object is old) and then marks and sweeps in
+ * slices that share the budget with the minor collection they follow. The write barrier
+ * shades the value a field store overwrites (snapshot at the beginning), and objects
+ * promoted while marking are allocated black, so everything reachable at the snapshot
+ * survives the cycle. The usable part of the nursery shrinks while minor collections take
+ * more than half the budget, and a cycle that falls far behind the promotion rate is
+ * finished in one pause rather than letting the old generation grow without bound.
+ *
+ * Objects only move during a minor collection, so a raw pointer to a young object is
+ * stale after any allocation: the mutator keeps its references in values the `roots`
+ * callback visits, and reports old-to-young references through the write barrier.
+ * Objects referenced by raw pointer fields (classes, functions) are always tenured.
+ *
+ * An object may be followed by data of its own (the fields of an instance), size_of gives
+ * the whole size, which is what the heap allocates, copies and accounts for.
+ */
+struct Heap
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase : std::uint8_t { IDLE, MINOR, MAJOR }; // what visit() does
+    enum class Cycle : std::uint8_t { IDLE, MARKING, SWEEPING };
+
+    static constexpr std::size_t DEFAULT_NURSERY_SIZE = 1 << 20;
+    static constexpr std::size_t MIN_NURSERY_SIZE     = 1 << 16;
+    static constexpr std::size_t MIN_MAJOR_THRESHOLD  = 1 << 22;
+    static constexpr std::size_t ALIGNMENT            = alignof(std::max_align_t);
+
+    std::byte               *nursery = nullptr;
+    std::byte               *top     = nullptr;
+    std::byte               *limit   = nullptr; // end of the part of the nursery in use
+    std::byte               *end     = nullptr;
+    Object                  *objects    = nullptr; // the old generation
+    Object                  *unswept    = nullptr; // old objects the running sweep has not seen
+    std::size_t              allocated  = 0;       // bytes in the old generation
+    std::size_t              next_major = MIN_MAJOR_THRESHOLD;
+    std::vector<Object *>    remembered; // old objects that may point into the nursery
+    std::vector<Object *>    promoted;   // promoted objects left to scan by a minor collection
+    std::vector<Object *>    gray;       // marked old objects left to trace
+    Phase                    phase = Phase::IDLE;
+    Cycle                    cycle = Cycle::IDLE;
+    std::chrono::nanoseconds max_pause{0}; // a target, 0 runs a major cycle in one pause
+    std::function<void()>    roots;        // passes every root value to visit()
+    std::size_t              minor_collections = 0;
+    std::size_t              major_collections = 0;
+    std::size_t              forced_cycles     = 0; // finished over the budget
+    std::size_t              long_pauses       = 0; // longer than max_pause
+    PauseHistogram           pauses;
+
+    explicit Heap(std::size_t nursery_size = DEFAULT_NURSERY_SIZE);
+    Heap(const Heap &)            = delete;
+    Heap &operator=(const Heap &) = delete;
+    ~Heap();
+
+    static constexpr std::size_t align(const std::size_t size)
+    {
+        return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    template <typename T, typename... Args>
+    T *make(Args &&...args)
+    {
+        return make_sized<T>(sizeof(T), std::forward<Args>(args)...);
+    }
+
+    // `size` covers the object and the data that follows it (see size_of)
+    template <typename T, typename... Args>
+    T *make_sized(const std::size_t size, Args &&...args)
+    {
+        const std::size_t aligned = align(size);
+        if (static_cast<std::size_t>(limit - top) < aligned)
+        {
+            collect();
+            if (static_cast<std::size_t>(limit - top) < aligned) // larger than the nursery
+                return make_tenured_sized<T>(size, std::forward<Args>(args)...);
+        }
+        T *object = new (top) T(std::forward<Args>(args)...);
+        top += aligned;
+        return object;
+    }
+
+    // objects that live as long as the module, like its strings, functions and classes
+    template <typename T, typename... Args>
+    T *make_tenured(Args &&...args)
+    {
+        return make_tenured_sized<T>(sizeof(T), std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename... Args>
+    T *make_tenured_sized(const std::size_t size, Args &&...args)
+    {
+        T *object = new (::operator new(size)) T(std::forward<Args>(args)...);
+        tenure(object, size);
+        return object;
+    }
+
+    [[nodiscard]] bool is_young(const Object *object) const
+    {
+        const auto *address = reinterpret_cast<const std::byte *>(object);
+        return address >= nursery && address < end;
+    }
+
+    // called before `value` replaces `previous` in a field of `object`
+    void write_barrier(Object *object, const Value previous, const Value value)
+    {
+        if (cycle == Cycle::MARKING && previous.is_object())
+            mark(previous.as_object());
+        if (value.is_object() && is_young(value.as_object()) && !is_young(object) &&
+            (object->flags & Object::REMEMBERED) == 0)
+        {
+            object->flags |= Object::REMEMBERED;
+            remembered.push_back(object);
+        }
+    }
+
+    void visit(Value &value);
+    void visit(StringObject *&string); // the halves of a rope
+    void collect();
+    void collect_minor();
+    void resize_nursery(std::chrono::nanoseconds minor_pause);
+    void begin_major();
+    bool step_major(Clock::time_point deadline);
+    void report(std::ostream &out) const;
+
+    void    empty_nursery();
+    void    tenure(Object *object, std::size_t size);
+    Object *promote(Object *object);
+    void    mark(Object *object);
+    void    trace(Object *object);
+    bool    sweep(Clock::time_point deadline);
+    bool    drain(Clock::time_point deadline);
+
+    static void free(Object *object);
+};
+} // namespace cool::vm::runtime
@@ -0,0 +1,18 @@
+#include "inline_cache.hpp"
+
+namespace cool::vm::runtime {
+bool InlineCache::miss(const ClassObject                                      *klass,
+                       const std::unordered_map<std::uint32_t, std::uint32_t> &slots,
+                       std::uint32_t                                          &slot)
+{
+    const auto it = slots.find(name);
+    if (it == slots.end())
+        return false;
+    slot = it->second;
+    if (count < ENTRIES)
+        entries[count++] = {klass, slot};
+    else
+        megamorphic = true;
+    return true;
+}
+} // namespace cool::vm::runtime
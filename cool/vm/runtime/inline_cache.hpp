@@ -0,0 +1,52 @@
+#pragma once
+
+#include "object.hpp"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace cool::vm::runtime {
+/* The classes a GETFIELD, SETFIELD or INVOKE site has seen, each with the slot of the
+ * site's member in that class (a field slot, or a vtable slot for INVOKE). A site is
+ * monomorphic with one entry and polymorphic up to ENTRIES; past that it is megamorphic
+ * and a class that is not cached is looked up by name every time.
+ */
+struct InlineCache
+{
+    static constexpr int ENTRIES = 4;
+
+    struct Entry
+    {
+        const ClassObject *klass = nullptr;
+        std::uint32_t      slot  = 0;
+    };
+
+    std::array<Entry, ENTRIES> entries{};
+    std::uint32_t              name        = 0; // string index of the member
+    std::uint8_t               count       = 0;
+    bool                       megamorphic = false;
+
+    explicit InlineCache(const std::uint32_t name) : name{name} {}
+
+    // the slot of the member in `klass`, false if the class has no such member
+    bool lookup(const ClassObject                                      *klass,
+                const std::unordered_map<std::uint32_t, std::uint32_t> &slots,
+                std::uint32_t                                          &slot)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (entries[i].klass == klass)
+            {
+                slot = entries[i].slot;
+                return true;
+            }
+        }
+        return miss(klass, slots, slot);
+    }
+
+    // looks the member up by name and caches the class while there is room
+    bool miss(const ClassObject                                      *klass,
+              const std::unordered_map<std::uint32_t, std::uint32_t> &slots, std::uint32_t &slot);
+};
+} // namespace cool::vm::runtime
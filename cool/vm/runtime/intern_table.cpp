@@ -0,0 +1,18 @@
+#include "intern_table.hpp"
+
+namespace cool::vm::runtime {
+StringObject *InternTable::find(const std::string_view value, const std::size_t hash) const
+{
+    const auto [first, last] = strings.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+        if (it->second->value == value)
+            return it->second;
+    return nullptr;
+}
+
+void InternTable::add(StringObject *string)
+{
+    string->interned = true;
+    strings.emplace(string->hash(), string);
+}
+} // namespace cool::vm::runtime
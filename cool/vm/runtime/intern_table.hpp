@@ -0,0 +1,22 @@
+#pragma once
+
+#include "object.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+
+namespace cool::vm::runtime {
+/* The interned strings by content: the string table of the module, which holds the string
+ * literals and member names. Entries are keyed by the strings' cached hashes, so a lookup
+ * hashes its key once and only compares the characters of candidates with the same hash.
+ * Interned strings are tenured and live as long as the interpreter.
+ */
+struct InternTable
+{
+    std::unordered_multimap<std::size_t, StringObject *> strings;
+
+    [[nodiscard]] StringObject *find(std::string_view value, std::size_t hash) const;
+    void                        add(StringObject *string);
+};
+} // namespace cool::vm::runtime
@@ -0,0 +1,63 @@
+#include "object.hpp"
+
+namespace cool::vm::runtime {
+StringObject::StringObject(const Value &left, const Value &right)
+    : Object{TYPE}, left{static_cast<StringObject *>(left.as_object())},
+      right{static_cast<StringObject *>(right.as_object())},
+      length{this->left->length + this->right->length}
+{
+}
+
+/* The halves are only reachable through the node, so dropping them needs no write barrier:
+ * nothing else can come to reference them once the characters are copied out.
+ */
+const std::string &StringObject::flat()
+{
+    if (!is_rope())
+        return value;
+
+    std::string                 result;
+    std::vector<StringObject *> pending{this};
+    result.reserve(length);
+    while (!pending.empty())
+    {
+        StringObject *piece = pending.back();
+        pending.pop_back();
+        if (piece->is_rope())
+        {
+            pending.push_back(piece->right);
+            pending.push_back(piece->left);
+        }
+        else
+        {
+            result += piece->value;
+        }
+    }
+    value = std::move(result);
+    left  = nullptr;
+    right = nullptr;
+    return value;
+}
+
+std::size_t StringObject::hash()
+{
+    if (!hashed)
+    {
+        hash_code = hash_string(flat());
+        hashed    = true;
+    }
+    return hash_code;
+}
+
+// 64-bit FNV-1a
+std::size_t hash_string(const std::string_view value)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (const char c : value)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return static_cast<std::size_t>(hash);
+}
+} // namespace cool::vm::runtime
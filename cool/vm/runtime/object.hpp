@@ -0,0 +1,212 @@
+#pragma once
+
+#include "bytecode/image.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cool::vm::runtime {
+enum class ObjectType : std::uint8_t { STRING, INTEGER, FUNCTION, CLASS, INSTANCE, CELL, CLOSURE };
+
+/* Heap objects start with their type tag and collector flags. Old objects are chained
+ * through `next` so the heap can sweep them, a young object that was copied out of the
+ * nursery keeps its new address there instead.
+ */
+struct Object
+{
+    static constexpr std::uint8_t MARKED     = 1 << 0;
+    static constexpr std::uint8_t REMEMBERED = 1 << 1;
+    static constexpr std::uint8_t FORWARDED  = 1 << 2;
+
+    const ObjectType type;
+    std::uint8_t     flags = 0;
+    Object          *next  = nullptr;
+
+    explicit Object(const ObjectType type) : type{type} {}
+};
+
+/* A flat string or a rope. Concatenating long strings makes a rope node that points at
+ * both halves instead of copying them, and the node is flattened in place the first time
+ * its characters are needed, so building a string piece by piece stays linear. The hash
+ * is computed once. An interned string is the only one with its content, so two interned
+ * strings are equal exactly when they are the same object.
+ */
+struct StringObject : Object
+{
+    static constexpr ObjectType  TYPE     = ObjectType::STRING;
+    static constexpr std::size_t MIN_ROPE = 64; // shorter concatenations are copied
+
+    std::string   value;           // empty while the string is an unflattened rope
+    StringObject *left  = nullptr; // the halves of an unflattened rope
+    StringObject *right = nullptr;
+    std::size_t   length;
+    std::size_t   hash_code = 0;
+    bool          hashed    = false;
+    bool          interned  = false;
+
+    explicit StringObject(std::string value)
+        : Object{TYPE}, value{std::move(value)}, length{this->value.size()}
+    {
+    }
+
+    // the halves are read when the node is constructed, after the allocation that may move them
+    StringObject(const Value &left, const Value &right);
+
+    [[nodiscard]] bool is_rope() const
+    {
+        return left != nullptr;
+    }
+
+    const std::string &flat();
+    std::size_t        hash();
+};
+
+std::size_t hash_string(std::string_view value);
+
+// an integer outside the range Value stores inline
+struct IntegerObject : Object
+{
+    static constexpr ObjectType TYPE = ObjectType::INTEGER;
+    const std::int64_t          value;
+
+    explicit IntegerObject(const std::int64_t value) : Object{TYPE}, value{value} {}
+};
+
+struct FunctionObject : Object
+{
+    static constexpr ObjectType   TYPE = ObjectType::FUNCTION;
+    const bytecode::FunctionView *function;
+    std::string_view              name;
+
+    FunctionObject(const bytecode::FunctionView *function, const std::string_view name)
+        : Object{TYPE}, function{function}, name{name}
+    {
+    }
+};
+
+/* Members are keyed by module string index: names are interned in the string table, so
+ * equal indices mean equal names. The layout is fixed when the class is linked: `fields`
+ * names every instance slot, parent fields first, and `vtable` holds every method of the
+ * chain, an override taking the slot of the method it replaces. A subclass only extends
+ * its parent's layout, so a slot means the same member for the whole subtree.
+ */
+struct ClassObject : Object
+{
+    static constexpr ObjectType                      TYPE = ObjectType::CLASS;
+    std::string_view                                 name;
+    ClassObject                                     *parent      = nullptr;
+    FunctionObject                                  *initializer = nullptr;
+    FunctionObject                                  *init        = nullptr;
+    std::vector<std::uint32_t>                       fields; // name of each slot
+    std::vector<FunctionObject *>                    vtable;
+    std::unordered_map<std::uint32_t, std::uint32_t> field_slots;  // name -> field slot
+    std::unordered_map<std::uint32_t, std::uint32_t> method_slots; // name -> vtable slot
+
+    explicit ClassObject(const std::string_view name) : Object{TYPE}, name{name} {}
+};
+
+// the field values follow the object in memory, one per slot of the class layout
+struct InstanceObject : Object
+{
+    static constexpr ObjectType TYPE = ObjectType::INSTANCE;
+    ClassObject                *klass;
+    const std::uint32_t         field_count;
+
+    explicit InstanceObject(ClassObject *klass)
+        : Object{TYPE}, klass{klass},
+          field_count{static_cast<std::uint32_t>(klass->fields.size())}
+    {
+        std::fill_n(fields(), field_count, Value::nil());
+    }
+
+    Value *fields()
+    {
+        return reinterpret_cast<Value *>(this + 1);
+    }
+
+    [[nodiscard]] const Value *fields() const
+    {
+        return reinterpret_cast<const Value *>(this + 1);
+    }
+
+    static constexpr std::size_t size(const std::uint32_t field_count)
+    {
+        return sizeof(InstanceObject) + field_count * sizeof(Value);
+    }
+};
+
+static_assert(sizeof(InstanceObject) % alignof(Value) == 0);
+
+// a local that closures capture and something assigns, shared by all of them (see BOX)
+struct CellObject : Object
+{
+    static constexpr ObjectType TYPE  = ObjectType::CELL;
+    Value                       value = Value::nil();
+
+    CellObject() : Object{TYPE} {}
+};
+
+/* A function with the values of its upvalues, which follow the object in memory in the
+ * order of the function's descriptors. A boxed local is captured as its cell.
+ */
+struct ClosureObject : Object
+{
+    static constexpr ObjectType TYPE = ObjectType::CLOSURE;
+    FunctionObject             *function; // tenured, like every function
+    const std::uint32_t         upvalue_count;
+
+    ClosureObject(FunctionObject *function, const std::uint32_t upvalue_count)
+        : Object{TYPE}, function{function}, upvalue_count{upvalue_count}
+    {
+        std::fill_n(upvalues(), upvalue_count, Value::nil());
+    }
+
+    Value *upvalues()
+    {
+        return reinterpret_cast<Value *>(this + 1);
+    }
+
+    [[nodiscard]] const Value *upvalues() const
+    {
+        return reinterpret_cast<const Value *>(this + 1);
+    }
+
+    static constexpr std::size_t size(const std::uint32_t upvalue_count)
+    {
+        return sizeof(ClosureObject) + upvalue_count * sizeof(Value);
+    }
+};
+
+static_assert(sizeof(ClosureObject) % alignof(Value) == 0);
+
+// the bytes an object occupies, including any trailing data
+template <typename T>
+std::size_t size_of(const T *)
+{
+    return sizeof(T);
+}
+
+inline std::size_t size_of(const InstanceObject *instance)
+{
+    return InstanceObject::size(instance->field_count);
+}
+
+inline std::size_t size_of(const ClosureObject *closure)
+{
+    return ClosureObject::size(closure->upvalue_count);
+}
+
+template <typename T>
+T *as(const Value value)
+{
+    if (!value.is_object() || value.as_object()->type != T::TYPE)
+        return nullptr;
+    return static_cast<T *>(value.as_object());
+}
+} // namespace cool::vm::runtime
@@ -0,0 +1,87 @@
+#include "pause_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace cool::vm::runtime {
+namespace {
+std::string format(const std::uint64_t nanoseconds)
+{
+    char buffer[32];
+    if (nanoseconds < 1000)
+        std::snprintf(buffer, sizeof buffer, "%llu ns",
+                      static_cast<unsigned long long>(nanoseconds));
+    else if (nanoseconds < 1000 * 1000)
+        std::snprintf(buffer, sizeof buffer, "%.1f us", static_cast<double>(nanoseconds) / 1e3);
+    else
+        std::snprintf(buffer, sizeof buffer, "%.2f ms", static_cast<double>(nanoseconds) / 1e6);
+    return buffer;
+}
+} // namespace
+
+void PauseHistogram::record(const std::chrono::nanoseconds pause)
+{
+    const auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(pause.count(), 0));
+    counts[bucket(nanoseconds)]++;
+    count++;
+    total += nanoseconds;
+    max = std::max(max, nanoseconds);
+}
+
+std::uint64_t PauseHistogram::percentile(const double fraction) const
+{
+    const auto rank =
+            static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count)));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank && seen > 0)
+            return std::min(lower_bound(i + 1), max);
+    }
+    return max;
+}
+
+void PauseHistogram::report(std::ostream &out) const
+{
+    out << "gc: " << count << " pauses, total " << format(total) << ", max " << format(max)
+        << '\n';
+    if (count == 0)
+        return;
+    out << "gc: p50 " << format(percentile(0.5)) << ", p90 " << format(percentile(0.9))
+        << ", p99 " << format(percentile(0.99)) << ", p99.9 " << format(percentile(0.999))
+        << '\n';
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+        char line[96];
+        std::snprintf(line, sizeof line, "gc:   [%10s, %10s) %llu\n",
+                      format(lower_bound(i)).c_str(), format(lower_bound(i + 1)).c_str(),
+                      static_cast<unsigned long long>(counts[i]));
+        out << line;
+    }
+}
+
+// below 8 ns every nanosecond has its own bucket, above it the top three bits after the
+// leading one pick the sub-bucket of the octave
+int PauseHistogram::bucket(const std::uint64_t nanoseconds)
+{
+    if (nanoseconds < SUB_BUCKETS)
+        return static_cast<int>(nanoseconds);
+    const int octave = 63 - __builtin_clzll(nanoseconds);
+    const int sub    = static_cast<int>(nanoseconds >> (octave - 3)) & (SUB_BUCKETS - 1);
+    return (octave - 2) * SUB_BUCKETS + sub;
+}
+
+std::uint64_t PauseHistogram::lower_bound(const int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return static_cast<std::uint64_t>(bucket);
+    const int octave = bucket / SUB_BUCKETS + 2;
+    const int sub    = bucket % SUB_BUCKETS;
+    return static_cast<std::uint64_t>(SUB_BUCKETS + sub) << (octave - 3);
+}
+} // namespace cool::vm::runtime
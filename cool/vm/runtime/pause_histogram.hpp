@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace cool::vm::runtime {
+/* Collector pause times on a log scale: every power of two of nanoseconds is split into
+ * eight buckets, so a reported percentile is at most 12.5% above the real one.
+ */
+struct PauseHistogram
+{
+    static constexpr int SUB_BUCKETS = 8;
+    static constexpr int BUCKETS     = 64 * SUB_BUCKETS;
+
+    std::array<std::uint64_t, BUCKETS> counts{};
+    std::uint64_t                      count = 0;
+    std::uint64_t                      total = 0; // nanoseconds
+    std::uint64_t                      max   = 0;
+
+    void record(std::chrono::nanoseconds pause);
+
+    // the upper bound of the bucket holding the `fraction` quantile, in nanoseconds
+    [[nodiscard]] std::uint64_t percentile(double fraction) const;
+
+    void report(std::ostream &out) const;
+
+    static int           bucket(std::uint64_t nanoseconds);
+    static std::uint64_t lower_bound(int bucket);
+};
+} // namespace cool::vm::runtime
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace cool::vm::runtime {
+struct Object;
+
+enum class ValueType : std::uint8_t { NIL, BOOL, INT, FLOAT, OBJECT };
+
+/* A register value in 8 bytes, NaN-boxed.
+ *
+ * Floats are stored as themselves. Everything else hides in the quiet NaN space that no
+ * arithmetic result occupies (NaNs are canonicalized on the way in), told apart by the top
+ * 16 bits:
+ *   0x7FFC  nil, false and true in the low bits
+ *   0x7FFD  an integer in [-2^47, 2^47), the low 48 bits in two's complement
+ *   0x7FFF  a heap object, the low 48 bits are the pointer
+ * Integers outside the inline range are boxed on the heap (runtime::IntegerObject).
+ */
+struct Value
+{
+    static constexpr std::uint64_t QNAN          = 0x7FFC000000000000;
+    static constexpr std::uint64_t CANONICAL_NAN = 0x7FF8000000000000;
+    static constexpr std::uint64_t NIL           = QNAN | 1;
+    static constexpr std::uint64_t FALSE_BITS    = QNAN | 2;
+    static constexpr std::uint64_t TRUE_BITS     = QNAN | 3;
+    static constexpr std::uint64_t INT_TAG       = 0x7FFD000000000000;
+    static constexpr std::uint64_t OBJECT_TAG    = 0x7FFF000000000000;
+    static constexpr std::uint64_t TAG_MASK      = 0xFFFF000000000000;
+    static constexpr std::uint64_t PAYLOAD_MASK  = 0x0000FFFFFFFFFFFF;
+    static constexpr std::int64_t  INLINE_MIN    = -(std::int64_t{1} << 47);
+    static constexpr std::int64_t  INLINE_MAX    = (std::int64_t{1} << 47) - 1;
+
+    std::uint64_t bits = NIL;
+
+    static constexpr Value nil() { return {}; }
+
+    static constexpr Value boolean_value(const bool value)
+    {
+        return from_bits(value ? TRUE_BITS : FALSE_BITS);
+    }
+
+    static constexpr bool fits_int(const std::int64_t value)
+    {
+        return value >= INLINE_MIN && value <= INLINE_MAX;
+    }
+
+    // `value` must fit the inline range
+    static constexpr Value int_value(const std::int64_t value)
+    {
+        return from_bits(INT_TAG | (static_cast<std::uint64_t>(value) & PAYLOAD_MASK));
+    }
+
+    static Value float_value(const double value)
+    {
+        if (value != value)
+            return from_bits(CANONICAL_NAN);
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        return from_bits(bits);
+    }
+
+    static Value object_value(Object *value)
+    {
+        return from_bits(OBJECT_TAG | reinterpret_cast<std::uintptr_t>(value));
+    }
+
+    static constexpr Value from_bits(const std::uint64_t bits)
+    {
+        Value value;
+        value.bits = bits;
+        return value;
+    }
+
+    [[nodiscard]] constexpr bool is_nil() const { return bits == NIL; }
+    [[nodiscard]] constexpr bool is_bool() const { return (bits | 1) == (TRUE_BITS | 1); }
+    [[nodiscard]] constexpr bool is_int() const { return (bits & TAG_MASK) == INT_TAG; }
+    [[nodiscard]] constexpr bool is_float() const { return (bits & QNAN) != QNAN; }
+    [[nodiscard]] constexpr bool is_object() const { return (bits & TAG_MASK) == OBJECT_TAG; }
+
+    [[nodiscard]] constexpr bool as_bool() const { return bits == TRUE_BITS; }
+
+    [[nodiscard]] constexpr std::int64_t as_int() const
+    {
+        return static_cast<std::int64_t>(bits << 16) >> 16;
+    }
+
+    [[nodiscard]] double as_float() const
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    [[nodiscard]] Object *as_object() const
+    {
+        return reinterpret_cast<Object *>(static_cast<std::uintptr_t>(bits & PAYLOAD_MASK));
+    }
+
+    // only nil and false are falsy, they are adjacent encodings
+    [[nodiscard]] constexpr bool truthy() const { return bits - NIL > FALSE_BITS - NIL; }
+
+    [[nodiscard]] constexpr ValueType type() const
+    {
+        if (is_float())
+            return ValueType::FLOAT;
+        if (is_int())
+            return ValueType::INT;
+        if (is_object())
+            return ValueType::OBJECT;
+        return is_nil() ? ValueType::NIL : ValueType::BOOL;
+    }
+};
+
+static_assert(sizeof(Value) == 8);
+static_assert(!Value::nil().truthy() && !Value::boolean_value(false).truthy());
+static_assert(Value::boolean_value(true).truthy() && Value::boolean_value(true).is_bool());
+static_assert(Value::int_value(Value::INLINE_MIN).as_int() == Value::INLINE_MIN);
+static_assert(Value::int_value(-1).as_int() == -1 && Value::int_value(0).truthy());
+static_assert(sizeof(void *) == 8, "NaN-boxing assumes 64-bit pointers");
+} // namespace cool::vm::runtime